@@ -99,6 +99,7 @@ void dbg_assert_imp(const char *filename, int line, int test, const char *msg)
 	if(!test)
 	{
 		dbg_msg("assert", "%s(%d): %s", filename, line, msg);
+		dbg_logger_flush();
 		dbg_break_imp();
 	}
 }
@@ -112,6 +113,264 @@ void dbg_break_imp(void)
 #endif
 }
 
+/* async logging: every thread queues its lines in its own ring buffer and
+   the logger thread passes them on in the order they were queued */
+enum
+{
+	LOG_RING_SIZE = 64 * 1024, /* power of two */
+	LOG_MAX_RINGS = 64,
+};
+
+typedef struct
+{
+	unsigned seq;
+	unsigned len;
+	int64 time;
+} LOG_RECORD;
+
+typedef struct
+{
+	/* only the owning thread moves write_pos, only the logger thread moves read_pos */
+	volatile unsigned write_pos;
+	volatile unsigned read_pos;
+	volatile unsigned owned;
+	unsigned char buffer[LOG_RING_SIZE];
+} LOG_RING;
+
+static LOG_RING *log_rings[LOG_MAX_RINGS];
+static volatile unsigned log_num_rings = 0;
+static LOCK log_rings_lock;
+static SEMAPHORE log_sphore;
+static void *log_thread = 0;
+static volatile unsigned log_async = 0;
+static volatile unsigned log_stop = 0;
+static volatile unsigned log_seq = 0;
+static volatile unsigned log_dropped = 0;
+static unsigned log_reported_dropped = 0;
+static unsigned log_next_seq = 0;
+static int log_initialized = 0;
+static int64 log_cached_time = -1;
+static char log_cached_timestr[80];
+#if defined(CONF_FAMILY_WINDOWS)
+static DWORD log_ring_key;
+#else
+static pthread_key_t log_ring_key;
+#endif
+
+#if defined(__GNUC__)
+static unsigned log_load(volatile unsigned *p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+static void log_store(volatile unsigned *p, unsigned v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+static unsigned log_fetch_inc(volatile unsigned *p) { return __atomic_fetch_add(p, 1, __ATOMIC_RELAXED); }
+#else
+/* volatile accesses have acquire and release semantics with msvc */
+static unsigned log_load(volatile unsigned *p) { return *p; }
+static void log_store(volatile unsigned *p, unsigned v) { *p = v; }
+static unsigned log_fetch_inc(volatile unsigned *p) { return InterlockedIncrement((volatile LONG *)p) - 1; }
+#endif
+
+static void log_ring_write(LOG_RING *ring, unsigned pos, const void *data, unsigned size)
+{
+	unsigned offset = pos & (LOG_RING_SIZE - 1);
+	unsigned first = size < LOG_RING_SIZE - offset ? size : LOG_RING_SIZE - offset;
+	mem_copy(ring->buffer + offset, data, first);
+	mem_copy(ring->buffer, (const unsigned char *)data + first, size - first);
+}
+
+static void log_ring_read(LOG_RING *ring, unsigned pos, void *data, unsigned size)
+{
+	unsigned offset = pos & (LOG_RING_SIZE - 1);
+	unsigned first = size < LOG_RING_SIZE - offset ? size : LOG_RING_SIZE - offset;
+	mem_copy(data, ring->buffer + offset, first);
+	mem_copy((unsigned char *)data + first, ring->buffer, size - first);
+}
+
+/* called when a thread exits, its ring can be taken over once it's empty */
+#if defined(CONF_FAMILY_WINDOWS)
+static void WINAPI log_ring_release(void *user)
+#else
+static void log_ring_release(void *user)
+#endif
+{
+	if(user)
+		log_store(&((LOG_RING *)user)->owned, 0);
+}
+
+static LOG_RING *log_ring_get(void)
+{
+	LOG_RING *ring;
+	unsigned i;
+#if defined(CONF_FAMILY_WINDOWS)
+	ring = (LOG_RING *)FlsGetValue(log_ring_key);
+#else
+	ring = (LOG_RING *)pthread_getspecific(log_ring_key);
+#endif
+	if(ring)
+		return ring;
+
+	lock_wait(log_rings_lock);
+	for(i = 0; i < log_num_rings && !ring; i++)
+	{
+		if(!log_load(&log_rings[i]->owned) && log_load(&log_rings[i]->read_pos) == log_rings[i]->write_pos)
+			ring = log_rings[i];
+	}
+	if(!ring && log_num_rings < LOG_MAX_RINGS)
+	{
+		ring = (LOG_RING *)malloc(sizeof(*ring));
+		if(ring)
+		{
+			ring->write_pos = 0;
+			ring->read_pos = 0;
+			log_rings[log_num_rings] = ring;
+			log_store(&log_num_rings, log_num_rings + 1);
+		}
+	}
+	if(ring)
+	{
+		log_store(&ring->owned, 1);
+#if defined(CONF_FAMILY_WINDOWS)
+		FlsSetValue(log_ring_key, ring);
+#else
+		pthread_setspecific(log_ring_key, ring);
+#endif
+	}
+	lock_unlock(log_rings_lock);
+	return ring;
+}
+
+/* returns 0 if the line has to be logged synchronously */
+static int log_queue(const char *sys, const char *fmt, va_list args)
+{
+	char str[1024 * 4];
+	LOG_RECORD record;
+	unsigned write_pos;
+	int len;
+	LOG_RING *ring = log_ring_get();
+	if(!ring)
+		return 0;
+
+	str_format(str, sizeof(str), "[%s]: ", sys);
+	len = strlen(str);
+#if defined(CONF_FAMILY_WINDOWS)
+	_vsnprintf(str + len, sizeof(str) - len, fmt, args);
+	str[sizeof(str) - 1] = 0;
+#else
+	vsnprintf(str + len, sizeof(str) - len, fmt, args);
+#endif
+
+	record.len = strlen(str);
+	record.time = time(0);
+	write_pos = ring->write_pos;
+	if(sizeof(record) + record.len > LOG_RING_SIZE - (write_pos - log_load(&ring->read_pos)))
+	{
+		log_fetch_inc(&log_dropped);
+		return 1;
+	}
+	record.seq = log_fetch_inc(&log_seq);
+	log_ring_write(ring, write_pos, &record, sizeof(record));
+	log_ring_write(ring, write_pos + sizeof(record), str, record.len);
+	log_store(&ring->write_pos, write_pos + sizeof(record) + record.len);
+	sphore_signal(&log_sphore);
+	return 1;
+}
+
+static const char *log_timestr(int64 time_data)
+{
+	/* only formatted once per second */
+	if(time_data != log_cached_time)
+	{
+		str_timestamp_ex((time_t)time_data, log_cached_timestr, sizeof(log_cached_timestr), FORMAT_SPACE);
+		log_cached_time = time_data;
+	}
+	return log_cached_timestr;
+}
+
+static void log_drain(void)
+{
+	char line[1024 * 4 + 128];
+	unsigned dropped;
+	int waited = 0;
+	int i;
+	while(1)
+	{
+		LOG_RING *ring = 0;
+		LOG_RECORD record;
+		unsigned num_rings = log_load(&log_num_rings);
+		unsigned r;
+		int len;
+
+		/* the oldest line of all rings */
+		for(r = 0; r < num_rings; r++)
+		{
+			LOG_RECORD head;
+			if(log_rings[r]->read_pos == log_load(&log_rings[r]->write_pos))
+				continue;
+			log_ring_read(log_rings[r], log_rings[r]->read_pos, &head, sizeof(head));
+			if(!ring || (int)(head.seq - record.seq) < 0)
+			{
+				ring = log_rings[r];
+				record = head;
+			}
+		}
+		if(!ring)
+			break;
+
+		/* a thread got an earlier number but hasn't published its line
+		   yet, it's printed first. don't wait forever in case that thread
+		   is stuck */
+		if((int)(record.seq - log_next_seq) > 0 && waited < 1000)
+		{
+			waited++;
+			thread_yield();
+			continue;
+		}
+		waited = 0;
+		log_next_seq = record.seq + 1;
+
+		str_format(line, sizeof(line), "[%s]", log_timestr(record.time));
+		len = strlen(line);
+		log_ring_read(ring, ring->read_pos + sizeof(record), line + len, record.len);
+		line[len + record.len] = 0;
+		for(i = 0; i < num_loggers; i++)
+			loggers[i].logger(line, loggers[i].user);
+		log_store(&ring->read_pos, ring->read_pos + sizeof(record) + record.len);
+	}
+
+	dropped = log_load(&log_dropped);
+	if(dropped != log_reported_dropped)
+	{
+		str_format(line, sizeof(line), "[%s][dbg/logger]: dropped %u lines, the log buffer was full", log_timestr(time(0)), dropped - log_reported_dropped);
+		for(i = 0; i < num_loggers; i++)
+			loggers[i].logger(line, loggers[i].user);
+		log_reported_dropped = dropped;
+	}
+}
+
+static void log_thread_func(void *user)
+{
+	(void)user;
+	while(1)
+	{
+		unsigned stop;
+		sphore_wait(&log_sphore);
+		stop = log_load(&log_stop);
+		log_drain();
+		if(stop)
+			break;
+	}
+}
+
+static void log_async_stop(void)
+{
+	if(!log_thread)
+		return;
+	log_store(&log_async, 0);
+	log_store(&log_stop, 1);
+	sphore_signal(&log_sphore);
+	thread_wait(log_thread);
+	log_thread = 0;
+	log_store(&log_stop, 0);
+}
+
 void dbg_msg(const char *sys, const char *fmt, ...)
 {
 	va_list args;
@@ -122,6 +381,14 @@ void dbg_msg(const char *sys, const char *fmt, ...)
 	int i;
 
 	char timestr[80];
+
+	va_start(args, fmt);
+	if(log_load(&log_async) && log_queue(sys, fmt, args))
+	{
+		va_end(args);
+		return;
+	}
+
 	str_timestamp_format(timestr, sizeof(timestr), FORMAT_SPACE);
 
 	str_format(str, sizeof(str), "[%s][%s]: ", timestr, sys);
@@ -129,7 +396,6 @@ void dbg_msg(const char *sys, const char *fmt, ...)
 	len = strlen(str);
 	msg = (char *)str + len;
 
-	va_start(args, fmt);
 #if defined(CONF_FAMILY_WINDOWS)
 	_vsnprintf(msg, sizeof(str) - len, fmt, args);
 #else
@@ -207,6 +473,7 @@ static void logger_file_finish(void *user)
 static void dbg_logger_finish(void)
 {
 	int i;
+	log_async_stop();
 	for(i = 0; i < num_loggers; i++)
 	{
 		if(loggers[i].finish)
@@ -254,6 +521,69 @@ void dbg_logger_file(const char *filename)
 	else
 		dbg_msg("dbg/logger", "failed to open '%s' for logging", filename);
 }
+
+void dbg_logger_async(void)
+{
+	if(log_thread)
+		return;
+	if(!log_initialized)
+	{
+#if defined(CONF_FAMILY_WINDOWS)
+		log_ring_key = FlsAlloc(log_ring_release);
+		if(log_ring_key == FLS_OUT_OF_INDEXES)
+			return;
+#else
+		if(pthread_key_create(&log_ring_key, log_ring_release) != 0)
+			return;
+#endif
+		log_rings_lock = lock_create();
+		sphore_init(&log_sphore);
+		log_initialized = 1;
+	}
+	/* stay synchronous if there's nothing to drain the buffers */
+	log_thread = thread_init(log_thread_func, 0, "logger");
+	if(log_thread)
+		log_store(&log_async, 1);
+}
+
+void dbg_logger_sync(void)
+{
+	log_async_stop();
+}
+
+void dbg_logger_remove(DBG_LOGGER logger, void *user)
+{
+	int i;
+	for(i = 0; i < num_loggers; i++)
+	{
+		if(loggers[i].logger == logger && loggers[i].user == user)
+		{
+			mem_move(&loggers[i], &loggers[i + 1], (num_loggers - i - 1) * sizeof(loggers[0]));
+			num_loggers--;
+			return;
+		}
+	}
+}
+
+void dbg_logger_flush(void)
+{
+	int tries;
+	if(!log_load(&log_async))
+		return;
+	/* give up after a second, e.g. if the logger thread itself is stuck */
+	for(tries = 0; tries < 1000; tries++)
+	{
+		unsigned num_rings = log_load(&log_num_rings);
+		unsigned r;
+		int empty = 1;
+		for(r = 0; r < num_rings && empty; r++)
+			empty = log_load(&log_rings[r]->read_pos) == log_load(&log_rings[r]->write_pos);
+		if(empty)
+			return;
+		sphore_signal(&log_sphore);
+		thread_sleep(1000);
+	}
+}
 /* */
 
 void mem_copy(void *dest, const void *source, unsigned size)
@@ -1719,6 +1719,46 @@ void dbg_logger_stdout(void);
 void dbg_logger_debugger(void);
 void dbg_logger_file(const char *filename);
 
+/*
+	Function: dbg_logger_async
+		Makes <dbg_msg> only queue the lines in a buffer of the calling
+		thread, a background thread passes them on to the loggers. Lines
+		are dropped and counted if a thread's buffer is full.
+
+	Remarks:
+		- Register the loggers before calling this.
+*/
+void dbg_logger_async(void);
+
+/*
+	Function: dbg_logger_sync
+		Stops asynchronous logging after passing on the queued lines,
+		<dbg_msg> calls the loggers directly again.
+
+	Remarks:
+		- Lines queued by other threads while this runs may only be
+		  passed on when asynchronous logging is started again.
+*/
+void dbg_logger_sync(void);
+
+/*
+	Function: dbg_logger_remove
+		Removes a logger registered with <dbg_logger> without calling its
+		finish function.
+
+	Remarks:
+		- Only call this while no other thread logs and asynchronous
+		  logging is stopped.
+*/
+void dbg_logger_remove(DBG_LOGGER logger, void *user);
+
+/*
+	Function: dbg_logger_flush
+		Waits until the lines queued by asynchronous logging have been
+		passed on to the loggers.
+*/
+void dbg_logger_flush(void);
+
 typedef struct
 {
 	int sent_packets;
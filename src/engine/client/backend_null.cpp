@@ -0,0 +1,520 @@
+#include <base/math.h>
+#include <base/system.h>
+#include <base/tl/threading.h>
+
+#include <engine/shared/config.h>
+
+#include "backend_null.h"
+
+static const char *CommandName(int Cmd)
+{
+	switch(Cmd)
+	{
+	case CCommandBuffer::CMD_NOP: return "nop";
+	case CCommandBuffer::CMD_RUNBUFFER: return "run_buffer";
+	case CCommandBuffer::CMD_SIGNAL: return "signal";
+	case CCommandBuffer::CMD_TEXTURE_CREATE: return "texture_create";
+	case CCommandBuffer::CMD_TEXTURE_DESTROY: return "texture_destroy";
+	case CCommandBuffer::CMD_TEXTURE_UPDATE: return "texture_update";
+	case CCommandBuffer::CMD_CLEAR: return "clear";
+	case CCommandBuffer::CMD_RENDER: return "render";
+	case CCommandBuffer::CMD_RENDER_TEX3D: return "render_tex3d";
+	case CCommandBuffer::CMD_CREATE_BUFFER_OBJECT: return "create_buffer_object";
+	case CCommandBuffer::CMD_RECREATE_BUFFER_OBJECT: return "recreate_buffer_object";
+	case CCommandBuffer::CMD_UPDATE_BUFFER_OBJECT: return "update_buffer_object";
+	case CCommandBuffer::CMD_COPY_BUFFER_OBJECT: return "copy_buffer_object";
+	case CCommandBuffer::CMD_DELETE_BUFFER_OBJECT: return "delete_buffer_object";
+	case CCommandBuffer::CMD_CREATE_BUFFER_CONTAINER: return "create_buffer_container";
+	case CCommandBuffer::CMD_DELETE_BUFFER_CONTAINER: return "delete_buffer_container";
+	case CCommandBuffer::CMD_UPDATE_BUFFER_CONTAINER: return "update_buffer_container";
+	case CCommandBuffer::CMD_INDICES_REQUIRED_NUM_NOTIFY: return "indices_required_num_notify";
+	case CCommandBuffer::CMD_RENDER_TILE_LAYER: return "render_tile_layer";
+	case CCommandBuffer::CMD_RENDER_BORDER_TILE: return "render_border_tile";
+	case CCommandBuffer::CMD_RENDER_BORDER_TILE_LINE: return "render_border_tile_line";
+	case CCommandBuffer::CMD_RENDER_QUAD_LAYER: return "render_quad_layer";
+	case CCommandBuffer::CMD_RENDER_TEXT: return "render_text";
+	case CCommandBuffer::CMD_RENDER_TEXT_STREAM: return "render_text_stream";
+	case CCommandBuffer::CMD_RENDER_QUAD_CONTAINER: return "render_quad_container";
+	case CCommandBuffer::CMD_RENDER_QUAD_CONTAINER_SPRITE: return "render_quad_container_sprite";
+	case CCommandBuffer::CMD_RENDER_QUAD_CONTAINER_SPRITE_MULTIPLE: return "render_quad_container_sprite_multiple";
+	case CCommandBuffer::CMD_SWAP: return "swap";
+	case CCommandBuffer::CMD_VSYNC: return "vsync";
+	case CCommandBuffer::CMD_SCREENSHOT: return "screenshot";
+	case CCommandBuffer::CMD_VIDEOMODES: return "videomodes";
+	case CCommandBuffer::CMD_RESIZE: return "resize";
+	default: return "unknown";
+	}
+}
+
+static int VerticesPerPrimitive(unsigned PrimType)
+{
+	switch(PrimType)
+	{
+	case CCommandBuffer::PRIMTYPE_LINES: return 2;
+	case CCommandBuffer::PRIMTYPE_TRIANGLES: return 3;
+	case CCommandBuffer::PRIMTYPE_QUADS: return 4;
+	default: return 0;
+	}
+}
+
+static int TexFormatToPixelSize(int TexFormat)
+{
+	if(TexFormat == CCommandBuffer::TEXFORMAT_RGB)
+		return 3;
+	if(TexFormat == CCommandBuffer::TEXFORMAT_ALPHA)
+		return 1;
+	return 4;
+}
+
+CGraphicsBackend_Null::CGraphicsBackend_Null()
+{
+	mem_zero(&m_Stats, sizeof(m_Stats));
+	m_NumFrames = 0;
+	m_FrameTime = 0;
+	m_MaxFrameTime = 0;
+	m_LastSwap = 0;
+	m_Validate = false;
+	m_NumErrors = 0;
+	mem_zero(m_aTextures, sizeof(m_aTextures));
+	mem_zero(m_aTextureMemSize, sizeof(m_aTextureMemSize));
+	m_TextureMemoryUsage = 0;
+}
+
+int CGraphicsBackend_Null::Init(const char *pName, int *Screen, int *pWidth, int *pHeight, int FsaaSamples, int Flags, int *pDesktopWidth, int *pDesktopHeight, int *pCurrentWidth, int *pCurrentHeight, IStorage *pStorage)
+{
+	// there is no screen, pretend to have the requested resolution
+	if(*pWidth == 0 || *pHeight == 0)
+	{
+		*pWidth = 1920;
+		*pHeight = 1080;
+	}
+	*Screen = 0;
+	*pDesktopWidth = *pCurrentWidth = *pWidth;
+	*pDesktopHeight = *pCurrentHeight = *pHeight;
+
+	m_Validate = g_Config.m_GfxNullBackend == 2;
+	dbg_msg("gfx/null", "using the null graphics backend%s, nothing is displayed", m_Validate ? " with command validation" : "");
+	return 0;
+}
+
+int CGraphicsBackend_Null::Shutdown()
+{
+	if(!m_NumFrames)
+		return 0;
+
+	double Frames = (double)m_NumFrames;
+	dbg_msg("gfx/null", "%lld frames, %.3f ms average frame time, %.3f ms max",
+		(long long)m_NumFrames, m_FrameTime * 1000.0 / time_freq() / Frames, m_MaxFrameTime * 1000.0 / time_freq());
+	dbg_msg("gfx/null", "per frame: %.1f draw calls, %.1f streamed vertices, %.1f kB of commands and data",
+		m_Stats.m_NumDrawCalls / Frames, m_Stats.m_NumVertices / Frames, m_Stats.m_NumBytes / 1024.0 / Frames);
+	for(int i = 0; i < NUM_CORE_COMMANDS; i++)
+	{
+		if(m_Stats.m_aCommands[i])
+			dbg_msg("gfx/null", "  %-40s %12lld (%.2f per frame)", CommandName(i), (long long)m_Stats.m_aCommands[i], m_Stats.m_aCommands[i] / Frames);
+	}
+	if(m_Validate)
+		dbg_msg("gfx/null", "%d invalid commands", m_NumErrors);
+	return 0;
+}
+
+void CGraphicsBackend_Null::Error(const char *pWhat, const char *pProblem, int Index)
+{
+	if(m_NumErrors++ < MAX_LOGGED_ERRORS)
+		dbg_msg("gfx/null", "%s: %s %d", pWhat, pProblem, Index);
+}
+
+void CGraphicsBackend_Null::ValidateState(const CCommandBuffer::SState &State)
+{
+	if(State.m_Texture != -1)
+		ValidateTexture(State.m_Texture, "state texture");
+	if(State.m_ClipEnable && (State.m_ClipW < 0 || State.m_ClipH < 0))
+		Error("state clip", "negative clip size", minimum(State.m_ClipW, State.m_ClipH));
+}
+
+void CGraphicsBackend_Null::ValidateData(CCommandBuffer *pBuffer, const void *pData, size_t Size, const char *pWhat)
+{
+	// everything a command points to has to be allocated from its own buffer
+	const unsigned char *pStart = pBuffer->m_DataBuffer.DataPtr();
+	const unsigned char *pEnd = pStart + pBuffer->m_DataBuffer.DataUsed();
+	const unsigned char *pPtr = (const unsigned char *)pData;
+	if(pPtr < pStart || pPtr + Size > pEnd)
+		Error(pWhat, "data outside of the command buffer, size", (int)Size);
+}
+
+void CGraphicsBackend_Null::ValidateTexture(int Slot, const char *pWhat)
+{
+	if(Slot < 0 || Slot >= CCommandBuffer::MAX_TEXTURES)
+		Error(pWhat, "texture slot out of range", Slot);
+	else if(!m_aTextures[Slot])
+		Error(pWhat, "texture doesn't exist", Slot);
+}
+
+void CGraphicsBackend_Null::ValidateBufferObject(int Index, const char *pWhat)
+{
+	if(Index < 0 || Index >= (int)m_vBufferObjects.size() || !m_vBufferObjects[Index])
+		Error(pWhat, "buffer object doesn't exist", Index);
+}
+
+void CGraphicsBackend_Null::ValidateBufferContainer(int Index, const char *pWhat)
+{
+	if(Index < 0 || Index >= (int)m_vBufferContainers.size() || !m_vBufferContainers[Index].m_Alive)
+		Error(pWhat, "buffer container doesn't exist", Index);
+}
+
+void CGraphicsBackend_Null::SetBufferContainer(int Index, const SBufferContainerInfo::SAttribute *pAttributes, int AttrCount)
+{
+	if(Index < 0)
+		return;
+	if(Index >= (int)m_vBufferContainers.size())
+		m_vBufferContainers.resize(Index + 1);
+	CBufferContainer &Container = m_vBufferContainers[Index];
+	Container.m_Alive = true;
+	Container.m_vBufferObjects.clear();
+	for(int i = 0; i < AttrCount; i++)
+	{
+		if(m_Validate)
+			ValidateBufferObject(pAttributes[i].m_VertBufferBindingIndex, "buffer container attribute");
+		Container.m_vBufferObjects.push_back(pAttributes[i].m_VertBufferBindingIndex);
+	}
+}
+
+void CGraphicsBackend_Null::RunCommand(CCommandBuffer *pBuffer, const CCommandBuffer::SCommand *pBaseCommand)
+{
+	if(pBaseCommand->m_Cmd < NUM_CORE_COMMANDS)
+		m_Stats.m_aCommands[pBaseCommand->m_Cmd]++;
+	else if(m_Validate)
+		Error("command", "unknown command", pBaseCommand->m_Cmd);
+
+	switch(pBaseCommand->m_Cmd)
+	{
+	case CCommandBuffer::CMD_SIGNAL:
+		static_cast<const CCommandBuffer::SCommand_Signal *>(pBaseCommand)->m_pSemaphore->signal();
+		break;
+	case CCommandBuffer::CMD_TEXTURE_CREATE:
+	{
+		const CCommandBuffer::SCommand_Texture_Create *pCommand = static_cast<const CCommandBuffer::SCommand_Texture_Create *>(pBaseCommand);
+		if(pCommand->m_Slot < 0 || pCommand->m_Slot >= CCommandBuffer::MAX_TEXTURES)
+			Error("texture create", "texture slot out of range", pCommand->m_Slot);
+		else
+		{
+			if(m_Validate && m_aTextures[pCommand->m_Slot])
+				Error("texture create", "texture already exists", pCommand->m_Slot);
+			m_TextureMemoryUsage -= m_aTextureMemSize[pCommand->m_Slot];
+			m_aTextures[pCommand->m_Slot] = true;
+			m_aTextureMemSize[pCommand->m_Slot] = pCommand->m_Width * pCommand->m_Height * pCommand->m_PixelSize;
+			m_TextureMemoryUsage += m_aTextureMemSize[pCommand->m_Slot];
+			m_Stats.m_NumBytes += m_aTextureMemSize[pCommand->m_Slot];
+		}
+		free(pCommand->m_pData);
+		break;
+	}
+	case CCommandBuffer::CMD_TEXTURE_UPDATE:
+	{
+		const CCommandBuffer::SCommand_Texture_Update *pCommand = static_cast<const CCommandBuffer::SCommand_Texture_Update *>(pBaseCommand);
+		if(m_Validate)
+			ValidateTexture(pCommand->m_Slot, "texture update");
+		m_Stats.m_NumBytes += pCommand->m_Width * pCommand->m_Height * TexFormatToPixelSize(pCommand->m_Format);
+		free(pCommand->m_pData);
+		break;
+	}
+	case CCommandBuffer::CMD_TEXTURE_DESTROY:
+	{
+		const CCommandBuffer::SCommand_Texture_Destroy *pCommand = static_cast<const CCommandBuffer::SCommand_Texture_Destroy *>(pBaseCommand);
+		if(m_Validate)
+			ValidateTexture(pCommand->m_Slot, "texture destroy");
+		if(pCommand->m_Slot >= 0 && pCommand->m_Slot < CCommandBuffer::MAX_TEXTURES)
+		{
+			m_TextureMemoryUsage -= m_aTextureMemSize[pCommand->m_Slot];
+			m_aTextureMemSize[pCommand->m_Slot] = 0;
+			m_aTextures[pCommand->m_Slot] = false;
+		}
+		break;
+	}
+	case CCommandBuffer::CMD_RENDER:
+	{
+		const CCommandBuffer::SCommand_Render *pCommand = static_cast<const CCommandBuffer::SCommand_Render *>(pBaseCommand);
+		int NumVertices = pCommand->m_PrimCount * VerticesPerPrimitive(pCommand->m_PrimType);
+		m_Stats.m_NumDrawCalls++;
+		m_Stats.m_NumVertices += NumVertices;
+		if(m_Validate)
+		{
+			ValidateState(pCommand->m_State);
+			if(!VerticesPerPrimitive(pCommand->m_PrimType))
+				Error("render", "unknown primitive type", pCommand->m_PrimType);
+			ValidateData(pBuffer, pCommand->m_pVertices, NumVertices * sizeof(CCommandBuffer::SVertex), "render");
+		}
+		break;
+	}
+	case CCommandBuffer::CMD_RENDER_TEX3D:
+	{
+		const CCommandBuffer::SCommand_RenderTex3D *pCommand = static_cast<const CCommandBuffer::SCommand_RenderTex3D *>(pBaseCommand);
+		int NumVertices = pCommand->m_PrimCount * VerticesPerPrimitive(pCommand->m_PrimType);
+		m_Stats.m_NumDrawCalls++;
+		m_Stats.m_NumVertices += NumVertices;
+		if(m_Validate)
+		{
+			ValidateState(pCommand->m_State);
+			if(!VerticesPerPrimitive(pCommand->m_PrimType))
+				Error("render tex3d", "unknown primitive type", pCommand->m_PrimType);
+			ValidateData(pBuffer, pCommand->m_pVertices, NumVertices * sizeof(CCommandBuffer::SVertexTex3DStream), "render tex3d");
+		}
+		break;
+	}
+	case CCommandBuffer::CMD_CREATE_BUFFER_OBJECT:
+	{
+		const CCommandBuffer::SCommand_CreateBufferObject *pCommand = static_cast<const CCommandBuffer::SCommand_CreateBufferObject *>(pBaseCommand);
+		if(pCommand->m_BufferIndex < 0)
+		{
+			Error("create buffer object", "invalid index", pCommand->m_BufferIndex);
+			break;
+		}
+		if(pCommand->m_BufferIndex >= (int)m_vBufferObjects.size())
+			m_vBufferObjects.resize(pCommand->m_BufferIndex + 1, false);
+		else if(m_Validate && m_vBufferObjects[pCommand->m_BufferIndex])
+			Error("create buffer object", "buffer object already exists", pCommand->m_BufferIndex);
+		m_vBufferObjects[pCommand->m_BufferIndex] = true;
+		m_Stats.m_NumBytes += pCommand->m_DataSize;
+		if(m_Validate && pCommand->m_pUploadData)
+			ValidateData(pBuffer, pCommand->m_pUploadData, pCommand->m_DataSize, "create buffer object");
+		break;
+	}
+	case CCommandBuffer::CMD_RECREATE_BUFFER_OBJECT:
+	{
+		const CCommandBuffer::SCommand_RecreateBufferObject *pCommand = static_cast<const CCommandBuffer::SCommand_RecreateBufferObject *>(pBaseCommand);
+		m_Stats.m_NumBytes += pCommand->m_DataSize;
+		if(m_Validate)
+		{
+			ValidateBufferObject(pCommand->m_BufferIndex, "recreate buffer object");
+			if(pCommand->m_pUploadData)
+				ValidateData(pBuffer, pCommand->m_pUploadData, pCommand->m_DataSize, "recreate buffer object");
+		}
+		break;
+	}
+	case CCommandBuffer::CMD_UPDATE_BUFFER_OBJECT:
+	{
+		const CCommandBuffer::SCommand_UpdateBufferObject *pCommand = static_cast<const CCommandBuffer::SCommand_UpdateBufferObject *>(pBaseCommand);
+		m_Stats.m_NumBytes += pCommand->m_DataSize;
+		if(m_Validate)
+		{
+			ValidateBufferObject(pCommand->m_BufferIndex, "update buffer object");
+			ValidateData(pBuffer, pCommand->m_pUploadData, pCommand->m_DataSize, "update buffer object");
+		}
+		break;
+	}
+	case CCommandBuffer::CMD_COPY_BUFFER_OBJECT:
+	{
+		const CCommandBuffer::SCommand_CopyBufferObject *pCommand = static_cast<const CCommandBuffer::SCommand_CopyBufferObject *>(pBaseCommand);
+		if(m_Validate)
+		{
+			ValidateBufferObject(pCommand->m_ReadBufferIndex, "copy buffer object");
+			ValidateBufferObject(pCommand->m_WriteBufferIndex, "copy buffer object");
+		}
+		break;
+	}
+	case CCommandBuffer::CMD_DELETE_BUFFER_OBJECT:
+	{
+		const CCommandBuffer::SCommand_DeleteBufferObject *pCommand = static_cast<const CCommandBuffer::SCommand_DeleteBufferObject *>(pBaseCommand);
+		if(m_Validate)
+			ValidateBufferObject(pCommand->m_BufferIndex, "delete buffer object");
+		if(pCommand->m_BufferIndex >= 0 && pCommand->m_BufferIndex < (int)m_vBufferObjects.size())
+			m_vBufferObjects[pCommand->m_BufferIndex] = false;
+		break;
+	}
+	case CCommandBuffer::CMD_CREATE_BUFFER_CONTAINER:
+	{
+		const CCommandBuffer::SCommand_CreateBufferContainer *pCommand = static_cast<const CCommandBuffer::SCommand_CreateBufferContainer *>(pBaseCommand);
+		if(m_Validate && pCommand->m_BufferContainerIndex < (int)m_vBufferContainers.size() && m_vBufferContainers[pCommand->m_BufferContainerIndex].m_Alive)
+			Error("create buffer container", "buffer container already exists", pCommand->m_BufferContainerIndex);
+		SetBufferContainer(pCommand->m_BufferContainerIndex, pCommand->m_Attributes, pCommand->m_AttrCount);
+		break;
+	}
+	case CCommandBuffer::CMD_UPDATE_BUFFER_CONTAINER:
+	{
+		const CCommandBuffer::SCommand_UpdateBufferContainer *pCommand = static_cast<const CCommandBuffer::SCommand_UpdateBufferContainer *>(pBaseCommand);
+		if(m_Validate)
+			ValidateBufferContainer(pCommand->m_BufferContainerIndex, "update buffer container");
+		SetBufferContainer(pCommand->m_BufferContainerIndex, pCommand->m_Attributes, pCommand->m_AttrCount);
+		break;
+	}
+	case CCommandBuffer::CMD_DELETE_BUFFER_CONTAINER:
+	{
+		const CCommandBuffer::SCommand_DeleteBufferContainer *pCommand = static_cast<const CCommandBuffer::SCommand_DeleteBufferContainer *>(pBaseCommand);
+		if(m_Validate)
+			ValidateBufferContainer(pCommand->m_BufferContainerIndex, "delete buffer container");
+		if(pCommand->m_BufferContainerIndex < 0 || pCommand->m_BufferContainerIndex >= (int)m_vBufferContainers.size())
+			break;
+		CBufferContainer &Container = m_vBufferContainers[pCommand->m_BufferContainerIndex];
+		if(pCommand->m_DestroyAllBO)
+		{
+			// the buffer objects of the container die with it
+			for(int BufferObject : Container.m_vBufferObjects)
+				if(BufferObject >= 0 && BufferObject < (int)m_vBufferObjects.size())
+					m_vBufferObjects[BufferObject] = false;
+		}
+		Container.m_Alive = false;
+		Container.m_vBufferObjects.clear();
+		break;
+	}
+	case CCommandBuffer::CMD_RENDER_TILE_LAYER:
+	{
+		const CCommandBuffer::SCommand_RenderTileLayer *pCommand = static_cast<const CCommandBuffer::SCommand_RenderTileLayer *>(pBaseCommand);
+		m_Stats.m_NumDrawCalls += pCommand->m_IndicesDrawNum;
+		if(m_Validate)
+		{
+			ValidateState(pCommand->m_State);
+			ValidateBufferContainer(pCommand->m_BufferContainerIndex, "render tile layer");
+			ValidateData(pBuffer, pCommand->m_pIndicesOffsets, pCommand->m_IndicesDrawNum * sizeof(char *), "render tile layer");
+			ValidateData(pBuffer, pCommand->m_pDrawCount, pCommand->m_IndicesDrawNum * sizeof(unsigned int), "render tile layer");
+		}
+		break;
+	}
+	case CCommandBuffer::CMD_RENDER_BORDER_TILE:
+	{
+		const CCommandBuffer::SCommand_RenderBorderTile *pCommand = static_cast<const CCommandBuffer::SCommand_RenderBorderTile *>(pBaseCommand);
+		m_Stats.m_NumDrawCalls++;
+		if(m_Validate)
+		{
+			ValidateState(pCommand->m_State);
+			ValidateBufferContainer(pCommand->m_BufferContainerIndex, "render border tile");
+		}
+		break;
+	}
+	case CCommandBuffer::CMD_RENDER_BORDER_TILE_LINE:
+	{
+		const CCommandBuffer::SCommand_RenderBorderTileLine *pCommand = static_cast<const CCommandBuffer::SCommand_RenderBorderTileLine *>(pBaseCommand);
+		m_Stats.m_NumDrawCalls++;
+		if(m_Validate)
+		{
+			ValidateState(pCommand->m_State);
+			ValidateBufferContainer(pCommand->m_BufferContainerIndex, "render border tile line");
+		}
+		break;
+	}
+	case CCommandBuffer::CMD_RENDER_QUAD_LAYER:
+	{
+		const CCommandBuffer::SCommand_RenderQuadLayer *pCommand = static_cast<const CCommandBuffer::SCommand_RenderQuadLayer *>(pBaseCommand);
+		m_Stats.m_NumDrawCalls++;
+		if(m_Validate)
+		{
+			ValidateState(pCommand->m_State);
+			ValidateBufferContainer(pCommand->m_BufferContainerIndex, "render quad layer");
+			ValidateData(pBuffer, pCommand->m_pQuadInfo, pCommand->m_QuadNum * sizeof(SQuadRenderInfo), "render quad layer");
+		}
+		break;
+	}
+	case CCommandBuffer::CMD_RENDER_TEXT:
+	{
+		const CCommandBuffer::SCommand_RenderText *pCommand = static_cast<const CCommandBuffer::SCommand_RenderText *>(pBaseCommand);
+		m_Stats.m_NumDrawCalls++;
+		if(m_Validate)
+		{
+			ValidateState(pCommand->m_State);
+			ValidateBufferContainer(pCommand->m_BufferContainerIndex, "render text");
+			ValidateTexture(pCommand->m_TextTextureIndex, "render text");
+			ValidateTexture(pCommand->m_TextOutlineTextureIndex, "render text");
+		}
+		break;
+	}
+	case CCommandBuffer::CMD_RENDER_TEXT_STREAM:
+	{
+		const CCommandBuffer::SCommand_RenderTextStream *pCommand = static_cast<const CCommandBuffer::SCommand_RenderTextStream *>(pBaseCommand);
+		int NumVertices = pCommand->m_PrimCount * VerticesPerPrimitive(pCommand->m_PrimType);
+		m_Stats.m_NumDrawCalls++;
+		m_Stats.m_NumVertices += NumVertices;
+		if(m_Validate)
+		{
+			ValidateState(pCommand->m_State);
+			ValidateTexture(pCommand->m_TextTextureIndex, "render text stream");
+			ValidateTexture(pCommand->m_TextOutlineTextureIndex, "render text stream");
+			ValidateData(pBuffer, pCommand->m_pVertices, NumVertices * sizeof(CCommandBuffer::SVertex), "render text stream");
+		}
+		break;
+	}
+	case CCommandBuffer::CMD_RENDER_QUAD_CONTAINER:
+	{
+		const CCommandBuffer::SCommand_RenderQuadContainer *pCommand = static_cast<const CCommandBuffer::SCommand_RenderQuadContainer *>(pBaseCommand);
+		m_Stats.m_NumDrawCalls++;
+		if(m_Validate)
+		{
+			ValidateState(pCommand->m_State);
+			ValidateBufferContainer(pCommand->m_BufferContainerIndex, "render quad container");
+		}
+		break;
+	}
+	case CCommandBuffer::CMD_RENDER_QUAD_CONTAINER_SPRITE:
+	{
+		const CCommandBuffer::SCommand_RenderQuadContainerAsSprite *pCommand = static_cast<const CCommandBuffer::SCommand_RenderQuadContainerAsSprite *>(pBaseCommand);
+		m_Stats.m_NumDrawCalls++;
+		if(m_Validate)
+		{
+			ValidateState(pCommand->m_State);
+			ValidateBufferContainer(pCommand->m_BufferContainerIndex, "render quad container sprite");
+		}
+		break;
+	}
+	case CCommandBuffer::CMD_RENDER_QUAD_CONTAINER_SPRITE_MULTIPLE:
+	{
+		const CCommandBuffer::SCommand_RenderQuadContainerAsSpriteMultiple *pCommand = static_cast<const CCommandBuffer::SCommand_RenderQuadContainerAsSpriteMultiple *>(pBaseCommand);
+		m_Stats.m_NumDrawCalls++;
+		if(m_Validate)
+		{
+			ValidateState(pCommand->m_State);
+			ValidateBufferContainer(pCommand->m_BufferContainerIndex, "render quad container sprite multiple");
+			ValidateData(pBuffer, pCommand->m_pRenderInfo, pCommand->m_DrawCount * sizeof(IGraphics::SRenderSpriteInfo), "render quad container sprite multiple");
+		}
+		break;
+	}
+	case CCommandBuffer::CMD_SWAP:
+	{
+		int64 Now = time_get();
+		if(m_LastSwap)
+		{
+			int64 FrameTime = Now - m_LastSwap;
+			m_FrameTime += FrameTime;
+			m_MaxFrameTime = maximum(m_MaxFrameTime, FrameTime);
+			m_NumFrames++;
+		}
+		m_LastSwap = Now;
+		break;
+	}
+	case CCommandBuffer::CMD_VSYNC:
+	{
+		const CCommandBuffer::SCommand_VSync *pCommand = static_cast<const CCommandBuffer::SCommand_VSync *>(pBaseCommand);
+		*pCommand->m_pRetOk = true;
+		break;
+	}
+	case CCommandBuffer::CMD_SCREENSHOT:
+	{
+		// there are no pixels, the screenshot is skipped
+		const CCommandBuffer::SCommand_Screenshot *pCommand = static_cast<const CCommandBuffer::SCommand_Screenshot *>(pBaseCommand);
+		pCommand->m_pImage->m_pData = 0;
+		break;
+	}
+	case CCommandBuffer::CMD_VIDEOMODES:
+	{
+		const CCommandBuffer::SCommand_VideoModes *pCommand = static_cast<const CCommandBuffer::SCommand_VideoModes *>(pBaseCommand);
+		*pCommand->m_pNumModes = 0;
+		if(pCommand->m_MaxModes > 0)
+		{
+			pCommand->m_pModes[0].m_Width = g_Config.m_GfxScreenWidth;
+			pCommand->m_pModes[0].m_Height = g_Config.m_GfxScreenHeight;
+			pCommand->m_pModes[0].m_Red = 8;
+			pCommand->m_pModes[0].m_Green = 8;
+			pCommand->m_pModes[0].m_Blue = 8;
+			*pCommand->m_pNumModes = 1;
+		}
+		break;
+	}
+	}
+}
+
+void CGraphicsBackend_Null::RunBuffer(CCommandBuffer *pBuffer)
+{
+	m_Stats.m_NumBytes += pBuffer->m_CmdBuffer.DataUsed() + pBuffer->m_DataBuffer.DataUsed();
+
+	unsigned CmdIndex = 0;
+	while(const CCommandBuffer::SCommand *pBaseCommand = pBuffer->GetCommand(&CmdIndex))
+		RunCommand(pBuffer, pBaseCommand);
+}
+
+IGraphicsBackend *CreateGraphicsBackendNull() { return new CGraphicsBackend_Null; }
@@ -0,0 +1,90 @@
+#ifndef ENGINE_CLIENT_BACKEND_NULL_H
+#define ENGINE_CLIENT_BACKEND_NULL_H
+
+#include "graphics_threaded.h"
+
+#include <vector>
+
+// graphics backend without a window or gpu, consumes the command buffers on
+// the main thread and only keeps statistics about them. used to measure the
+// cpu side of rendering, e.g. by playing a demo with gfx_null_backend 1
+class CGraphicsBackend_Null : public IGraphicsBackend
+{
+	enum
+	{
+		NUM_CORE_COMMANDS = CCommandBuffer::CMD_RESIZE + 1,
+		MAX_LOGGED_ERRORS = 20,
+	};
+
+	struct CStats
+	{
+		int64 m_aCommands[NUM_CORE_COMMANDS];
+		int64 m_NumDrawCalls;
+		int64 m_NumVertices;
+		int64 m_NumBytes;
+	};
+
+	CStats m_Stats;
+	int64 m_NumFrames;
+	int64 m_FrameTime;
+	int64 m_MaxFrameTime;
+	int64 m_LastSwap;
+
+	bool m_Validate;
+	int m_NumErrors;
+	bool m_aTextures[CCommandBuffer::MAX_TEXTURES];
+	int m_aTextureMemSize[CCommandBuffer::MAX_TEXTURES];
+	int m_TextureMemoryUsage;
+	std::vector<bool> m_vBufferObjects;
+	struct CBufferContainer
+	{
+		bool m_Alive;
+		std::vector<int> m_vBufferObjects;
+	};
+	std::vector<CBufferContainer> m_vBufferContainers;
+
+	void Error(const char *pWhat, const char *pProblem, int Index);
+	void ValidateState(const CCommandBuffer::SState &State);
+	void ValidateData(CCommandBuffer *pBuffer, const void *pData, size_t Size, const char *pWhat);
+	void ValidateTexture(int Slot, const char *pWhat);
+	void ValidateBufferObject(int Index, const char *pWhat);
+	void ValidateBufferContainer(int Index, const char *pWhat);
+	void SetBufferContainer(int Index, const SBufferContainerInfo::SAttribute *pAttributes, int AttrCount);
+
+	void RunCommand(CCommandBuffer *pBuffer, const CCommandBuffer::SCommand *pBaseCommand);
+
+public:
+	CGraphicsBackend_Null();
+
+	int Init(const char *pName, int *Screen, int *pWidth, int *pHeight, int FsaaSamples, int Flags, int *pDesktopWidth, int *pDesktopHeight, int *pCurrentWidth, int *pCurrentHeight, class IStorage *pStorage) override;
+	int Shutdown() override;
+
+	int MemoryUsage() const override { return m_TextureMemoryUsage; }
+
+	int GetNumScreens() const override { return 1; }
+
+	void Minimize() override {}
+	void Maximize() override {}
+	bool Fullscreen(bool State) override { return false; }
+	void SetWindowBordered(bool State) override {}
+	bool SetWindowScreen(int Index) override { return Index == 0; }
+	int GetWindowScreen() override { return 0; }
+	int WindowActive() override { return 1; }
+	int WindowOpen() override { return 1; }
+	void SetWindowGrab(bool Grab) override {}
+	void NotifyWindow() override {}
+
+	void RunBuffer(CCommandBuffer *pBuffer) override;
+	bool IsIdle() const override { return true; }
+	void WaitForIdle() override {}
+
+	// take the same code paths as with the opengl 3.3 backend
+	bool IsNewOpenGL() override { return true; }
+	bool HasTileBuffering() override { return true; }
+	bool HasQuadBuffering() override { return true; }
+	bool HasTextBuffering() override { return true; }
+	bool HasQuadContainerBuffering() override { return true; }
+	bool Has2DTextureArrays() override { return true; }
+};
+
+#endif // ENGINE_CLIENT_BACKEND_NULL_H
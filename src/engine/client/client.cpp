@@ -46,6 +46,7 @@
 #include <engine/shared/json.h>
 #include <engine/shared/network.h>
 #include <engine/shared/packer.h>
+#include <engine/shared/profiler.h>
 #include <engine/shared/protocol.h>
 #include <engine/shared/protocol_ex.h>
 #include <engine/shared/ringbuffer.h>
@@ -1121,6 +1122,9 @@ const char *CClient::ErrorString()
 
 void CClient::Render()
 {
+	static int s_ProfileZone = g_Profiler.RegisterZone("client/render");
+	CProfileScope Scope(s_ProfileZone);
+
 	if(g_Config.m_ClOverlayEntities)
 	{
 		ColorRGBA bg = color_cast<ColorRGBA>(ColorHSLA(g_Config.m_ClBackgroundEntitiesColor));
@@ -1745,7 +1749,7 @@ void CClient::ProcessServerPacket(CNetChunk *pPacket)
 						str_format(aUrl, sizeof(aUrl), "%s/%s", g_Config.m_ClMapDownloadUrl, aEscaped);
 
 						m_pMapdownloadTask = std::make_shared<CGetFile>(Storage(), aUrl, m_aMapdownloadFilename, IStorage::TYPE_SAVE, CTimeout{g_Config.m_ClMapDownloadConnectTimeoutMs, g_Config.m_ClMapDownloadLowSpeedLimit, g_Config.m_ClMapDownloadLowSpeedTime});
-						Engine()->AddJob(m_pMapdownloadTask);
+						Engine()->AddJob(m_pMapdownloadTask, CJobPool::PRIORITY_HIGH);
 					}
 					else
 						SendMapRequest();
@@ -1870,6 +1874,9 @@ void CClient::ProcessServerPacket(CNetChunk *pPacket)
 		}
 		else if(Msg == NETMSG_SNAP || Msg == NETMSG_SNAPSINGLE || Msg == NETMSG_SNAPEMPTY)
 		{
+			static int s_ProfileZone = g_Profiler.RegisterZone("client/snapshot");
+			CProfileScope Scope(s_ProfileZone);
+
 			int NumParts = 1;
 			int Part = 0;
 			int GameTick = Unpacker.GetInt();
@@ -2158,6 +2165,9 @@ void CClient::ProcessServerPacketDummy(CNetChunk *pPacket)
 		}
 		else if(Msg == NETMSG_SNAP || Msg == NETMSG_SNAPSINGLE || Msg == NETMSG_SNAPEMPTY)
 		{
+			static int s_ProfileZone = g_Profiler.RegisterZone("client/snapshot");
+			CProfileScope Scope(s_ProfileZone);
+
 			int NumParts = 1;
 			int Part = 0;
 			int GameTick = Unpacker.GetInt();
@@ -2664,6 +2674,9 @@ void DemoPlayer()->SetPause(int paused)
 
 void CClient::Update()
 {
+	static int s_ProfileZone = g_Profiler.RegisterZone("client/update");
+	CProfileScope Scope(s_ProfileZone);
+
 	if(State() == IClient::STATE_DEMOPLAYBACK)
 	{
 #if defined(CONF_VIDEORECORDER)
@@ -2693,6 +2706,10 @@ void CClient::Update()
 		{
 			// disconnect on error
 			Disconnect();
+
+			// nothing is displayed, the headless run is over with the demo
+			if(g_Config.m_GfxNullBackend)
+				SetState(IClient::STATE_QUITTING);
 		}
 	}
 	else if(State() == IClient::STATE_ONLINE)
@@ -3242,6 +3259,7 @@ void CClient::Run()
 
 			bool IsRenderActive = (g_Config.m_GfxBackgroundRender || m_pGraphics->WindowOpen());
 
+			g_Profiler.SetEnabled(g_Config.m_DbgProfile);
 			if(IsRenderActive &&
 				(!g_Config.m_GfxAsyncRenderOld || m_pGraphics->IsIdle()) &&
 				(!g_Config.m_GfxRefreshRate || (time_freq() / (int64)g_Config.m_GfxRefreshRate) <= Now - LastRenderTime))
@@ -3295,6 +3313,7 @@ void CClient::Run()
 				}
 
 				Input()->NextFrame();
+				g_Profiler.NextFrame();
 			}
 			else if(!IsRenderActive)
 			{
@@ -4140,6 +4159,8 @@ void CClient::RegisterCommands()
 	m_pConsole->Chain("gfx_borderless", ConchainWindowBordered, this);
 	m_pConsole->Chain("gfx_vsync", ConchainWindowVSync, this);
 
+	g_Profiler.Init(m_pConsole, Kernel()->RequestInterface<IStorage>(), CFGFLAG_CLIENT);
+
 	// DDRace
 
 #define CONSOLE_COMMAND(name, params, flags, callback, userdata, help) m_pConsole->Register(name, params, flags, 0, 0, help);
@@ -4417,7 +4438,7 @@ void CClient::RequestDDNetInfo()
 	}
 
 	m_pDDNetInfoTask = std::make_shared<CGetFile>(Storage(), aUrl, m_aDDNetInfoTmp, IStorage::TYPE_SAVE, CTimeout{10000, 500, 10});
-	Engine()->AddJob(m_pDDNetInfoTask);
+	Engine()->AddJob(m_pDDNetInfoTask, CJobPool::PRIORITY_LOW);
 }
 
 int CClient::GetPredictionTime()
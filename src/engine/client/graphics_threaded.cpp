@@ -17,6 +17,7 @@
 #include <engine/graphics.h>
 #include <engine/keys.h>
 #include <engine/shared/config.h>
+#include <engine/shared/profiler.h>
 #include <engine/storage.h>
 #include <game/localization.h>
 
@@ -490,6 +491,10 @@ void CGraphics_Threaded::CopyTextureBufferSub(uint8_t *pDestBuffer, uint8_t *pSo
 
 void CGraphics_Threaded::KickCommandBuffer()
 {
+	// includes waiting for the backend to finish the previous buffer
+	static int s_ProfileZone = g_Profiler.RegisterZone("graphics/submit");
+	CProfileScope Scope(s_ProfileZone);
+
 	m_pBackend->RunBuffer(m_pCommandBuffer);
 
 	// swap buffer
@@ -2102,7 +2107,7 @@ int CGraphics_Threaded::Init()
 	m_FirstFreeBufferObjectIndex = -1;
 	m_FirstFreeQuadContainer = -1;
 
-	m_pBackend = CreateGraphicsBackend();
+	m_pBackend = g_Config.m_GfxNullBackend ? CreateGraphicsBackendNull() : CreateGraphicsBackend();
 	if(InitWindow() != 0)
 		return -1;
 
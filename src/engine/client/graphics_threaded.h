@@ -1113,5 +1113,6 @@ public:
 };
 
 extern IGraphicsBackend *CreateGraphicsBackend();
+extern IGraphicsBackend *CreateGraphicsBackendNull();
 
 #endif // ENGINE_CLIENT_GRAPHICS_THREADED_H
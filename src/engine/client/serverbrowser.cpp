@@ -1,6 +1,7 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include <algorithm> // sort  TODO: remove this
+#include <ctype.h>
 
 #include <base/hash_ctxt.h>
 #include <base/math.h>
@@ -59,6 +60,14 @@ CServerBrowser::CServerBrowser()
 	m_Sorthash = 0;
 	m_aFilterString[0] = 0;
 	m_aFilterGametypeString[0] = 0;
+	m_aExcludeString[0] = 0;
+	m_aFilterServerAddressString[0] = 0;
+	m_FilterPing = 0;
+	m_FilterCountryIndex = -1;
+	m_aLowerFilterString[0] = 0;
+	m_aLowerFilterGametypeString[0] = 0;
+	m_aLowerExcludeString[0] = 0;
+	m_aLowerFilterServerAddressString[0] = 0;
 
 	m_ServerlistType = 0;
 	m_BroadcastTime = 0;
@@ -170,136 +179,147 @@ bool CServerBrowser::SortCompareNumPlayersAndPing(int Index1, int Index2) const
 		return a->m_Info.m_NumFilteredPlayers - (a->m_Info.m_Latency / 100) * MAX_CLIENTS < b->m_Info.m_NumFilteredPlayers - (b->m_Info.m_Latency / 100) * MAX_CLIENTS;
 }
 
-void CServerBrowser::Filter()
+static void StrToLower(char *pDst, const char *pSrc, int DstSize)
 {
-	int i = 0, p = 0;
-	m_NumSortedServers = 0;
+	// the same folding str_find_nocase does, so str_find on the results matches it
+	int i = 0;
+	for(; i < DstSize - 1 && pSrc[i]; i++)
+		pDst[i] = tolower((unsigned char)pSrc[i]);
+	pDst[i] = 0;
+}
 
-	// allocate the sorted list
-	if(m_NumSortedServersCapacity < m_NumServers)
+void CServerBrowser::UpdateSearchKeys(CServerEntry *pEntry)
+{
+	const CServerInfo &Info = pEntry->m_Info;
+	StrToLower(pEntry->m_aLowerName, Info.m_aName, sizeof(pEntry->m_aLowerName));
+	StrToLower(pEntry->m_aLowerMap, Info.m_aMap, sizeof(pEntry->m_aLowerMap));
+	StrToLower(pEntry->m_aLowerGameType, Info.m_aGameType, sizeof(pEntry->m_aLowerGameType));
+	StrToLower(pEntry->m_aLowerAddress, Info.m_aAddress, sizeof(pEntry->m_aLowerAddress));
+	for(int p = 0; p < Info.m_NumClients; p++)
 	{
-		if(m_pSortedServerlist)
-			free(m_pSortedServerlist);
-		m_NumSortedServersCapacity = m_NumServers;
-		m_pSortedServerlist = (int *)calloc(m_NumSortedServersCapacity, sizeof(int));
+		StrToLower(pEntry->m_aaLowerClientNames[p], Info.m_aClients[p].m_aName, sizeof(pEntry->m_aaLowerClientNames[p]));
+		StrToLower(pEntry->m_aaLowerClientClans[p], Info.m_aClients[p].m_aClan, sizeof(pEntry->m_aaLowerClientClans[p]));
 	}
+}
 
-	// filter the servers
-	for(i = 0; i < m_NumServers; i++)
+bool CServerBrowser::IsFiltered(CServerEntry *pEntry) const
+{
+	CServerInfo &Info = pEntry->m_Info;
+	int Filtered = 0;
+
+	if(g_Config.m_BrFilterEmpty && Info.m_NumFilteredPlayers == 0)
+		Filtered = 1;
+	else if(g_Config.m_BrFilterFull && Players(Info) == Max(Info))
+		Filtered = 1;
+	else if(g_Config.m_BrFilterPw && Info.m_Flags & SERVER_FLAG_PASSWORD)
+		Filtered = 1;
+	else if(m_FilterPing && m_FilterPing < Info.m_Latency)
+		Filtered = 1;
+	else if(g_Config.m_BrFilterCompatversion && str_comp_num(Info.m_aVersion, m_aNetVersion, 3) != 0)
+		Filtered = 1;
+	else if(m_aLowerFilterServerAddressString[0] && !str_find(pEntry->m_aLowerAddress, m_aLowerFilterServerAddressString))
+		Filtered = 1;
+	else if(g_Config.m_BrFilterGametypeStrict && m_aFilterGametypeString[0] && str_comp_nocase(Info.m_aGameType, m_aFilterGametypeString))
+		Filtered = 1;
+	else if(!g_Config.m_BrFilterGametypeStrict && m_aLowerFilterGametypeString[0] && !str_find(pEntry->m_aLowerGameType, m_aLowerFilterGametypeString))
+		Filtered = 1;
+	else if(g_Config.m_BrFilterUnfinishedMap && Info.m_HasRank == 1)
+		Filtered = 1;
+	else
 	{
-		int Filtered = 0;
-
-		if(g_Config.m_BrFilterEmpty && m_ppServerlist[i]->m_Info.m_NumFilteredPlayers == 0)
-			Filtered = 1;
-		else if(g_Config.m_BrFilterFull && Players(m_ppServerlist[i]->m_Info) == Max(m_ppServerlist[i]->m_Info))
-			Filtered = 1;
-		else if(g_Config.m_BrFilterPw && m_ppServerlist[i]->m_Info.m_Flags & SERVER_FLAG_PASSWORD)
-			Filtered = 1;
-		else if(g_Config.m_BrFilterPing && g_Config.m_BrFilterPing < m_ppServerlist[i]->m_Info.m_Latency)
-			Filtered = 1;
-		else if(g_Config.m_BrFilterCompatversion && str_comp_num(m_ppServerlist[i]->m_Info.m_aVersion, m_aNetVersion, 3) != 0)
-			Filtered = 1;
-		else if(g_Config.m_BrFilterServerAddress[0] && !str_find_nocase(m_ppServerlist[i]->m_Info.m_aAddress, g_Config.m_BrFilterServerAddress))
-			Filtered = 1;
-		else if(g_Config.m_BrFilterGametypeStrict && g_Config.m_BrFilterGametype[0] && str_comp_nocase(m_ppServerlist[i]->m_Info.m_aGameType, g_Config.m_BrFilterGametype))
-			Filtered = 1;
-		else if(!g_Config.m_BrFilterGametypeStrict && g_Config.m_BrFilterGametype[0] && !str_find_nocase(m_ppServerlist[i]->m_Info.m_aGameType, g_Config.m_BrFilterGametype))
-			Filtered = 1;
-		else if(g_Config.m_BrFilterUnfinishedMap && m_ppServerlist[i]->m_Info.m_HasRank == 1)
-			Filtered = 1;
-		else
+		if(g_Config.m_BrFilterCountry)
 		{
-			if(g_Config.m_BrFilterCountry)
+			Filtered = 1;
+			// match against player country
+			for(int p = 0; p < Info.m_NumClients; p++)
 			{
-				Filtered = 1;
-				// match against player country
-				for(p = 0; p < m_ppServerlist[i]->m_Info.m_NumClients; p++)
+				if(Info.m_aClients[p].m_Country == m_FilterCountryIndex)
 				{
-					if(m_ppServerlist[i]->m_Info.m_aClients[p].m_Country == g_Config.m_BrFilterCountryIndex)
-					{
-						Filtered = 0;
-						break;
-					}
+					Filtered = 0;
+					break;
 				}
 			}
+		}
 
-			if(!Filtered && g_Config.m_BrFilterString[0] != 0)
-			{
-				int MatchFound = 0;
-
-				m_ppServerlist[i]->m_Info.m_QuickSearchHit = 0;
+		if(!Filtered && m_aLowerFilterString[0] != 0)
+		{
+			int MatchFound = 0;
 
-				// match against server name
-				if(str_find_nocase(m_ppServerlist[i]->m_Info.m_aName, g_Config.m_BrFilterString))
-				{
-					MatchFound = 1;
-					m_ppServerlist[i]->m_Info.m_QuickSearchHit |= IServerBrowser::QUICK_SERVERNAME;
-				}
+			Info.m_QuickSearchHit = 0;
 
-				// match against players
-				for(p = 0; p < m_ppServerlist[i]->m_Info.m_NumClients; p++)
-				{
-					if(str_find_nocase(m_ppServerlist[i]->m_Info.m_aClients[p].m_aName, g_Config.m_BrFilterString) ||
-						str_find_nocase(m_ppServerlist[i]->m_Info.m_aClients[p].m_aClan, g_Config.m_BrFilterString))
-					{
-						MatchFound = 1;
-						m_ppServerlist[i]->m_Info.m_QuickSearchHit |= IServerBrowser::QUICK_PLAYER;
-						break;
-					}
-				}
+			// match against server name
+			if(str_find(pEntry->m_aLowerName, m_aLowerFilterString))
+			{
+				MatchFound = 1;
+				Info.m_QuickSearchHit |= IServerBrowser::QUICK_SERVERNAME;
+			}
 
-				// match against map
-				if(str_find_nocase(m_ppServerlist[i]->m_Info.m_aMap, g_Config.m_BrFilterString))
+			// match against players
+			for(int p = 0; p < Info.m_NumClients; p++)
+			{
+				if(str_find(pEntry->m_aaLowerClientNames[p], m_aLowerFilterString) ||
+					str_find(pEntry->m_aaLowerClientClans[p], m_aLowerFilterString))
 				{
 					MatchFound = 1;
-					m_ppServerlist[i]->m_Info.m_QuickSearchHit |= IServerBrowser::QUICK_MAPNAME;
+					Info.m_QuickSearchHit |= IServerBrowser::QUICK_PLAYER;
+					break;
 				}
-
-				if(!MatchFound)
-					Filtered = 1;
 			}
 
-			if(!Filtered && g_Config.m_BrExcludeString[0] != 0)
+			// match against map
+			if(str_find(pEntry->m_aLowerMap, m_aLowerFilterString))
 			{
-				int MatchFound = 0;
+				MatchFound = 1;
+				Info.m_QuickSearchHit |= IServerBrowser::QUICK_MAPNAME;
+			}
 
-				// match against server name
-				if(str_find_nocase(m_ppServerlist[i]->m_Info.m_aName, g_Config.m_BrExcludeString))
-				{
-					MatchFound = 1;
-				}
+			if(!MatchFound)
+				Filtered = 1;
+		}
 
-				// match against map
-				if(str_find_nocase(m_ppServerlist[i]->m_Info.m_aMap, g_Config.m_BrExcludeString))
-				{
-					MatchFound = 1;
-				}
+		if(!Filtered && m_aLowerExcludeString[0] != 0)
+		{
+			// match against server name, map and gametype
+			if(str_find(pEntry->m_aLowerName, m_aLowerExcludeString) ||
+				str_find(pEntry->m_aLowerMap, m_aLowerExcludeString) ||
+				str_find(pEntry->m_aLowerGameType, m_aLowerExcludeString))
+				Filtered = 1;
+		}
+	}
 
-				// match against gametype
-				if(str_find_nocase(m_ppServerlist[i]->m_Info.m_aGameType, g_Config.m_BrExcludeString))
-				{
-					MatchFound = 1;
-				}
+	if(Filtered)
+		return true;
 
-				if(MatchFound)
-					Filtered = 1;
-			}
-		}
+	// check for friend
+	Info.m_FriendState = IFriends::FRIEND_NO;
+	for(int p = 0; p < Info.m_NumClients; p++)
+	{
+		Info.m_aClients[p].m_FriendState = m_pFriends->GetFriendState(Info.m_aClients[p].m_aName, Info.m_aClients[p].m_aClan);
+		Info.m_FriendState = maximum(Info.m_FriendState, Info.m_aClients[p].m_FriendState);
+	}
 
-		if(Filtered == 0)
-		{
-			// check for friend
-			m_ppServerlist[i]->m_Info.m_FriendState = IFriends::FRIEND_NO;
-			for(p = 0; p < m_ppServerlist[i]->m_Info.m_NumClients; p++)
-			{
-				m_ppServerlist[i]->m_Info.m_aClients[p].m_FriendState = m_pFriends->GetFriendState(m_ppServerlist[i]->m_Info.m_aClients[p].m_aName,
-					m_ppServerlist[i]->m_Info.m_aClients[p].m_aClan);
-				m_ppServerlist[i]->m_Info.m_FriendState = maximum(m_ppServerlist[i]->m_Info.m_FriendState, m_ppServerlist[i]->m_Info.m_aClients[p].m_FriendState);
-			}
+	return g_Config.m_BrFilterFriends && Info.m_FriendState == IFriends::FRIEND_NO;
+}
 
-			if(!g_Config.m_BrFilterFriends || m_ppServerlist[i]->m_Info.m_FriendState != IFriends::FRIEND_NO)
-				m_pSortedServerlist[m_NumSortedServers++] = i;
-		}
+void CServerBrowser::Filter()
+{
+	m_NumSortedServers = 0;
+
+	// allocate the sorted list
+	if(m_NumSortedServersCapacity < m_NumServers)
+	{
+		if(m_pSortedServerlist)
+			free(m_pSortedServerlist);
+		m_NumSortedServersCapacity = m_NumServers;
+		m_pSortedServerlist = (int *)calloc(m_NumSortedServersCapacity, sizeof(int));
+	}
+
+	// filter the servers
+	for(int i = 0; i < m_NumServers; i++)
+	{
+		m_ppServerlist[i]->m_Info.m_SortedIndex = -1;
+		if(!IsFiltered(m_ppServerlist[i]))
+			m_pSortedServerlist[m_NumSortedServers++] = i;
 	}
 }
 
@@ -320,6 +340,17 @@ int CServerBrowser::SortHash() const
 	return i;
 }
 
+bool CServerBrowser::FilterChanged() const
+{
+	return m_Sorthash != SortHash() ||
+		m_FilterPing != g_Config.m_BrFilterPing ||
+		m_FilterCountryIndex != g_Config.m_BrFilterCountryIndex ||
+		str_comp(m_aFilterString, g_Config.m_BrFilterString) != 0 ||
+		str_comp(m_aFilterGametypeString, g_Config.m_BrFilterGametype) != 0 ||
+		str_comp(m_aExcludeString, g_Config.m_BrExcludeString) != 0 ||
+		str_comp(m_aFilterServerAddressString, g_Config.m_BrFilterServerAddress) != 0;
+}
+
 void SetFilteredPlayers(const CServerInfo &Item)
 {
 	if(g_Config.m_BrFilterSpectators)
@@ -338,10 +369,40 @@ void SetFilteredPlayers(const CServerInfo &Item)
 	}
 }
 
+CServerBrowser::SortFunc CServerBrowser::SortFunction() const
+{
+	if(g_Config.m_BrSortOrder == 2 && (g_Config.m_BrSort == IServerBrowser::SORT_NUMPLAYERS || g_Config.m_BrSort == IServerBrowser::SORT_PING))
+		return &CServerBrowser::SortCompareNumPlayersAndPing;
+	else if(g_Config.m_BrSort == IServerBrowser::SORT_NAME)
+		return &CServerBrowser::SortCompareName;
+	else if(g_Config.m_BrSort == IServerBrowser::SORT_PING)
+		return &CServerBrowser::SortComparePing;
+	else if(g_Config.m_BrSort == IServerBrowser::SORT_MAP)
+		return &CServerBrowser::SortCompareMap;
+	else if(g_Config.m_BrSort == IServerBrowser::SORT_NUMPLAYERS)
+		return &CServerBrowser::SortCompareNumPlayers;
+	else if(g_Config.m_BrSort == IServerBrowser::SORT_GAMETYPE)
+		return &CServerBrowser::SortCompareGametype;
+	return 0;
+}
+
 void CServerBrowser::Sort()
 {
 	int i;
 
+	// remember the filter settings and fold the search strings once
+	str_copy(m_aFilterGametypeString, g_Config.m_BrFilterGametype, sizeof(m_aFilterGametypeString));
+	str_copy(m_aFilterString, g_Config.m_BrFilterString, sizeof(m_aFilterString));
+	str_copy(m_aExcludeString, g_Config.m_BrExcludeString, sizeof(m_aExcludeString));
+	str_copy(m_aFilterServerAddressString, g_Config.m_BrFilterServerAddress, sizeof(m_aFilterServerAddressString));
+	m_FilterPing = g_Config.m_BrFilterPing;
+	m_FilterCountryIndex = g_Config.m_BrFilterCountryIndex;
+	m_Sorthash = SortHash();
+	StrToLower(m_aLowerFilterGametypeString, m_aFilterGametypeString, sizeof(m_aLowerFilterGametypeString));
+	StrToLower(m_aLowerFilterString, m_aFilterString, sizeof(m_aLowerFilterString));
+	StrToLower(m_aLowerExcludeString, m_aExcludeString, sizeof(m_aLowerExcludeString));
+	StrToLower(m_aLowerFilterServerAddressString, m_aFilterServerAddressString, sizeof(m_aLowerFilterServerAddressString));
+
 	// fill m_NumFilteredPlayers
 	for(i = 0; i < m_NumServers; i++)
 	{
@@ -352,26 +413,75 @@ void CServerBrowser::Sort()
 	Filter();
 
 	// sort
-	if(g_Config.m_BrSortOrder == 2 && (g_Config.m_BrSort == IServerBrowser::SORT_NUMPLAYERS || g_Config.m_BrSort == IServerBrowser::SORT_PING))
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist + m_NumSortedServers, SortWrap(this, &CServerBrowser::SortCompareNumPlayersAndPing));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_NAME)
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist + m_NumSortedServers, SortWrap(this, &CServerBrowser::SortCompareName));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_PING)
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist + m_NumSortedServers, SortWrap(this, &CServerBrowser::SortComparePing));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_MAP)
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist + m_NumSortedServers, SortWrap(this, &CServerBrowser::SortCompareMap));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_NUMPLAYERS)
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist + m_NumSortedServers, SortWrap(this, &CServerBrowser::SortCompareNumPlayers));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_GAMETYPE)
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist + m_NumSortedServers, SortWrap(this, &CServerBrowser::SortCompareGametype));
+	SortFunc pfnSort = SortFunction();
+	if(pfnSort)
+		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist + m_NumSortedServers, SortWrap(this, pfnSort));
 
 	// set indexes
 	for(i = 0; i < m_NumSortedServers; i++)
 		m_ppServerlist[m_pSortedServerlist[i]]->m_Info.m_SortedIndex = i;
+}
+
+void CServerBrowser::RemoveSorted(CServerEntry *pEntry)
+{
+	int Index = pEntry->m_Info.m_SortedIndex;
+	if(Index < 0)
+		return;
+
+	m_NumSortedServers--;
+	for(int i = Index; i < m_NumSortedServers; i++)
+	{
+		m_pSortedServerlist[i] = m_pSortedServerlist[i + 1];
+		m_ppServerlist[m_pSortedServerlist[i]]->m_Info.m_SortedIndex = i;
+	}
+	pEntry->m_Info.m_SortedIndex = -1;
+}
 
-	str_copy(m_aFilterGametypeString, g_Config.m_BrFilterGametype, sizeof(m_aFilterGametypeString));
-	str_copy(m_aFilterString, g_Config.m_BrFilterString, sizeof(m_aFilterString));
-	m_Sorthash = SortHash();
+void CServerBrowser::InsertSorted(CServerEntry *pEntry)
+{
+	if(m_NumSortedServersCapacity < m_NumServers)
+	{
+		int *pNewList = (int *)calloc(m_NumServers, sizeof(int));
+		if(m_pSortedServerlist)
+		{
+			mem_copy(pNewList, m_pSortedServerlist, m_NumSortedServers * sizeof(int));
+			free(m_pSortedServerlist);
+		}
+		m_NumSortedServersCapacity = m_NumServers;
+		m_pSortedServerlist = pNewList;
+	}
+
+	// behind all equal entries, like a stable sort would place a new one
+	int *pEnd = m_pSortedServerlist + m_NumSortedServers;
+	int *pPos = pEnd;
+	SortFunc pfnSort = SortFunction();
+	if(pfnSort)
+		pPos = std::upper_bound(m_pSortedServerlist, pEnd, pEntry->m_Info.m_ServerIndex, SortWrap(this, pfnSort));
+
+	int Index = pPos - m_pSortedServerlist;
+	for(int i = m_NumSortedServers; i > Index; i--)
+	{
+		m_pSortedServerlist[i] = m_pSortedServerlist[i - 1];
+		m_ppServerlist[m_pSortedServerlist[i]]->m_Info.m_SortedIndex = i;
+	}
+	m_pSortedServerlist[Index] = pEntry->m_Info.m_ServerIndex;
+	pEntry->m_Info.m_SortedIndex = Index;
+	m_NumSortedServers++;
+}
+
+void CServerBrowser::UpdateSorted(CServerEntry *pEntry)
+{
+	// the list is rebuilt anyway if the filters changed
+	if(FilterChanged())
+	{
+		Sort();
+		return;
+	}
+
+	SetFilteredPlayers(pEntry->m_Info);
+	RemoveSorted(pEntry);
+	if(!IsFiltered(pEntry))
+		InsertSorted(pEntry);
 }
 
 void CServerBrowser::RemoveRequest(CServerEntry *pEntry)
@@ -423,9 +533,13 @@ void CServerBrowser::SetInfo(CServerEntry *pEntry, const CServerInfo &Info)
 {
 	bool Fav = pEntry->m_Info.m_Favorite;
 	bool Off = pEntry->m_Info.m_Official;
+	int SortedIndex = pEntry->m_Info.m_SortedIndex;
+	int ServerIndex = pEntry->m_Info.m_ServerIndex;
 	pEntry->m_Info = Info;
 	pEntry->m_Info.m_Favorite = Fav;
 	pEntry->m_Info.m_Official = Off;
+	pEntry->m_Info.m_SortedIndex = SortedIndex;
+	pEntry->m_Info.m_ServerIndex = ServerIndex;
 	pEntry->m_Info.m_NetAddr = pEntry->m_Addr;
 
 	// all these are just for nice compatibility
@@ -443,6 +557,7 @@ void CServerBrowser::SetInfo(CServerEntry *pEntry, const CServerInfo &Info)
 	}*/
 
 	pEntry->m_GotInfo = 1;
+	UpdateSearchKeys(pEntry);
 }
 
 CServerBrowser::CServerEntry *CServerBrowser::Add(const NETADDR &Addr)
@@ -461,8 +576,10 @@ CServerBrowser::CServerEntry *CServerBrowser::Add(const NETADDR &Addr)
 
 	pEntry->m_Info.m_Latency = 999;
 	pEntry->m_Info.m_HasRank = -1;
+	pEntry->m_Info.m_SortedIndex = -1;
 	net_addr_str(&Addr, pEntry->m_Info.m_aAddress, sizeof(pEntry->m_Info.m_aAddress), true);
 	str_copy(pEntry->m_Info.m_aName, pEntry->m_Info.m_aAddress, sizeof(pEntry->m_Info.m_aName));
+	UpdateSearchKeys(pEntry);
 
 	// check if it's a favorite
 	for(i = 0; i < m_NumFavoriteServers; i++)
@@ -616,7 +733,9 @@ void CServerBrowser::Set(const NETADDR &Addr, int Type, int Token, const CServer
 		RemoveRequest(pEntry);
 	}
 
-	Sort();
+	// only the changed entry needs to be filtered and moved
+	if(pEntry)
+		UpdateSorted(pEntry);
 }
 
 void CServerBrowser::Refresh(int Type)
@@ -976,7 +1095,7 @@ void CServerBrowser::Update(bool ForceResort)
 	}
 
 	// check if we need to resort
-	if(m_Sorthash != SortHash() || ForceResort)
+	if(FilterChanged() || ForceResort)
 		Sort();
 }
 
@@ -1158,6 +1277,9 @@ void CServerBrowser::LoadDDNetRanks()
 		if(m_ppServerlist[i]->m_Info.m_aMap[0])
 			m_ppServerlist[i]->m_Info.m_HasRank = HasRank(m_ppServerlist[i]->m_Info.m_aMap);
 	}
+
+	// the unfinished map filter depends on the ranks
+	Sort();
 }
 
 int CServerBrowser::HasRank(const char *pMap)
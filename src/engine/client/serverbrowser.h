@@ -22,6 +22,14 @@ public:
 		bool m_Request64Legacy;
 		CServerInfo m_Info;
 
+		// lowercase copies of the strings the filters search in, updated with the info
+		char m_aLowerName[sizeof(CServerInfo::m_aName)];
+		char m_aLowerMap[sizeof(CServerInfo::m_aMap)];
+		char m_aLowerGameType[sizeof(CServerInfo::m_aGameType)];
+		char m_aLowerAddress[sizeof(CServerInfo::m_aAddress)];
+		char m_aaLowerClientNames[MAX_CLIENTS][MAX_NAME_LENGTH];
+		char m_aaLowerClientClans[MAX_CLIENTS][MAX_CLAN_LENGTH];
+
 		CServerEntry *m_pNextIp; // ip hashed list
 
 		CServerEntry *m_pPrevReq; // request list
@@ -169,9 +177,20 @@ private:
 	int m_NumServers;
 	int m_NumServerCapacity;
 
+	// filter settings the sorted list was built with, see FilterChanged()
 	int m_Sorthash;
 	char m_aFilterString[64];
 	char m_aFilterGametypeString[128];
+	char m_aExcludeString[64];
+	char m_aFilterServerAddressString[128];
+	int m_FilterPing;
+	int m_FilterCountryIndex;
+
+	// lowercase filter strings for the cached lowercase search keys
+	char m_aLowerFilterString[64];
+	char m_aLowerFilterGametypeString[128];
+	char m_aLowerExcludeString[64];
+	char m_aLowerFilterServerAddressString[128];
 
 	int m_ServerlistType;
 	int64 m_BroadcastTime;
@@ -191,10 +210,21 @@ private:
 	bool SortCompareNumClients(int Index1, int Index2) const;
 	bool SortCompareNumPlayersAndPing(int Index1, int Index2) const;
 
+	typedef bool (CServerBrowser::*SortFunc)(int, int) const;
+	SortFunc SortFunction() const;
+
 	//
+	bool IsFiltered(CServerEntry *pEntry) const;
 	void Filter();
 	void Sort();
 	int SortHash() const;
+	bool FilterChanged() const;
+
+	// keep the sorted list up to date when a single entry changes
+	void UpdateSearchKeys(CServerEntry *pEntry);
+	void RemoveSorted(CServerEntry *pEntry);
+	void InsertSorted(CServerEntry *pEntry);
+	void UpdateSorted(CServerEntry *pEntry);
 
 	CServerEntry *Add(const NETADDR &Addr);
 
@@ -7,6 +7,8 @@
 #include <engine/storage.h>
 
 #include <engine/shared/config.h>
+#include <engine/shared/soundcache.h>
+#include <engine/shared/soundmixer.h>
 
 #include "SDL.h"
 
@@ -20,262 +22,38 @@ extern "C" {
 #include <wavpack.h>
 }
 #include <math.h>
+#include <thread>
 
 enum
 {
 	NUM_SAMPLES = 512,
-	NUM_VOICES = 256,
-	NUM_CHANNELS = 16,
 };
 
-struct CSample
-{
-	short *m_pData;
-	int m_NumFrames;
-	int m_Rate;
-	int m_Channels;
-	int m_LoopStart;
-	int m_LoopEnd;
-	int m_PausedAt;
-};
-
-struct CChannel
+enum
 {
-	int m_Vol;
-	int m_Pan;
+	SAMPLE_EMPTY = 0,
+	SAMPLE_LOADING,
+	SAMPLE_READY,
+	SAMPLE_FAILED,
+	// unloaded while the audio thread might still use it
+	SAMPLE_UNLOADING,
 };
 
-struct CVoice
-{
-	CSample *m_pSample;
-	CChannel *m_pChannel;
-	int m_Age; // increases when reused
-	int m_Tick;
-	int m_Vol; // 0 - 255
-	int m_Flags;
-	int m_X, m_Y;
-	float m_Falloff; // [0.0, 1.0]
-
-	int m_Shape;
-	union
-	{
-		ISound::CVoiceShapeCircle m_Circle;
-		ISound::CVoiceShapeRectangle m_Rectangle;
-	};
-};
+typedef CSoundMixer::CSample CSample;
 
 static CSample m_aSamples[NUM_SAMPLES] = {{0}};
-static CVoice m_aVoices[NUM_VOICES] = {{0}};
-static CChannel m_aChannels[NUM_CHANNELS] = {{255, 0}};
-
-static LOCK m_SoundLock = 0;
-
-static int m_CenterX = 0;
-static int m_CenterY = 0;
+static std::atomic<int> m_aSampleStates[NUM_SAMPLES];
+static std::shared_ptr<IJob> s_apDecodeJobs[NUM_SAMPLES];
+static CSoundMixer m_Mixer;
 
 static int m_MixingRate = 48000;
 static volatile int m_SoundVolume = 100;
 
-static int m_NextVoice = 0;
-static int *m_pMixBuffer = 0; // buffer only used by the thread callback function
-static unsigned m_MaxFrames = 0;
-
-static const void *s_pWVBuffer = 0x0;
-static int s_WVBufferPosition = 0;
-static int s_WVBufferSize = 0;
-
-const int DefaultDistance = 1500;
 int m_LastBreak = 0;
 
-// TODO: there should be a faster way todo this
-static short Int2Short(int i)
-{
-	if(i > 0x7fff)
-		return 0x7fff;
-	else if(i < -0x7fff)
-		return -0x7fff;
-	return i;
-}
-
-static int IntAbs(int i)
-{
-	if(i < 0)
-		return -i;
-	return i;
-}
-
 static void Mix(short *pFinalOut, unsigned Frames)
 {
-	int MasterVol;
-	mem_zero(m_pMixBuffer, m_MaxFrames * 2 * sizeof(int));
-	Frames = minimum(Frames, m_MaxFrames);
-
-	// acquire lock while we are mixing
-	lock_wait(m_SoundLock);
-
-	MasterVol = m_SoundVolume;
-
-	for(unsigned i = 0; i < NUM_VOICES; i++)
-	{
-		if(m_aVoices[i].m_pSample)
-		{
-			// mix voice
-			CVoice *v = &m_aVoices[i];
-			int *pOut = m_pMixBuffer;
-
-			int Step = v->m_pSample->m_Channels; // setup input sources
-			short *pInL = &v->m_pSample->m_pData[v->m_Tick * Step];
-			short *pInR = &v->m_pSample->m_pData[v->m_Tick * Step + 1];
-
-			unsigned End = v->m_pSample->m_NumFrames - v->m_Tick;
-
-			int Rvol = (int)(v->m_pChannel->m_Vol * (v->m_Vol / 255.0f));
-			int Lvol = (int)(v->m_pChannel->m_Vol * (v->m_Vol / 255.0f));
-
-			// make sure that we don't go outside the sound data
-			if(Frames < End)
-				End = Frames;
-
-			// check if we have a mono sound
-			if(v->m_pSample->m_Channels == 1)
-				pInR = pInL;
-
-			// volume calculation
-			if(v->m_Flags & ISound::FLAG_POS && v->m_pChannel->m_Pan)
-			{
-				// TODO: we should respect the channel panning value
-				int dx = v->m_X - m_CenterX;
-				int dy = v->m_Y - m_CenterY;
-				//
-				int p = IntAbs(dx);
-				float FalloffX = 0.0f;
-				float FalloffY = 0.0f;
-
-				int RangeX = 0; // for panning
-				bool InVoiceField = false;
-
-				switch(v->m_Shape)
-				{
-				case ISound::SHAPE_CIRCLE:
-				{
-					float r = v->m_Circle.m_Radius;
-					RangeX = r;
-
-					int Dist = (int)sqrtf((float)dx * dx + dy * dy); // nasty float
-					if(Dist < r)
-					{
-						InVoiceField = true;
-
-						// falloff
-						int FalloffDistance = r * v->m_Falloff;
-						if(Dist > FalloffDistance)
-							FalloffX = FalloffY = (r - Dist) / (r - FalloffDistance);
-						else
-							FalloffX = FalloffY = 1.0f;
-					}
-					else
-						InVoiceField = false;
-
-					break;
-				}
-
-				case ISound::SHAPE_RECTANGLE:
-				{
-					RangeX = v->m_Rectangle.m_Width / 2.0f;
-
-					int abs_dx = abs(dx);
-					int abs_dy = abs(dy);
-
-					int w = v->m_Rectangle.m_Width / 2.0f;
-					int h = v->m_Rectangle.m_Height / 2.0f;
-
-					if(abs_dx < w && abs_dy < h)
-					{
-						InVoiceField = true;
-
-						// falloff
-						int fx = v->m_Falloff * w;
-						int fy = v->m_Falloff * h;
-
-						FalloffX = abs_dx > fx ? (float)(w - abs_dx) / (w - fx) : 1.0f;
-						FalloffY = abs_dy > fy ? (float)(h - abs_dy) / (h - fy) : 1.0f;
-					}
-					else
-						InVoiceField = false;
-
-					break;
-				}
-				};
-
-				if(InVoiceField)
-				{
-					// panning
-					if(!(v->m_Flags & ISound::FLAG_NO_PANNING))
-					{
-						if(dx > 0)
-							Lvol = ((RangeX - p) * Lvol) / RangeX;
-						else
-							Rvol = ((RangeX - p) * Rvol) / RangeX;
-					}
-
-					{
-						Lvol *= FalloffX * FalloffY;
-						Rvol *= FalloffX * FalloffY;
-					}
-				}
-				else
-				{
-					Lvol = 0;
-					Rvol = 0;
-				}
-			}
-
-			// process all frames
-			for(unsigned s = 0; s < End; s++)
-			{
-				*pOut++ += (*pInL) * Lvol;
-				*pOut++ += (*pInR) * Rvol;
-				pInL += Step;
-				pInR += Step;
-				v->m_Tick++;
-			}
-
-			// free voice if not used any more
-			if(v->m_Tick == v->m_pSample->m_NumFrames)
-			{
-				if(v->m_Flags & ISound::FLAG_LOOP)
-					v->m_Tick = 0;
-				else
-				{
-					v->m_pSample = 0;
-					v->m_Age++;
-				}
-			}
-		}
-	}
-
-	// release the lock
-	lock_unlock(m_SoundLock);
-
-	{
-		// clamp accumulated values
-		// TODO: this seams slow
-		for(unsigned i = 0; i < Frames; i++)
-		{
-			int j = i << 1;
-			int vl = ((m_pMixBuffer[j] * MasterVol) / 101) >> 8;
-			int vr = ((m_pMixBuffer[j + 1] * MasterVol) / 101) >> 8;
-
-			pFinalOut[j] = Int2Short(vl);
-			pFinalOut[j + 1] = Int2Short(vr);
-
-			// dbg_msg("sound", "the real shit: %d %d", pFinalOut[j], pFinalOut[j+1]);
-		}
-	}
-
-#if defined(CONF_ARCH_ENDIAN_BIG)
-	swap_endian(pFinalOut, sizeof(short), Frames * 2);
-#endif
+	m_Mixer.Mix(pFinalOut, Frames);
 }
 
 static void SdlCallback(void *pUnused, Uint8 *pStream, int Len)
@@ -299,8 +77,6 @@ int CSound::Init()
 
 	SDL_AudioSpec Format, FormatOut;
 
-	m_SoundLock = lock_create();
-
 	if(!g_Config.m_SndEnable)
 		return 0;
 
@@ -331,8 +107,13 @@ int CSound::Init()
 	else
 		dbg_msg("client/sound", "sound init successful using audio driver '%s'", SDL_GetCurrentAudioDriver());
 
-	m_MaxFrames = FormatOut.samples * 2;
-	m_pMixBuffer = (int *)calloc(m_MaxFrames * 2, sizeof(int));
+	m_Mixer.Init(FormatOut.samples * 2);
+	m_DecodePool.Init(clamp((int)std::thread::hardware_concurrency() - 1, 1, 4));
+	if(g_Config.m_SndDecodeCache)
+	{
+		m_pStorage->CreateFolder("soundcache", IStorage::TYPE_SAVE);
+		CSoundCache::Prune(m_pStorage, "soundcache", (int64)g_Config.m_SndDecodeCacheSize * 1024 * 1024);
+	}
 
 	SDL_PauseAudioDevice(m_Device, 0);
 
@@ -351,10 +132,10 @@ int CSound::Update()
 
 	if(WantedVolume != m_SoundVolume)
 	{
-		lock_wait(m_SoundLock);
 		m_SoundVolume = WantedVolume;
-		lock_unlock(m_SoundLock);
+		m_Mixer.SetVolume(WantedVolume);
 	}
+	m_Mixer.Flush();
 	//#if defined(CONF_VIDEORECORDER)
 	//	if(IVideo::Current() && g_Config.m_ClVideoSndEnable)
 	//		IVideo::Current()->NextAudioFrame(Mix);
@@ -364,16 +145,20 @@ int CSound::Update()
 
 int CSound::Shutdown()
 {
+	// the audio thread is gone after this, so the samples can go right away
+	SDL_CloseAudioDevice(m_Device);
+	SDL_QuitSubSystem(SDL_INIT_AUDIO);
+	m_Mixer.Shutdown();
+	m_SoundEnabled = 0;
+
 	for(unsigned SampleID = 0; SampleID < NUM_SAMPLES; SampleID++)
 	{
 		UnloadSample(SampleID);
 	}
 
-	SDL_CloseAudioDevice(m_Device);
-	SDL_QuitSubSystem(SDL_INIT_AUDIO);
-	lock_destroy(m_SoundLock);
-	free(m_pMixBuffer);
-	m_pMixBuffer = 0;
+	// the sounds decoded in this session may have filled the cache
+	if(g_Config.m_SndDecodeCache && m_pStorage)
+		CSoundCache::Prune(m_pStorage, "soundcache", (int64)g_Config.m_SndDecodeCacheSize * 1024 * 1024);
 	return 0;
 }
 
@@ -382,25 +167,25 @@ int CSound::AllocID()
 	// TODO: linear search, get rid of it
 	for(unsigned SampleID = 0; SampleID < NUM_SAMPLES; SampleID++)
 	{
-		if(m_aSamples[SampleID].m_pData == 0x0)
+		int State = SAMPLE_EMPTY;
+		if(m_aSampleStates[SampleID].compare_exchange_strong(State, SAMPLE_LOADING))
 			return SampleID;
 	}
 
 	return -1;
 }
 
-void CSound::RateConvert(int SampleID)
+static void RateConvert(CSample *pSample, int Rate)
 {
-	CSample *pSample = &m_aSamples[SampleID];
 	int NumFrames = 0;
 	short *pNewData = 0;
 
 	// make sure that we need to convert this sound
-	if(!pSample->m_pData || pSample->m_Rate == m_MixingRate)
+	if(!pSample->m_pData || pSample->m_Rate == Rate)
 		return;
 
 	// allocate new data
-	NumFrames = (int)((pSample->m_NumFrames / (float)pSample->m_Rate) * m_MixingRate);
+	NumFrames = (int)((pSample->m_NumFrames / (float)pSample->m_Rate) * Rate);
 	pNewData = (short *)calloc(NumFrames * pSample->m_Channels, sizeof(short));
 
 	for(int i = 0; i < NumFrames; i++)
@@ -425,16 +210,11 @@ void CSound::RateConvert(int SampleID)
 	free(pSample->m_pData);
 	pSample->m_pData = pNewData;
 	pSample->m_NumFrames = NumFrames;
-	pSample->m_Rate = m_MixingRate;
+	pSample->m_Rate = Rate;
 }
 
-int CSound::DecodeOpus(int SampleID, const void *pData, unsigned DataSize)
+static bool DecodeOpus(CSample *pSample, const void *pData, unsigned DataSize)
 {
-	if(SampleID == -1 || SampleID >= NUM_SAMPLES)
-		return -1;
-
-	CSample *pSample = &m_aSamples[SampleID];
-
 	OggOpusFile *OpusFile = op_open_memory((const unsigned char *)pData, DataSize, NULL);
 	if(OpusFile)
 	{
@@ -446,7 +226,8 @@ int CSound::DecodeOpus(int SampleID, const void *pData, unsigned DataSize)
 		if(pSample->m_Channels > 2)
 		{
 			dbg_msg("sound/opus", "file is not mono or stereo.");
-			return -1;
+			op_free(OpusFile);
+			return false;
 		}
 
 		pSample->m_pData = (short *)calloc(NumSamples * NumChannels, sizeof(short));
@@ -455,9 +236,19 @@ int CSound::DecodeOpus(int SampleID, const void *pData, unsigned DataSize)
 		int Pos = 0;
 		while(Pos < NumSamples)
 		{
-			Read = op_read(OpusFile, pSample->m_pData + Pos * NumChannels, NumSamples * NumChannels, NULL);
+			Read = op_read(OpusFile, pSample->m_pData + Pos * NumChannels, (NumSamples - Pos) * NumChannels, NULL);
+			if(Read < 0)
+			{
+				dbg_msg("sound/opus", "failed to decode sample (%d)", Read);
+				free(pSample->m_pData);
+				op_free(OpusFile);
+				return false;
+			}
+			else if(Read == 0)
+				break;
 			Pos += Read;
 		}
+		op_free(OpusFile);
 
 		pSample->m_NumFrames = NumSamples; // ?
 		pSample->m_Rate = 48000;
@@ -468,25 +259,32 @@ int CSound::DecodeOpus(int SampleID, const void *pData, unsigned DataSize)
 	else
 	{
 		dbg_msg("sound/opus", "failed to decode sample");
-		return -1;
+		return false;
 	}
 
-	return SampleID;
+	return true;
 }
 
-static int ReadDataOld(void *pBuffer, int Size)
+// the encoded file a wavpack context reads from
+struct CWVReader
 {
-	int ChunkSize = minimum(Size, s_WVBufferSize - s_WVBufferPosition);
-	mem_copy(pBuffer, (const char *)s_pWVBuffer + s_WVBufferPosition, ChunkSize);
-	s_WVBufferPosition += ChunkSize;
+	const char *m_pData;
+	int m_Size;
+	int m_Position;
+};
+
+static int ReadDataOld(CWVReader *pReader, void *pBuffer, int Size)
+{
+	int ChunkSize = minimum(Size, pReader->m_Size - pReader->m_Position);
+	mem_copy(pBuffer, pReader->m_pData + pReader->m_Position, ChunkSize);
+	pReader->m_Position += ChunkSize;
 	return ChunkSize;
 }
 
 #if defined(CONF_WAVPACK_OPEN_FILE_INPUT_EX)
 static int ReadData(void *pId, void *pBuffer, int Size)
 {
-	(void)pId;
-	return ReadDataOld(pBuffer, Size);
+	return ReadDataOld((CWVReader *)pId, pBuffer, Size);
 }
 
 static int ReturnFalse(void *pId)
@@ -497,35 +295,38 @@ static int ReturnFalse(void *pId)
 
 static unsigned int GetPos(void *pId)
 {
-	(void)pId;
-	return s_WVBufferPosition;
+	return ((CWVReader *)pId)->m_Position;
 }
 
 static unsigned int GetLength(void *pId)
 {
-	(void)pId;
-	return s_WVBufferSize;
+	return ((CWVReader *)pId)->m_Size;
 }
 
 static int PushBackByte(void *pId, int Char)
 {
-	s_WVBufferPosition -= 1;
+	((CWVReader *)pId)->m_Position -= 1;
 	return 0;
 }
-#endif
+#else
+// the old api has no user pointer, samples are decoded on several threads
+static thread_local CWVReader *s_pWVReader = 0;
 
-int CSound::DecodeWV(int SampleID, const void *pData, unsigned DataSize)
+static int ReadDataThread(void *pBuffer, int Size)
 {
-	if(SampleID == -1 || SampleID >= NUM_SAMPLES)
-		return -1;
+	return ReadDataOld(s_pWVReader, pBuffer, Size);
+}
+#endif
 
-	CSample *pSample = &m_aSamples[SampleID];
+static bool DecodeWV(CSample *pSample, const void *pData, unsigned DataSize)
+{
 	char aError[100];
 	WavpackContext *pContext;
 
-	s_pWVBuffer = pData;
-	s_WVBufferSize = DataSize;
-	s_WVBufferPosition = 0;
+	CWVReader Reader;
+	Reader.m_pData = (const char *)pData;
+	Reader.m_Size = DataSize;
+	Reader.m_Position = 0;
 
 #if defined(CONF_WAVPACK_OPEN_FILE_INPUT_EX)
 	WavpackStreamReader Callback = {0};
@@ -534,9 +335,10 @@ int CSound::DecodeWV(int SampleID, const void *pData, unsigned DataSize)
 	Callback.get_pos = GetPos;
 	Callback.push_back_byte = PushBackByte;
 	Callback.read_bytes = ReadData;
-	pContext = WavpackOpenFileInputEx(&Callback, (void *)1, 0, aError, 0, 0);
+	pContext = WavpackOpenFileInputEx(&Callback, &Reader, 0, aError, 0, 0);
 #else
-	pContext = WavpackOpenFileInput(ReadDataOld, aError);
+	s_pWVReader = &Reader;
+	pContext = WavpackOpenFileInput(ReadDataThread, aError);
 #endif
 	if(pContext)
 	{
@@ -551,16 +353,16 @@ int CSound::DecodeWV(int SampleID, const void *pData, unsigned DataSize)
 		pSample->m_Channels = NumChannels;
 		pSample->m_Rate = SampleRate;
 
-		if(pSample->m_Channels > 2)
-		{
-			dbg_msg("sound/wv", "file is not mono or stereo.");
-			return -1;
-		}
-
-		if(BitsPerSample != 16)
+		if(pSample->m_Channels > 2 || BitsPerSample != 16)
 		{
-			dbg_msg("sound/wv", "bps is %d, not 16", BitsPerSample);
-			return -1;
+			if(pSample->m_Channels > 2)
+				dbg_msg("sound/wv", "file is not mono or stereo.");
+			else
+				dbg_msg("sound/wv", "bps is %d, not 16", BitsPerSample);
+#ifdef CONF_WAVPACK_CLOSE_FILE
+			WavpackCloseFile(pContext);
+#endif
+			return false;
 		}
 
 		int *pBuffer = (int *)calloc(NumSamples * NumChannels, sizeof(int));
@@ -586,62 +388,130 @@ int CSound::DecodeWV(int SampleID, const void *pData, unsigned DataSize)
 	else
 	{
 		dbg_msg("sound/wv", "failed to decode sample (%s)", aError);
-		return -1;
+		return false;
 	}
 
-	return SampleID;
+	return true;
 }
 
-int CSound::LoadOpus(const char *pFilename)
+// decodes and converts the sample to the mixing rate, or takes it from the
+// cache if there is a storage for it
+static bool DecodeSample(CSample *pSample, int SampleID, int Format, const void *pData, unsigned DataSize, IStorage *pCacheStorage)
 {
-	// don't waste memory on sound when we are stress testing
-#ifdef CONF_DEBUG
-	if(g_Config.m_DbgStress)
-		return -1;
-#endif
-
-	// no need to load sound when we are running with no sound
-	if(!m_SoundEnabled)
-		return -1;
+	mem_zero(pSample, sizeof(*pSample));
 
-	if(!m_pStorage)
-		return -1;
+	SHA256_DIGEST Hash;
+	char aCacheFile[MAX_PATH_LENGTH];
+	if(pCacheStorage)
+	{
+		Hash = sha256(pData, DataSize);
+		CSoundCache::Filename(Hash, m_MixingRate, aCacheFile, sizeof(aCacheFile));
+		IOHANDLE File = pCacheStorage->OpenFile(aCacheFile, IOFLAG_READ, IStorage::TYPE_SAVE);
+		if(File)
+		{
+			bool Cached = CSoundCache::Load(File, Hash, m_MixingRate, pSample);
+			io_close(File);
+			if(Cached)
+				return true;
+		}
+	}
 
-	IOHANDLE File = m_pStorage->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_ALL);
-	if(!File)
+	bool Success = Format == CSound::FORMAT_OPUS ? DecodeOpus(pSample, pData, DataSize) : DecodeWV(pSample, pData, DataSize);
+	if(!Success)
 	{
-		dbg_msg("sound/opus", "failed to open file. filename='%s'", pFilename);
-		return -1;
+		mem_zero(pSample, sizeof(*pSample));
+		return false;
 	}
+	RateConvert(pSample, m_MixingRate);
 
-	int SampleID = AllocID();
-	int DataSize = io_length(File);
-	if(SampleID < 0 || DataSize <= 0)
+	if(pCacheStorage)
 	{
-		io_close(File);
-		File = NULL;
-		dbg_msg("sound/opus", "failed to open file. filename='%s'", pFilename);
-		return -1;
+		// the same sound can be decoded into two samples at once, so every
+		// sample gets its own temporary file
+		char aTmpFile[MAX_PATH_LENGTH];
+		str_format(aTmpFile, sizeof(aTmpFile), "%s.%d.tmp", aCacheFile, SampleID);
+		IOHANDLE File = pCacheStorage->OpenFile(aTmpFile, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+		bool Saved = false;
+		if(File)
+		{
+			Saved = CSoundCache::Save(File, Hash, pSample);
+			io_close(File);
+		}
+		if(!Saved || !pCacheStorage->RenameFile(aTmpFile, aCacheFile, IStorage::TYPE_SAVE))
+		{
+			pCacheStorage->RemoveFile(aTmpFile, IStorage::TYPE_SAVE);
+			dbg_msg("sound", "failed to save '%s'", aCacheFile);
+		}
 	}
+	return true;
+}
+
+static void PublishSample(int SampleID, const CSample &Sample, bool Success)
+{
+	if(Success)
+		m_aSamples[SampleID] = Sample;
+	// Play only hands ready samples to the mixer, so the sample is complete
+	// before anyone can use it
+	m_aSampleStates[SampleID] = Success ? SAMPLE_READY : SAMPLE_FAILED;
+}
 
-	// read the whole file into memory
-	char *pData = new char[DataSize];
-	io_read(File, pData, DataSize);
+class CSoundDecodeJob : public IJob
+{
+	int m_SampleID;
+	int m_Format;
+	IOHANDLE m_File;
+	std::vector<unsigned char> m_vData;
+	IStorage *m_pCacheStorage;
 
-	SampleID = DecodeOpus(SampleID, pData, DataSize);
+	void Run()
+	{
+		if(m_File)
+		{
+			m_vData.resize(io_length(m_File));
+			m_vData.resize(io_read(m_File, &m_vData[0], m_vData.size()));
+			io_close(m_File);
+			m_File = 0;
+		}
 
-	delete[] pData;
-	io_close(File);
-	File = NULL;
+		CSample Sample;
+		bool Success = DecodeSample(&Sample, m_SampleID, m_Format, m_vData.data(), m_vData.size(), m_pCacheStorage);
+		PublishSample(m_SampleID, Sample, Success);
+		m_vData.clear();
+	}
 
-	if(g_Config.m_Debug)
-		dbg_msg("sound/opus", "loaded %s", pFilename);
+public:
+	// takes the file, or copies the data if there is no file
+	CSoundDecodeJob(int SampleID, int Format, IOHANDLE File, const void *pData, unsigned DataSize, IStorage *pCacheStorage) :
+		m_SampleID(SampleID),
+		m_Format(Format),
+		m_File(File),
+		m_pCacheStorage(pCacheStorage)
+	{
+		if(!File)
+			m_vData.assign((const unsigned char *)pData, (const unsigned char *)pData + DataSize);
+	}
+};
+
+void CSound::DecodeAsync(int SampleID, int Format, IOHANDLE File, const void *pData, unsigned DataSize)
+{
+	IStorage *pCacheStorage = g_Config.m_SndDecodeCache ? m_pStorage : 0;
+	s_apDecodeJobs[SampleID] = std::make_shared<CSoundDecodeJob>(SampleID, Format, File, pData, DataSize, pCacheStorage);
+	m_DecodePool.Add(s_apDecodeJobs[SampleID]);
+}
 
-	RateConvert(SampleID);
+int CSound::DecodeNow(int SampleID, int Format, const void *pData, unsigned DataSize)
+{
+	CSample Sample;
+	if(!DecodeSample(&Sample, SampleID, Format, pData, DataSize, 0))
+	{
+		m_aSampleStates[SampleID] = SAMPLE_EMPTY;
+		return -1;
+	}
+	PublishSample(SampleID, Sample, true);
 	return SampleID;
 }
 
-int CSound::LoadWV(const char *pFilename)
+int CSound::LoadFile(const char *pFilename, int Format, const char *pLogSystem)
 {
 	// don't waste memory on sound when we are stress testing
 #ifdef CONF_DEBUG
@@ -659,38 +529,29 @@ int CSound::LoadWV(const char *pFilename)
 	IOHANDLE File = m_pStorage->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_ALL);
 	if(!File)
 	{
-		dbg_msg("sound/wv", "failed to open file. filename='%s'", pFilename);
+		dbg_msg(pLogSystem, "failed to open file. filename='%s'", pFilename);
 		return -1;
 	}
 
-	int SampleID = AllocID();
 	int DataSize = io_length(File);
-	if(SampleID < 0 || DataSize <= 0)
+	int SampleID = DataSize > 0 ? AllocID() : -1;
+	if(SampleID < 0)
 	{
 		io_close(File);
 		File = NULL;
-		dbg_msg("sound/wv", "failed to open file. filename='%s'", pFilename);
+		dbg_msg(pLogSystem, "failed to open file. filename='%s'", pFilename);
 		return -1;
 	}
 
-	// read the whole file into memory
-	char *pData = new char[DataSize];
-	io_read(File, pData, DataSize);
-
-	SampleID = DecodeWV(SampleID, pData, DataSize);
-
-	delete[] pData;
-	io_close(File);
-	File = NULL;
+	// the file is read and decoded on the pool
+	DecodeAsync(SampleID, Format, File, 0, 0);
 
 	if(g_Config.m_Debug)
-		dbg_msg("sound/wv", "loaded %s", pFilename);
-
-	RateConvert(SampleID);
+		dbg_msg(pLogSystem, "loading %s", pFilename);
 	return SampleID;
 }
 
-int CSound::LoadOpusFromMem(const void *pData, unsigned DataSize, bool FromEditor = false)
+int CSound::LoadMem(const void *pData, unsigned DataSize, bool FromEditor, int Format)
 {
 	// don't waste memory on sound when we are stress testing
 #ifdef CONF_DEBUG
@@ -709,51 +570,80 @@ int CSound::LoadOpusFromMem(const void *pData, unsigned DataSize, bool FromEdito
 	if(SampleID < 0)
 		return -1;
 
-	SampleID = DecodeOpus(SampleID, pData, DataSize);
+	// the editor needs to know right away whether the sound is valid
+	if(FromEditor)
+		return DecodeNow(SampleID, Format, pData, DataSize);
 
-	RateConvert(SampleID);
+	DecodeAsync(SampleID, Format, 0, pData, DataSize);
 	return SampleID;
 }
 
-int CSound::LoadWVFromMem(const void *pData, unsigned DataSize, bool FromEditor = false)
+int CSound::LoadOpus(const char *pFilename)
 {
-	// don't waste memory on sound when we are stress testing
-#ifdef CONF_DEBUG
-	if(g_Config.m_DbgStress)
-		return -1;
-#endif
-
-	// no need to load sound when we are running with no sound
-	if(!m_SoundEnabled && !FromEditor)
-		return -1;
-
-	if(!pData)
-		return -1;
+	return LoadFile(pFilename, FORMAT_OPUS, "sound/opus");
+}
 
-	int SampleID = AllocID();
-	if(SampleID < 0)
-		return -1;
+int CSound::LoadWV(const char *pFilename)
+{
+	return LoadFile(pFilename, FORMAT_WV, "sound/wv");
+}
 
-	SampleID = DecodeWV(SampleID, pData, DataSize);
+int CSound::LoadOpusFromMem(const void *pData, unsigned DataSize, bool FromEditor = false)
+{
+	return LoadMem(pData, DataSize, FromEditor, FORMAT_OPUS);
+}
 
-	RateConvert(SampleID);
-	return SampleID;
+int CSound::LoadWVFromMem(const void *pData, unsigned DataSize, bool FromEditor = false)
+{
+	return LoadMem(pData, DataSize, FromEditor, FORMAT_WV);
 }
 
 void CSound::UnloadSample(int SampleID)
 {
-	if(SampleID == -1 || SampleID >= NUM_SAMPLES)
+	if(SampleID < 0 || SampleID >= NUM_SAMPLES)
+		return;
+
+	// the decode job writes to the sample, it has to finish first
+	if(s_apDecodeJobs[SampleID])
+	{
+		m_DecodePool.Wait(s_apDecodeJobs[SampleID]);
+		s_apDecodeJobs[SampleID] = nullptr;
+	}
+
+	int State = m_aSampleStates[SampleID];
+	if(State == SAMPLE_EMPTY)
 		return;
 
-	Stop(SampleID);
+	if(State == SAMPLE_READY || State == SAMPLE_UNLOADING)
+	{
+		// the audio thread must be done with the sample before it's freed,
+		// else keep it and try again on the next unload or the shutdown
+		Stop(SampleID);
+		if(!m_Mixer.Sync(1000))
+		{
+			dbg_msg("sound", "audio thread didn't release sample %d in time, keeping it", SampleID);
+			m_aSampleStates[SampleID] = SAMPLE_UNLOADING;
+			return;
+		}
+	}
 	free(m_aSamples[SampleID].m_pData);
+	mem_zero(&m_aSamples[SampleID], sizeof(CSample));
+	m_aSampleStates[SampleID] = SAMPLE_EMPTY;
+}
+
+bool CSound::IsSampleReady(int SampleID)
+{
+	return SampleID >= 0 && SampleID < NUM_SAMPLES && m_aSampleStates[SampleID] == SAMPLE_READY;
+}
 
-	m_aSamples[SampleID].m_pData = 0x0;
+bool CSound::IsSampleFailed(int SampleID)
+{
+	return SampleID >= 0 && SampleID < NUM_SAMPLES && m_aSampleStates[SampleID] == SAMPLE_FAILED;
 }
 
 float CSound::GetSampleDuration(int SampleID)
 {
-	if(SampleID == -1 || SampleID >= NUM_SAMPLES)
+	if(!IsSampleReady(SampleID))
 		return 0.0f;
 
 	return (m_aSamples[SampleID].m_NumFrames / m_aSamples[SampleID].m_Rate);
@@ -761,8 +651,7 @@ float CSound::GetSampleDuration(int SampleID)
 
 void CSound::SetListenerPos(float x, float y)
 {
-	m_CenterX = (int)x;
-	m_CenterY = (int)y;
+	m_Mixer.SetListenerPos(x, y);
 }
 
 void CSound::SetVoiceVolume(CVoiceHandle Voice, float Volume)
@@ -770,13 +659,7 @@ void CSound::SetVoiceVolume(CVoiceHandle Voice, float Volume)
 	if(!Voice.IsValid())
 		return;
 
-	int VoiceID = Voice.Id();
-
-	if(m_aVoices[VoiceID].m_Age != Voice.Age())
-		return;
-
-	Volume = clamp(Volume, 0.0f, 1.0f);
-	m_aVoices[VoiceID].m_Vol = (int)(Volume * 255.0f);
+	m_Mixer.SetVoiceVolume(Voice.Id(), Voice.Age(), Volume);
 }
 
 void CSound::SetVoiceFalloff(CVoiceHandle Voice, float Falloff)
@@ -784,13 +667,7 @@ void CSound::SetVoiceFalloff(CVoiceHandle Voice, float Falloff)
 	if(!Voice.IsValid())
 		return;
 
-	int VoiceID = Voice.Id();
-
-	if(m_aVoices[VoiceID].m_Age != Voice.Age())
-		return;
-
-	Falloff = clamp(Falloff, 0.0f, 1.0f);
-	m_aVoices[VoiceID].m_Falloff = Falloff;
+	m_Mixer.SetVoiceFalloff(Voice.Id(), Voice.Age(), Falloff);
 }
 
 void CSound::SetVoiceLocation(CVoiceHandle Voice, float x, float y)
@@ -798,13 +675,7 @@ void CSound::SetVoiceLocation(CVoiceHandle Voice, float x, float y)
 	if(!Voice.IsValid())
 		return;
 
-	int VoiceID = Voice.Id();
-
-	if(m_aVoices[VoiceID].m_Age != Voice.Age())
-		return;
-
-	m_aVoices[VoiceID].m_X = x;
-	m_aVoices[VoiceID].m_Y = y;
+	m_Mixer.SetVoiceLocation(Voice.Id(), Voice.Age(), x, y);
 }
 
 void CSound::SetVoiceTimeOffset(CVoiceHandle Voice, float offset)
@@ -812,36 +683,7 @@ void CSound::SetVoiceTimeOffset(CVoiceHandle Voice, float offset)
 	if(!Voice.IsValid())
 		return;
 
-	int VoiceID = Voice.Id();
-
-	if(m_aVoices[VoiceID].m_Age != Voice.Age())
-		return;
-
-	lock_wait(m_SoundLock);
-	{
-		if(m_aVoices[VoiceID].m_pSample)
-		{
-			int Tick = 0;
-			bool IsLooping = m_aVoices[VoiceID].m_Flags & ISound::FLAG_LOOP;
-			uint64 TickOffset = m_aVoices[VoiceID].m_pSample->m_Rate * offset;
-			if(m_aVoices[VoiceID].m_pSample->m_NumFrames > 0 && IsLooping)
-				Tick = TickOffset % m_aVoices[VoiceID].m_pSample->m_NumFrames;
-			else
-				Tick = clamp(TickOffset, (uint64)0, (uint64)m_aVoices[VoiceID].m_pSample->m_NumFrames);
-
-			// at least 200msec off, else depend on buffer size
-			float Threshold = maximum(0.2f * m_aVoices[VoiceID].m_pSample->m_Rate, (float)m_MaxFrames);
-			if(abs(m_aVoices[VoiceID].m_Tick - Tick) > Threshold)
-			{
-				// take care of looping (modulo!)
-				if(!(IsLooping && (minimum(m_aVoices[VoiceID].m_Tick, Tick) + m_aVoices[VoiceID].m_pSample->m_NumFrames - maximum(m_aVoices[VoiceID].m_Tick, Tick)) <= Threshold))
-				{
-					m_aVoices[VoiceID].m_Tick = Tick;
-				}
-			}
-		}
-	}
-	lock_unlock(m_SoundLock);
+	m_Mixer.SetVoiceTimeOffset(Voice.Id(), Voice.Age(), offset);
 }
 
 void CSound::SetVoiceCircle(CVoiceHandle Voice, float Radius)
@@ -849,13 +691,7 @@ void CSound::SetVoiceCircle(CVoiceHandle Voice, float Radius)
 	if(!Voice.IsValid())
 		return;
 
-	int VoiceID = Voice.Id();
-
-	if(m_aVoices[VoiceID].m_Age != Voice.Age())
-		return;
-
-	m_aVoices[VoiceID].m_Shape = ISound::SHAPE_CIRCLE;
-	m_aVoices[VoiceID].m_Circle.m_Radius = maximum(0.0f, Radius);
+	m_Mixer.SetVoiceCircle(Voice.Id(), Voice.Age(), Radius);
 }
 
 void CSound::SetVoiceRectangle(CVoiceHandle Voice, float Width, float Height)
@@ -863,62 +699,22 @@ void CSound::SetVoiceRectangle(CVoiceHandle Voice, float Width, float Height)
 	if(!Voice.IsValid())
 		return;
 
-	int VoiceID = Voice.Id();
-
-	if(m_aVoices[VoiceID].m_Age != Voice.Age())
-		return;
-
-	m_aVoices[VoiceID].m_Shape = ISound::SHAPE_RECTANGLE;
-	m_aVoices[VoiceID].m_Rectangle.m_Width = maximum(0.0f, Width);
-	m_aVoices[VoiceID].m_Rectangle.m_Height = maximum(0.0f, Height);
+	m_Mixer.SetVoiceRectangle(Voice.Id(), Voice.Age(), Width, Height);
 }
 
 void CSound::SetChannel(int ChannelID, float Vol, float Pan)
 {
-	m_aChannels[ChannelID].m_Vol = (int)(Vol * 255.0f);
-	m_aChannels[ChannelID].m_Pan = (int)(Pan * 255.0f); // TODO: this is only on and off right now
+	m_Mixer.SetChannel(ChannelID, Vol, Pan);
 }
 
 ISound::CVoiceHandle CSound::Play(int ChannelID, int SampleID, int Flags, float x, float y)
 {
-	int VoiceID = -1;
-	int Age = -1;
-	int i;
-
-	lock_wait(m_SoundLock);
-
-	// search for voice
-	for(i = 0; i < NUM_VOICES; i++)
-	{
-		int id = (m_NextVoice + i) % NUM_VOICES;
-		if(!m_aVoices[id].m_pSample)
-		{
-			VoiceID = id;
-			m_NextVoice = id + 1;
-			break;
-		}
-	}
+	// samples that are still decoding are skipped
+	if(!IsSampleReady(SampleID))
+		return CVoiceHandle();
 
-	// voice found, use it
-	if(VoiceID != -1)
-	{
-		m_aVoices[VoiceID].m_pSample = &m_aSamples[SampleID];
-		m_aVoices[VoiceID].m_pChannel = &m_aChannels[ChannelID];
-		if(Flags & FLAG_LOOP)
-			m_aVoices[VoiceID].m_Tick = m_aSamples[SampleID].m_PausedAt;
-		else
-			m_aVoices[VoiceID].m_Tick = 0;
-		m_aVoices[VoiceID].m_Vol = 255;
-		m_aVoices[VoiceID].m_Flags = Flags;
-		m_aVoices[VoiceID].m_X = (int)x;
-		m_aVoices[VoiceID].m_Y = (int)y;
-		m_aVoices[VoiceID].m_Falloff = 0.0f;
-		m_aVoices[VoiceID].m_Shape = ISound::SHAPE_CIRCLE;
-		m_aVoices[VoiceID].m_Circle.m_Radius = DefaultDistance;
-		Age = m_aVoices[VoiceID].m_Age;
-	}
-
-	lock_unlock(m_SoundLock);
+	int Age = -1;
+	int VoiceID = m_Mixer.Play(ChannelID, &m_aSamples[SampleID], Flags, x, y, &Age);
 	return CreateVoiceHandle(VoiceID, Age);
 }
 
@@ -934,39 +730,17 @@ ISound::CVoiceHandle CSound::Play(int ChannelID, int SampleID, int Flags)
 
 void CSound::Stop(int SampleID)
 {
+	if(SampleID < 0 || SampleID >= NUM_SAMPLES)
+		return;
+
 	// TODO: a nice fade out
-	lock_wait(m_SoundLock);
-	CSample *pSample = &m_aSamples[SampleID];
-	for(int i = 0; i < NUM_VOICES; i++)
-	{
-		if(m_aVoices[i].m_pSample == pSample)
-		{
-			if(m_aVoices[i].m_Flags & FLAG_LOOP)
-				m_aVoices[i].m_pSample->m_PausedAt = m_aVoices[i].m_Tick;
-			else
-				m_aVoices[i].m_pSample->m_PausedAt = 0;
-			m_aVoices[i].m_pSample = 0;
-		}
-	}
-	lock_unlock(m_SoundLock);
+	m_Mixer.StopSample(&m_aSamples[SampleID]);
 }
 
 void CSound::StopAll()
 {
 	// TODO: a nice fade out
-	lock_wait(m_SoundLock);
-	for(int i = 0; i < NUM_VOICES; i++)
-	{
-		if(m_aVoices[i].m_pSample)
-		{
-			if(m_aVoices[i].m_Flags & FLAG_LOOP)
-				m_aVoices[i].m_pSample->m_PausedAt = m_aVoices[i].m_Tick;
-			else
-				m_aVoices[i].m_pSample->m_PausedAt = 0;
-		}
-		m_aVoices[i].m_pSample = 0;
-	}
-	lock_unlock(m_SoundLock);
+	m_Mixer.StopAll();
 }
 
 void CSound::StopVoice(CVoiceHandle Voice)
@@ -974,17 +748,7 @@ void CSound::StopVoice(CVoiceHandle Voice)
 	if(!Voice.IsValid())
 		return;
 
-	int VoiceID = Voice.Id();
-
-	if(m_aVoices[VoiceID].m_Age != Voice.Age())
-		return;
-
-	lock_wait(m_SoundLock);
-	{
-		m_aVoices[VoiceID].m_pSample = 0;
-		m_aVoices[VoiceID].m_Age++;
-	}
-	lock_unlock(m_SoundLock);
+	m_Mixer.StopVoice(Voice.Id(), Voice.Age());
 }
 
 IEngineSound *CreateEngineSound() { return new CSound; }
@@ -7,6 +7,8 @@
 #include <engine/sound.h>
 #include <engine/storage.h>
 
+#include <engine/shared/jobs.h>
+
 #include "SDL.h"
 
 class CSound : public IEngineSound
@@ -14,7 +16,21 @@ class CSound : public IEngineSound
 	int m_SoundEnabled;
 	SDL_AudioDeviceID m_Device;
 
+	// decodes samples, so loading them doesn't block the caller
+	CJobPool m_DecodePool;
+
+	void DecodeAsync(int SampleID, int Format, IOHANDLE File, const void *pData, unsigned DataSize);
+	int DecodeNow(int SampleID, int Format, const void *pData, unsigned DataSize);
+	int LoadFile(const char *pFilename, int Format, const char *pLogSystem);
+	int LoadMem(const void *pData, unsigned DataSize, bool FromEditor, int Format);
+
 public:
+	enum
+	{
+		FORMAT_WV = 0,
+		FORMAT_OPUS,
+	};
+
 	IEngineGraphics *m_pGraphics;
 	IStorage *m_pStorage;
 
@@ -24,12 +40,6 @@ public:
 	int Shutdown();
 	int AllocID();
 
-	static void RateConvert(int SampleID);
-
-	// TODO: Refactor: clean this mess up
-	static int DecodeWV(int SampleID, const void *pData, unsigned DataSize);
-	static int DecodeOpus(int SampleID, const void *pData, unsigned DataSize);
-
 	virtual bool IsSoundEnabled() { return m_SoundEnabled != 0; }
 
 	virtual int LoadWV(const char *pFilename);
@@ -37,6 +47,8 @@ public:
 	virtual int LoadOpus(const char *pFilename);
 	virtual int LoadOpusFromMem(const void *pData, unsigned DataSize, bool FromEditor);
 	virtual void UnloadSample(int SampleID);
+	virtual bool IsSampleReady(int SampleID);
+	virtual bool IsSampleFailed(int SampleID);
 
 	virtual float GetSampleDuration(int SampleID); // in s
 
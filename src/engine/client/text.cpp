@@ -2,8 +2,10 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include <base/math.h>
 #include <base/system.h>
+#include <engine/engine.h>
 #include <engine/graphics.h>
 #include <engine/shared/config.h>
+#include <engine/shared/jobs.h>
 #include <engine/storage.h>
 #include <engine/textrender.h>
 
@@ -15,9 +17,11 @@
 enum
 {
 	MAX_CHARACTERS = 64,
+	// 128k * 2 of data used for rendering glyphs
+	GLYPH_DATA_SIZE = (1024 / 4) * (1024 / 4),
 };
 
-#include <map>
+#include <memory>
 #include <vector>
 
 struct SFontSizeChar
@@ -65,12 +69,80 @@ struct STextureSkyline
 	std::vector<int> m_CurHeightOfPixelColumn;
 };
 
+// open addressing hash table from characters to their glyphs, looked up for
+// every rendered character. pointers to glyphs stay valid until the next
+// insertion
+class CGlyphMap
+{
+	struct SEntry
+	{
+		bool m_Used;
+		int m_Chr;
+		SFontSizeChar m_Glyph;
+	};
+
+	std::vector<SEntry> m_vEntries;
+	int m_Num;
+
+	unsigned Slot(int Chr) const { return ((unsigned)Chr * 2654435761u) & (m_vEntries.size() - 1); }
+
+	void Grow()
+	{
+		std::vector<SEntry> vOldEntries;
+		vOldEntries.swap(m_vEntries);
+		m_vEntries.resize(maximum((int)vOldEntries.size() * 2, 256));
+		m_Num = 0;
+		for(const SEntry &Entry : vOldEntries)
+			if(Entry.m_Used)
+				*Insert(Entry.m_Chr) = Entry.m_Glyph;
+	}
+
+public:
+	CGlyphMap() :
+		m_Num(0) {}
+
+	SFontSizeChar *Find(int Chr)
+	{
+		if(m_vEntries.empty())
+			return 0;
+		for(unsigned i = Slot(Chr);; i = (i + 1) & (m_vEntries.size() - 1))
+		{
+			if(!m_vEntries[i].m_Used)
+				return 0;
+			if(m_vEntries[i].m_Chr == Chr)
+				return &m_vEntries[i].m_Glyph;
+		}
+	}
+
+	// the character must not be in the table yet, the new glyph is zeroed
+	SFontSizeChar *Insert(int Chr)
+	{
+		if((m_Num + 1) * 2 > (int)m_vEntries.size())
+			Grow();
+		unsigned i = Slot(Chr);
+		while(m_vEntries[i].m_Used)
+			i = (i + 1) & (m_vEntries.size() - 1);
+		m_vEntries[i].m_Used = true;
+		m_vEntries[i].m_Chr = Chr;
+		mem_zero(&m_vEntries[i].m_Glyph, sizeof(m_vEntries[i].m_Glyph));
+		m_Num++;
+		return &m_vEntries[i].m_Glyph;
+	}
+
+	void Clear()
+	{
+		m_vEntries.clear();
+		m_Num = 0;
+	}
+};
+
 struct CFontSizeData
 {
 	int m_FontSize;
 	FT_Face *m_pFace;
 
-	std::map<int, SFontSizeChar> m_Chars;
+	CGlyphMap m_Chars;
+	bool m_WarmupStarted;
 };
 
 #define MIN_FONT_SIZE 6
@@ -97,7 +169,8 @@ public:
 		{
 			m_aFontSizes[i].m_FontSize = i + MIN_FONT_SIZE;
 			m_aFontSizes[i].m_pFace = &this->m_FtFace;
-			m_aFontSizes[i].m_Chars.clear();
+			m_aFontSizes[i].m_Chars.Clear();
+			m_aFontSizes[i].m_WarmupStarted = false;
 		}
 	}
 
@@ -109,6 +182,7 @@ public:
 	}
 
 	void *m_pBuf;
+	size_t m_BufSize;
 	char m_aFilename[512];
 	FT_Face m_FtFace;
 
@@ -133,6 +207,153 @@ public:
 	STextureSkyline m_TextureSkyline[2];
 };
 
+static void Grow(unsigned char *pIn, unsigned char *pOut, int w, int h, int OutlineCount)
+{
+	for(int y = 0; y < h; y++)
+		for(int x = 0; x < w; x++)
+		{
+			int c = pIn[y * w + x];
+
+			for(int sy = -OutlineCount; sy <= OutlineCount; sy++)
+				for(int sx = -OutlineCount; sx <= OutlineCount; sx++)
+				{
+					int GetX = x + sx;
+					int GetY = y + sy;
+					if(GetX >= 0 && GetY >= 0 && GetX < w && GetY < h)
+					{
+						int Index = GetY * w + GetX;
+						if(pIn[Index] > c)
+							c = pIn[Index];
+					}
+				}
+
+			pOut[y * w + x] = c;
+		}
+}
+
+static int AdjustOutlineThicknessToFontSize(int OutlineThickness, int FontSize)
+{
+	if(FontSize > 48)
+		OutlineThickness *= 4;
+	else if(FontSize >= 18)
+		OutlineThickness *= 2;
+	return OutlineThickness;
+}
+
+struct SGlyphInfo
+{
+	FT_UInt m_GlyphIndex;
+	int m_Width;
+	int m_Height;
+	int m_OffsetX;
+	int m_OffsetY;
+	int m_AdvanceX;
+};
+
+// renders a glyph of a face whose pixel size is already set, padded for the
+// outline, and its outlined version. doesn't touch any shared state, so it
+// can run on any thread with its own face
+static bool RasterizeGlyph(FT_Face FtFace, FT_UInt GlyphIndex, int FontSize, SGlyphInfo *pInfo, unsigned char *pData, unsigned char *pDataOutlined, int DataSize)
+{
+	if(FT_Load_Glyph(FtFace, GlyphIndex, FT_LOAD_RENDER | FT_LOAD_NO_BITMAP))
+		return false;
+
+	FT_Bitmap *pBitmap = &FtFace->glyph->bitmap; // ignore_convention
+
+	// adjust spacing
+	int OutlineThickness = AdjustOutlineThicknessToFontSize(1, FontSize);
+	int x = 1 + OutlineThickness;
+	int y = 1 + OutlineThickness;
+
+	int Width = pBitmap->width + x * 2; // ignore_convention
+	int Height = pBitmap->rows + y * 2; // ignore_convention
+	if(Width * Height > DataSize)
+		return false;
+
+	// prepare glyph data
+	mem_zero(pData, Width * Height);
+
+	for(unsigned py = 0; py < pBitmap->rows; py++) // ignore_convention
+		for(unsigned px = 0; px < pBitmap->width; px++) // ignore_convention
+			pData[(py + y) * Width + px + x] = pBitmap->buffer[py * pBitmap->width + px]; // ignore_convention
+
+	Grow(pData, pDataOutlined, Width, Height, OutlineThickness);
+
+	pInfo->m_GlyphIndex = GlyphIndex;
+	pInfo->m_Width = Width;
+	pInfo->m_Height = Height;
+	pInfo->m_OffsetX = (FtFace->glyph->metrics.horiBearingX >> 6); // ignore_convention
+	pInfo->m_OffsetY = -((FtFace->glyph->metrics.height >> 6) - (FtFace->glyph->metrics.horiBearingY >> 6)); // ignore_convention
+	pInfo->m_AdvanceX = (FtFace->glyph->advance.x >> 6); // ignore_convention
+	return true;
+}
+
+// rasterizes the commonly used characters of a font size in the background,
+// the first time the size is used. the glyphs are put into the atlas on the
+// main thread, which only has to render the rare characters itself then
+class CGlyphWarmupJob : public IJob
+{
+	const FT_Byte *m_pFontBuf;
+	size_t m_FontBufSize;
+
+	void Run()
+	{
+		// basic latin and latin-1 supplement
+		static const int s_aaRanges[][2] = {{0x20, 0x7e}, {0xa0, 0xff}};
+
+		if(m_Abort)
+			return;
+
+		// freetype libraries and faces can't be shared between threads
+		FT_Library Library;
+		if(FT_Init_FreeType(&Library))
+			return;
+
+		FT_Face Face;
+		if(FT_New_Memory_Face(Library, m_pFontBuf, m_FontBufSize, 0, &Face) == 0)
+		{
+			FT_Set_Pixel_Sizes(Face, 0, m_FontSize);
+
+			std::vector<unsigned char> vData(GLYPH_DATA_SIZE);
+			std::vector<unsigned char> vDataOutlined(GLYPH_DATA_SIZE);
+			for(const auto &Range : s_aaRanges)
+			{
+				for(int Chr = Range[0]; Chr <= Range[1] && !m_Abort; Chr++)
+				{
+					FT_UInt GlyphIndex = Face->charmap ? FT_Get_Char_Index(Face, (FT_ULong)Chr) : 0;
+					SGlyphInfo Info;
+					if(GlyphIndex == 0 || !RasterizeGlyph(Face, GlyphIndex, m_FontSize, &Info, vData.data(), vDataOutlined.data(), GLYPH_DATA_SIZE))
+						continue;
+
+					m_vChars.push_back(Chr);
+					m_vInfos.push_back(Info);
+					m_vData.insert(m_vData.end(), vData.begin(), vData.begin() + Info.m_Width * Info.m_Height);
+					m_vData.insert(m_vData.end(), vDataOutlined.begin(), vDataOutlined.begin() + Info.m_Width * Info.m_Height);
+				}
+			}
+			FT_Done_Face(Face);
+		}
+		FT_Done_FreeType(Library);
+	}
+
+public:
+	CGlyphWarmupJob(CFont *pFont, int FontSize) :
+		m_pFontBuf((const FT_Byte *)pFont->m_pBuf), m_FontBufSize(pFont->m_BufSize), m_Abort(false), m_pFont(pFont), m_FontSize(FontSize)
+	{
+	}
+
+	// stops the job early, its glyphs are incomplete then
+	std::atomic<bool> m_Abort;
+
+	CFont *m_pFont;
+	int m_FontSize;
+
+	std::vector<int> m_vChars;
+	std::vector<SGlyphInfo> m_vInfos;
+	// every glyph followed by its outlined version
+	std::vector<unsigned char> m_vData;
+};
+
 struct STextString
 {
 	int m_QuadBufferObjectIndex;
@@ -194,6 +415,7 @@ class CTextRender : public IEngineTextRender
 {
 	IGraphics *m_pGraphics;
 	IGraphics *Graphics() { return m_pGraphics; }
+	IEngine *m_pEngine;
 
 	unsigned int m_RenderFlags;
 
@@ -267,33 +489,94 @@ class CTextRender : public IEngineTextRender
 
 	FT_Library m_FTLibrary;
 
-	virtual void SetRenderFlags(unsigned int Flags)
+	std::vector<std::shared_ptr<CGlyphWarmupJob>> m_vpGlyphWarmupJobs;
+
+	// results of TextWidth and TextLineCount for short strings, which are
+	// measured again every frame for e.g. nameplates and scoreboard rows
+	enum
 	{
-		m_RenderFlags = Flags;
+		LAYOUT_CACHE_SIZE = 1024,
+		LAYOUT_CACHE_TEXT_SIZE = 64,
+	};
+
+	struct STextLayout
+	{
+		bool m_Valid;
+		CFont *m_pFont;
+		unsigned m_RenderFlags;
+		float m_Size;
+		float m_LineWidth;
+		float m_FakeToScreenX;
+		float m_FakeToScreenY;
+		int m_Length;
+		char m_aText[LAYOUT_CACHE_TEXT_SIZE];
+
+		float m_Width;
+		float m_AlignedFontSize;
+		int m_LineCount;
+	};
+
+	STextLayout m_aLayoutCache[LAYOUT_CACHE_SIZE];
+	STextLayout m_UncachedLayout;
+
+	void ClearLayoutCache()
+	{
+		for(STextLayout &Layout : m_aLayoutCache)
+			Layout.m_Valid = false;
 	}
 
-	void Grow(unsigned char *pIn, unsigned char *pOut, int w, int h, int OutlineCount)
+	const STextLayout *GetTextLayout(float Size, const char *pText, int Length, float LineWidth)
 	{
-		for(int y = 0; y < h; y++)
-			for(int x = 0; x < w; x++)
-			{
-				int c = pIn[y * w + x];
+		if(Length < 0)
+			Length = str_length(pText);
 
-				for(int sy = -OutlineCount; sy <= OutlineCount; sy++)
-					for(int sx = -OutlineCount; sx <= OutlineCount; sx++)
-					{
-						int GetX = x + sx;
-						int GetY = y + sy;
-						if(GetX >= 0 && GetY >= 0 && GetX < w && GetY < h)
-						{
-							int Index = GetY * w + GetX;
-							if(pIn[Index] > c)
-								c = pIn[Index];
-						}
-					}
+		// the layout depends on the pixel alignment of the current screen
+		float ScreenX0, ScreenY0, ScreenX1, ScreenY1;
+		Graphics()->GetScreen(&ScreenX0, &ScreenY0, &ScreenX1, &ScreenY1);
+		float FakeToScreenX = Graphics()->ScreenWidth() / (ScreenX1 - ScreenX0);
+		float FakeToScreenY = Graphics()->ScreenHeight() / (ScreenY1 - ScreenY0);
 
-				pOut[y * w + x] = c;
-			}
+		STextLayout *pLayout = &m_UncachedLayout;
+		if(Length < LAYOUT_CACHE_TEXT_SIZE)
+		{
+			// fnv-1a
+			unsigned Hash = 2166136261u;
+			for(int i = 0; i < Length; i++)
+				Hash = (Hash ^ (unsigned char)pText[i]) * 16777619u;
+			Hash = (Hash ^ (unsigned)(Size * 64.0f)) * 16777619u;
+			Hash = (Hash ^ (unsigned)(LineWidth * 64.0f)) * 16777619u;
+
+			pLayout = &m_aLayoutCache[Hash & (LAYOUT_CACHE_SIZE - 1)];
+			if(pLayout->m_Valid && pLayout->m_pFont == m_pCurFont && pLayout->m_RenderFlags == m_RenderFlags &&
+				pLayout->m_Size == Size && pLayout->m_LineWidth == LineWidth &&
+				pLayout->m_FakeToScreenX == FakeToScreenX && pLayout->m_FakeToScreenY == FakeToScreenY &&
+				pLayout->m_Length == Length && mem_comp(pLayout->m_aText, pText, Length) == 0)
+				return pLayout;
+
+			pLayout->m_Valid = true;
+			pLayout->m_pFont = m_pCurFont;
+			pLayout->m_RenderFlags = m_RenderFlags;
+			pLayout->m_Size = Size;
+			pLayout->m_LineWidth = LineWidth;
+			pLayout->m_FakeToScreenX = FakeToScreenX;
+			pLayout->m_FakeToScreenY = FakeToScreenY;
+			pLayout->m_Length = Length;
+			mem_copy(pLayout->m_aText, pText, Length);
+		}
+
+		CTextCursor Cursor;
+		SetCursor(&Cursor, 0, 0, Size, 0);
+		Cursor.m_LineWidth = LineWidth;
+		TextEx(&Cursor, pText, Length);
+		pLayout->m_Width = Cursor.m_X;
+		pLayout->m_AlignedFontSize = Cursor.m_AlignedFontSize;
+		pLayout->m_LineCount = Cursor.m_LineCount;
+		return pLayout;
+	}
+
+	virtual void SetRenderFlags(unsigned int Flags)
+	{
+		m_RenderFlags = Flags;
 	}
 
 	IGraphics::CTextureHandle InitTexture(int Width, int Height, void *pUploadData = NULL)
@@ -344,15 +627,6 @@ class CTextRender : public IEngineTextRender
 		pFont->m_TextureSkyline[TextureIndex].m_CurHeightOfPixelColumn.resize(NewDimensions, 0);
 	}
 
-	int AdjustOutlineThicknessToFontSize(int OutlineThickness, int FontSize)
-	{
-		if(FontSize > 48)
-			OutlineThickness *= 4;
-		else if(FontSize >= 18)
-			OutlineThickness *= 2;
-		return OutlineThickness;
-	}
-
 	void UploadGlyph(CFont *pFont, int TextureIndex, int PosX, int PosY, int Width, int Height, const unsigned char *pData)
 	{
 		for(int y = 0; y < Height; ++y)
@@ -365,9 +639,8 @@ class CTextRender : public IEngineTextRender
 		Graphics()->LoadTextureRawSub(pFont->m_aTextures[TextureIndex], PosX, PosY, Width, Height, CImageInfo::FORMAT_ALPHA, pData);
 	}
 
-	// 128k * 2 of data used for rendering glyphs
-	unsigned char ms_aGlyphData[(1024 / 4) * (1024 / 4)];
-	unsigned char ms_aGlyphDataOutlined[(1024 / 4) * (1024 / 4)];
+	unsigned char ms_aGlyphData[GLYPH_DATA_SIZE];
+	unsigned char ms_aGlyphDataOutlined[GLYPH_DATA_SIZE];
 
 	bool GetCharacterSpace(CFont *pFont, int TextureIndex, int Width, int Height, int &PosX, int &PosY)
 	{
@@ -445,14 +718,40 @@ class CTextRender : public IEngineTextRender
 			return false;
 	}
 
-	void RenderGlyph(CFont *pFont, CFontSizeData *pSizeData, int Chr)
+	void AddGlyph(CFont *pFont, int Chr, const SGlyphInfo *pInfo, const unsigned char *pData, const unsigned char *pDataOutlined, SFontSizeChar *pFontchr)
 	{
-		FT_Bitmap *pBitmap;
+		// upload the glyph
+		int X = 0;
+		int Y = 0;
+		while(!GetCharacterSpace(pFont, 0, pInfo->m_Width, pInfo->m_Height, X, Y))
+		{
+			IncreaseFontTexture(pFont, 0);
+		}
+		UploadGlyph(pFont, 0, X, Y, pInfo->m_Width, pInfo->m_Height, pData);
 
-		int x = 1;
-		int y = 1;
-		unsigned int px, py;
+		while(!GetCharacterSpace(pFont, 1, pInfo->m_Width, pInfo->m_Height, X, Y))
+		{
+			IncreaseFontTexture(pFont, 1);
+		}
+		UploadGlyph(pFont, 1, X, Y, pInfo->m_Width, pInfo->m_Height, pDataOutlined);
+
+		// set char info
+		pFontchr->m_ID = Chr;
+		pFontchr->m_Height = pInfo->m_Height;
+		pFontchr->m_Width = pInfo->m_Width;
+		pFontchr->m_OffsetX = pInfo->m_OffsetX;
+		pFontchr->m_OffsetY = pInfo->m_OffsetY;
+		pFontchr->m_AdvanceX = pInfo->m_AdvanceX;
+
+		pFontchr->m_aUVs[0] = X;
+		pFontchr->m_aUVs[1] = Y;
+		pFontchr->m_aUVs[2] = pFontchr->m_aUVs[0] + pInfo->m_Width;
+		pFontchr->m_aUVs[3] = pFontchr->m_aUVs[1] + pInfo->m_Height;
+		pFontchr->m_GlyphIndex = pInfo->m_GlyphIndex;
+	}
 
+	void RenderGlyph(CFont *pFont, CFontSizeData *pSizeData, int Chr, SFontSizeChar *pFontchr)
+	{
 		FT_Face FtFace = pFont->m_FtFace;
 
 		FT_Set_Pixel_Sizes(FtFace, 0, pSizeData->m_FontSize);
@@ -489,82 +788,67 @@ class CTextRender : public IEngineTextRender
 			}
 		}
 
-		if(FT_Load_Glyph(FtFace, GlyphIndex, FT_LOAD_RENDER | FT_LOAD_NO_BITMAP))
+		SGlyphInfo Info;
+		if(!RasterizeGlyph(FtFace, GlyphIndex, pSizeData->m_FontSize, &Info, ms_aGlyphData, ms_aGlyphDataOutlined, GLYPH_DATA_SIZE))
 		{
 			dbg_msg("pFont", "error loading glyph %d", Chr);
 			return;
 		}
 
-		pBitmap = &FtFace->glyph->bitmap; // ignore_convention
-
-		// adjust spacing
-		int OutlineThickness = AdjustOutlineThicknessToFontSize(1, pSizeData->m_FontSize);
-		x += OutlineThickness;
-		y += OutlineThickness;
-
-		unsigned int Width = pBitmap->width + x * 2;
-		unsigned int Height = pBitmap->rows + y * 2;
-
-		// prepare glyph data
-		mem_zero(ms_aGlyphData, Width * Height);
-
-		for(py = 0; py < pBitmap->rows; py++) // ignore_convention
-			for(px = 0; px < pBitmap->width; px++) // ignore_convention
-				ms_aGlyphData[(py + y) * Width + px + x] = pBitmap->buffer[py * pBitmap->width + px]; // ignore_convention
-
-		// upload the glyph
-		int X = 0;
-		int Y = 0;
-		while(!GetCharacterSpace(pFont, 0, (int)Width, (int)Height, X, Y))
-		{
-			IncreaseFontTexture(pFont, 0);
-		}
-		UploadGlyph(pFont, 0, X, Y, (int)Width, (int)Height, ms_aGlyphData);
-
-		Grow(ms_aGlyphData, ms_aGlyphDataOutlined, Width, Height, OutlineThickness);
+		AddGlyph(pFont, Chr, &Info, ms_aGlyphData, ms_aGlyphDataOutlined, pFontchr);
+	}
 
-		while(!GetCharacterSpace(pFont, 1, (int)Width, (int)Height, X, Y))
+	SFontSizeChar *GetChar(CFont *pFont, CFontSizeData *pSizeData, int Chr)
+	{
+		SFontSizeChar *pFontchr = pSizeData->m_Chars.Find(Chr);
+		if(!pFontchr)
 		{
-			IncreaseFontTexture(pFont, 1);
-		}
-		UploadGlyph(pFont, 1, X, Y, (int)Width, (int)Height, ms_aGlyphDataOutlined);
+			if(!pSizeData->m_WarmupStarted)
+				StartGlyphWarmup(pFont, pSizeData);
 
-		// set char info
-		{
-			SFontSizeChar *pFontchr = &pSizeData->m_Chars[Chr];
-			int BMPHeight = pBitmap->rows + y * 2;
-			int BMPWidth = pBitmap->width + x * 2;
-
-			pFontchr->m_ID = Chr;
-			pFontchr->m_Height = Height;
-			pFontchr->m_Width = Width;
-			pFontchr->m_OffsetX = (FtFace->glyph->metrics.horiBearingX >> 6); // ignore_convention
-			pFontchr->m_OffsetY = -((FtFace->glyph->metrics.height >> 6) - (FtFace->glyph->metrics.horiBearingY >> 6));
-			pFontchr->m_AdvanceX = (FtFace->glyph->advance.x >> 6); // ignore_convention
-
-			pFontchr->m_aUVs[0] = X;
-			pFontchr->m_aUVs[1] = Y;
-			pFontchr->m_aUVs[2] = pFontchr->m_aUVs[0] + BMPWidth;
-			pFontchr->m_aUVs[3] = pFontchr->m_aUVs[1] + BMPHeight;
-			pFontchr->m_GlyphIndex = GlyphIndex;
+			// render and add character
+			pFontchr = pSizeData->m_Chars.Insert(Chr);
+			RenderGlyph(pFont, pSizeData, Chr, pFontchr);
 		}
+		return pFontchr;
 	}
 
-	SFontSizeChar *GetChar(CFont *pFont, CFontSizeData *pSizeData, int Chr)
+	void StartGlyphWarmup(CFont *pFont, CFontSizeData *pSizeData)
 	{
-		std::map<int, SFontSizeChar>::iterator it = pSizeData->m_Chars.find(Chr);
-		if(it == pSizeData->m_Chars.end())
-		{
-			// render and add character
-			SFontSizeChar &FontSizeChr = pSizeData->m_Chars[Chr];
+		pSizeData->m_WarmupStarted = true;
+		if(!m_pEngine)
+			return;
 
-			RenderGlyph(pFont, pSizeData, Chr);
+		std::shared_ptr<CGlyphWarmupJob> pJob = std::make_shared<CGlyphWarmupJob>(pFont, pSizeData->m_FontSize);
+		m_pEngine->AddJob(pJob);
+		m_vpGlyphWarmupJobs.push_back(pJob);
+	}
 
-			return &FontSizeChr;
-		}
-		else
+	// only call this while nothing is drawn, the atlas textures might grow
+	void FinishGlyphWarmups()
+	{
+		for(size_t i = 0; i < m_vpGlyphWarmupJobs.size();)
 		{
-			return &it->second;
+			CGlyphWarmupJob *pJob = m_vpGlyphWarmupJobs[i].get();
+			if(pJob->Status() != IJob::STATE_DONE)
+			{
+				i++;
+				continue;
+			}
+
+			CFontSizeData *pSizeData = pJob->m_pFont->GetFontSize(pJob->m_FontSize);
+			size_t Offset = 0;
+			for(size_t g = 0; g < pJob->m_vChars.size(); g++)
+			{
+				const SGlyphInfo *pInfo = &pJob->m_vInfos[g];
+				int DataSize = pInfo->m_Width * pInfo->m_Height;
+				int Chr = pJob->m_vChars[g];
+				// skip what was rendered in the meantime
+				if(!pSizeData->m_Chars.Find(Chr))
+					AddGlyph(pJob->m_pFont, Chr, pInfo, &pJob->m_vData[Offset], &pJob->m_vData[Offset + DataSize], pSizeData->m_Chars.Insert(Chr));
+				Offset += DataSize * 2;
+			}
+			m_vpGlyphWarmupJobs.erase(m_vpGlyphWarmupJobs.begin() + i);
 		}
 	}
 
@@ -579,6 +863,7 @@ public:
 	CTextRender()
 	{
 		m_pGraphics = 0;
+		m_pEngine = 0;
 
 		m_Color = ColorRGBA(1, 1, 1, 1);
 		m_OutlineColor = ColorRGBA(0, 0, 0, 0.3f);
@@ -591,10 +876,19 @@ public:
 		//m_FontTextureFormat = GL_ALPHA;
 
 		m_RenderFlags = 0;
+
+		ClearLayoutCache();
 	}
 
 	virtual ~CTextRender()
 	{
+		// the jobs read the font buffers. stop them first, waiting then
+		// only runs or blocks for the job itself
+		for(auto &pJob : m_vpGlyphWarmupJobs)
+			pJob->m_Abort = true;
+		for(auto &pJob : m_vpGlyphWarmupJobs)
+			m_pEngine->WaitJob(pJob);
+
 		for(size_t i = 0; i < m_Fonts.size(); ++i)
 		{
 			FT_Done_Face(m_Fonts[i]->m_FtFace);
@@ -614,6 +908,7 @@ public:
 	virtual void Init()
 	{
 		m_pGraphics = Kernel()->RequestInterface<IGraphics>();
+		m_pEngine = Kernel()->RequestInterface<IEngine>();
 		FT_Init_FreeType(&m_FTLibrary);
 		// print freetype version
 		{
@@ -681,6 +976,7 @@ public:
 		dbg_msg("textrender", "loaded pFont from '%s'", pFilename);
 
 		pFont->m_pBuf = (void *)pBuf;
+		pFont->m_BufSize = Size;
 		pFont->m_CurTextureDimensions[0] = 1024;
 		pFont->m_TextureData[0] = new unsigned char[pFont->m_CurTextureDimensions[0] * pFont->m_CurTextureDimensions[0]];
 		mem_zero(pFont->m_TextureData[0], pFont->m_CurTextureDimensions[0] * pFont->m_CurTextureDimensions[0] * sizeof(unsigned char));
@@ -777,22 +1073,15 @@ public:
 
 	virtual float TextWidth(void *pFontSetV, float Size, const char *pText, int StrLength, float LineWidth, float *pAlignedHeight = NULL)
 	{
-		CTextCursor Cursor;
-		SetCursor(&Cursor, 0, 0, Size, 0);
-		Cursor.m_LineWidth = LineWidth;
-		TextEx(&Cursor, pText, StrLength);
+		const STextLayout *pLayout = GetTextLayout(Size, pText, StrLength, LineWidth);
 		if(pAlignedHeight != NULL)
-			*pAlignedHeight = Cursor.m_AlignedFontSize;
-		return Cursor.m_X;
+			*pAlignedHeight = pLayout->m_AlignedFontSize;
+		return pLayout->m_Width;
 	}
 
 	virtual int TextLineCount(void *pFontSetV, float Size, const char *pText, float LineWidth)
 	{
-		CTextCursor Cursor;
-		SetCursor(&Cursor, 0, 0, Size, 0);
-		Cursor.m_LineWidth = LineWidth;
-		TextEx(&Cursor, pText, -1);
-		return Cursor.m_LineCount;
+		return GetTextLayout(Size, pText, -1, LineWidth)->m_LineCount;
 	}
 
 	virtual void TextColor(float r, float g, float b, float a)
@@ -864,6 +1153,10 @@ public:
 		if(Length < 0)
 			Length = str_length(pText);
 
+		// nested calls only measure, don't grow the atlas while drawing
+		if((pCursor->m_Flags & TEXTFLAG_RENDER) && !m_vpGlyphWarmupJobs.empty())
+			FinishGlyphWarmups();
+
 		float Scale = 1.0f / pSizeData->m_FontSize;
 
 		//the outlined texture is always the same size as the current
@@ -1158,6 +1451,9 @@ public:
 	{
 		STextContainer &TextContainer = GetTextContainer(TextContainerIndex);
 
+		if(!m_vpGlyphWarmupJobs.empty())
+			FinishGlyphWarmups();
+
 		CFontSizeData *pSizeData = NULL;
 
 		float ScreenX0, ScreenY0, ScreenX1, ScreenY1;
@@ -1902,6 +2198,8 @@ public:
 
 			m_Fonts[i]->InitFontSizes();
 		}
+
+		ClearLayoutCache();
 	}
 };
 
@@ -31,7 +31,11 @@ protected:
 public:
 	virtual void Init() = 0;
 	virtual void InitLogfile() = 0;
-	virtual void AddJob(std::shared_ptr<IJob> pJob) = 0;
+	virtual void AddJob(std::shared_ptr<IJob> pJob, int Priority = CJobPool::PRIORITY_NORMAL) = 0;
+	virtual void AddJobs(const std::vector<std::shared_ptr<IJob>> &vpJobs, int Priority = CJobPool::PRIORITY_NORMAL) = 0;
+	virtual void WaitJob(const std::shared_ptr<IJob> &pJob) = 0;
+	// for code that takes a pool directly, e.g. CDataFileWriter
+	class CJobPool *JobPool() { return &m_JobPool; }
 };
 
 extern IEngine *CreateEngine(const char *pAppname, bool Silent, int Jobs);
@@ -1,5 +1,9 @@
 #include "name_ban.h"
 
+#include <base/math.h>
+
+#include <utility>
+
 CNameBan *IsNameBanned(const char *pName, CNameBan *pNameBans, int NumNameBans)
 {
 	char aTrimmed[MAX_NAME_LENGTH];
@@ -22,3 +26,187 @@ CNameBan *IsNameBanned(const char *pName, CNameBan *pNameBans, int NumNameBans)
 	}
 	return pResult;
 }
+
+// Same as str_utf32_dist_buffer(...) <= Max, but stops as soon as every
+// entry of a row exceeds Max, as the distance can't get smaller after that.
+static bool DistanceWithin(const int *pA, int LengthA, const int *pB, int LengthB, int Max)
+{
+	int aaRows[2][MAX_NAME_SKELETON_LENGTH + 1];
+	int *pPrev = aaRows[0];
+	int *pCur = aaRows[1];
+	for(int i = 0; i <= LengthA; i++)
+		pPrev[i] = i;
+	for(int j = 1; j <= LengthB; j++)
+	{
+		pCur[0] = j;
+		int RowMin = j;
+		for(int i = 1; i <= LengthA; i++)
+		{
+			int Subst = pA[i - 1] != pB[j - 1];
+			pCur[i] = minimum(pCur[i - 1] + 1, pPrev[i] + 1, pPrev[i - 1] + Subst);
+			RowMin = minimum(RowMin, pCur[i]);
+		}
+		if(RowMin > Max)
+			return false;
+		std::swap(pPrev, pCur);
+	}
+	return pPrev[LengthA] <= Max;
+}
+
+CNameBanIndex::CNameBanIndex()
+{
+	Build(0, 0);
+}
+
+void CNameBanIndex::BuildHistogram(const int *pSkeleton, int Length, unsigned char *pHistogram)
+{
+	mem_zero(pHistogram, NUM_HISTOGRAM_BINS);
+	for(int i = 0; i < Length; i++)
+		pHistogram[((unsigned)pSkeleton[i] * 2654435761u) >> 27]++;
+}
+
+int CNameBanIndex::Step(int Node, int Code) const
+{
+	while(1)
+	{
+		std::map<int, int>::const_iterator Child = m_vNodes[Node].m_Children.find(Code);
+		if(Child != m_vNodes[Node].m_Children.end())
+			return Child->second;
+		if(Node == 0)
+			return 0;
+		Node = m_vNodes[Node].m_Fail;
+	}
+}
+
+void CNameBanIndex::Build(CNameBan *pNameBans, int NumNameBans)
+{
+	m_pNameBans = pNameBans;
+	m_NumNameBans = NumNameBans;
+
+	for(int l = 0; l <= MAX_NAME_SKELETON_LENGTH; l++)
+	{
+		m_aLengthBuckets[l].clear();
+		m_aMaxDistance[l] = -1;
+	}
+	m_vSkeletonInfos.resize(NumNameBans);
+
+	m_vNodes.clear();
+	m_vNodes.emplace_back();
+	m_vNodes[0].m_Fail = 0;
+	m_vNodes[0].m_Output = -1;
+	m_EmptySubstringBan = -1;
+
+	for(int i = 0; i < NumNameBans; i++)
+	{
+		CNameBan *pBan = &pNameBans[i];
+		m_aLengthBuckets[pBan->m_SkeletonLength].push_back(i);
+		m_aMaxDistance[pBan->m_SkeletonLength] = maximum(m_aMaxDistance[pBan->m_SkeletonLength], pBan->m_Distance);
+		BuildHistogram(pBan->m_aSkeleton, pBan->m_SkeletonLength, m_vSkeletonInfos[i].m_aHistogram);
+
+		if(pBan->m_IsSubstring != 1)
+			continue;
+		if(!pBan->m_aName[0])
+		{
+			m_EmptySubstringBan = i;
+			continue;
+		}
+		// decode exactly like str_utf8_find_nocase does
+		int Node = 0;
+		const char *pStr = pBan->m_aName;
+		while(*pStr)
+		{
+			int Code = str_utf8_tolower(str_utf8_decode(&pStr));
+			std::map<int, int>::iterator Child = m_vNodes[Node].m_Children.find(Code);
+			if(Child != m_vNodes[Node].m_Children.end())
+			{
+				Node = Child->second;
+				continue;
+			}
+			int NewNode = m_vNodes.size();
+			m_vNodes[Node].m_Children[Code] = NewNode;
+			m_vNodes.emplace_back();
+			m_vNodes[NewNode].m_Fail = 0;
+			m_vNodes[NewNode].m_Output = -1;
+			Node = NewNode;
+		}
+		m_vNodes[Node].m_Output = i;
+	}
+
+	// breadth first, so the failure target is always finished before its users
+	std::vector<int> vQueue;
+	vQueue.push_back(0);
+	for(unsigned q = 0; q < vQueue.size(); q++)
+	{
+		int Node = vQueue[q];
+		for(const auto &Child : m_vNodes[Node].m_Children)
+		{
+			CNode *pChild = &m_vNodes[Child.second];
+			pChild->m_Fail = Node == 0 ? 0 : Step(m_vNodes[Node].m_Fail, Child.first);
+			pChild->m_Output = maximum(pChild->m_Output, m_vNodes[pChild->m_Fail].m_Output);
+			vQueue.push_back(Child.second);
+		}
+	}
+}
+
+CNameBan *CNameBanIndex::IsNameBanned(const char *pName) const
+{
+	char aTrimmed[MAX_NAME_LENGTH];
+	str_copy(aTrimmed, str_utf8_skip_whitespaces(pName), sizeof(aTrimmed));
+	str_utf8_trim_right(aTrimmed);
+
+	int aSkeleton[MAX_NAME_SKELETON_LENGTH];
+	int SkeletonLength = str_utf8_to_skeleton(aTrimmed, aSkeleton, sizeof(aSkeleton) / sizeof(aSkeleton[0]));
+	unsigned char aHistogram[NUM_HISTOGRAM_BINS];
+	BuildHistogram(aSkeleton, SkeletonLength, aHistogram);
+
+	// the last matching ban wins, like in the linear search
+	int Result = -1;
+	if(*pName)
+	{
+		Result = m_EmptySubstringBan;
+		int Node = 0;
+		while(*pName)
+		{
+			Node = Step(Node, str_utf8_tolower(str_utf8_decode(&pName)));
+			Result = maximum(Result, m_vNodes[Node].m_Output);
+		}
+	}
+
+	for(int l = 0; l <= MAX_NAME_SKELETON_LENGTH; l++)
+	{
+		// the distance is at least the difference in length
+		int LengthDiff = absolute(l - SkeletonLength);
+		if(LengthDiff > m_aMaxDistance[l])
+			continue;
+
+		const std::vector<int> &vBucket = m_aLengthBuckets[l];
+		for(int b = vBucket.size() - 1; b >= 0 && vBucket[b] > Result; b--)
+		{
+			const CNameBan *pBan = &m_pNameBans[vBucket[b]];
+			if(LengthDiff > pBan->m_Distance)
+				continue;
+
+			// and at least the number of characters that have no counterpart
+			const unsigned char *pHistogram = m_vSkeletonInfos[vBucket[b]].m_aHistogram;
+			int Missing = 0;
+			int Extra = 0;
+			for(int i = 0; i < NUM_HISTOGRAM_BINS; i++)
+			{
+				int Diff = aHistogram[i] - pHistogram[i];
+				if(Diff > 0)
+					Extra += Diff;
+				else
+					Missing -= Diff;
+			}
+			if(maximum(Missing, Extra) > pBan->m_Distance)
+				continue;
+
+			if(DistanceWithin(aSkeleton, SkeletonLength, pBan->m_aSkeleton, pBan->m_SkeletonLength, pBan->m_Distance))
+			{
+				Result = vBucket[b];
+				break;
+			}
+		}
+	}
+	return Result >= 0 ? &m_pNameBans[Result] : 0;
+}
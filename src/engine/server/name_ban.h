@@ -4,6 +4,9 @@
 #include <base/system.h>
 #include <engine/shared/protocol.h>
 
+#include <map>
+#include <vector>
+
 enum
 {
 	MAX_NAME_SKELETON_LENGTH = MAX_NAME_LENGTH * 4,
@@ -31,4 +34,49 @@ public:
 
 CNameBan *IsNameBanned(const char *pName, CNameBan *pNameBans, int NumNameBans);
 
+// Finds the same ban as IsNameBanned, but only looks at bans whose skeleton
+// length and character histogram allow a close enough distance, and matches
+// all substring bans in one pass. Needs to be rebuilt whenever the bans change.
+class CNameBanIndex
+{
+	enum
+	{
+		NUM_HISTOGRAM_BINS = 32,
+	};
+
+	struct CSkeletonInfo
+	{
+		unsigned char m_aHistogram[NUM_HISTOGRAM_BINS];
+	};
+
+	struct CNode
+	{
+		std::map<int, int> m_Children;
+		int m_Fail;
+		// highest ban index of all patterns ending here, including suffixes
+		int m_Output;
+	};
+
+	CNameBan *m_pNameBans;
+	int m_NumNameBans;
+
+	// ban indices by skeleton length, ascending
+	std::vector<int> m_aLengthBuckets[MAX_NAME_SKELETON_LENGTH + 1];
+	int m_aMaxDistance[MAX_NAME_SKELETON_LENGTH + 1];
+	std::vector<CSkeletonInfo> m_vSkeletonInfos;
+
+	// aho-corasick automaton over the lowercased substring bans
+	std::vector<CNode> m_vNodes;
+	int m_EmptySubstringBan;
+
+	static void BuildHistogram(const int *pSkeleton, int Length, unsigned char *pHistogram);
+	int Step(int Node, int Code) const;
+
+public:
+	CNameBanIndex();
+
+	void Build(CNameBan *pNameBans, int NumNameBans);
+	CNameBan *IsNameBanned(const char *pName) const;
+};
+
 #endif // ENGINE_SERVER_NAME_BAN_H
@@ -24,6 +24,7 @@
 #include <engine/shared/netban.h>
 #include <engine/shared/network.h>
 #include <engine/shared/packer.h>
+#include <engine/shared/profiler.h>
 #include <engine/shared/protocol.h>
 #include <engine/shared/protocol_ex.h>
 #include <engine/shared/snapshot.h>
@@ -317,6 +318,10 @@ CServer::CServer() :
 	m_ServerInfoFirstRequest = 0;
 	m_ServerInfoNumRequests = 0;
 	m_ServerInfoNeedsUpdate = false;
+	m_ServerInfoStatsStart = 0;
+	mem_zero(m_aServerInfoRequests, sizeof(m_aServerInfoRequests));
+	mem_zero(m_aServerInfoRequestsPerSecond, sizeof(m_aServerInfoRequestsPerSecond));
+	mem_zero(m_aServerInfoRequestsTotal, sizeof(m_aServerInfoRequestsTotal));
 
 #ifdef CONF_FAMILY_UNIX
 	m_ConnLoggingSocketCreated = false;
@@ -326,6 +331,9 @@ CServer::CServer() :
 
 	m_aErrorShutdownReason[0] = 0;
 
+	m_NumTicks = 0;
+	m_NumTickOverruns = 0;
+
 	Init();
 }
 
@@ -374,7 +382,7 @@ void CServer::SetClientName(int ClientID, const char *pName)
 	if(!pName)
 		return;
 
-	CNameBan *pBanned = IsNameBanned(pName, m_aNameBans.base_ptr(), m_aNameBans.size());
+	CNameBan *pBanned = m_NameBanIndex.IsNameBanned(pName);
 	if(pBanned)
 	{
 		if(m_aClients[ClientID].m_State == CClient::STATE_READY)
@@ -1727,11 +1735,50 @@ bool CServer::RateLimitServerInfoConnless()
 	return SendClients;
 }
 
+void CServer::CountServerInfoRequest(int Stat)
+{
+	int64 Now = time_get();
+	if(Now >= m_ServerInfoStatsStart + time_freq())
+	{
+		// only keep the counts if they cover the last second
+		bool Recent = Now < m_ServerInfoStatsStart + 2 * time_freq();
+		for(int i = 0; i < NUM_SERVERINFO_STATS; i++)
+		{
+			m_aServerInfoRequestsPerSecond[i] = Recent ? m_aServerInfoRequests[i] : 0;
+			m_aServerInfoRequests[i] = 0;
+		}
+		m_ServerInfoStatsStart = Now;
+	}
+
+	if(Stat >= 0)
+	{
+		m_aServerInfoRequests[Stat]++;
+		m_aServerInfoRequestsTotal[Stat]++;
+	}
+}
+
 void CServer::SendServerInfoConnless(const NETADDR *pAddr, int Token, int Type)
 {
+	CountServerInfoRequest(Type);
 	SendServerInfo(pAddr, Token, Type, RateLimitServerInfoConnless());
 }
 
+void CServer::SendServerInfoSixupConnless(const NETADDR *pAddr, int Token, SECURITY_TOKEN ResponseToken)
+{
+	CountServerInfoRequest(SERVERINFO_STATS_SIXUP);
+	bool SendClients = RateLimitServerInfoConnless() && Token != -1;
+
+	unsigned char aToken[8];
+	int TokenSize = CVariableInt::Pack(aToken, Token) - aToken;
+
+	CNetChunk Response;
+	Response.m_ClientID = -1;
+	Response.m_Address = *pAddr;
+	Response.m_Flags = NETSENDFLAG_CONNLESS;
+	Response.m_pData = m_SixupServerInfoCache[SendClients].m_lCache.front().Packet(aToken, TokenSize, &Response.m_DataSize);
+	m_NetServer.SendConnlessSixup(&Response, ResponseToken);
+}
+
 static inline int GetCacheIndex(int Type, bool SendClient)
 {
 	if(Type == SERVERINFO_INGAME)
@@ -1754,8 +1801,19 @@ CServer::CCache::~CCache()
 
 CServer::CCache::CCacheChunk::CCacheChunk(const void *pData, int Size)
 {
-	mem_copy(m_aData, pData, Size);
+	mem_copy(m_aBuffer + MAX_PREFIX_SIZE, pData, Size);
 	m_DataSize = Size;
+	m_pHeader = SERVERBROWSE_INFO;
+}
+
+const unsigned char *CServer::CCache::CCacheChunk::Packet(const void *pToken, int TokenSize, int *pSize)
+{
+	dbg_assert(TokenSize <= MAX_PREFIX_SIZE - HEADER_SIZE, "token too long");
+	unsigned char *pStart = m_aBuffer + MAX_PREFIX_SIZE - TokenSize - HEADER_SIZE;
+	mem_copy(pStart, m_pHeader, HEADER_SIZE);
+	mem_copy(pStart + HEADER_SIZE, pToken, TokenSize);
+	*pSize = HEADER_SIZE + TokenSize + m_DataSize;
+	return pStart;
 }
 
 void CServer::CCache::AddChunk(const void *pData, int Size)
@@ -1768,6 +1826,19 @@ void CServer::CCache::Clear()
 	m_lCache.clear();
 }
 
+static void SetServerInfoHeaders(CServer::CCache *pCache, int Type)
+{
+	for(auto &Chunk : pCache->m_lCache)
+	{
+		if(Type == SERVERINFO_EXTENDED)
+			Chunk.m_pHeader = &Chunk == &pCache->m_lCache.front() ? SERVERBROWSE_INFO_EXTENDED : SERVERBROWSE_INFO_EXTENDED_MORE;
+		else if(Type == SERVERINFO_64_LEGACY)
+			Chunk.m_pHeader = SERVERBROWSE_INFO_64_LEGACY;
+		else
+			Chunk.m_pHeader = SERVERBROWSE_INFO;
+	}
+}
+
 void CServer::CacheServerInfo(CCache *pCache, int Type, bool SendClients)
 {
 	pCache->Clear();
@@ -1883,6 +1954,7 @@ void CServer::CacheServerInfo(CCache *pCache, int Type, bool SendClients)
 	if(!SendClients)
 	{
 		SAVE(pp.Size());
+		SetServerInfoHeaders(pCache, Type);
 		return;
 	}
 
@@ -1960,6 +2032,7 @@ void CServer::CacheServerInfo(CCache *pCache, int Type, bool SendClients)
 #undef RESET
 #undef ADD_RAW
 #undef ADD_INT
+	SetServerInfoHeaders(pCache, Type);
 }
 
 void CServer::CacheServerInfoSixup(CCache *pCache, bool SendClients)
@@ -2026,54 +2099,20 @@ void CServer::CacheServerInfoSixup(CCache *pCache, bool SendClients)
 
 void CServer::SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool SendClients)
 {
-	CPacker p;
-	char aBuf[128];
-	p.Reset();
-
 	CCache *pCache = &m_ServerInfoCache[GetCacheIndex(Type, SendClients)];
 
-#define ADD_RAW(p, x) (p).AddRaw(x, sizeof(x))
-#define ADD_INT(p, x) \
-	do \
-	{ \
-		str_format(aBuf, sizeof(aBuf), "%d", x); \
-		(p).AddString(aBuf, 0); \
-	} while(0)
+	// the token is the only part that differs between requests
+	char aToken[16];
+	int TokenSize = str_format(aToken, sizeof(aToken), "%d", Token) + 1;
 
 	CNetChunk Packet;
 	Packet.m_ClientID = -1;
 	Packet.m_Address = *pAddr;
 	Packet.m_Flags = NETSENDFLAG_CONNLESS;
 
-	for(const auto &Chunk : pCache->m_lCache)
+	for(auto &Chunk : pCache->m_lCache)
 	{
-		p.Reset();
-		if(Type == SERVERINFO_EXTENDED)
-		{
-			if(&Chunk == &pCache->m_lCache.front())
-				p.AddRaw(SERVERBROWSE_INFO_EXTENDED, sizeof(SERVERBROWSE_INFO_EXTENDED));
-			else
-				p.AddRaw(SERVERBROWSE_INFO_EXTENDED_MORE, sizeof(SERVERBROWSE_INFO_EXTENDED_MORE));
-			ADD_INT(p, Token);
-		}
-		else if(Type == SERVERINFO_64_LEGACY)
-		{
-			ADD_RAW(p, SERVERBROWSE_INFO_64_LEGACY);
-			ADD_INT(p, Token);
-		}
-		else if(Type == SERVERINFO_VANILLA || Type == SERVERINFO_INGAME)
-		{
-			ADD_RAW(p, SERVERBROWSE_INFO);
-			ADD_INT(p, Token);
-		}
-		else
-		{
-			dbg_assert(false, "unknown serverinfo type");
-		}
-
-		p.AddRaw(Chunk.m_aData, Chunk.m_DataSize);
-		Packet.m_pData = p.Data();
-		Packet.m_DataSize = p.Size();
+		Packet.m_pData = Chunk.Packet(aToken, TokenSize, &Packet.m_DataSize);
 		m_NetServer.Send(&Packet);
 	}
 }
@@ -2090,7 +2129,7 @@ void CServer::GetServerInfoSixup(CPacker *pPacker, int Token, bool SendClients)
 	SendClients = SendClients && Token != -1;
 
 	CCache::CCacheChunk &FirstChunk = m_SixupServerInfoCache[SendClients].m_lCache.front();
-	pPacker->AddRaw(FirstChunk.m_aData, FirstChunk.m_DataSize);
+	pPacker->AddRaw(FirstChunk.Data(), FirstChunk.m_DataSize);
 }
 
 void CServer::ExpireServerInfo()
@@ -2185,17 +2224,7 @@ void CServer::PumpNetwork(bool PacketWaiting)
 						if(Unpacker.Error())
 							continue;
 
-						CPacker Packer;
-						CNetChunk Response;
-
-						GetServerInfoSixup(&Packer, SrvBrwsToken, RateLimitServerInfoConnless());
-
-						Response.m_ClientID = -1;
-						Response.m_Address = Packet.m_Address;
-						Response.m_Flags = NETSENDFLAG_CONNLESS;
-						Response.m_pData = Packer.Data();
-						Response.m_DataSize = Packer.Size();
-						m_NetServer.SendConnlessSixup(&Response, ResponseToken);
+						SendServerInfoSixupConnless(&Packet.m_Address, SrvBrwsToken, ResponseToken);
 					}
 					else if(Type != -1)
 					{
@@ -2427,12 +2456,20 @@ int CServer::Run()
 		UpdateServerInfo();
 		while(m_RunServer < STOPPING)
 		{
+			static int s_NetworkZone = g_Profiler.RegisterZone("server/network");
+			static int s_TickZone = g_Profiler.RegisterZone("server/tick");
+			g_Profiler.SetEnabled(g_Config.m_DbgProfile);
+
 			if(NonActive)
+			{
+				CProfileScope Scope(s_NetworkZone);
 				PumpNetwork(PacketWaiting);
+			}
 
 			set_new_tick();
 
 			int64 t = time_get();
+			int64 TickStart = g_Profiler.Active() ? time_get_impl() : 0;
 			int NewTicks = 0;
 
 			// load new map TODO: don't poll this
@@ -2521,31 +2558,42 @@ int CServer::Run()
 
 			while(t > TickStartTime(m_CurrentGameTick + 1))
 			{
-				for(int c = 0; c < MAX_CLIENTS; c++)
-					if(m_aClients[c].m_State == CClient::STATE_INGAME)
-						for(int i = 0; i < 200; i++)
-							if(m_aClients[c].m_aInputs[i].m_GameTick == Tick() + 1)
-								GameServer()->OnClientPredictedEarlyInput(c, m_aClients[c].m_aInputs[i].m_aData);
+				static int s_InputZone = g_Profiler.RegisterZone("server/input");
+				static int s_GameTickZone = g_Profiler.RegisterZone("server/gametick");
+				{
+					CProfileScope Scope(s_InputZone);
+					for(int c = 0; c < MAX_CLIENTS; c++)
+						if(m_aClients[c].m_State == CClient::STATE_INGAME)
+							for(int i = 0; i < 200; i++)
+								if(m_aClients[c].m_aInputs[i].m_GameTick == Tick() + 1)
+									GameServer()->OnClientPredictedEarlyInput(c, m_aClients[c].m_aInputs[i].m_aData);
+				}
 
 				m_CurrentGameTick++;
 				NewTicks++;
 
 				// apply new input
-				for(int c = 0; c < MAX_CLIENTS; c++)
 				{
-					if(m_aClients[c].m_State != CClient::STATE_INGAME)
-						continue;
-					for(int i = 0; i < 200; i++)
+					CProfileScope Scope(s_InputZone);
+					for(int c = 0; c < MAX_CLIENTS; c++)
 					{
-						if(m_aClients[c].m_aInputs[i].m_GameTick == Tick())
+						if(m_aClients[c].m_State != CClient::STATE_INGAME)
+							continue;
+						for(int i = 0; i < 200; i++)
 						{
-							GameServer()->OnClientPredictedInput(c, m_aClients[c].m_aInputs[i].m_aData);
-							break;
+							if(m_aClients[c].m_aInputs[i].m_GameTick == Tick())
+							{
+								GameServer()->OnClientPredictedInput(c, m_aClients[c].m_aInputs[i].m_aData);
+								break;
+							}
 						}
 					}
 				}
 
-				GameServer()->OnTick();
+				{
+					CProfileScope Scope(s_GameTickZone);
+					GameServer()->OnTick();
+				}
 				if(ErrorShutdown())
 				{
 					break;
@@ -2555,8 +2603,12 @@ int CServer::Run()
 			// snap game
 			if(NewTicks)
 			{
+				static int s_SnapshotZone = g_Profiler.RegisterZone("server/snapshot");
 				if(g_Config.m_SvHighBandwidth || (m_CurrentGameTick % 2) == 0)
+				{
+					CProfileScope Scope(s_SnapshotZone);
 					DoSnapshot();
+				}
 
 				UpdateClientRconCommands();
 
@@ -2566,17 +2618,40 @@ int CServer::Run()
 			}
 
 			// master server stuff
-			m_Register.RegisterUpdate(m_NetServer.NetType());
-			if(g_Config.m_SvSixup)
-				m_RegSixup.RegisterUpdate(m_NetServer.NetType());
-
-			if(m_ServerInfoNeedsUpdate)
-				UpdateServerInfo();
+			{
+				static int s_RegisterZone = g_Profiler.RegisterZone("server/register");
+				CProfileScope Scope(s_RegisterZone);
+				m_Register.RegisterUpdate(m_NetServer.NetType());
+				if(g_Config.m_SvSixup)
+					m_RegSixup.RegisterUpdate(m_NetServer.NetType());
+
+				if(m_ServerInfoNeedsUpdate)
+					UpdateServerInfo();
+			}
 
-			Antibot()->OnEngineTick();
+			{
+				static int s_AntibotZone = g_Profiler.RegisterZone("server/antibot");
+				CProfileScope Scope(s_AntibotZone);
+				Antibot()->OnEngineTick();
+			}
 
 			if(!NonActive)
+			{
+				CProfileScope Scope(s_NetworkZone);
 				PumpNetwork(PacketWaiting);
+			}
+
+			if(TickStart)
+				g_Profiler.AddSample(s_TickZone, TickStart, time_get_impl());
+			if(NewTicks)
+			{
+				g_Profiler.NextFrame();
+
+				// the next tick should already have started
+				m_NumTicks += NewTicks;
+				if(time_get_impl() > TickStartTime(m_CurrentGameTick + 1))
+					m_NumTickOverruns++;
+			}
 
 			NonActive = true;
 
@@ -2957,11 +3032,13 @@ void CServer::ConNameBan(IConsole::IResult *pResult, void *pUser)
 			pBan->m_Distance = Distance;
 			pBan->m_IsSubstring = IsSubstring;
 			str_copy(pBan->m_aReason, pReason, sizeof(pBan->m_aReason));
+			pThis->m_NameBanIndex.Build(pThis->m_aNameBans.base_ptr(), pThis->m_aNameBans.size());
 			return;
 		}
 	}
 
 	pThis->m_aNameBans.add(CNameBan(pName, Distance, IsSubstring, pReason));
+	pThis->m_NameBanIndex.Build(pThis->m_aNameBans.base_ptr(), pThis->m_aNameBans.size());
 	str_format(aBuf, sizeof(aBuf), "added name='%s' distance=%d is_substring=%d reason='%s'", pName, Distance, IsSubstring, pReason);
 	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "name_ban", aBuf);
 }
@@ -2982,6 +3059,7 @@ void CServer::ConNameUnban(IConsole::IResult *pResult, void *pUser)
 			pThis->m_aNameBans.remove_index(i);
 		}
 	}
+	pThis->m_NameBanIndex.Build(pThis->m_aNameBans.base_ptr(), pThis->m_aNameBans.size());
 }
 
 void CServer::ConNameBans(IConsole::IResult *pResult, void *pUser)
@@ -2997,6 +3075,42 @@ void CServer::ConNameBans(IConsole::IResult *pResult, void *pUser)
 	}
 }
 
+void CServer::ConServerInfoStats(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = (CServer *)pUser;
+	pThis->CountServerInfoRequest(-1);
+
+	static const char *s_apNames[NUM_SERVERINFO_STATS] = {"vanilla", "64_legacy", "extended", "sixup"};
+	for(int i = 0; i < NUM_SERVERINFO_STATS; i++)
+	{
+		char aBuf[128];
+		str_format(aBuf, sizeof(aBuf), "%s: %d requests in the last second, %lld total", s_apNames[i], pThis->m_aServerInfoRequestsPerSecond[i], pThis->m_aServerInfoRequestsTotal[i]);
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+	}
+}
+
+void CServer::ConProfile(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = (CServer *)pUser;
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "%lld ticks, %lld took longer than a tick", pThis->m_NumTicks, pThis->m_NumTickOverruns);
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profiler", aBuf);
+	if(!g_Profiler.NumFrames())
+	{
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profiler", "no measurements, enable them with dbg_profile 1");
+		return;
+	}
+
+	str_format(aBuf, sizeof(aBuf), "over the last %d ticks or batches of ticks, in ms:", g_Profiler.NumFrames());
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profiler", aBuf);
+	for(int i = 0; i < g_Profiler.NumZones(); i++)
+	{
+		str_format(aBuf, sizeof(aBuf), "%s: p50=%.3f p99=%.3f max=%.3f", g_Profiler.ZoneName(i),
+			g_Profiler.Percentile(i, 50) * 1000.0f, g_Profiler.Percentile(i, 99) * 1000.0f, g_Profiler.Max(i) * 1000.0f);
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profiler", aBuf);
+	}
+}
+
 void CServer::ConShutdown(IConsole::IResult *pResult, void *pUser)
 {
 	((CServer *)pUser)->m_RunServer = STOPPING;
@@ -3399,6 +3513,9 @@ void CServer::RegisterCommands()
 	Console()->Register("name_ban", "s[name] ?i[distance] ?i[is_substring] ?r[reason]", CFGFLAG_SERVER, ConNameBan, this, "Ban a certain nick name");
 	Console()->Register("name_unban", "s[name]", CFGFLAG_SERVER, ConNameUnban, this, "Unban a certain nick name");
 	Console()->Register("name_bans", "", CFGFLAG_SERVER, ConNameBans, this, "List all name bans");
+	Console()->Register("server_info_stats", "", CFGFLAG_SERVER, ConServerInfoStats, this, "Show how many server info requests were answered");
+	Console()->Register("profile", "", CFGFLAG_SERVER, ConProfile, this, "Show how long the parts of a tick took and how many ticks overran");
+	g_Profiler.Init(Console(), m_pStorage, CFGFLAG_SERVER);
 
 	Console()->Chain("sv_name", ConchainSpecialInfoupdate, this);
 	Console()->Chain("password", ConchainSpecialInfoupdate, this);
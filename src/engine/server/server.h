@@ -254,7 +254,12 @@ public:
 
 	char m_aErrorShutdownReason[128];
 
+	// all ticks and how often their processing took until the next one was due
+	int64 m_NumTicks;
+	int64 m_NumTickOverruns;
+
 	array<CNameBan> m_aNameBans;
+	CNameBanIndex m_NameBanIndex;
 
 	CServer();
 
@@ -324,12 +329,27 @@ public:
 	public:
 		class CCacheChunk
 		{
+			enum
+			{
+				HEADER_SIZE = 8,
+				// room for the packet header and the token in front of the data
+				MAX_PREFIX_SIZE = HEADER_SIZE + 16,
+			};
+
+			unsigned char m_aBuffer[MAX_PREFIX_SIZE + NET_MAX_PAYLOAD];
+
 		public:
 			CCacheChunk(const void *pData, int Size);
 			CCacheChunk(const CCacheChunk &) = delete;
 
+			const unsigned char *Data() const { return m_aBuffer + MAX_PREFIX_SIZE; }
+			// writes header and token right in front of the data and
+			// returns the complete response
+			const unsigned char *Packet(const void *pToken, int TokenSize, int *pSize);
+
+			// header of the response, all of them are HEADER_SIZE long
+			const unsigned char *m_pHeader;
 			int m_DataSize;
-			unsigned char m_aData[NET_MAX_PAYLOAD];
 		};
 
 		std::list<CCacheChunk> m_lCache;
@@ -344,6 +364,17 @@ public:
 	CCache m_SixupServerInfoCache[2];
 	bool m_ServerInfoNeedsUpdate;
 
+	enum
+	{
+		// the other ones are indexed by the requested SERVERINFO_* type
+		SERVERINFO_STATS_SIXUP = 3,
+		NUM_SERVERINFO_STATS,
+	};
+	int64 m_ServerInfoStatsStart;
+	int m_aServerInfoRequests[NUM_SERVERINFO_STATS];
+	int m_aServerInfoRequestsPerSecond[NUM_SERVERINFO_STATS];
+	int64 m_aServerInfoRequestsTotal[NUM_SERVERINFO_STATS];
+
 	void ExpireServerInfo();
 	void CacheServerInfo(CCache *pCache, int Type, bool SendClients);
 	void CacheServerInfoSixup(CCache *pCache, bool SendClients);
@@ -351,6 +382,8 @@ public:
 	void GetServerInfoSixup(CPacker *pPacker, int Token, bool SendClients);
 	bool RateLimitServerInfoConnless();
 	void SendServerInfoConnless(const NETADDR *pAddr, int Token, int Type);
+	void SendServerInfoSixupConnless(const NETADDR *pAddr, int Token, SECURITY_TOKEN ResponseToken);
+	void CountServerInfoRequest(int Stat);
 	void UpdateServerInfo(bool Resend = false);
 
 	void PumpNetwork(bool PacketWaiting);
@@ -387,6 +420,8 @@ public:
 	static void ConNameBan(IConsole::IResult *pResult, void *pUser);
 	static void ConNameUnban(IConsole::IResult *pResult, void *pUser);
 	static void ConNameBans(IConsole::IResult *pResult, void *pUser);
+	static void ConServerInfoStats(IConsole::IResult *pResult, void *pUser);
+	static void ConProfile(IConsole::IResult *pResult, void *pUser);
 
 	// console commands for sqlmasters
 	static void ConAddSqlServer(IConsole::IResult *pResult, void *pUserData);
@@ -420,13 +420,18 @@ void CConsole::ExecuteLineStroked(int Stroke, const char *pStr, int ClientID, bo
 			pEnd++;
 		}
 
-		if(ParseStart(&Result, pStr, (pEnd - pStr) + 1) != 0)
-			return;
+		CCommand *pCommand;
+		bool Parsed = FindParsedLine(pStr, pEnd - pStr, &Result, &pCommand);
+		if(!Parsed)
+		{
+			if(ParseStart(&Result, pStr, (pEnd - pStr) + 1) != 0)
+				return;
 
-		if(!*Result.m_pCommand)
-			return;
+			if(!*Result.m_pCommand)
+				return;
 
-		CCommand *pCommand = FindCommand(Result.m_pCommand, m_FlagMask);
+			pCommand = FindCommand(Result.m_pCommand, m_FlagMask);
+		}
 
 		if(pCommand)
 		{
@@ -462,7 +467,13 @@ void CConsole::ExecuteLineStroked(int Stroke, const char *pStr, int ClientID, bo
 
 				if(Stroke || IsStrokeCommand)
 				{
-					if(ParseArgs(&Result, pCommand->m_pParams))
+					bool ArgsValid = Parsed || !ParseArgs(&Result, pCommand->m_pParams);
+
+					// the stroke argument doesn't point into the string storage, so don't cache those
+					if(ArgsValid && !Parsed && !IsStrokeCommand)
+						AddParsedLine(pStr, pEnd - pStr, pCommand, &Result);
+
+					if(!ArgsValid)
 					{
 						char aBuf[256];
 						str_format(aBuf, sizeof(aBuf), "Invalid arguments... Usage: %s %s", pCommand->m_pName, pCommand->m_pParams);
@@ -536,9 +547,18 @@ void CConsole::PossibleCommands(const char *pStr, int FlagMask, bool Temp, FPoss
 	}
 }
 
+unsigned CConsole::CommandHash(const char *pName)
+{
+	// case insensitive, matching the str_comp_nocase lookup
+	unsigned Hash = 5381;
+	for(; *pName; pName++)
+		Hash = ((Hash << 5) + Hash) + (unsigned char)str_uppercase(*pName);
+	return Hash % COMMAND_HASH_SIZE;
+}
+
 CConsole::CCommand *CConsole::FindCommand(const char *pName, int FlagMask)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->m_pNext)
+	for(CCommand *pCommand = m_apCommandHash[CommandHash(pName)]; pCommand; pCommand = pCommand->m_pNextHash)
 	{
 		if(pCommand->m_Flags & FlagMask)
 		{
@@ -550,6 +570,57 @@ CConsole::CCommand *CConsole::FindCommand(const char *pName, int FlagMask)
 	return 0x0;
 }
 
+static unsigned LineHash(const char *pStr, int Length)
+{
+	unsigned Hash = 5381;
+	for(int i = 0; i < Length; i++)
+		Hash = ((Hash << 5) + Hash) + (unsigned char)pStr[i];
+	return Hash;
+}
+
+bool CConsole::FindParsedLine(const char *pStr, int Length, CResult *pResult, CCommand **ppCommand)
+{
+	if(Length >= CParsedLine::MAX_LINE_LENGTH)
+		return false;
+
+	const CParsedLine *pLine = &m_aParseCache[LineHash(pStr, Length) % PARSE_CACHE_SIZE];
+	if(!pLine->m_pCommand || pLine->m_FlagMask != m_FlagMask || pLine->m_Length != Length || mem_comp(pLine->m_aLine, pStr, Length) != 0)
+		return false;
+
+	mem_copy(pResult->m_aStringStorage, pLine->m_aStorage, Length + 1);
+	pResult->m_pCommand = pResult->m_aStringStorage + pLine->m_CommandOffset;
+	pResult->m_pArgsStart = pResult->m_aStringStorage + Length;
+	for(int i = 0; i < pLine->m_NumArgs; i++)
+		pResult->AddArgument(pResult->m_aStringStorage + pLine->m_aArgOffsets[i]);
+	pResult->m_Victim = pLine->m_Victim;
+	*ppCommand = pLine->m_pCommand;
+	return true;
+}
+
+void CConsole::AddParsedLine(const char *pStr, int Length, CCommand *pCommand, const CResult *pResult)
+{
+	if(Length >= CParsedLine::MAX_LINE_LENGTH || pResult->NumArguments() > CParsedLine::MAX_ARGS)
+		return;
+
+	CParsedLine *pLine = &m_aParseCache[LineHash(pStr, Length) % PARSE_CACHE_SIZE];
+	pLine->m_pCommand = pCommand;
+	pLine->m_FlagMask = m_FlagMask;
+	pLine->m_Length = Length;
+	mem_copy(pLine->m_aLine, pStr, Length);
+	mem_copy(pLine->m_aStorage, pResult->m_aStringStorage, Length + 1);
+	pLine->m_CommandOffset = pResult->m_pCommand - pResult->m_aStringStorage;
+	pLine->m_NumArgs = pResult->NumArguments();
+	for(int i = 0; i < pLine->m_NumArgs; i++)
+		pLine->m_aArgOffsets[i] = pResult->m_apArgs[i] - pResult->m_aStringStorage;
+	pLine->m_Victim = pResult->m_Victim;
+}
+
+void CConsole::ClearParseCache()
+{
+	for(auto &Line : m_aParseCache)
+		Line.m_pCommand = 0;
+}
+
 void CConsole::ExecuteLine(const char *pStr, int ClientID, bool InterpretSemicolons)
 {
 	CConsole::ExecuteLineStroked(1, pStr, ClientID, InterpretSemicolons); // press it
@@ -932,6 +1003,8 @@ CConsole::CConsole(int FlagMask)
 	m_paStrokeStr[1] = "1";
 	m_ExecutionQueue.Reset();
 	m_pFirstCommand = 0;
+	mem_zero(m_apCommandHash, sizeof(m_apCommandHash));
+	ClearParseCache();
 	m_pFirstExec = 0;
 	mem_zero(m_aPrintCB, sizeof(m_aPrintCB));
 	m_NumPrintCB = 0;
@@ -1044,6 +1117,36 @@ void CConsole::AddCommandSorted(CCommand *pCommand)
 			}
 		}
 	}
+
+	unsigned Hash = CommandHash(pCommand->m_pName);
+	pCommand->m_pNextHash = m_apCommandHash[Hash];
+	m_apCommandHash[Hash] = pCommand;
+	ClearParseCache();
+}
+
+void CConsole::RemoveCommandHashed(CCommand *pCommand)
+{
+	for(CCommand **ppCur = &m_apCommandHash[CommandHash(pCommand->m_pName)]; *ppCur; ppCur = &(*ppCur)->m_pNextHash)
+	{
+		if(*ppCur == pCommand)
+		{
+			*ppCur = pCommand->m_pNextHash;
+			break;
+		}
+	}
+	ClearParseCache();
+}
+
+void CConsole::RebuildCommandHash()
+{
+	mem_zero(m_apCommandHash, sizeof(m_apCommandHash));
+	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->m_pNext)
+	{
+		unsigned Hash = CommandHash(pCommand->m_pName);
+		pCommand->m_pNextHash = m_apCommandHash[Hash];
+		m_apCommandHash[Hash] = pCommand;
+	}
+	ClearParseCache();
 }
 
 void CConsole::Register(const char *pName, const char *pParams,
@@ -1068,6 +1171,8 @@ void CConsole::Register(const char *pName, const char *pParams,
 
 	if(DoAdd)
 		AddCommandSorted(pCommand);
+	else
+		ClearParseCache();
 
 	if(pCommand->m_Flags & CFGFLAG_CHAT)
 		pCommand->SetAccessLevel(ACCESS_LEVEL_USER);
@@ -1134,6 +1239,7 @@ void CConsole::DeregisterTemp(const char *pName)
 	// add to recycle list
 	if(pRemoved)
 	{
+		RemoveCommandHashed(pRemoved);
 		pRemoved->m_pNext = m_pRecycleList;
 		m_pRecycleList = pRemoved;
 	}
@@ -1159,6 +1265,7 @@ void CConsole::DeregisterTempAll()
 
 	m_TempCommands.Reset();
 	m_pRecycleList = 0;
+	RebuildCommandHash();
 }
 
 void CConsole::Con_Chain(IResult *pResult, void *pUserData)
@@ -1205,7 +1312,7 @@ void CConsole::StoreCommands(bool Store)
 
 const IConsole::CCommandInfo *CConsole::GetCommandInfo(const char *pName, int FlagMask, bool Temp)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->m_pNext)
+	for(CCommand *pCommand = m_apCommandHash[CommandHash(pName)]; pCommand; pCommand = pCommand->m_pNextHash)
 	{
 		if(pCommand->m_Flags & FlagMask && pCommand->m_Temp == Temp)
 		{
@@ -14,6 +14,7 @@ class CConsole : public IConsole
 	{
 	public:
 		CCommand *m_pNext;
+		CCommand *m_pNextHash;
 		int m_Flags;
 		bool m_Temp;
 		FCommandCallback m_pfnCallback;
@@ -33,10 +34,16 @@ class CConsole : public IConsole
 		void *m_pUserData;
 	};
 
+	enum
+	{
+		COMMAND_HASH_SIZE = 1024,
+	};
+
 	int m_FlagMask;
 	bool m_StoreCommands;
 	const char *m_paStrokeStr[2];
 	CCommand *m_pFirstCommand;
+	CCommand *m_apCommandHash[COMMAND_HASH_SIZE];
 
 	class CExecFile
 	{
@@ -150,6 +157,39 @@ class CConsole : public IConsole
 	int ParseStart(CResult *pResult, const char *pString, int Length);
 	int ParseArgs(CResult *pResult, const char *pFormat);
 
+	// cache of already parsed command lines, so repeatedly executed binds,
+	// votes and chat commands skip tokenizing and argument parsing
+	class CParsedLine
+	{
+	public:
+		enum
+		{
+			MAX_LINE_LENGTH = 256,
+			MAX_ARGS = 16,
+		};
+
+		CCommand *m_pCommand;
+		int m_FlagMask;
+		int m_Length;
+		char m_aLine[MAX_LINE_LENGTH];
+		char m_aStorage[MAX_LINE_LENGTH];
+		int m_CommandOffset;
+		int m_NumArgs;
+		short m_aArgOffsets[MAX_ARGS];
+		int m_Victim;
+	};
+
+	enum
+	{
+		PARSE_CACHE_SIZE = 64,
+	};
+
+	CParsedLine m_aParseCache[PARSE_CACHE_SIZE];
+
+	bool FindParsedLine(const char *pStr, int Length, CResult *pResult, CCommand **ppCommand);
+	void AddParsedLine(const char *pStr, int Length, CCommand *pCommand, const CResult *pResult);
+	void ClearParseCache();
+
 	/*
 	this function will set pFormat to the next parameter (i,s,r,v,?) it contains and
 	return the parameter; descriptions in brackets like [file] will be skipped;
@@ -189,7 +229,10 @@ class CConsole : public IConsole
 		}
 	} m_ExecutionQueue;
 
+	static unsigned CommandHash(const char *pName);
 	void AddCommandSorted(CCommand *pCommand);
+	void RemoveCommandHashed(CCommand *pCommand);
+	void RebuildCommandHash();
 	CCommand *FindCommand(const char *pName, int FlagMask);
 
 public:
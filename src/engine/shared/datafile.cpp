@@ -6,6 +6,7 @@
 #include <base/hash_ctxt.h>
 #include <base/math.h>
 #include <base/system.h>
+#include <engine/shared/jobs.h>
 #include <engine/storage.h>
 
 #include "uuid_manager.h"
@@ -579,9 +580,59 @@ IOHANDLE CDataFileReader::File()
 	return m_pDataFile->m_File;
 }
 
+static void *CompressData(const void *pData, int Size, int Level, int *pCompressedSize)
+{
+	unsigned long s = compressBound(Size);
+	void *pCompData = malloc(s);
+
+	int Result = compress2((Bytef *)pCompData, &s, (const Bytef *)pData, Size, Level); // ignore_convention
+	if(Result != Z_OK)
+	{
+		dbg_msg("datafile", "compression error %d", Result);
+		dbg_assert(0, "zlib error");
+	}
+
+	// don't keep the worst case size around until the file is written
+	*pCompressedSize = (int)s;
+	return realloc(pCompData, maximum((int)s, 1));
+}
+
+class CDataFileCompressJob : public IJob
+{
+	void *m_pData;
+	int m_Size;
+	int m_Level;
+
+	void Run()
+	{
+		m_pCompressedData = CompressData(m_pData, m_Size, m_Level, &m_CompressedSize);
+		free(m_pData);
+		m_pData = 0;
+	}
+
+public:
+	CDataFileCompressJob(const void *pData, int Size, int Level) :
+		m_Size(Size), m_Level(Level), m_pCompressedData(0), m_CompressedSize(0)
+	{
+		m_pData = malloc(maximum(Size, 1));
+		mem_copy(m_pData, pData, Size);
+	}
+	~CDataFileCompressJob()
+	{
+		free(m_pData);
+		free(m_pCompressedData);
+	}
+
+	// taken over by the writer once the job is done
+	void *m_pCompressedData;
+	int m_CompressedSize;
+};
+
 CDataFileWriter::CDataFileWriter()
 {
 	m_File = 0;
+	m_pJobPool = 0;
+	m_CompressionLevel = Z_DEFAULT_COMPRESSION;
 	m_pItemTypes = static_cast<CItemTypeInfo *>(calloc(MAX_ITEM_TYPES, sizeof(CItemTypeInfo)));
 	m_pItems = static_cast<CItemInfo *>(calloc(MAX_ITEMS, sizeof(CItemInfo)));
 	m_pDatas = static_cast<CDataInfo *>(calloc(MAX_DATAS, sizeof(CDataInfo)));
@@ -613,6 +664,7 @@ void CDataFileWriter::Init()
 	m_NumExtendedItemTypes = 0;
 	mem_zero(m_pItemTypes, sizeof(CItemTypeInfo) * MAX_ITEM_TYPES);
 	mem_zero(m_aExtendedItemTypes, sizeof(m_aExtendedItemTypes));
+	m_vpCompressJobs.clear();
 
 	for(int i = 0; i < MAX_ITEM_TYPES; i++)
 	{
@@ -691,21 +743,18 @@ int CDataFileWriter::AddData(int Size, void *pData)
 	dbg_assert(m_NumDatas < 1024, "too much data");
 
 	CDataInfo *pInfo = &m_pDatas[m_NumDatas];
-	unsigned long s = compressBound(Size);
-	void *pCompData = malloc(s); // temporary buffer that we use during compression
-
-	int Result = compress((Bytef *)pCompData, &s, (Bytef *)pData, Size); // ignore_convention
-	if(Result != Z_OK)
+	pInfo->m_UncompressedSize = Size;
+	m_vpCompressJobs.resize(m_NumDatas + 1);
+	if(m_pJobPool)
 	{
-		dbg_msg("datafile", "compression error %d", Result);
-		dbg_assert(0, "zlib error");
+		std::shared_ptr<CDataFileCompressJob> pJob = std::make_shared<CDataFileCompressJob>(pData, Size, m_CompressionLevel);
+		m_pJobPool->Add(pJob);
+		m_vpCompressJobs[m_NumDatas] = pJob;
+		pInfo->m_CompressedSize = 0;
+		pInfo->m_pCompressedData = 0;
 	}
-
-	pInfo->m_UncompressedSize = Size;
-	pInfo->m_CompressedSize = (int)s;
-	pInfo->m_pCompressedData = malloc(pInfo->m_CompressedSize);
-	mem_copy(pInfo->m_pCompressedData, pCompData, pInfo->m_CompressedSize);
-	free(pCompData);
+	else
+		pInfo->m_pCompressedData = CompressData(pData, Size, m_CompressionLevel, &pInfo->m_CompressedSize);
 
 	m_NumDatas++;
 	return m_NumDatas - 1;
@@ -729,6 +778,18 @@ int CDataFileWriter::AddDataSwapped(int Size, void *pData)
 
 int CDataFileWriter::Finish()
 {
+	// collect the data compressed on the job pool, in order
+	for(int i = 0; i < (int)m_vpCompressJobs.size(); i++)
+	{
+		if(!m_vpCompressJobs[i])
+			continue;
+		m_pJobPool->Wait(m_vpCompressJobs[i]);
+		m_pDatas[i].m_CompressedSize = m_vpCompressJobs[i]->m_CompressedSize;
+		m_pDatas[i].m_pCompressedData = m_vpCompressJobs[i]->m_pCompressedData;
+		m_vpCompressJobs[i]->m_pCompressedData = 0;
+	}
+	m_vpCompressJobs.clear();
+
 	if(!m_File)
 		return 1;
 
@@ -8,6 +8,9 @@
 #include <base/hash.h>
 #include <base/system.h>
 
+#include <memory>
+#include <vector>
+
 // raw datafile access
 class CDataFileReader
 {
@@ -83,6 +86,8 @@ class CDataFileWriter
 	};
 
 	IOHANDLE m_File;
+	class CJobPool *m_pJobPool;
+	int m_CompressionLevel;
 	int m_NumItems;
 	int m_NumDatas;
 	int m_NumItemTypes;
@@ -91,6 +96,8 @@ class CDataFileWriter
 	CItemInfo *m_pItems;
 	CDataInfo *m_pDatas;
 	int m_aExtendedItemTypes[MAX_EXTENDED_ITEM_TYPES];
+	// per data index, empty for data that was compressed right away
+	std::vector<std::shared_ptr<class CDataFileCompressJob>> m_vpCompressJobs;
 
 	int GetExtendedItemTypeIndex(int Type);
 
@@ -100,6 +107,11 @@ public:
 	void Init();
 	bool OpenFile(class IStorage *pStorage, const char *pFilename, int StorageType = IStorage::TYPE_SAVE);
 	bool Open(class IStorage *pStorage, const char *Filename, int StorageType = IStorage::TYPE_SAVE);
+	// with a job pool AddData only copies the data and compresses it on the
+	// pool, Finish waits for it. the pool has to outlive the Finish call
+	void SetJobPool(class CJobPool *pJobPool) { m_pJobPool = pJobPool; }
+	// zlib level from 0 (store) to 9 (smallest), -1 for the default
+	void SetCompressionLevel(int Level) { m_CompressionLevel = Level; }
 	int AddData(int Size, void *pData);
 	int AddDataSwapped(int Size, void *pData);
 	int AddItem(int Type, int ID, int Size, void *pData);
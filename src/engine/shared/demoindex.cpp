@@ -0,0 +1,207 @@
+#include "demoindex.h"
+
+#include <base/math.h>
+#include <engine/storage.h>
+
+#include <unordered_set>
+
+static const char s_aMagic[4] = {'D', 'D', 'D', 'I'};
+
+static int NumMarkers(const char *pNumTimelineMarkers)
+{
+	int Num = ((pNumTimelineMarkers[0] << 24) & 0xFF000000) | ((pNumTimelineMarkers[1] << 16) & 0xFF0000) |
+		  ((pNumTimelineMarkers[2] << 8) & 0xFF00) | (pNumTimelineMarkers[3] & 0xFF);
+	return clamp(Num, 0, (int)MAX_TIMELINE_MARKERS);
+}
+
+CDemoIndex::CDemoIndex()
+{
+	m_Lock = lock_create();
+	m_Modified = false;
+}
+
+CDemoIndex::~CDemoIndex()
+{
+	lock_destroy(m_Lock);
+}
+
+std::string CDemoIndex::Key(const char *pPath, int StorageType)
+{
+	char aType[16];
+	str_format(aType, sizeof(aType), "%d:", StorageType);
+	return std::string(aType) + pPath;
+}
+
+void CDemoIndex::FillMapInfo(const CDemoHeader *pHeader, const SHA256_DIGEST *pSha256, CMapInfo *pMapInfo)
+{
+	// the same as CDemoPlayer::GetDemoInfo
+	str_copy(pMapInfo->m_aName, pHeader->m_aMapName, sizeof(pMapInfo->m_aName));
+	pMapInfo->m_Crc = (pHeader->m_aMapCrc[0] << 24) | (pHeader->m_aMapCrc[1] << 16) | (pHeader->m_aMapCrc[2] << 8) | (pHeader->m_aMapCrc[3]);
+	pMapInfo->m_Sha256 = *pSha256;
+	pMapInfo->m_Size = (pHeader->m_aMapSize[0] << 24) | (pHeader->m_aMapSize[1] << 16) | (pHeader->m_aMapSize[2] << 8) | (pHeader->m_aMapSize[3]);
+}
+
+void CDemoIndex::Clear()
+{
+	lock_wait(m_Lock);
+	m_Entries.clear();
+	m_Modified = false;
+	lock_unlock(m_Lock);
+}
+
+bool CDemoIndex::Load(IOHANDLE File)
+{
+	Clear();
+
+	int64 Length = io_length(File);
+	if(Length < (int64)sizeof(CFileHeader))
+		return false;
+	std::vector<unsigned char> vBuffer(Length);
+	if(io_read(File, &vBuffer[0], Length) != (unsigned)Length)
+		return false;
+
+	// the index is only written and read by the same machine, so there is no
+	// need to swap anything, a file from elsewhere just doesn't match
+	CFileHeader Header;
+	mem_copy(&Header, &vBuffer[0], sizeof(Header));
+	if(mem_comp(Header.m_aMagic, s_aMagic, sizeof(s_aMagic)) != 0 || Header.m_Version != VERSION || Header.m_NumItems < 0)
+		return false;
+
+	std::unordered_map<std::string, CEntry> Entries;
+	int64 Offset = sizeof(CFileHeader);
+	for(int i = 0; i < Header.m_NumItems; i++)
+	{
+		// records aren't aligned, so the items are copied out
+		CItem Item;
+		if(Length - Offset < (int64)sizeof(CItem))
+			return false;
+		mem_copy(&Item, &vBuffer[Offset], sizeof(Item));
+		Offset += sizeof(CItem);
+		if(Item.m_PathLength <= 0 || Item.m_PathLength >= MAX_PATH_LENGTH || Item.m_NumMarkers != NumMarkers(Item.m_aNumTimelineMarkers) ||
+			Length - Offset < Item.m_PathLength + Item.m_NumMarkers * (int64)sizeof(CTimelineMarkers::m_aTimelineMarkers[0]))
+			return false;
+
+		char aPath[MAX_PATH_LENGTH];
+		mem_copy(aPath, &vBuffer[Offset], Item.m_PathLength);
+		aPath[Item.m_PathLength] = 0;
+		Offset += Item.m_PathLength;
+
+		CEntry Entry;
+		mem_zero(&Entry, sizeof(Entry));
+		Entry.m_Size = Item.m_Size;
+		Entry.m_Time = Item.m_Time;
+		Entry.m_Valid = Item.m_Valid != 0;
+		Entry.m_Header = Item.m_Header;
+		mem_copy(Entry.m_TimelineMarkers.m_aNumTimelineMarkers, Item.m_aNumTimelineMarkers, sizeof(Item.m_aNumTimelineMarkers));
+		mem_copy(Entry.m_TimelineMarkers.m_aTimelineMarkers, &vBuffer[Offset], Item.m_NumMarkers * sizeof(Entry.m_TimelineMarkers.m_aTimelineMarkers[0]));
+		Offset += Item.m_NumMarkers * sizeof(Entry.m_TimelineMarkers.m_aTimelineMarkers[0]);
+		FillMapInfo(&Entry.m_Header, &Item.m_Sha256, &Entry.m_MapInfo);
+		Entries[Key(aPath, Item.m_StorageType)] = Entry;
+	}
+
+	lock_wait(m_Lock);
+	m_Entries.swap(Entries);
+	lock_unlock(m_Lock);
+	return true;
+}
+
+bool CDemoIndex::Save(IOHANDLE File)
+{
+	lock_wait(m_Lock);
+	std::vector<unsigned char> vBuffer(sizeof(CFileHeader));
+	CFileHeader Header;
+	mem_copy(Header.m_aMagic, s_aMagic, sizeof(Header.m_aMagic));
+	Header.m_Version = VERSION;
+	Header.m_NumItems = 0;
+	Header.m_Reserved = 0;
+	for(const auto &Pair : m_Entries)
+	{
+		const char *pPath = str_find(Pair.first.c_str(), ":") + 1;
+		CItem Item;
+		mem_zero(&Item, sizeof(Item));
+		Item.m_Size = Pair.second.m_Size;
+		Item.m_Time = Pair.second.m_Time;
+		Item.m_StorageType = str_toint(Pair.first.c_str());
+		Item.m_Valid = Pair.second.m_Valid;
+		Item.m_PathLength = str_length(pPath);
+		Item.m_Header = Pair.second.m_Header;
+		Item.m_Sha256 = Pair.second.m_MapInfo.m_Sha256;
+		mem_copy(Item.m_aNumTimelineMarkers, Pair.second.m_TimelineMarkers.m_aNumTimelineMarkers, sizeof(Item.m_aNumTimelineMarkers));
+		Item.m_NumMarkers = NumMarkers(Item.m_aNumTimelineMarkers);
+		if(Item.m_PathLength >= MAX_PATH_LENGTH)
+			continue;
+
+		int MarkersSize = Item.m_NumMarkers * sizeof(Pair.second.m_TimelineMarkers.m_aTimelineMarkers[0]);
+		int Offset = vBuffer.size();
+		vBuffer.resize(Offset + sizeof(CItem) + Item.m_PathLength + MarkersSize);
+		mem_copy(&vBuffer[Offset], &Item, sizeof(Item));
+		mem_copy(&vBuffer[Offset + sizeof(CItem)], pPath, Item.m_PathLength);
+		mem_copy(&vBuffer[Offset + sizeof(CItem) + Item.m_PathLength], Pair.second.m_TimelineMarkers.m_aTimelineMarkers, MarkersSize);
+		Header.m_NumItems++;
+	}
+	m_Modified = false;
+	lock_unlock(m_Lock);
+
+	mem_copy(&vBuffer[0], &Header, sizeof(Header));
+	return io_write(File, &vBuffer[0], vBuffer.size()) == vBuffer.size();
+}
+
+int CDemoIndex::Num()
+{
+	lock_wait(m_Lock);
+	int Num = m_Entries.size();
+	lock_unlock(m_Lock);
+	return Num;
+}
+
+bool CDemoIndex::Modified()
+{
+	lock_wait(m_Lock);
+	bool Modified = m_Modified;
+	lock_unlock(m_Lock);
+	return Modified;
+}
+
+bool CDemoIndex::Find(const char *pPath, int StorageType, int64 Size, int64 Time, CEntry *pEntry)
+{
+	std::string Path = Key(pPath, StorageType);
+	lock_wait(m_Lock);
+	auto It = m_Entries.find(Path);
+	bool Found = It != m_Entries.end() && It->second.m_Size == Size && It->second.m_Time == Time;
+	if(Found)
+		*pEntry = It->second;
+	lock_unlock(m_Lock);
+	return Found;
+}
+
+void CDemoIndex::Add(const char *pPath, int StorageType, const CEntry &Entry)
+{
+	std::string Path = Key(pPath, StorageType);
+	lock_wait(m_Lock);
+	m_Entries[Path] = Entry;
+	m_Modified = true;
+	lock_unlock(m_Lock);
+}
+
+void CDemoIndex::RemoveMissing(const char *pFolder, const std::vector<std::pair<std::string, int>> &vDemos)
+{
+	std::unordered_set<std::string> Listed;
+	for(const auto &Demo : vDemos)
+		Listed.insert(Key(Demo.first.c_str(), Demo.second));
+
+	int FolderLength = str_length(pFolder);
+	lock_wait(m_Lock);
+	for(auto It = m_Entries.begin(); It != m_Entries.end();)
+	{
+		const char *pPath = str_find(It->first.c_str(), ":") + 1;
+		bool InFolder = str_comp_num(pPath, pFolder, FolderLength) == 0 && pPath[FolderLength] == '/' && !str_find(pPath + FolderLength + 1, "/");
+		if(InFolder && !Listed.count(It->first))
+		{
+			It = m_Entries.erase(It);
+			m_Modified = true;
+		}
+		else
+			++It;
+	}
+	lock_unlock(m_Lock);
+}
@@ -0,0 +1,86 @@
+#ifndef ENGINE_SHARED_DEMOINDEX_H
+#define ENGINE_SHARED_DEMOINDEX_H
+
+#include <base/system.h>
+#include <engine/demo.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Remembers the headers of demos so the demo browser doesn't have to open
+// and parse every demo of a folder again. Entries are found by the path,
+// storage type, size and modification time of the demo.
+//
+// The file starts with a header, followed by one record per demo that only
+// holds the timeline markers actually used. All functions can be called
+// from any thread.
+class CDemoIndex
+{
+public:
+	enum
+	{
+		VERSION = 1,
+	};
+
+	struct CEntry
+	{
+		int64 m_Size;
+		int64 m_Time;
+		bool m_Valid;
+		CDemoHeader m_Header;
+		CTimelineMarkers m_TimelineMarkers;
+		CMapInfo m_MapInfo;
+	};
+
+private:
+	struct CFileHeader
+	{
+		char m_aMagic[4];
+		int m_Version;
+		int m_NumItems;
+		int m_Reserved;
+	};
+
+	struct CItem
+	{
+		int64 m_Size;
+		int64 m_Time;
+		int m_StorageType;
+		int m_Valid;
+		int m_PathLength;
+		int m_NumMarkers;
+		CDemoHeader m_Header;
+		SHA256_DIGEST m_Sha256;
+		char m_aNumTimelineMarkers[4];
+	};
+
+	LOCK m_Lock;
+	std::unordered_map<std::string, CEntry> m_Entries;
+	bool m_Modified;
+
+	static std::string Key(const char *pPath, int StorageType);
+	static void FillMapInfo(const CDemoHeader *pHeader, const SHA256_DIGEST *pSha256, CMapInfo *pMapInfo);
+
+public:
+	CDemoIndex();
+	~CDemoIndex();
+
+	// returns false if the file isn't a valid index, the index is empty then
+	bool Load(IOHANDLE File);
+	bool Save(IOHANDLE File);
+	void Clear();
+
+	int Num();
+	// true if entries were added or removed since the last load or save
+	bool Modified();
+
+	// copies the entry if the demo didn't change since it was added
+	bool Find(const char *pPath, int StorageType, int64 Size, int64 Time, CEntry *pEntry);
+	void Add(const char *pPath, int StorageType, const CEntry &Entry);
+	// removes the entries of demos directly in the folder that aren't listed
+	// in vDemos by path and storage type anymore
+	void RemoveMissing(const char *pFolder, const std::vector<std::pair<std::string, int>> &vDemos);
+};
+
+#endif // ENGINE_SHARED_DEMOINDEX_H
@@ -1,86 +1,192 @@
+#include "dilate.h"
+
 #include <base/math.h>
 #include <base/system.h>
 
-static void Dilate(int w, int h, int BPP, unsigned char *pSrc, unsigned char *pDest, unsigned char AlphaThreshold = 30)
+#include <engine/shared/jobs.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+enum
+{
+	DILATE_PASSES = 11,
+	// a band of rows only needs to look this far beyond its edges, every
+	// pass moves the color at most one row further
+	DILATE_HALO = DILATE_PASSES,
+	MIN_BAND_HEIGHT = 64,
+};
+
+static const unsigned char s_AlphaThreshold = 30;
+
+static void DilatePixel(int w, int h, int BPP, const unsigned char *pSrc, unsigned char *pDest, int x, int y)
 {
-	int ix, iy;
 	const int xo[] = {0, -1, 1, 0};
 	const int yo[] = {-1, 0, 0, 1};
 
 	int AlphaCompIndex = BPP - 1;
+	int m = (y * w + x) * BPP;
+	for(int i = 0; i < BPP; ++i)
+		pDest[m + i] = pSrc[m + i];
+	if(pSrc[m + AlphaCompIndex] > s_AlphaThreshold)
+		return;
 
-	int m = 0;
-	for(int y = 0; y < h; y++)
+	// take the color of the first opaque neighbour
+	for(int c = 0; c < 4; c++)
 	{
-		for(int x = 0; x < w; x++, m += BPP)
+		int ix = clamp(x + xo[c], 0, w - 1);
+		int iy = clamp(y + yo[c], 0, h - 1);
+		int k = iy * w * BPP + ix * BPP;
+		if(pSrc[k + AlphaCompIndex] > s_AlphaThreshold)
 		{
-			for(int i = 0; i < BPP; ++i)
-				pDest[m + i] = pSrc[m + i];
-			if(pSrc[m + AlphaCompIndex] > AlphaThreshold)
-				continue;
-
-			int SumOfOpaque[] = {0, 0, 0};
-			int Counter = 0;
-			for(int c = 0; c < 4; c++)
-			{
-				ix = clamp(x + xo[c], 0, w - 1);
-				iy = clamp(y + yo[c], 0, h - 1);
-				int k = iy * w * BPP + ix * BPP;
-				if(pSrc[k + AlphaCompIndex] > AlphaThreshold)
-				{
-					for(int p = 0; p < BPP - 1; ++p)
-						SumOfOpaque[p] += pSrc[k + p];
-					++Counter;
-					break;
-				}
-			}
+			for(int p = 0; p < BPP - 1; ++p)
+				pDest[m + p] = pSrc[k + p];
+			pDest[m + AlphaCompIndex] = 255;
+			return;
+		}
+	}
+}
 
-			if(Counter > 0)
-			{
-				for(int i = 0; i < BPP - 1; ++i)
-				{
-					SumOfOpaque[i] /= Counter;
-					pDest[m + i] = (unsigned char)SumOfOpaque[i];
-				}
+// same as DilatePixel, for pixels that have all four neighbours
+static void DilateInterior(int w, int BPP, const unsigned char *pSrc, unsigned char *pDest, int y, int x0, int x1)
+{
+	const int aOffsets[] = {-w * BPP, -BPP, BPP, w * BPP};
+	int AlphaCompIndex = BPP - 1;
+	for(int x = x0; x < x1; x++)
+	{
+		int m = (y * w + x) * BPP;
+		for(int i = 0; i < BPP; ++i)
+			pDest[m + i] = pSrc[m + i];
+		if(pSrc[m + AlphaCompIndex] > s_AlphaThreshold)
+			continue;
 
+		for(int c = 0; c < 4; c++)
+		{
+			int k = m + aOffsets[c];
+			if(pSrc[k + AlphaCompIndex] > s_AlphaThreshold)
+			{
+				for(int p = 0; p < BPP - 1; ++p)
+					pDest[m + p] = pSrc[k + p];
 				pDest[m + AlphaCompIndex] = 255;
+				break;
 			}
 		}
 	}
 }
 
-static void CopyColorValues(int w, int h, int BPP, unsigned char *pSrc, unsigned char *pDest)
+#if defined(__SSE2__)
+// four RGBA pixels at once, returns the first pixel that is left over
+static int DilateInteriorRGBA(int w, const unsigned char *pSrc, unsigned char *pDest, int y, int x0, int x1)
 {
-	int m = 0;
-	for(int y = 0; y < h; y++)
+	const __m128i Threshold = _mm_set1_epi32(s_AlphaThreshold);
+	const __m128i Alpha = _mm_set1_epi32(0xff000000);
+	const int Pitch = w * 4;
+	int x = x0;
+	for(; x + 4 <= x1; x += 4)
 	{
-		for(int x = 0; x < w; x++, m += BPP)
+		const unsigned char *p = pSrc + (y * w + x) * 4;
+		__m128i Center = _mm_loadu_si128((const __m128i *)p);
+		__m128i aNeighbours[4] = {
+			_mm_loadu_si128((const __m128i *)(p - Pitch)),
+			_mm_loadu_si128((const __m128i *)(p - 4)),
+			_mm_loadu_si128((const __m128i *)(p + 4)),
+			_mm_loadu_si128((const __m128i *)(p + Pitch)),
+		};
+
+		// select backwards, so the first opaque neighbour wins
+		__m128i Result = Center;
+		for(int c = 3; c >= 0; c--)
 		{
-			for(int i = 0; i < BPP - 1; ++i)
-				pDest[m + i] = pSrc[m + i];
+			__m128i Opaque = _mm_cmpgt_epi32(_mm_srli_epi32(aNeighbours[c], 24), Threshold);
+			__m128i Color = _mm_or_si128(aNeighbours[c], Alpha);
+			Result = _mm_or_si128(_mm_and_si128(Opaque, Color), _mm_andnot_si128(Opaque, Result));
 		}
+		__m128i Opaque = _mm_cmpgt_epi32(_mm_srli_epi32(Center, 24), Threshold);
+		Result = _mm_or_si128(_mm_and_si128(Opaque, Center), _mm_andnot_si128(Opaque, Result));
+		_mm_storeu_si128((__m128i *)(pDest + (y * w + x) * 4), Result);
 	}
+	return x;
 }
+#endif
 
-void DilateImage(unsigned char *pImageBuff, int w, int h, int BPP)
+static void Dilate(int w, int h, int BPP, const unsigned char *pSrc, unsigned char *pDest)
 {
-	unsigned char *pBuffer[2] = {NULL, NULL};
+	for(int y = 0; y < h; y++)
+	{
+		if(y == 0 || y == h - 1 || w < 3)
+		{
+			for(int x = 0; x < w; x++)
+				DilatePixel(w, h, BPP, pSrc, pDest, x, y);
+			continue;
+		}
 
-	pBuffer[0] = (unsigned char *)malloc(w * h * sizeof(unsigned char) * BPP);
-	pBuffer[1] = (unsigned char *)malloc(w * h * sizeof(unsigned char) * BPP);
+		// only the pixels at the border need their neighbours clamped
+		DilatePixel(w, h, BPP, pSrc, pDest, 0, y);
+		int x = 1;
+#if defined(__SSE2__)
+		if(BPP == 4)
+			x = DilateInteriorRGBA(w, pSrc, pDest, y, x, w - 1);
+#endif
+		DilateInterior(w, BPP, pSrc, pDest, y, x, w - 1);
+		DilatePixel(w, h, BPP, pSrc, pDest, w - 1, y);
+	}
+}
 
-	unsigned char *pPixelBuff = (unsigned char *)pImageBuff;
+// dilates the rows from y0 to y1 of the image into pResult. the band is
+// processed with enough rows around it that it comes out exactly like
+// dilating the whole image
+static void DilateBand(const unsigned char *pImageBuff, unsigned char *pResult, int w, int h, int BPP, int y0, int y1)
+{
+	int Start = maximum(y0 - (int)DILATE_HALO, 0);
+	int End = minimum(y1 + (int)DILATE_HALO, h);
+	int Rows = End - Start;
+	int RowSize = w * BPP;
 
-	Dilate(w, h, BPP, pPixelBuff, pBuffer[0]);
+	unsigned char *apBuffer[2];
+	apBuffer[0] = (unsigned char *)malloc(Rows * RowSize);
+	apBuffer[1] = (unsigned char *)malloc(Rows * RowSize);
 
-	for(int i = 0; i < 5; i++)
+	Dilate(w, Rows, BPP, pImageBuff + Start * RowSize, apBuffer[0]);
+	for(int i = 0; i < (DILATE_PASSES - 1) / 2; i++)
 	{
-		Dilate(w, h, BPP, pBuffer[0], pBuffer[1]);
-		Dilate(w, h, BPP, pBuffer[1], pBuffer[0]);
+		Dilate(w, Rows, BPP, apBuffer[0], apBuffer[1]);
+		Dilate(w, Rows, BPP, apBuffer[1], apBuffer[0]);
 	}
 
-	CopyColorValues(w, h, BPP, pBuffer[0], pPixelBuff);
+	mem_copy(pResult + y0 * RowSize, apBuffer[0] + (y0 - Start) * RowSize, (y1 - y0) * RowSize);
+	free(apBuffer[0]);
+	free(apBuffer[1]);
+}
 
-	free(pBuffer[0]);
-	free(pBuffer[1]);
+void DilateImage(unsigned char *pImageBuff, int w, int h, int BPP, CJobPool *pJobPool)
+{
+	if(w <= 0 || h <= 0)
+		return;
+
+	// bands of rows are independent, so they are spread over the pool
+	int NumBands = 1;
+	if(pJobPool)
+		NumBands = clamp(h / MIN_BAND_HEIGHT, 1, minimum(pJobPool->NumThreads(), (int)CParallelWork::MAX_HELPERS) + 1);
+
+	unsigned char *pResult = (unsigned char *)malloc(w * h * BPP);
+	if(NumBands == 1)
+		DilateBand(pImageBuff, pResult, w, h, BPP, 0, h);
+	else
+	{
+		CParallelWork Work(NumBands, [&](int Band) {
+			DilateBand(pImageBuff, pResult, w, h, BPP, h * Band / NumBands, h * (Band + 1) / NumBands);
+		});
+		pJobPool->Add(Work.HelperJobs(), CJobPool::PRIORITY_HIGH);
+		Work.WaitAll();
+	}
+
+	// only the colors change, the alpha channel stays as it was
+	int m = 0;
+	for(int i = 0; i < w * h; i++, m += BPP)
+	{
+		for(int c = 0; c < BPP - 1; ++c)
+			pImageBuff[m + c] = pResult[m + c];
+	}
+	free(pResult);
 }
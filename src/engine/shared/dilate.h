@@ -1,6 +1,7 @@
 #ifndef ENGINE_SHARED_DILATE_H
 #define ENGINE_SHARED_DILATE_H
 
-void DilateImage(unsigned char *pImageBuff, int w, int h, int BPP);
+// with a job pool, bands of rows are dilated on its workers as well
+void DilateImage(unsigned char *pImageBuff, int w, int h, int BPP, class CJobPool *pJobPool = 0);
 
 #endif
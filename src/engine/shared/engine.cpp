@@ -94,13 +94,28 @@ public:
 		// open logfile if needed
 		if(g_Config.m_Logfile[0])
 			dbg_logger_file(g_Config.m_Logfile);
+
+		if(g_Config.m_LogfileAsync)
+			dbg_logger_async();
 	}
 
-	void AddJob(std::shared_ptr<IJob> pJob)
+	void AddJob(std::shared_ptr<IJob> pJob, int Priority)
 	{
 		if(g_Config.m_Debug)
 			dbg_msg("engine", "job added");
-		m_JobPool.Add(std::move(pJob));
+		m_JobPool.Add(std::move(pJob), Priority);
+	}
+
+	void AddJobs(const std::vector<std::shared_ptr<IJob>> &vpJobs, int Priority)
+	{
+		if(g_Config.m_Debug)
+			dbg_msg("engine", "%d jobs added", (int)vpJobs.size());
+		m_JobPool.Add(vpJobs, Priority);
+	}
+
+	void WaitJob(const std::shared_ptr<IJob> &pJob)
+	{
+		m_JobPool.Wait(pJob);
 	}
 };
 
@@ -2,6 +2,8 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include "jobs.h"
 
+#include <base/math.h>
+
 IJob::IJob() :
 	m_Status(STATE_PENDING)
 {
@@ -27,15 +29,18 @@ int IJob::Status()
 	return m_Status.load();
 }
 
+// the worker the current thread belongs to, if any
+static thread_local void *s_pCurrentWorker = 0;
+
 CJobPool::CJobPool()
 {
 	// empty the pool
 	m_NumThreads = 0;
+	m_pWorkers = 0;
 	m_Shutdown = false;
-	m_Lock = lock_create();
+	m_NextWorker = 0;
+	m_NumWaiting = 0;
 	sphore_init(&m_Semaphore);
-	m_pFirstJob = 0;
-	m_pLastJob = 0;
 }
 
 CJobPool::~CJobPool()
@@ -45,62 +50,253 @@ CJobPool::~CJobPool()
 		sphore_signal(&m_Semaphore);
 	for(int i = 0; i < m_NumThreads; i++)
 	{
-		if(m_apThreads[i])
-			thread_wait(m_apThreads[i]);
+		if(m_pWorkers[i].m_pThread)
+			thread_wait(m_pWorkers[i].m_pThread);
+	}
+	if(m_pWorkers)
+	{
+		for(int i = 0; i < maximum(m_NumThreads, 1); i++)
+			lock_destroy(m_pWorkers[i].m_Lock);
+		delete[] m_pWorkers;
 	}
-	lock_destroy(m_Lock);
 	sphore_destroy(&m_Semaphore);
 }
 
+bool CJobPool::RunJob(const std::shared_ptr<IJob> &pJob)
+{
+	// a job taken by Wait() stays queued, whoever comes second skips it
+	int Expected = IJob::STATE_PENDING;
+	if(!pJob->m_Status.compare_exchange_strong(Expected, IJob::STATE_RUNNING))
+		return false;
+	pJob->Run();
+	pJob->m_Status = IJob::STATE_DONE;
+
+	if(m_NumWaiting.load() > 0)
+	{
+		std::lock_guard<std::mutex> Lock(m_WaitMutex);
+		m_WaitCond.notify_all();
+	}
+	return true;
+}
+
 void CJobPool::WorkerThread(void *pUser)
 {
-	CJobPool *pPool = (CJobPool *)pUser;
+	CWorker *pWorker = (CWorker *)pUser;
+	CJobPool *pPool = pWorker->m_pPool;
+	s_pCurrentWorker = pWorker;
 
 	while(!pPool->m_Shutdown)
 	{
-		std::shared_ptr<IJob> pJob = 0;
-
-		// fetch job from queue
+		// one wakeup per added job. if the job was run by a thread
+		// waiting in Wait() in the meantime, there is nothing to do
 		sphore_wait(&pPool->m_Semaphore);
-		lock_wait(pPool->m_Lock);
-		if(pPool->m_pFirstJob)
+		if(pPool->m_Shutdown)
+			break;
+		std::shared_ptr<IJob> pJob = pPool->TakeJob(pWorker->m_Index);
+		if(pJob)
+			pPool->RunJob(pJob);
+	}
+}
+
+void CJobPool::Init(int NumThreads)
+{
+	// a pool without threads still gets a queue, its jobs run in Wait()
+	m_NumThreads = maximum(NumThreads, 0);
+	m_pWorkers = new CWorker[maximum(m_NumThreads, 1)];
+	for(int i = 0; i < maximum(m_NumThreads, 1); i++)
+	{
+		CWorker *pWorker = &m_pWorkers[i];
+		pWorker->m_pPool = this;
+		pWorker->m_Index = i;
+		pWorker->m_pThread = 0;
+		pWorker->m_Lock = lock_create();
+		for(auto &NumJobs : pWorker->m_aNumJobs)
+			NumJobs = 0;
+	}
+
+	// start threads
+	for(int i = 0; i < m_NumThreads; i++)
+		m_pWorkers[i].m_pThread = thread_init(WorkerThread, &m_pWorkers[i], "CJobPool worker");
+}
+
+int CJobPool::SubmitWorker()
+{
+	// keep jobs added by a job on the same worker, it's likely to be idle soon
+	CWorker *pCurrent = (CWorker *)s_pCurrentWorker;
+	if(pCurrent && pCurrent->m_pPool == this)
+		return pCurrent->m_Index;
+	return m_NextWorker.fetch_add(1, std::memory_order_relaxed) % maximum(m_NumThreads, 1);
+}
+
+void CJobPool::Push(CWorker *pWorker, std::shared_ptr<IJob> pJob, int Priority)
+{
+	lock_wait(pWorker->m_Lock);
+	pWorker->m_aQueues[Priority].push_back(std::move(pJob));
+	pWorker->m_aNumJobs[Priority]++;
+	lock_unlock(pWorker->m_Lock);
+}
+
+std::shared_ptr<IJob> CJobPool::Pop(CWorker *pWorker, int Priority)
+{
+	if(pWorker->m_aNumJobs[Priority].load(std::memory_order_relaxed) == 0)
+		return 0;
+
+	std::shared_ptr<IJob> pJob = 0;
+	lock_wait(pWorker->m_Lock);
+	std::deque<std::shared_ptr<IJob>> &Queue = pWorker->m_aQueues[Priority];
+	if(!Queue.empty())
+	{
+		pJob = std::move(Queue.front());
+		Queue.pop_front();
+		pWorker->m_aNumJobs[Priority]--;
+	}
+	lock_unlock(pWorker->m_Lock);
+	return pJob;
+}
+
+std::shared_ptr<IJob> CJobPool::TakeJob(int Worker)
+{
+	int NumWorkers = maximum(m_NumThreads, 1);
+	for(int Priority = 0; Priority < NUM_PRIORITIES; Priority++)
+	{
+		// own queue first, then steal from the others
+		for(int i = 0; i < NumWorkers; i++)
 		{
-			pJob = pPool->m_pFirstJob;
-			pPool->m_pFirstJob = pPool->m_pFirstJob->m_pNext;
-			if(!pPool->m_pFirstJob)
-				pPool->m_pLastJob = 0;
+			std::shared_ptr<IJob> pJob = Pop(&m_pWorkers[(Worker + i) % NumWorkers], Priority);
+			if(pJob)
+				return pJob;
 		}
-		lock_unlock(pPool->m_Lock);
+	}
+	return 0;
+}
 
-		// do the job if we have one
-		if(pJob)
+void CJobPool::Add(std::shared_ptr<IJob> pJob, int Priority)
+{
+	dbg_assert(m_pWorkers != 0, "job pool not initialized");
+	dbg_assert(Priority >= 0 && Priority < NUM_PRIORITIES, "invalid job priority");
+
+	Push(&m_pWorkers[SubmitWorker()], std::move(pJob), Priority);
+	sphore_signal(&m_Semaphore);
+}
+
+void CJobPool::Add(const std::vector<std::shared_ptr<IJob>> &vpJobs, int Priority)
+{
+	dbg_assert(m_pWorkers != 0, "job pool not initialized");
+	dbg_assert(Priority >= 0 && Priority < NUM_PRIORITIES, "invalid job priority");
+
+	// hand every worker one contiguous part, taking each lock only once
+	int NumWorkers = maximum(m_NumThreads, 1);
+	int NumJobs = vpJobs.size();
+	int First = SubmitWorker();
+	for(int i = 0; i < NumWorkers; i++)
+	{
+		int Begin = (long long)NumJobs * i / NumWorkers;
+		int End = (long long)NumJobs * (i + 1) / NumWorkers;
+		if(Begin == End)
+			continue;
+
+		CWorker *pWorker = &m_pWorkers[(First + i) % NumWorkers];
+		lock_wait(pWorker->m_Lock);
+		for(int j = Begin; j < End; j++)
+			pWorker->m_aQueues[Priority].push_back(vpJobs[j]);
+		pWorker->m_aNumJobs[Priority] += End - Begin;
+		lock_unlock(pWorker->m_Lock);
+	}
+
+	for(int i = 0; i < NumJobs; i++)
+		sphore_signal(&m_Semaphore);
+}
+
+void CJobPool::Wait(const std::shared_ptr<IJob> &pJob)
+{
+	// still queued, run it here instead of waiting for a worker that
+	// may be busy with a download
+	if(RunJob(pJob))
+	{
+		// without threads nobody pops the queue, drop the job from it
+		if(m_NumThreads == 0)
 		{
-			pJob->m_Status = IJob::STATE_RUNNING;
-			pJob->Run();
-			pJob->m_Status = IJob::STATE_DONE;
+			CWorker *pWorker = &m_pWorkers[0];
+			lock_wait(pWorker->m_Lock);
+			for(int Priority = 0; Priority < NUM_PRIORITIES; Priority++)
+			{
+				std::deque<std::shared_ptr<IJob>> &Queue = pWorker->m_aQueues[Priority];
+				for(auto It = Queue.begin(); It != Queue.end(); ++It)
+				{
+					if(*It == pJob)
+					{
+						Queue.erase(It);
+						pWorker->m_aNumJobs[Priority]--;
+						break;
+					}
+				}
+			}
+			lock_unlock(pWorker->m_Lock);
 		}
+		return;
 	}
+
+	std::unique_lock<std::mutex> Lock(m_WaitMutex);
+	m_NumWaiting++;
+	while(pJob->Status() != IJob::STATE_DONE)
+		m_WaitCond.wait(Lock);
+	m_NumWaiting--;
 }
 
-void CJobPool::Init(int NumThreads)
+void CJobPool::Wait(const std::vector<std::shared_ptr<IJob>> &vpJobs)
 {
-	// start threads
-	m_NumThreads = NumThreads > MAX_THREADS ? MAX_THREADS : NumThreads;
-	for(int i = 0; i < NumThreads; i++)
-		m_apThreads[i] = thread_init(WorkerThread, this, "CJobPool worker");
+	for(const auto &pJob : vpJobs)
+		Wait(pJob);
 }
 
-void CJobPool::Add(std::shared_ptr<IJob> pJob)
+bool CParallelWork::CState::RunNext()
 {
-	lock_wait(m_Lock);
+	int Item = m_NextItem++;
+	if(Item >= m_NumItems)
+		return false;
+	m_Func(Item);
+	m_pDone[Item] = true;
+	return true;
+}
+
+void CParallelWork::CHelperJob::Run()
+{
+	while(m_pState->RunNext())
+	{
+	}
+}
 
-	// add job to queue
-	if(m_pLastJob)
-		m_pLastJob->m_pNext = pJob;
-	m_pLastJob = std::move(pJob);
-	if(!m_pFirstJob)
-		m_pFirstJob = m_pLastJob;
+CParallelWork::CParallelWork(int NumItems, std::function<void(int)> Func) :
+	m_pState(std::make_shared<CState>())
+{
+	m_pState->m_Func = std::move(Func);
+	m_pState->m_NumItems = NumItems;
+	m_pState->m_NextItem = 0;
+	m_pState->m_pDone.reset(new std::atomic<bool>[maximum(NumItems, 1)]);
+	for(int i = 0; i < NumItems; i++)
+		m_pState->m_pDone[i] = false;
+}
 
-	lock_unlock(m_Lock);
-	sphore_signal(&m_Semaphore);
+std::vector<std::shared_ptr<IJob>> CParallelWork::HelperJobs() const
+{
+	std::vector<std::shared_ptr<IJob>> vpJobs;
+	for(int i = 0; i < minimum(m_pState->m_NumItems, (int)MAX_HELPERS); i++)
+		vpJobs.push_back(std::make_shared<CHelperJob>(m_pState));
+	return vpJobs;
+}
+
+void CParallelWork::Wait(int Item)
+{
+	while(!IsDone(Item))
+	{
+		// when all items are taken, the item is being processed elsewhere
+		if(!m_pState->RunNext())
+			thread_yield();
+	}
+}
+
+void CParallelWork::WaitAll()
+{
+	for(int i = 0; i < m_pState->m_NumItems; i++)
+		Wait(i);
 }
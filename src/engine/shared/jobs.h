@@ -6,7 +6,12 @@
 #include <base/system.h>
 
 #include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 class IJob;
 class CJobPool;
@@ -16,8 +21,6 @@ class IJob
 	friend class CJobPool;
 
 private:
-	std::shared_ptr<IJob> m_pNext;
-
 	std::atomic<int> m_Status;
 	virtual void Run() = 0;
 
@@ -36,28 +39,117 @@ public:
 	};
 };
 
+// Every worker owns one queue per priority. Jobs added from outside the
+// pool are spread over the workers, jobs added from inside a job go to the
+// current worker. Idle workers steal from the others, always taking the
+// highest priority job available anywhere first.
 class CJobPool
 {
+public:
 	enum
 	{
-		MAX_THREADS = 32
+		PRIORITY_HIGH = 0, // blocks something the user is waiting for, e.g. map or skin loading
+		PRIORITY_NORMAL,
+		PRIORITY_LOW, // background network requests, e.g. http or host lookups
+		NUM_PRIORITIES
+	};
+
+private:
+	struct CWorker
+	{
+		CJobPool *m_pPool;
+		int m_Index;
+		void *m_pThread;
+
+		LOCK m_Lock;
+		std::deque<std::shared_ptr<IJob>> m_aQueues[NUM_PRIORITIES];
+		// read without the lock to skip empty queues
+		std::atomic<int> m_aNumJobs[NUM_PRIORITIES];
 	};
+
 	int m_NumThreads;
-	void *m_apThreads[MAX_THREADS];
+	CWorker *m_pWorkers;
 	std::atomic<bool> m_Shutdown;
+	std::atomic<unsigned> m_NextWorker;
 
-	LOCK m_Lock;
+	// counts added jobs, not guaranteed to match the queued ones exactly
 	SEMAPHORE m_Semaphore;
-	std::shared_ptr<IJob> m_pFirstJob;
-	std::shared_ptr<IJob> m_pLastJob;
+
+	// threads blocked in Wait() for a job running elsewhere
+	std::mutex m_WaitMutex;
+	std::condition_variable m_WaitCond;
+	std::atomic<int> m_NumWaiting;
 
 	static void WorkerThread(void *pUser);
 
+	int SubmitWorker();
+	void Push(CWorker *pWorker, std::shared_ptr<IJob> pJob, int Priority);
+	std::shared_ptr<IJob> Pop(CWorker *pWorker, int Priority);
+	std::shared_ptr<IJob> TakeJob(int Worker);
+	// runs the job unless another thread already started it
+	bool RunJob(const std::shared_ptr<IJob> &pJob);
+
 public:
 	CJobPool();
 	~CJobPool();
 
 	void Init(int NumThreads);
-	void Add(std::shared_ptr<IJob> pJob);
+	int NumThreads() const { return m_NumThreads; }
+	void Add(std::shared_ptr<IJob> pJob, int Priority = PRIORITY_NORMAL);
+	void Add(const std::vector<std::shared_ptr<IJob>> &vpJobs, int Priority = PRIORITY_NORMAL);
+
+	// runs the job on the calling thread if no worker started it yet,
+	// otherwise blocks until it's done. never runs other jobs, so it is
+	// safe to use from inside a job as well
+	void Wait(const std::shared_ptr<IJob> &pJob);
+	void Wait(const std::vector<std::shared_ptr<IJob>> &vpJobs);
+};
+
+// Numbered work items processed by pool workers and the waiting thread
+// together, in increasing order. Waiting helps with the remaining items
+// instead of waiting for a worker to get to them, so it can't get stuck
+// behind an unrelated long running job like a download.
+class CParallelWork
+{
+public:
+	enum
+	{
+		// more than the pools have workers, unneeded helpers return at once
+		MAX_HELPERS = 8,
+	};
+
+private:
+	struct CState
+	{
+		std::function<void(int)> m_Func;
+		int m_NumItems;
+		std::atomic<int> m_NextItem;
+		std::unique_ptr<std::atomic<bool>[]> m_pDone;
+
+		bool RunNext();
+	};
+
+	class CHelperJob : public IJob
+	{
+		std::shared_ptr<CState> m_pState;
+		void Run();
+
+	public:
+		CHelperJob(std::shared_ptr<CState> pState) :
+			m_pState(std::move(pState)) {}
+	};
+
+	std::shared_ptr<CState> m_pState;
+
+public:
+	CParallelWork(int NumItems, std::function<void(int)> Func);
+
+	// jobs for a pool that process items until none are left
+	std::vector<std::shared_ptr<IJob>> HelperJobs() const;
+
+	bool IsDone(int Item) const { return m_pState->m_pDone[Item].load(); }
+	// processes items on the calling thread until the item is done
+	void Wait(int Item);
+	void WaitAll();
 };
 #endif
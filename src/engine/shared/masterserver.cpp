@@ -55,7 +55,7 @@ public:
 		for(int i = 0; i < MAX_MASTERSERVERS; i++)
 		{
 			*m_apLookup[i] = CHostLookup(m_aMasterServers[i].m_aHostname, Nettype);
-			m_pEngine->AddJob(m_apLookup[i]);
+			m_pEngine->AddJob(m_apLookup[i], CJobPool::PRIORITY_LOW);
 			m_aMasterServers[i].m_Valid = false;
 			m_aMasterServers[i].m_Count = 0;
 		}
@@ -4,8 +4,109 @@
 #include <engine/shared/config.h>
 #include <engine/storage.h>
 
+#include "linereader.h"
 #include "netban.h"
 
+struct CNetPrefix
+{
+	unsigned char m_aIp[16];
+	int m_Length;
+};
+
+enum
+{
+	MAX_NET_PREFIXES = 2 * 128,
+};
+
+static int NetFamily(const NETADDR *pAddr)
+{
+	if(pAddr->type == NETTYPE_IPV4)
+		return 0;
+	if(pAddr->type == NETTYPE_IPV6)
+		return 1;
+	return -1;
+}
+
+static int NetBits(int Family)
+{
+	return Family == 0 ? 32 : 128;
+}
+
+static int NetBit(const unsigned char *pIp, int Bit)
+{
+	return (pIp[Bit / 8] >> (7 - Bit % 8)) & 1;
+}
+
+static int NetCommonPrefix(const unsigned char *pIp1, const unsigned char *pIp2, int MaxBits)
+{
+	int Bit = 0;
+	for(; Bit + 8 <= MaxBits && pIp1[Bit / 8] == pIp2[Bit / 8]; Bit += 8)
+		;
+	for(; Bit < MaxBits && NetBit(pIp1, Bit) == NetBit(pIp2, Bit); ++Bit)
+		;
+	return Bit;
+}
+
+static bool NetPrefixMatch(const unsigned char *pPrefix, const unsigned char *pIp, int Length)
+{
+	if(Length >= 8 && mem_comp(pPrefix, pIp, Length / 8) != 0)
+		return false;
+	int Rest = Length % 8;
+	return Rest == 0 || ((pPrefix[Length / 8] ^ pIp[Length / 8]) >> (8 - Rest)) == 0;
+}
+
+static int MakeNetPrefixes(const NETADDR *pAddr, CNetPrefix *pPrefixes)
+{
+	mem_copy(pPrefixes[0].m_aIp, pAddr->ip, sizeof(pPrefixes[0].m_aIp));
+	pPrefixes[0].m_Length = NetBits(NetFamily(pAddr));
+	return 1;
+}
+
+// splits the range into the minimal set of prefixes covering it
+static int MakeNetPrefixes(const CNetRange *pRange, CNetPrefix *pPrefixes)
+{
+	int Bytes = pRange->m_LB.type == NETTYPE_IPV4 ? 4 : 16;
+	int Bits = Bytes * 8;
+	unsigned char aCur[16], aEnd[16];
+	mem_copy(aCur, pRange->m_LB.ip, sizeof(aCur));
+
+	int Num = 0;
+	while(Num < MAX_NET_PREFIXES)
+	{
+		// largest aligned block starting at aCur
+		int Zeros = 0;
+		for(; Zeros < Bits && !NetBit(aCur, Bits - 1 - Zeros); ++Zeros)
+			;
+		for(int k = Zeros;; --k)
+		{
+			mem_copy(aEnd, aCur, sizeof(aEnd));
+			for(int i = 0; i < k; ++i)
+				aEnd[Bytes - 1 - i / 8] |= 1 << (i % 8);
+			if(mem_comp(aEnd, pRange->m_UB.ip, Bytes) <= 0)
+			{
+				mem_copy(pPrefixes[Num].m_aIp, aCur, sizeof(aCur));
+				pPrefixes[Num].m_Length = Bits - k;
+				++Num;
+				break;
+			}
+		}
+
+		if(mem_comp(aEnd, pRange->m_UB.ip, Bytes) == 0)
+			break;
+
+		// continue right after the block
+		mem_copy(aCur, aEnd, sizeof(aCur));
+		for(int i = Bytes - 1; i >= 0 && ++aCur[i] == 0; --i)
+			;
+	}
+	return Num;
+}
+
+static int NetFamily(const CNetRange *pRange)
+{
+	return NetFamily(&pRange->m_LB);
+}
+
 CNetBan::CNetHash::CNetHash(const NETADDR *pAddr)
 {
 	if(pAddr->type == NETTYPE_IPV4)
@@ -29,25 +130,225 @@ CNetBan::CNetHash::CNetHash(const CNetRange *pRange)
 	m_Hash &= 0xFF;
 }
 
-int CNetBan::CNetHash::MakeHashArray(const NETADDR *pAddr, CNetHash aHash[17])
+template<class T>
+int CNetBan::CBanTrie<T>::NewNode(const unsigned char *pPrefix, int Length)
 {
-	int Length = pAddr->type == NETTYPE_IPV4 ? 4 : 16;
-	aHash[0].m_Hash = 0;
-	aHash[0].m_HashIndex = 0;
-	for(int i = 1, Sum = 0; i <= Length; ++i)
+	int Node;
+	if(m_FirstFreeNode >= 0)
+	{
+		Node = m_FirstFreeNode;
+		m_FirstFreeNode = m_vNodes[Node].m_aChildren[0];
+	}
+	else
 	{
-		Sum += pAddr->ip[i - 1];
-		aHash[i].m_Hash = Sum & 0xFF;
-		aHash[i].m_HashIndex = i % Length;
+		Node = m_vNodes.size();
+		m_vNodes.emplace_back();
 	}
-	return Length;
+
+	CNode *pNode = &m_vNodes[Node];
+	mem_zero(pNode->m_aPrefix, sizeof(pNode->m_aPrefix));
+	mem_copy(pNode->m_aPrefix, pPrefix, (Length + 7) / 8);
+	pNode->m_Length = Length;
+	pNode->m_aChildren[0] = pNode->m_aChildren[1] = -1;
+	pNode->m_FirstEntry = -1;
+	return Node;
+}
+
+template<class T>
+void CNetBan::CBanTrie<T>::FreeNode(int Node)
+{
+	m_vNodes[Node].m_aChildren[0] = m_FirstFreeNode;
+	m_FirstFreeNode = Node;
+}
+
+template<class T>
+void CNetBan::CBanTrie<T>::AddPrefix(int Family, const unsigned char *pPrefix, int Length, CBan<T> *pBan)
+{
+	// find or create the node for this prefix
+	int Parent = -1, Slot = Family;
+	int Node;
+	while(1)
+	{
+		Node = Link(Family, Parent, Slot);
+		if(Node < 0)
+		{
+			Node = NewNode(pPrefix, Length);
+			Link(Family, Parent, Slot) = Node;
+			break;
+		}
+
+		int NodeLength = m_vNodes[Node].m_Length;
+		int Common = NetCommonPrefix(pPrefix, m_vNodes[Node].m_aPrefix, minimum(Length, NodeLength));
+		if(Common == NodeLength)
+		{
+			if(Length == NodeLength)
+				break;
+			Parent = Node;
+			Slot = NetBit(pPrefix, NodeLength);
+			continue;
+		}
+
+		// split the edge
+		int Split = NewNode(pPrefix, Common);
+		m_vNodes[Split].m_aChildren[NetBit(m_vNodes[Node].m_aPrefix, Common)] = Node;
+		Link(Family, Parent, Slot) = Split;
+		if(Common == Length)
+		{
+			Node = Split;
+			break;
+		}
+		int Leaf = NewNode(pPrefix, Length);
+		m_vNodes[Split].m_aChildren[NetBit(pPrefix, Common)] = Leaf;
+		Node = Leaf;
+		break;
+	}
+
+	// add the ban entry
+	int Entry;
+	if(m_FirstFreeEntry >= 0)
+	{
+		Entry = m_FirstFreeEntry;
+		m_FirstFreeEntry = m_vEntries[Entry].m_Next;
+	}
+	else
+	{
+		Entry = m_vEntries.size();
+		m_vEntries.emplace_back();
+	}
+	m_vEntries[Entry].m_pBan = pBan;
+	m_vEntries[Entry].m_Next = m_vNodes[Node].m_FirstEntry;
+	m_vNodes[Node].m_FirstEntry = Entry;
+}
+
+template<class T>
+void CNetBan::CBanTrie<T>::RemovePrefix(int Family, const unsigned char *pPrefix, int Length, CBan<T> *pBan)
+{
+	int GrandParent = -1, GrandSlot = Family;
+	int Parent = -1, Slot = Family;
+	int Node = Link(Family, Parent, Slot);
+	while(Node >= 0)
+	{
+		const CNode *pNode = &m_vNodes[Node];
+		if(NetCommonPrefix(pPrefix, pNode->m_aPrefix, minimum(Length, pNode->m_Length)) < pNode->m_Length)
+			return;
+		if(pNode->m_Length == Length)
+			break;
+		GrandParent = Parent;
+		GrandSlot = Slot;
+		Parent = Node;
+		Slot = NetBit(pPrefix, pNode->m_Length);
+		Node = pNode->m_aChildren[Slot];
+	}
+	if(Node < 0)
+		return;
+
+	// remove the ban entry
+	for(int *pEntry = &m_vNodes[Node].m_FirstEntry; *pEntry >= 0; pEntry = &m_vEntries[*pEntry].m_Next)
+	{
+		if(m_vEntries[*pEntry].m_pBan == pBan)
+		{
+			int Entry = *pEntry;
+			*pEntry = m_vEntries[Entry].m_Next;
+			m_vEntries[Entry].m_Next = m_FirstFreeEntry;
+			m_FirstFreeEntry = Entry;
+			break;
+		}
+	}
+
+	// keep the trie compressed
+	CNode *pNode = &m_vNodes[Node];
+	if(pNode->m_FirstEntry >= 0 || (pNode->m_aChildren[0] >= 0 && pNode->m_aChildren[1] >= 0))
+		return;
+
+	int Child = pNode->m_aChildren[0] >= 0 ? pNode->m_aChildren[0] : pNode->m_aChildren[1];
+	Link(Family, Parent, Slot) = Child;
+	FreeNode(Node);
+
+	// the parent might be a pass-through node now
+	if(Child < 0 && Parent >= 0)
+	{
+		CNode *pParent = &m_vNodes[Parent];
+		if(pParent->m_FirstEntry < 0)
+		{
+			Link(Family, GrandParent, GrandSlot) = pParent->m_aChildren[Slot ^ 1];
+			FreeNode(Parent);
+		}
+	}
+}
+
+template<class T>
+void CNetBan::CBanTrie<T>::Add(CBan<T> *pBan)
+{
+	int Family = NetFamily(&pBan->m_Data);
+	if(Family < 0)
+		return;
+
+	CNetPrefix aPrefixes[MAX_NET_PREFIXES];
+	int Num = MakeNetPrefixes(&pBan->m_Data, aPrefixes);
+	for(int i = 0; i < Num; ++i)
+		AddPrefix(Family, aPrefixes[i].m_aIp, aPrefixes[i].m_Length, pBan);
+}
+
+template<class T>
+void CNetBan::CBanTrie<T>::Remove(CBan<T> *pBan)
+{
+	int Family = NetFamily(&pBan->m_Data);
+	if(Family < 0)
+		return;
+
+	CNetPrefix aPrefixes[MAX_NET_PREFIXES];
+	int Num = MakeNetPrefixes(&pBan->m_Data, aPrefixes);
+	for(int i = 0; i < Num; ++i)
+		RemovePrefix(Family, aPrefixes[i].m_aIp, aPrefixes[i].m_Length, pBan);
+}
+
+template<class T>
+void CNetBan::CBanTrie<T>::Reset()
+{
+	m_vNodes.clear();
+	m_vEntries.clear();
+	m_FirstFreeNode = -1;
+	m_FirstFreeEntry = -1;
+	m_aRoots[0] = m_aRoots[1] = -1;
+}
+
+template<class T>
+typename CNetBan::CBan<T> *CNetBan::CBanTrie<T>::Find(const NETADDR *pAddr) const
+{
+	int Family = NetFamily(pAddr);
+	if(Family < 0)
+		return 0;
+
+	// descend by the address bits only, the skipped prefix bits are
+	// verified afterwards for the nodes that actually hold bans
+	int Bits = NetBits(Family);
+	int aCandidates[128 + 1];
+	int NumCandidates = 0;
+	for(int Node = m_aRoots[Family]; Node >= 0;)
+	{
+		const CNode *pNode = &m_vNodes[Node];
+		if(pNode->m_FirstEntry >= 0)
+			aCandidates[NumCandidates++] = Node;
+		if(pNode->m_Length >= Bits)
+			break;
+		Node = pNode->m_aChildren[NetBit(pAddr->ip, pNode->m_Length)];
+	}
+
+	// most specific match first
+	for(int i = NumCandidates - 1; i >= 0; --i)
+	{
+		const CNode *pNode = &m_vNodes[aCandidates[i]];
+		if(NetPrefixMatch(pNode->m_aPrefix, pAddr->ip, pNode->m_Length))
+			return m_vEntries[pNode->m_FirstEntry].m_pBan;
+	}
+	return 0;
 }
 
 template<class T, int HashCount>
 typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Add(const T *pData, const CBanInfo *pInfo, const CNetHash *pNetHash)
 {
 	if(!m_pFirstFree)
-		return 0;
+		AllocChunk();
 
 	// create new ban
 	CBan<T> *pBan = m_pFirstFree;
@@ -68,6 +369,9 @@ typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Add(const T *pData,
 	pBan->m_pHashNext = m_paaHashList[pNetHash->m_HashIndex][pNetHash->m_Hash];
 	m_paaHashList[pNetHash->m_HashIndex][pNetHash->m_Hash] = pBan;
 
+	// add it to the lookup trie
+	m_Trie.Add(pBan);
+
 	// insert it into the used list
 	if(m_pFirstUsed)
 	{
@@ -123,6 +427,9 @@ int CNetBan::CBanPool<T, HashCount>::Remove(CBan<T> *pBan)
 		m_paaHashList[pBan->m_NetHash.m_HashIndex][pBan->m_NetHash.m_Hash] = pBan->m_pHashNext;
 	pBan->m_pHashNext = pBan->m_pHashPrev = 0;
 
+	// remove from lookup trie
+	m_Trie.Remove(pBan);
+
 	// remove from used list
 	if(pBan->m_pNext)
 		pBan->m_pNext->m_pPrev = pBan->m_pPrev;
@@ -198,23 +505,41 @@ void CNetBan::UnbanAll()
 	m_BanRangePool.Reset();
 }
 
+template<class T, int HashCount>
+void CNetBan::CBanPool<T, HashCount>::AllocChunk()
+{
+	CBan<T> *pChunk = new CBan<T>[BAN_CHUNK_SIZE];
+	mem_zero(pChunk, sizeof(CBan<T>) * BAN_CHUNK_SIZE);
+	m_vpBanChunks.push_back(pChunk);
+
+	for(int i = 1; i < BAN_CHUNK_SIZE - 1; ++i)
+	{
+		pChunk[i].m_pNext = &pChunk[i + 1];
+		pChunk[i].m_pPrev = &pChunk[i - 1];
+	}
+
+	pChunk[0].m_pNext = &pChunk[1];
+	pChunk[BAN_CHUNK_SIZE - 1].m_pPrev = &pChunk[BAN_CHUNK_SIZE - 2];
+	pChunk[BAN_CHUNK_SIZE - 1].m_pNext = m_pFirstFree;
+	if(m_pFirstFree)
+		m_pFirstFree->m_pPrev = &pChunk[BAN_CHUNK_SIZE - 1];
+	m_pFirstFree = &pChunk[0];
+}
+
 template<class T, int HashCount>
 void CNetBan::CBanPool<T, HashCount>::Reset()
 {
+	for(auto *pChunk : m_vpBanChunks)
+		delete[] pChunk;
+	m_vpBanChunks.clear();
+
 	mem_zero(m_paaHashList, sizeof(m_paaHashList));
-	mem_zero(m_aBans, sizeof(m_aBans));
+	m_Trie.Reset();
 	m_pFirstUsed = 0;
+	m_pFirstFree = 0;
 	m_CountUsed = 0;
 
-	for(int i = 1; i < MAX_BANS - 1; ++i)
-	{
-		m_aBans[i].m_pNext = &m_aBans[i + 1];
-		m_aBans[i].m_pPrev = &m_aBans[i - 1];
-	}
-
-	m_aBans[0].m_pNext = &m_aBans[1];
-	m_aBans[MAX_BANS - 1].m_pPrev = &m_aBans[MAX_BANS - 2];
-	m_pFirstFree = &m_aBans[0];
+	AllocChunk();
 }
 
 template<class T, int HashCount>
@@ -311,6 +636,7 @@ void CNetBan::Init(IConsole *pConsole, IStorage *pStorage)
 	Console()->Register("unban_all", "", CFGFLAG_SERVER | CFGFLAG_MASTER | CFGFLAG_STORE, ConUnbanAll, this, "Unban all entries");
 	Console()->Register("bans", "", CFGFLAG_SERVER | CFGFLAG_MASTER | CFGFLAG_STORE, ConBans, this, "Show banlist");
 	Console()->Register("bans_save", "s[file]", CFGFLAG_SERVER | CFGFLAG_MASTER | CFGFLAG_STORE, ConBansSave, this, "Save banlist in a file");
+	Console()->Register("bans_import", "s[file] ?i[minutes] ?r[reason]", CFGFLAG_SERVER | CFGFLAG_MASTER | CFGFLAG_STORE, ConBansImport, this, "Import a list of ips, ip ranges and CIDR blocks from a file");
 }
 
 void CNetBan::Update()
@@ -402,11 +728,9 @@ bool CNetBan::IsBanned(const NETADDR *pOrigAddr, char *pBuf, unsigned BufferSize
 		pAddr = &addr;
 		addr.type = NETTYPE_IPV4;
 	}
-	CNetHash aHash[17];
-	int Length = CNetHash::MakeHashArray(pAddr, aHash);
 
 	// check ban addresses
-	CBanAddr *pBan = m_BanAddrPool.Find(pAddr, &aHash[Length]);
+	CBanAddr *pBan = m_BanAddrPool.Lookup(pAddr);
 	if(pBan)
 	{
 		MakeBanInfo(pBan, pBuf, BufferSize, MSGTYPE_PLAYER);
@@ -414,19 +738,120 @@ bool CNetBan::IsBanned(const NETADDR *pOrigAddr, char *pBuf, unsigned BufferSize
 	}
 
 	// check ban ranges
-	for(int i = Length - 1; i >= 0; --i)
+	CBanRange *pBanRange = m_BanRangePool.Lookup(pAddr);
+	if(pBanRange)
+	{
+		MakeBanInfo(pBanRange, pBuf, BufferSize, MSGTYPE_PLAYER);
+		return true;
+	}
+
+	return false;
+}
+
+template<class T>
+int CNetBan::BanSilent(T *pBanPool, const typename T::CDataType *pData, const CBanInfo *pInfo)
+{
+	// do not ban localhost
+	if(NetMatch(pData, &m_LocalhostIPV4) || NetMatch(pData, &m_LocalhostIPV6))
+		return -1;
+
+	CNetHash NetHash(pData);
+	CBan<typename T::CDataType> *pBan = pBanPool->Find(pData, &NetHash);
+	if(pBan)
+		pBanPool->Update(pBan, pInfo);
+	else
+		pBanPool->Add(pData, pInfo, &NetHash);
+	return 0;
+}
+
+static bool ParseBanAddr(const char *pStr, NETADDR *pAddr)
+{
+	// accept bare IPv6 addresses as well
+	char aBuf[128];
+	if(pStr[0] != '[' && str_find(pStr, ":") != str_rchr(pStr, ':'))
 	{
-		for(CBanRange *pBan = m_BanRangePool.First(&aHash[i]); pBan; pBan = pBan->m_pHashNext)
+		str_format(aBuf, sizeof(aBuf), "[%s]", pStr);
+		pStr = aBuf;
+	}
+	return net_addr_from_str(pAddr, pStr) == 0;
+}
+
+int CNetBan::ImportBans(const char *pFilename, int Seconds, const char *pReason)
+{
+	IOHANDLE File = Storage()->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_ALL);
+	if(!File)
+		return -1;
+
+	CBanInfo Info = {0};
+	Info.m_Expires = Seconds > 0 ? time_timestamp() + Seconds : CBanInfo::EXPIRES_NEVER;
+	str_copy(Info.m_aReason, pReason, sizeof(Info.m_aReason));
+
+	// one entry per line: "addr", "addr/prefixlength" or "first-last"
+	int Count = 0;
+	char *pLine;
+	CLineReader LineReader;
+	LineReader.Init(File);
+	while((pLine = LineReader.Get()))
+	{
+		char *pComment = (char *)str_find(pLine, "#");
+		if(pComment)
+			*pComment = 0;
+
+		char *pFirst = str_skip_whitespaces(pLine);
+		if(!*pFirst)
+			continue;
+
+		char *pEnd = pFirst;
+		while(*pEnd && !str_isspace(*pEnd) && *pEnd != '\r' && *pEnd != '-' && *pEnd != '/')
+			pEnd++;
+		char Separator = *pEnd;
+		char *pSecond = Separator ? str_skip_whitespaces(pEnd + 1) : pEnd;
+		*pEnd = 0;
+		if(*pSecond == '-' && Separator != '/')
+			pSecond = str_skip_whitespaces(pSecond + 1);
+		*str_skip_to_whitespace(pSecond) = 0;
+
+		int PrefixLength = -1;
+		if(Separator == '/')
+		{
+			// an empty or broken length must not turn into /0
+			if(!*pSecond || str_length(pSecond) > 3 || !str_isallnum(pSecond))
+				continue;
+			PrefixLength = str_toint(pSecond);
+			pSecond = 0;
+		}
+		else if(!*pSecond)
+			pSecond = 0;
+
+		CNetRange Range;
+		if(!ParseBanAddr(pFirst, &Range.m_LB) || (pSecond && !ParseBanAddr(pSecond, &Range.m_UB)))
+			continue;
+
+		if(PrefixLength >= 0)
 		{
-			if(NetMatch(&pBan->m_Data, pAddr, i, Length))
+			int Bits = Range.m_LB.type == NETTYPE_IPV4 ? 32 : 128;
+			if(PrefixLength > Bits)
+				continue;
+			Range.m_UB = Range.m_LB;
+			for(int i = PrefixLength; i < Bits; ++i)
 			{
-				MakeBanInfo(pBan, pBuf, BufferSize, MSGTYPE_PLAYER);
-				return true;
+				Range.m_LB.ip[i / 8] &= ~(1 << (7 - i % 8));
+				Range.m_UB.ip[i / 8] |= 1 << (7 - i % 8);
 			}
+			if(PrefixLength < Bits)
+				pSecond = pFirst;
 		}
-	}
 
-	return false;
+		if(!pSecond || NetComp(&Range.m_LB, &Range.m_UB) == 0)
+		{
+			if(BanSilent(&m_BanAddrPool, &Range.m_LB, &Info) == 0)
+				++Count;
+		}
+		else if(Range.IsValid() && BanSilent(&m_BanRangePool, &Range, &Info) == 0)
+			++Count;
+	}
+	io_close(File);
+	return Count;
 }
 
 void CNetBan::ConBan(IConsole::IResult *pResult, void *pUser)
@@ -558,3 +983,19 @@ void CNetBan::ConBansSave(IConsole::IResult *pResult, void *pUser)
 	str_format(aBuf, sizeof(aBuf), "saved banlist to '%s'", pResult->GetString(0));
 	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
 }
+
+void CNetBan::ConBansImport(IConsole::IResult *pResult, void *pUser)
+{
+	CNetBan *pThis = static_cast<CNetBan *>(pUser);
+
+	int Minutes = pResult->NumArguments() > 1 ? clamp(pResult->GetInteger(1), 0, 44640) : 0;
+	const char *pReason = pResult->NumArguments() > 2 ? pResult->GetString(2) : "No reason given";
+
+	char aBuf[256];
+	int Count = pThis->ImportBans(pResult->GetString(0), Minutes * 60, pReason);
+	if(Count < 0)
+		str_format(aBuf, sizeof(aBuf), "failed to import banlist from '%s'", pResult->GetString(0));
+	else
+		str_format(aBuf, sizeof(aBuf), "imported %d %s from '%s'", Count, Count == 1 ? "ban" : "bans", pResult->GetString(0));
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
+}
@@ -5,6 +5,8 @@
 
 #include <base/system.h>
 
+#include <vector>
+
 inline int NetComp(const NETADDR *pAddr1, const NETADDR *pAddr2)
 {
 	return mem_comp(pAddr1, pAddr2, pAddr1->type == NETTYPE_IPV4 ? 8 : 20);
@@ -69,8 +71,6 @@ protected:
 		CNetHash() {}
 		CNetHash(const NETADDR *pAddr);
 		CNetHash(const CNetRange *pRange);
-
-		static int MakeHashArray(const NETADDR *pAddr, CNetHash aHash[17]);
 	};
 
 	struct CBanInfo
@@ -100,6 +100,47 @@ protected:
 		CBan *m_pPrev;
 	};
 
+	// compressed binary prefix trie (IPv4 and IPv6) over the banned
+	// addresses/ranges, ranges are split into their covering prefixes
+	template<class T>
+	class CBanTrie
+	{
+	public:
+		void Add(CBan<T> *pBan);
+		void Remove(CBan<T> *pBan);
+		void Reset();
+
+		// returns the most specific ban covering the address
+		CBan<T> *Find(const NETADDR *pAddr) const;
+
+	private:
+		struct CNode
+		{
+			unsigned char m_aPrefix[16];
+			int m_Length; // in bits
+			int m_aChildren[2];
+			int m_FirstEntry;
+		};
+
+		struct CEntry
+		{
+			CBan<T> *m_pBan;
+			int m_Next;
+		};
+
+		int NewNode(const unsigned char *pPrefix, int Length);
+		void FreeNode(int Node);
+		int &Link(int Family, int Parent, int Slot) { return Parent < 0 ? m_aRoots[Family] : m_vNodes[Parent].m_aChildren[Slot]; }
+		void AddPrefix(int Family, const unsigned char *pPrefix, int Length, CBan<T> *pBan);
+		void RemovePrefix(int Family, const unsigned char *pPrefix, int Length, CBan<T> *pBan);
+
+		std::vector<CNode> m_vNodes;
+		std::vector<CEntry> m_vEntries;
+		int m_FirstFreeNode;
+		int m_FirstFreeEntry;
+		int m_aRoots[2];
+	};
+
 	template<class T, int HashCount>
 	class CBanPool
 	{
@@ -112,10 +153,8 @@ protected:
 		void Reset();
 
 		int Num() const { return m_CountUsed; }
-		bool IsFull() const { return m_CountUsed == MAX_BANS; }
 
 		CBan<CDataType> *First() const { return m_pFirstUsed; }
-		CBan<CDataType> *First(const CNetHash *pNetHash) const { return m_paaHashList[pNetHash->m_HashIndex][pNetHash->m_Hash]; }
 		CBan<CDataType> *Find(const CDataType *pData, const CNetHash *pNetHash) const
 		{
 			for(CBan<CDataType> *pBan = m_paaHashList[pNetHash->m_HashIndex][pNetHash->m_Hash]; pBan; pBan = pBan->m_pHashNext)
@@ -127,15 +166,29 @@ protected:
 			return 0;
 		}
 		CBan<CDataType> *Get(int Index) const;
+		CBan<CDataType> *Lookup(const NETADDR *pAddr) const { return m_Trie.Find(pAddr); }
+
+		CBanPool() = default;
+		~CBanPool()
+		{
+			for(auto *pChunk : m_vpBanChunks)
+				delete[] pChunk;
+		}
+		// the chunks belong to the pool
+		CBanPool(const CBanPool &Other) = delete;
+		CBanPool &operator=(const CBanPool &Other) = delete;
 
 	private:
 		enum
 		{
-			MAX_BANS = 1024,
+			BAN_CHUNK_SIZE = 1024,
 		};
 
+		void AllocChunk();
+
 		CBan<CDataType> *m_paaHashList[HashCount][256];
-		CBan<CDataType> m_aBans[MAX_BANS];
+		std::vector<CBan<CDataType> *> m_vpBanChunks;
+		CBanTrie<CDataType> m_Trie;
 		CBan<CDataType> *m_pFirstFree;
 		CBan<CDataType> *m_pFirstUsed;
 		int m_CountUsed;
@@ -152,6 +205,8 @@ protected:
 	int Ban(T *pBanPool, const typename T::CDataType *pData, int Seconds, const char *pReason);
 	template<class T>
 	int Unban(T *pBanPool, const typename T::CDataType *pData);
+	template<class T>
+	int BanSilent(T *pBanPool, const typename T::CDataType *pData, const CBanInfo *pInfo);
 
 	class IConsole *m_pConsole;
 	class IStorage *m_pStorage;
@@ -182,6 +237,8 @@ public:
 	int UnbanByIndex(int Index);
 	void UnbanAll();
 	bool IsBanned(const NETADDR *pAddr, char *pBuf, unsigned BufferSize) const;
+	int ImportBans(const char *pFilename, int Seconds, const char *pReason);
+	int NumBans() const { return m_BanAddrPool.Num() + m_BanRangePool.Num(); }
 
 	static void ConBan(class IConsole::IResult *pResult, void *pUser);
 	static void ConBanRange(class IConsole::IResult *pResult, void *pUser);
@@ -190,6 +247,7 @@ public:
 	static void ConUnbanAll(class IConsole::IResult *pResult, void *pUser);
 	static void ConBans(class IConsole::IResult *pResult, void *pUser);
 	static void ConBansSave(class IConsole::IResult *pResult, void *pUser);
+	static void ConBansImport(class IConsole::IResult *pResult, void *pUser);
 };
 
 template<class T>
@@ -299,6 +299,15 @@ class CNetServer
 	{
 	public:
 		CNetConnection m_Connection;
+
+		// address hash chain
+		int m_HashBucket;
+		int m_NextInHash;
+	};
+
+	enum
+	{
+		SLOT_HASH_SIZE = 256,
 	};
 
 	struct CSpamConn
@@ -313,6 +322,7 @@ class CNetServer
 	MMSGS m_MMSGS;
 	class CNetBan *m_pNetBan;
 	CSlot m_aSlots[NET_MAX_CLIENTS];
+	int m_aSlotHash[SLOT_HASH_SIZE];
 	int m_MaxClients;
 	int m_MaxClientsPerIP;
 
@@ -340,6 +350,8 @@ class CNetServer
 	void OnConnCtrlMsg(NETADDR &Addr, int ClientID, int ControlMsg, const CNetPacketConstruct &Packet);
 	bool ClientExists(const NETADDR &Addr) { return GetClientSlot(Addr) != -1; };
 	int GetClientSlot(const NETADDR &Addr);
+	static unsigned SlotHash(const NETADDR &Addr);
+	void UpdateSlotHash(int Slot);
 	void SendControl(NETADDR &Addr, int ControlMsg, const void *pExtra, int ExtraSize, SECURITY_TOKEN SecurityToken);
 
 	int TryAcceptClient(NETADDR &Addr, SECURITY_TOKEN SecurityToken, bool VanillaAuth = false, bool Sixup = false, SECURITY_TOKEN Token = 0);
@@ -77,7 +77,13 @@ bool CNetServer::Open(NETADDR BindAddr, CNetBan *pNetBan, int MaxClients, int Ma
 	secure_random_fill(m_SecurityTokenSeed, sizeof(m_SecurityTokenSeed));
 
 	for(int i = 0; i < NET_MAX_CLIENTS; i++)
+	{
 		m_aSlots[i].m_Connection.Init(m_Socket, true);
+		m_aSlots[i].m_HashBucket = -1;
+		m_aSlots[i].m_NextInHash = -1;
+	}
+	for(int i = 0; i < SLOT_HASH_SIZE; i++)
+		m_aSlotHash[i] = -1;
 
 	net_init_mmsgs(&m_MMSGS);
 
@@ -163,10 +169,42 @@ void CNetServer::SendControl(NETADDR &Addr, int ControlMsg, const void *pExtra,
 	CNetBase::SendControlMsg(m_Socket, &Addr, 0, ControlMsg, pExtra, ExtraSize, SecurityToken);
 }
 
+unsigned CNetServer::SlotHash(const NETADDR &Addr)
+{
+	// the port is left out, so all connections of an ip share a bucket
+	unsigned Hash = Addr.type;
+	for(unsigned i = 0; i < sizeof(Addr.ip); i++)
+		Hash = Hash * 31 + Addr.ip[i];
+	return (Hash ^ (Hash >> 16)) % SLOT_HASH_SIZE;
+}
+
+void CNetServer::UpdateSlotHash(int Slot)
+{
+	CSlot *pSlot = &m_aSlots[Slot];
+
+	// unlink from the old bucket
+	if(pSlot->m_HashBucket >= 0)
+	{
+		for(int *pLink = &m_aSlotHash[pSlot->m_HashBucket]; *pLink >= 0; pLink = &m_aSlots[*pLink].m_NextInHash)
+		{
+			if(*pLink == Slot)
+			{
+				*pLink = pSlot->m_NextInHash;
+				break;
+			}
+		}
+	}
+
+	// slots stay hashed while offline, lookups check the connection state
+	pSlot->m_HashBucket = SlotHash(*pSlot->m_Connection.PeerAddress());
+	pSlot->m_NextInHash = m_aSlotHash[pSlot->m_HashBucket];
+	m_aSlotHash[pSlot->m_HashBucket] = Slot;
+}
+
 int CNetServer::NumClientsWithAddr(NETADDR Addr)
 {
 	int FoundAddr = 0;
-	for(int i = 0; i < MaxClients(); ++i)
+	for(int i = m_aSlotHash[SlotHash(Addr)]; i >= 0; i = m_aSlots[i].m_NextInHash)
 	{
 		if(m_aSlots[i].m_Connection.State() == NET_CONNSTATE_OFFLINE ||
 			(m_aSlots[i].m_Connection.State() == NET_CONNSTATE_ERROR &&
@@ -259,6 +297,7 @@ int CNetServer::TryAcceptClient(NETADDR &Addr, SECURITY_TOKEN SecurityToken, boo
 
 	// init connection slot
 	m_aSlots[Slot].m_Connection.DirectInit(Addr, SecurityToken, Token, Sixup);
+	UpdateSlotHash(Slot);
 
 	if(VanillaAuth)
 	{
@@ -589,12 +628,12 @@ int CNetServer::GetClientSlot(const NETADDR &Addr)
 {
 	int Slot = -1;
 
-	for(int i = 0; i < MaxClients(); i++)
+	for(int i = m_aSlotHash[SlotHash(Addr)]; i >= 0; i = m_aSlots[i].m_NextInHash)
 	{
-		if(m_aSlots[i].m_Connection.State() != NET_CONNSTATE_OFFLINE &&
+		if(i > Slot &&
+			m_aSlots[i].m_Connection.State() != NET_CONNSTATE_OFFLINE &&
 			m_aSlots[i].m_Connection.State() != NET_CONNSTATE_ERROR &&
 			net_addr_comp(m_aSlots[i].m_Connection.PeerAddress(), &Addr) == 0)
-
 		{
 			Slot = i;
 		}
@@ -807,6 +846,7 @@ bool CNetServer::SetTimedOut(int ClientID, int OrigID)
 
 	m_aSlots[ClientID].m_Connection.SetTimedOut(ClientAddr(OrigID), m_aSlots[OrigID].m_Connection.SeqSequence(), m_aSlots[OrigID].m_Connection.AckSequence(), m_aSlots[OrigID].m_Connection.SecurityToken(), m_aSlots[OrigID].m_Connection.ResendBuffer(), m_aSlots[OrigID].m_Connection.m_Sixup);
 	m_aSlots[OrigID].m_Connection.Reset();
+	UpdateSlotHash(ClientID);
 	return true;
 }
 
@@ -0,0 +1,241 @@
+#include "profiler.h"
+
+#include <base/math.h>
+
+#include <engine/shared/json.h>
+#include <engine/storage.h>
+
+#include <algorithm>
+
+CProfiler g_Profiler;
+
+CProfiler::CProfiler()
+{
+	m_NumZones = 0;
+	m_HistoryIndex = 0;
+	m_NumFrames = 0;
+	m_Enabled = false;
+	m_Tracing = false;
+	m_TraceStart = 0;
+	m_TraceFramesLeft = 0;
+	m_pConsole = 0;
+	m_pStorage = 0;
+}
+
+void CProfiler::Init(IConsole *pConsole, IStorage *pStorage, int Flags)
+{
+	m_pConsole = pConsole;
+	m_pStorage = pStorage;
+
+	m_pConsole->Register("profile_trace_start", "?i[frames]", Flags, ConTraceStart, this, "Start recording a trace of the profiled zones, optionally saved after the given number of frames or ticks");
+	m_pConsole->Register("profile_trace_stop", "?r[file]", Flags, ConTraceStop, this, "Stop recording the trace and save it as a Chrome trace file");
+}
+
+void CProfiler::ConTraceStart(IConsole::IResult *pResult, void *pUserData)
+{
+	CProfiler *pSelf = (CProfiler *)pUserData;
+	pSelf->StartTrace(pResult->NumArguments() ? pResult->GetInteger(0) : 0);
+	pSelf->m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profiler", "trace started");
+}
+
+void CProfiler::ConTraceStop(IConsole::IResult *pResult, void *pUserData)
+{
+	CProfiler *pSelf = (CProfiler *)pUserData;
+	if(!pSelf->m_Tracing && pSelf->m_vTraceEvents.empty())
+	{
+		pSelf->m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profiler", "no trace is running");
+		return;
+	}
+
+	if(pResult->NumArguments())
+		pSelf->SaveTrace(pResult->GetString(0));
+	else
+		pSelf->SaveTrace(0);
+}
+
+void CProfiler::SaveTrace(const char *pFilename)
+{
+	char aFilename[MAX_PATH_LENGTH];
+	if(pFilename)
+		str_copy(aFilename, pFilename, sizeof(aFilename));
+	else
+	{
+		char aDate[20];
+		str_timestamp(aDate, sizeof(aDate));
+		str_format(aFilename, sizeof(aFilename), "dumps/trace_%s.json", aDate);
+	}
+
+	char aBuf[256];
+	int NumEvents = NumTraceEvents();
+	IOHANDLE File = m_pStorage->OpenFile(aFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(!File)
+	{
+		m_Tracing = false;
+		m_vTraceEvents.clear();
+		str_format(aBuf, sizeof(aBuf), "failed to open '%s'", aFilename);
+	}
+	else
+	{
+		bool Success = StopTrace(File);
+		io_close(File);
+		if(Success)
+			str_format(aBuf, sizeof(aBuf), "saved %d events to '%s'", NumEvents, aFilename);
+		else
+			str_format(aBuf, sizeof(aBuf), "failed to write '%s'", aFilename);
+	}
+	m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profiler", aBuf);
+}
+
+int CProfiler::RegisterZone(const char *pName)
+{
+	for(int i = 0; i < m_NumZones; i++)
+		if(str_comp(m_aZones[i].m_pName, pName) == 0)
+			return i;
+	if(m_NumZones == MAX_ZONES)
+	{
+		dbg_msg("profiler", "too many zones, '%s' isn't measured", pName);
+		return -1;
+	}
+
+	CZone *pZone = &m_aZones[m_NumZones];
+	pZone->m_pName = pName;
+	pZone->m_FrameTime = 0;
+	mem_zero(pZone->m_aHistory, sizeof(pZone->m_aHistory));
+	return m_NumZones++;
+}
+
+void CProfiler::SetEnabled(bool Enabled)
+{
+	if(Enabled && !m_Enabled)
+	{
+		// start over, the old history has a gap
+		for(int i = 0; i < m_NumZones; i++)
+		{
+			m_aZones[i].m_FrameTime = 0;
+			mem_zero(m_aZones[i].m_aHistory, sizeof(m_aZones[i].m_aHistory));
+		}
+		m_NumFrames = 0;
+	}
+	m_Enabled = Enabled;
+}
+
+void CProfiler::AddSample(int Zone, int64 Start, int64 End)
+{
+	if(Zone < 0)
+		return;
+	m_aZones[Zone].m_FrameTime += End - Start;
+
+	if(m_Tracing)
+	{
+		if((int)m_vTraceEvents.size() == MAX_TRACE_EVENTS)
+		{
+			dbg_msg("profiler", "trace is full, stopped recording");
+			m_Tracing = false;
+			return;
+		}
+		CTraceEvent Event;
+		Event.m_Zone = Zone;
+		Event.m_Start = Start;
+		Event.m_End = End;
+		m_vTraceEvents.push_back(Event);
+	}
+}
+
+void CProfiler::NextFrame()
+{
+	if(m_Tracing && m_TraceFramesLeft > 0 && --m_TraceFramesLeft == 0)
+	{
+		if(m_pStorage)
+			SaveTrace(0);
+		else
+			m_Tracing = false;
+	}
+
+	if(!m_Enabled)
+	{
+		for(int i = 0; i < m_NumZones; i++)
+			m_aZones[i].m_FrameTime = 0;
+		return;
+	}
+
+	m_HistoryIndex = (m_HistoryIndex + 1) % HISTORY_SIZE;
+	for(int i = 0; i < m_NumZones; i++)
+	{
+		m_aZones[i].m_aHistory[m_HistoryIndex] = m_aZones[i].m_FrameTime;
+		m_aZones[i].m_FrameTime = 0;
+	}
+	m_NumFrames = minimum(m_NumFrames + 1, (int)HISTORY_SIZE);
+}
+
+float CProfiler::Average(int Zone) const
+{
+	if(!m_NumFrames)
+		return 0.0f;
+	int64 Sum = 0;
+	for(int i = 0; i < m_NumFrames; i++)
+		Sum += m_aZones[Zone].m_aHistory[(m_HistoryIndex - i + HISTORY_SIZE) % HISTORY_SIZE];
+	return Sum / (float)m_NumFrames / time_freq();
+}
+
+float CProfiler::Max(int Zone) const
+{
+	int64 Max = 0;
+	for(int i = 0; i < m_NumFrames; i++)
+		Max = maximum(Max, m_aZones[Zone].m_aHistory[(m_HistoryIndex - i + HISTORY_SIZE) % HISTORY_SIZE]);
+	return Max / (float)time_freq();
+}
+
+float CProfiler::Percentile(int Zone, float Percent) const
+{
+	if(!m_NumFrames)
+		return 0.0f;
+	int64 aTimes[HISTORY_SIZE];
+	for(int i = 0; i < m_NumFrames; i++)
+		aTimes[i] = m_aZones[Zone].m_aHistory[(m_HistoryIndex - i + HISTORY_SIZE) % HISTORY_SIZE];
+	int Index = clamp((int)(m_NumFrames * Percent / 100.0f), 0, m_NumFrames - 1);
+	std::nth_element(aTimes, aTimes + Index, aTimes + m_NumFrames);
+	return aTimes[Index] / (float)time_freq();
+}
+
+float CProfiler::FrameTime(int Zone, int FramesAgo) const
+{
+	if(FramesAgo < 0 || FramesAgo >= m_NumFrames)
+		return 0.0f;
+	return m_aZones[Zone].m_aHistory[(m_HistoryIndex - FramesAgo + HISTORY_SIZE) % HISTORY_SIZE] / (float)time_freq();
+}
+
+void CProfiler::StartTrace(int NumFrames)
+{
+	m_vTraceEvents.clear();
+	m_TraceStart = time_get_impl();
+	m_TraceFramesLeft = NumFrames;
+	m_Tracing = true;
+}
+
+bool CProfiler::StopTrace(IOHANDLE File)
+{
+	m_Tracing = false;
+
+	bool Success = true;
+	char aBuf[512];
+	char aName[128];
+	str_copy(aBuf, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", sizeof(aBuf));
+	Success = Success && io_write(File, aBuf, str_length(aBuf)) == (unsigned)str_length(aBuf);
+	for(unsigned i = 0; i < m_vTraceEvents.size() && Success; i++)
+	{
+		// timestamps and durations are in microseconds
+		const CTraceEvent &Event = m_vTraceEvents[i];
+		str_format(aBuf, sizeof(aBuf), "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1}",
+			i == 0 ? "" : ",",
+			EscapeJson(aName, sizeof(aName), m_aZones[Event.m_Zone].m_pName),
+			(Event.m_Start - m_TraceStart) * 1000000.0 / time_freq(),
+			(Event.m_End - Event.m_Start) * 1000000.0 / time_freq());
+		Success = io_write(File, aBuf, str_length(aBuf)) == (unsigned)str_length(aBuf);
+	}
+	str_copy(aBuf, "\n]}\n", sizeof(aBuf));
+	Success = Success && io_write(File, aBuf, str_length(aBuf)) == (unsigned)str_length(aBuf);
+
+	m_vTraceEvents.clear();
+	m_vTraceEvents.shrink_to_fit();
+	return Success;
+}
@@ -0,0 +1,111 @@
+#ifndef ENGINE_SHARED_PROFILER_H
+#define ENGINE_SHARED_PROFILER_H
+
+#include <base/system.h>
+#include <engine/console.h>
+
+#include <vector>
+
+// Measures how long named zones of a frame or tick take. The time of every
+// zone is summed up per frame and kept for the last HISTORY_SIZE frames,
+// and while a trace is running every single measurement is recorded so it
+// can be saved in the Chrome trace event format (chrome://tracing, Perfetto).
+// Not thread-safe, only measure on the main thread.
+class CProfiler
+{
+public:
+	enum
+	{
+		MAX_ZONES = 128,
+		HISTORY_SIZE = 512,
+		MAX_TRACE_EVENTS = 1024 * 1024,
+	};
+
+private:
+	struct CZone
+	{
+		const char *m_pName;
+		int64 m_FrameTime;
+		int64 m_aHistory[HISTORY_SIZE];
+	};
+
+	struct CTraceEvent
+	{
+		int m_Zone;
+		int64 m_Start;
+		int64 m_End;
+	};
+
+	CZone m_aZones[MAX_ZONES];
+	int m_NumZones;
+	int m_HistoryIndex;
+	int m_NumFrames;
+	bool m_Enabled;
+
+	bool m_Tracing;
+	int64 m_TraceStart;
+	int m_TraceFramesLeft;
+	std::vector<CTraceEvent> m_vTraceEvents;
+
+	class IConsole *m_pConsole;
+	class IStorage *m_pStorage;
+
+	static void ConTraceStart(class IConsole::IResult *pResult, void *pUserData);
+	static void ConTraceStop(class IConsole::IResult *pResult, void *pUserData);
+
+	void SaveTrace(const char *pFilename);
+
+public:
+	CProfiler();
+
+	// registers profile_trace_start and profile_trace_stop with the given flags
+	void Init(class IConsole *pConsole, class IStorage *pStorage, int Flags);
+
+	// the name must stay valid, the same name always gets the same zone
+	int RegisterZone(const char *pName);
+	int NumZones() const { return m_NumZones; }
+	const char *ZoneName(int Zone) const { return m_aZones[Zone].m_pName; }
+
+	void SetEnabled(bool Enabled);
+	bool Active() const { return m_Enabled || m_Tracing; }
+
+	void AddSample(int Zone, int64 Start, int64 End);
+	void NextFrame();
+
+	// over the history, in seconds
+	int NumFrames() const { return m_NumFrames; }
+	float Average(int Zone) const;
+	float Max(int Zone) const;
+	// e.g. 50 for the median
+	float Percentile(int Zone, float Percent) const;
+	// the zone's time of a past frame, 0 is the last finished one
+	float FrameTime(int Zone, int FramesAgo) const;
+
+	// with NumFrames > 0 the trace is saved after that many frames
+	void StartTrace(int NumFrames = 0);
+	bool IsTracing() const { return m_Tracing; }
+	int NumTraceEvents() const { return m_vTraceEvents.size(); }
+	// stops the trace and writes it, returns false if writing failed
+	bool StopTrace(IOHANDLE File);
+};
+
+extern CProfiler g_Profiler;
+
+class CProfileScope
+{
+	int m_Zone;
+	int64 m_Start;
+
+public:
+	CProfileScope(int Zone) :
+		m_Zone(Zone), m_Start(g_Profiler.Active() ? time_get_impl() : 0)
+	{
+	}
+	~CProfileScope()
+	{
+		if(m_Start)
+			g_Profiler.AddSample(m_Zone, m_Start, time_get_impl());
+	}
+};
+
+#endif // ENGINE_SHARED_PROFILER_H
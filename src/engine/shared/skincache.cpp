@@ -0,0 +1,256 @@
+#include "skincache.h"
+
+#include <base/math.h>
+#include <base/vmath.h>
+
+#include <engine/graphics.h>
+
+static const char s_aMagic[4] = {'D', 'D', 'S', 'C'};
+
+static int64 AlignOffset(int64 Offset)
+{
+	return (Offset + 15) & ~(int64)15;
+}
+
+CSkinCache::CSkinCache()
+{
+	m_pBuffer = 0;
+	m_NextFind = 0;
+}
+
+CSkinCache::~CSkinCache()
+{
+	Clear();
+}
+
+void CSkinCache::Clear()
+{
+	free(m_pBuffer);
+	m_pBuffer = 0;
+	m_vEntries.clear();
+	m_NextFind = 0;
+}
+
+bool CSkinCache::Load(IOHANDLE File)
+{
+	Clear();
+
+	int64 Length = io_length(File);
+	if(Length < (int64)sizeof(CHeader))
+		return false;
+	m_pBuffer = (unsigned char *)malloc(Length);
+	if(io_read(File, m_pBuffer, Length) != (unsigned)Length)
+	{
+		Clear();
+		return false;
+	}
+
+	// the cache is only written and read by the same machine, so there is no
+	// need to swap anything, a file from elsewhere just doesn't match
+	const CHeader *pHeader = (const CHeader *)m_pBuffer;
+	if(mem_comp(pHeader->m_aMagic, s_aMagic, sizeof(s_aMagic)) != 0 || pHeader->m_Version != VERSION ||
+		pHeader->m_NumItems < 0 || pHeader->m_NumItems > (Length - (int64)sizeof(CHeader)) / (int64)sizeof(CItem))
+	{
+		Clear();
+		return false;
+	}
+
+	const CItem *pItems = (const CItem *)(m_pBuffer + sizeof(CHeader));
+	for(int i = 0; i < pHeader->m_NumItems; i++)
+	{
+		const CItem *pItem = &pItems[i];
+		bool Failed = pItem->m_Width == 0 && pItem->m_Height == 0 && pItem->m_DataOffset == 0 && pItem->m_ColorDataOffset == 0;
+		int Size = Failed ? 0 : DataSize(pItem->m_Width, pItem->m_Height, pItem->m_Format);
+		if((!Failed && Size <= 0) || pItem->m_aPath[MAX_PATH - 1] != 0 ||
+			pItem->m_DataOffset < 0 || pItem->m_DataOffset > Length - Size ||
+			pItem->m_ColorDataOffset < 0 || pItem->m_ColorDataOffset > Length - Size)
+		{
+			Clear();
+			return false;
+		}
+
+		CEntry Entry;
+		Entry.m_pPath = pItem->m_aPath;
+		Entry.m_Size = pItem->m_Size;
+		Entry.m_Time = pItem->m_Time;
+		Entry.m_Width = pItem->m_Width;
+		Entry.m_Height = pItem->m_Height;
+		Entry.m_Format = pItem->m_Format;
+		Entry.m_BloodColor = ColorRGBA(pItem->m_aBloodColor[0], pItem->m_aBloodColor[1], pItem->m_aBloodColor[2], 1.0f);
+		Entry.m_pData = Failed ? 0 : m_pBuffer + pItem->m_DataOffset;
+		Entry.m_pColorData = Failed ? 0 : m_pBuffer + pItem->m_ColorDataOffset;
+		m_vEntries.push_back(Entry);
+	}
+	return true;
+}
+
+const CSkinCache::CEntry *CSkinCache::Find(const char *pPath, int64 Size, int64 Time) const
+{
+	// the skins are usually looked up in the order they were saved in, so
+	// start after the last one that was found
+	for(int i = 0; i < Num(); i++)
+	{
+		int Index = (m_NextFind + i) % Num();
+		const CEntry *pEntry = &m_vEntries[Index];
+		if(str_comp(pEntry->m_pPath, pPath) == 0)
+		{
+			m_NextFind = Index + 1;
+			if(pEntry->m_Size != Size || pEntry->m_Time != Time)
+				return 0;
+			return pEntry;
+		}
+	}
+	return 0;
+}
+
+bool CSkinCache::Save(IOHANDLE File, const std::vector<CEntry> &vEntries)
+{
+	std::vector<CItem> vItems;
+	std::vector<const CEntry *> vpSaved;
+	for(const CEntry &Entry : vEntries)
+	{
+		if(str_length(Entry.m_pPath) >= MAX_PATH)
+			continue;
+		CItem Item;
+		mem_zero(&Item, sizeof(Item));
+		str_copy(Item.m_aPath, Entry.m_pPath, sizeof(Item.m_aPath));
+		Item.m_Size = Entry.m_Size;
+		Item.m_Time = Entry.m_Time;
+		// a failed skin only keeps its path, size and time
+		if(Entry.m_pData)
+		{
+			Item.m_Width = Entry.m_Width;
+			Item.m_Height = Entry.m_Height;
+			Item.m_Format = Entry.m_Format;
+			Item.m_aBloodColor[0] = Entry.m_BloodColor.r;
+			Item.m_aBloodColor[1] = Entry.m_BloodColor.g;
+			Item.m_aBloodColor[2] = Entry.m_BloodColor.b;
+		}
+		vItems.push_back(Item);
+		vpSaved.push_back(&Entry);
+	}
+
+	int64 Offset = AlignOffset(sizeof(CHeader) + vItems.size() * sizeof(CItem));
+	for(unsigned i = 0; i < vItems.size(); i++)
+	{
+		CItem &Item = vItems[i];
+		if(!vpSaved[i]->m_pData)
+			continue;
+		int Size = DataSize(Item.m_Width, Item.m_Height, Item.m_Format);
+		Item.m_DataOffset = Offset;
+		Item.m_ColorDataOffset = AlignOffset(Offset + Size);
+		Offset = AlignOffset(Item.m_ColorDataOffset + Size);
+	}
+
+	CHeader Header;
+	mem_copy(Header.m_aMagic, s_aMagic, sizeof(Header.m_aMagic));
+	Header.m_Version = VERSION;
+	Header.m_NumItems = vItems.size();
+	Header.m_Reserved = 0;
+
+	static const unsigned char s_aPadding[16] = {0};
+	int64 Written = 0;
+	bool Success = io_write(File, &Header, sizeof(Header)) == sizeof(Header);
+	Written += sizeof(Header);
+	if(!vItems.empty())
+	{
+		Success = Success && io_write(File, &vItems[0], vItems.size() * sizeof(CItem)) == vItems.size() * sizeof(CItem);
+		Written += vItems.size() * sizeof(CItem);
+	}
+	for(unsigned i = 0; i < vItems.size() && Success; i++)
+	{
+		if(!vpSaved[i]->m_pData)
+			continue;
+		int Size = DataSize(vItems[i].m_Width, vItems[i].m_Height, vItems[i].m_Format);
+		const unsigned char *apData[2] = {vpSaved[i]->m_pData, vpSaved[i]->m_pColorData};
+		int64 aOffsets[2] = {vItems[i].m_DataOffset, vItems[i].m_ColorDataOffset};
+		for(int j = 0; j < 2 && Success; j++)
+		{
+			unsigned Padding = aOffsets[j] - Written;
+			Success = io_write(File, s_aPadding, Padding) == Padding && io_write(File, apData[j], Size) == (unsigned)Size;
+			Written = aOffsets[j] + Size;
+		}
+	}
+	return Success;
+}
+
+int CSkinCache::DataSize(int Width, int Height, int Format)
+{
+	if(Width <= 0 || Height <= 0 || Width > (2 << 12) || Height > (2 << 12) || (Format != CImageInfo::FORMAT_RGB && Format != CImageInfo::FORMAT_RGBA))
+		return 0;
+	return Width * Height * (Format == CImageInfo::FORMAT_RGBA ? 4 : 3);
+}
+
+bool CSkinCache::PrepareSkin(const CImageInfo *pInfo, unsigned char *pColorData, ColorRGBA *pBloodColor)
+{
+	int BodySize = 96; // body size
+	if(BodySize > pInfo->m_Height)
+		return false;
+	int Step = pInfo->m_Format == CImageInfo::FORMAT_RGBA ? 4 : 3;
+	unsigned char *d = pColorData;
+	mem_copy(d, pInfo->m_pData, DataSize(pInfo->m_Width, pInfo->m_Height, pInfo->m_Format));
+	int Pitch = pInfo->m_Width * 4;
+
+	// dig out blood color
+	{
+		int aColors[3] = {0};
+		for(int y = 0; y < BodySize; y++)
+			for(int x = 0; x < BodySize; x++)
+			{
+				if(d[y * Pitch + x * 4 + 3] > 128)
+				{
+					aColors[0] += d[y * Pitch + x * 4 + 0];
+					aColors[1] += d[y * Pitch + x * 4 + 1];
+					aColors[2] += d[y * Pitch + x * 4 + 2];
+				}
+			}
+
+		*pBloodColor = ColorRGBA(normalize(vec3(aColors[0], aColors[1], aColors[2])));
+	}
+
+	// create colorless version
+
+	// make the texture gray scale
+	for(int i = 0; i < pInfo->m_Width * pInfo->m_Height; i++)
+	{
+		int v = (d[i * Step] + d[i * Step + 1] + d[i * Step + 2]) / 3;
+		d[i * Step] = v;
+		d[i * Step + 1] = v;
+		d[i * Step + 2] = v;
+	}
+
+	int Freq[256] = {0};
+	int OrgWeight = 0;
+	int NewWeight = 192;
+
+	// find most common frequence
+	for(int y = 0; y < BodySize; y++)
+		for(int x = 0; x < BodySize; x++)
+		{
+			if(d[y * Pitch + x * 4 + 3] > 128)
+				Freq[d[y * Pitch + x * 4]]++;
+		}
+
+	for(int i = 1; i < 256; i++)
+	{
+		if(Freq[OrgWeight] < Freq[i])
+			OrgWeight = i;
+	}
+
+	// reorder
+	int InvOrgWeight = 255 - OrgWeight;
+	int InvNewWeight = 255 - NewWeight;
+	for(int y = 0; y < BodySize; y++)
+		for(int x = 0; x < BodySize; x++)
+		{
+			int v = d[y * Pitch + x * 4];
+			if(v <= OrgWeight)
+				v = (int)(((v / (float)OrgWeight) * NewWeight));
+			else
+				v = (int)(((v - OrgWeight) / (float)InvOrgWeight) * InvNewWeight + NewWeight);
+			d[y * Pitch + x * 4] = v;
+			d[y * Pitch + x * 4 + 1] = v;
+			d[y * Pitch + x * 4 + 2] = v;
+		}
+	return true;
+}
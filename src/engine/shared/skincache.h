@@ -0,0 +1,92 @@
+#ifndef ENGINE_SHARED_SKINCACHE_H
+#define ENGINE_SHARED_SKINCACHE_H
+
+#include <base/color.h>
+#include <base/system.h>
+
+#include <vector>
+
+class CImageInfo;
+
+// Keeps decoded and prepared skins in a single file so only new or changed
+// skins have to be decoded on the next start. Entries are found by the
+// path, size and modification time of the skin's png. Pngs that aren't
+// valid skins are kept as entries without data, so they aren't decoded
+// again either until they change.
+//
+// The file starts with a header and a table of fixed size items, followed
+// by the pixel data at 16 byte aligned offsets. It is read in one piece and
+// the entries point right into that buffer.
+class CSkinCache
+{
+public:
+	enum
+	{
+		VERSION = 1,
+		MAX_PATH = 128,
+	};
+
+	struct CEntry
+	{
+		const char *m_pPath;
+		int64 m_Size;
+		int64 m_Time;
+		int m_Width;
+		int m_Height;
+		int m_Format;
+		ColorRGBA m_BloodColor;
+		// the original and the gray scale version, both null for a png
+		// that failed to load
+		const unsigned char *m_pData;
+		const unsigned char *m_pColorData;
+	};
+
+private:
+	struct CHeader
+	{
+		char m_aMagic[4];
+		int m_Version;
+		int m_NumItems;
+		int m_Reserved;
+	};
+
+	struct CItem
+	{
+		int64 m_Size;
+		int64 m_Time;
+		int64 m_DataOffset;
+		int64 m_ColorDataOffset;
+		int m_Width;
+		int m_Height;
+		int m_Format;
+		float m_aBloodColor[3];
+		char m_aPath[MAX_PATH];
+	};
+
+	unsigned char *m_pBuffer;
+	std::vector<CEntry> m_vEntries;
+	mutable int m_NextFind;
+
+public:
+	CSkinCache();
+	~CSkinCache();
+
+	// returns false if the file isn't a valid cache, the cache is empty then
+	bool Load(IOHANDLE File);
+	void Clear();
+
+	int Num() const { return m_vEntries.size(); }
+	const CEntry *Get(int Index) const { return &m_vEntries[Index]; }
+	const CEntry *Find(const char *pPath, int64 Size, int64 Time) const;
+
+	// entries with a too long path are left out
+	static bool Save(IOHANDLE File, const std::vector<CEntry> &vEntries);
+
+	// creates the gray scale version of a skin and digs out its blood color.
+	// pColorData needs the size of the image data, returns false if the
+	// image is too small to be a skin
+	static bool PrepareSkin(const CImageInfo *pInfo, unsigned char *pColorData, ColorRGBA *pBloodColor);
+	static int DataSize(int Width, int Height, int Format);
+};
+
+#endif // ENGINE_SHARED_SKINCACHE_H
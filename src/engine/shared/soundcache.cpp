@@ -0,0 +1,113 @@
+#include "soundcache.h"
+
+#include <engine/storage.h>
+
+#include <algorithm>
+#include <vector>
+
+static const char s_aMagic[4] = {'D', 'D', 'P', 'C'};
+
+void CSoundCache::Filename(const SHA256_DIGEST &Hash, int Rate, char *pBuffer, int BufferSize)
+{
+	char aHash[SHA256_MAXSTRSIZE];
+	sha256_str(Hash, aHash, sizeof(aHash));
+	str_format(pBuffer, BufferSize, "soundcache/%s_%d.pcm", aHash, Rate);
+}
+
+bool CSoundCache::Load(IOHANDLE File, const SHA256_DIGEST &Hash, int Rate, CSoundMixer::CSample *pSample)
+{
+	// like the skin cache, the files are only read by the machine that
+	// wrote them, so nothing is swapped
+	int64 Length = io_length(File);
+	CHeader Header;
+	if(io_read(File, &Header, sizeof(Header)) != sizeof(Header))
+		return false;
+	if(mem_comp(Header.m_aMagic, s_aMagic, sizeof(s_aMagic)) != 0 || Header.m_Version != VERSION ||
+		Header.m_Hash != Hash || Header.m_Rate != Rate ||
+		Header.m_Channels < 1 || Header.m_Channels > 2 || Header.m_NumFrames <= 0)
+		return false;
+
+	int64 Size = (int64)Header.m_NumFrames * Header.m_Channels * sizeof(short);
+	if(Length != (int64)sizeof(Header) + Size)
+		return false;
+
+	short *pData = (short *)malloc(Size);
+	if(io_read(File, pData, Size) != (unsigned)Size)
+	{
+		free(pData);
+		return false;
+	}
+
+	mem_zero(pSample, sizeof(*pSample));
+	pSample->m_pData = pData;
+	pSample->m_NumFrames = Header.m_NumFrames;
+	pSample->m_Rate = Header.m_Rate;
+	pSample->m_Channels = Header.m_Channels;
+	pSample->m_LoopStart = -1;
+	pSample->m_LoopEnd = -1;
+	return true;
+}
+
+bool CSoundCache::Save(IOHANDLE File, const SHA256_DIGEST &Hash, const CSoundMixer::CSample *pSample)
+{
+	CHeader Header;
+	mem_zero(&Header, sizeof(Header));
+	mem_copy(Header.m_aMagic, s_aMagic, sizeof(Header.m_aMagic));
+	Header.m_Version = VERSION;
+	Header.m_Rate = pSample->m_Rate;
+	Header.m_Channels = pSample->m_Channels;
+	Header.m_NumFrames = pSample->m_NumFrames;
+	Header.m_Hash = Hash;
+
+	unsigned Size = pSample->m_NumFrames * pSample->m_Channels * sizeof(short);
+	if(io_write(File, &Header, sizeof(Header)) != sizeof(Header))
+		return false;
+	return io_write(File, pSample->m_pData, Size) == Size;
+}
+
+struct CCacheFile
+{
+	char m_aName[128];
+	time_t m_Date;
+
+	// newest first
+	bool operator<(const CCacheFile &Other) const { return m_Date > Other.m_Date; }
+};
+
+static int CacheFileScan(const char *pName, time_t Date, int IsDir, int DirType, void *pUser)
+{
+	if(IsDir || !str_endswith(pName, ".pcm"))
+		return 0;
+	std::vector<CCacheFile> *pvFiles = (std::vector<CCacheFile> *)pUser;
+	CCacheFile File;
+	str_copy(File.m_aName, pName, sizeof(File.m_aName));
+	File.m_Date = Date;
+	pvFiles->push_back(File);
+	return 0;
+}
+
+int CSoundCache::Prune(IStorage *pStorage, const char *pDirectory, int64 MaxSize)
+{
+	std::vector<CCacheFile> vFiles;
+	pStorage->ListDirectoryInfo(IStorage::TYPE_SAVE, pDirectory, CacheFileScan, &vFiles);
+	std::stable_sort(vFiles.begin(), vFiles.end());
+
+	int NumRemoved = 0;
+	int64 Size = 0;
+	for(const auto &File : vFiles)
+	{
+		char aPath[MAX_PATH_LENGTH];
+		str_format(aPath, sizeof(aPath), "%s/%s", pDirectory, File.m_aName);
+		if(Size <= MaxSize)
+		{
+			IOHANDLE Handle = pStorage->OpenFile(aPath, IOFLAG_READ, IStorage::TYPE_SAVE);
+			if(!Handle)
+				continue;
+			Size += io_length(Handle);
+			io_close(Handle);
+		}
+		if(Size > MaxSize && pStorage->RemoveFile(aPath, IStorage::TYPE_SAVE))
+			NumRemoved++;
+	}
+	return NumRemoved;
+}
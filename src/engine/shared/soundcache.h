@@ -0,0 +1,50 @@
+#ifndef ENGINE_SHARED_SOUNDCACHE_H
+#define ENGINE_SHARED_SOUNDCACHE_H
+
+#include <base/hash.h>
+#include <base/system.h>
+
+#include "soundmixer.h"
+
+class IStorage;
+
+// Keeps decoded samples that are already converted to the mixing rate on
+// disk, so sounds don't have to be decoded again on the next load. Every
+// sample has its own file, named after the hash of the encoded sound and
+// the rate. A changed sound never matches an old file, which is why the
+// files are never checked for being outdated. Prune keeps the directory
+// below a size by removing the oldest files.
+class CSoundCache
+{
+public:
+	enum
+	{
+		VERSION = 1,
+	};
+
+private:
+	struct CHeader
+	{
+		char m_aMagic[4];
+		int m_Version;
+		int m_Rate;
+		int m_Channels;
+		int m_NumFrames;
+		int m_Reserved;
+		SHA256_DIGEST m_Hash;
+	};
+
+public:
+	static void Filename(const SHA256_DIGEST &Hash, int Rate, char *pBuffer, int BufferSize);
+
+	// allocates the sample data with malloc, returns false if the file
+	// isn't a valid cache for the hash and rate
+	static bool Load(IOHANDLE File, const SHA256_DIGEST &Hash, int Rate, CSoundMixer::CSample *pSample);
+	static bool Save(IOHANDLE File, const SHA256_DIGEST &Hash, const CSoundMixer::CSample *pSample);
+
+	// removes the oldest cache files in the save directory until the
+	// rest fit into MaxSize bytes, returns the number of removed files
+	static int Prune(IStorage *pStorage, const char *pDirectory, int64 MaxSize);
+};
+
+#endif // ENGINE_SHARED_SOUNDCACHE_H
@@ -0,0 +1,644 @@
+#include "soundmixer.h"
+
+#include <base/math.h>
+
+#include <math.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SOUNDMIXER_NEON 1
+#endif
+
+static const int s_DefaultDistance = 1500;
+
+static short Int2Short(int i)
+{
+	if(i > 0x7fff)
+		return 0x7fff;
+	else if(i < -0x7fff)
+		return -0x7fff;
+	return i;
+}
+
+CSoundMixer::CSoundMixer()
+{
+	mem_zero(m_aVoices, sizeof(m_aVoices));
+	for(int i = 0; i < NUM_CHANNELS; i++)
+	{
+		m_aChannels[i].m_Vol = 255;
+		m_aChannels[i].m_Pan = 0;
+	}
+	m_CenterX = 0;
+	m_CenterY = 0;
+	m_pMixBuffer = 0;
+	m_MaxFrames = 0;
+
+	mem_zero(m_apVoiceSamples, sizeof(m_apVoiceSamples));
+	m_NextVoice = 0;
+	for(int i = 0; i < NUM_VOICES; i++)
+	{
+		m_aVoiceStates[i] = 0;
+		m_aVoiceParams[i].m_Changed = 0;
+		m_aVoiceParams[i].m_Volume = 1.0f;
+		m_aVoiceParams[i].m_Falloff = 0.0f;
+		m_aVoiceParams[i].m_X = 0.0f;
+		m_aVoiceParams[i].m_Y = 0.0f;
+		m_aVoiceParams[i].m_TimeOffset = 0.0f;
+		m_aVoiceParams[i].m_Shape = ISound::SHAPE_CIRCLE;
+		m_aVoiceParams[i].m_aShapeArgs[0] = s_DefaultDistance;
+		m_aVoiceParams[i].m_aShapeArgs[1] = 0.0f;
+	}
+	for(int i = 0; i < NUM_CHANNELS; i++)
+	{
+		m_aChannelParams[i].m_Vol = 1.0f;
+		m_aChannelParams[i].m_Pan = 0.0f;
+	}
+	m_ListenerX = 0;
+	m_ListenerY = 0;
+	m_Volume = 100;
+	m_Running = false;
+	m_ReadPos = 0;
+	m_WritePos = 0;
+}
+
+CSoundMixer::~CSoundMixer()
+{
+	Shutdown();
+}
+
+void CSoundMixer::Init(unsigned MaxFrames)
+{
+	m_MaxFrames = MaxFrames;
+	m_pMixBuffer = (int *)calloc(m_MaxFrames * 2, sizeof(int));
+	m_Running = true;
+}
+
+void CSoundMixer::Shutdown()
+{
+	m_Running = false;
+	m_vPending.clear();
+	free(m_pMixBuffer);
+	m_pMixBuffer = 0;
+}
+
+CSoundMixer::CCommand CSoundMixer::MakeCommand(int Type, int Voice)
+{
+	CCommand Command;
+	mem_zero(&Command, sizeof(Command));
+	Command.m_Type = Type;
+	Command.m_Voice = Voice;
+	return Command;
+}
+
+bool CSoundMixer::Push(const CCommand &Command)
+{
+	if(!m_Running)
+		return false;
+	// keep the order, nothing may overtake the waiting commands
+	Flush();
+	if(!m_vPending.empty())
+	{
+		m_vPending.push_back(Command);
+		return true;
+	}
+	unsigned Write = m_WritePos.load(std::memory_order_relaxed);
+	if(Write - m_ReadPos.load(std::memory_order_acquire) >= QUEUE_SIZE)
+	{
+		m_vPending.push_back(Command);
+		return true;
+	}
+	m_aQueue[Write % QUEUE_SIZE] = Command;
+	m_WritePos.store(Write + 1, std::memory_order_release);
+	return true;
+}
+
+void CSoundMixer::Flush()
+{
+	if(m_vPending.empty())
+		return;
+	unsigned Write = m_WritePos.load(std::memory_order_relaxed);
+	unsigned Room = QUEUE_SIZE - (Write - m_ReadPos.load(std::memory_order_acquire));
+	unsigned Num = minimum(Room, (unsigned)m_vPending.size());
+	for(unsigned i = 0; i < Num; i++)
+		m_aQueue[(Write + i) % QUEUE_SIZE] = m_vPending[i];
+	m_WritePos.store(Write + Num, std::memory_order_release);
+	m_vPending.erase(m_vPending.begin(), m_vPending.begin() + Num);
+}
+
+void CSoundMixer::SetParams(int Voice, int Changed)
+{
+	m_aVoiceParams[Voice].m_Changed.fetch_or(Changed, std::memory_order_release);
+}
+
+bool CSoundMixer::FreeVoice(int Voice, int Age)
+{
+	int State = Age * 2 + 1;
+	return m_aVoiceStates[Voice].compare_exchange_strong(State, (Age + 1) * 2);
+}
+
+bool CSoundMixer::CheckVoice(int Voice, int Age) const
+{
+	return Voice >= 0 && Voice < NUM_VOICES && m_aVoiceStates[Voice].load() == Age * 2 + 1;
+}
+
+int CSoundMixer::Play(int ChannelID, CSample *pSample, int Flags, float x, float y, int *pAge)
+{
+	if(!m_Running)
+		return -1;
+
+	// search for voice
+	int VoiceID = -1;
+	int State = 0;
+	for(int i = 0; i < NUM_VOICES; i++)
+	{
+		int id = (m_NextVoice + i) % NUM_VOICES;
+		State = m_aVoiceStates[id];
+		if(!(State & 1) && m_aVoiceStates[id].compare_exchange_strong(State, State | 1))
+		{
+			VoiceID = id;
+			m_NextVoice = id + 1;
+			break;
+		}
+	}
+	if(VoiceID == -1)
+		return -1;
+
+	// the settings of the last time the voice played don't apply anymore
+	int Age = State / 2;
+	CVoiceParams *pParams = &m_aVoiceParams[VoiceID];
+	pParams->m_Volume = 1.0f;
+	pParams->m_Falloff = 0.0f;
+	pParams->m_X = x;
+	pParams->m_Y = y;
+	pParams->m_Shape = ISound::SHAPE_CIRCLE;
+	pParams->m_aShapeArgs[0] = s_DefaultDistance;
+	pParams->m_Changed.store(((unsigned)Age << PARAM_BITS) | PARAM_DEFAULTS, std::memory_order_release);
+
+	CCommand Command = MakeCommand(COMMAND_PLAY, VoiceID);
+	Command.m_Age = Age;
+	Command.m_Flags = Flags;
+	Command.m_Channel = ChannelID;
+	Command.m_pSample = pSample;
+	if(!Push(Command))
+	{
+		FreeVoice(VoiceID, Command.m_Age);
+		return -1;
+	}
+	m_apVoiceSamples[VoiceID] = pSample;
+	*pAge = Command.m_Age;
+	return VoiceID;
+}
+
+void CSoundMixer::StopVoice(int Voice, int Age)
+{
+	if(!CheckVoice(Voice, Age) || !FreeVoice(Voice, Age))
+		return;
+	CCommand Command = MakeCommand(COMMAND_STOP, Voice);
+	Push(Command);
+}
+
+int CSoundMixer::StopSample(CSample *pSample)
+{
+	int NumStopped = 0;
+	for(int i = 0; i < NUM_VOICES; i++)
+	{
+		int State = m_aVoiceStates[i];
+		if(!(State & 1) || m_apVoiceSamples[i] != pSample || !FreeVoice(i, State / 2))
+			continue;
+
+		// looping samples continue where they were stopped
+		CCommand Command = MakeCommand(COMMAND_STOP, i);
+		Command.m_Flags = 1;
+		Push(Command);
+		NumStopped++;
+	}
+	return NumStopped;
+}
+
+void CSoundMixer::StopAll()
+{
+	for(int i = 0; i < NUM_VOICES; i++)
+	{
+		int State = m_aVoiceStates[i];
+		if(!(State & 1) || !FreeVoice(i, State / 2))
+			continue;
+		CCommand Command = MakeCommand(COMMAND_STOP, i);
+		Command.m_Flags = 1;
+		Push(Command);
+	}
+}
+
+void CSoundMixer::SetVoiceVolume(int Voice, int Age, float Volume)
+{
+	if(!CheckVoice(Voice, Age))
+		return;
+	m_aVoiceParams[Voice].m_Volume = clamp(Volume, 0.0f, 1.0f);
+	SetParams(Voice, PARAM_VOLUME);
+}
+
+void CSoundMixer::SetVoiceFalloff(int Voice, int Age, float Falloff)
+{
+	if(!CheckVoice(Voice, Age))
+		return;
+	m_aVoiceParams[Voice].m_Falloff = clamp(Falloff, 0.0f, 1.0f);
+	SetParams(Voice, PARAM_FALLOFF);
+}
+
+void CSoundMixer::SetVoiceLocation(int Voice, int Age, float x, float y)
+{
+	if(!CheckVoice(Voice, Age))
+		return;
+	m_aVoiceParams[Voice].m_X = x;
+	m_aVoiceParams[Voice].m_Y = y;
+	SetParams(Voice, PARAM_LOCATION);
+}
+
+void CSoundMixer::SetVoiceTimeOffset(int Voice, int Age, float Offset)
+{
+	if(!CheckVoice(Voice, Age))
+		return;
+	m_aVoiceParams[Voice].m_TimeOffset = Offset;
+	SetParams(Voice, PARAM_TIME_OFFSET);
+}
+
+void CSoundMixer::SetVoiceCircle(int Voice, int Age, float Radius)
+{
+	if(!CheckVoice(Voice, Age))
+		return;
+	m_aVoiceParams[Voice].m_Shape = ISound::SHAPE_CIRCLE;
+	m_aVoiceParams[Voice].m_aShapeArgs[0] = maximum(0.0f, Radius);
+	SetParams(Voice, PARAM_SHAPE);
+}
+
+void CSoundMixer::SetVoiceRectangle(int Voice, int Age, float Width, float Height)
+{
+	if(!CheckVoice(Voice, Age))
+		return;
+	m_aVoiceParams[Voice].m_Shape = ISound::SHAPE_RECTANGLE;
+	m_aVoiceParams[Voice].m_aShapeArgs[0] = maximum(0.0f, Width);
+	m_aVoiceParams[Voice].m_aShapeArgs[1] = maximum(0.0f, Height);
+	SetParams(Voice, PARAM_SHAPE);
+}
+
+void CSoundMixer::SetChannel(int ChannelID, float Vol, float Pan)
+{
+	m_aChannelParams[ChannelID].m_Vol = Vol;
+	m_aChannelParams[ChannelID].m_Pan = Pan;
+}
+
+void CSoundMixer::SetListenerPos(float x, float y)
+{
+	m_ListenerX = (int)x;
+	m_ListenerY = (int)y;
+}
+
+bool CSoundMixer::Sync(int TimeoutMs)
+{
+	unsigned Target = m_WritePos.load() + m_vPending.size();
+	int64 End = time_get_impl() + time_freq() * TimeoutMs / 1000;
+	while(m_Running)
+	{
+		Flush();
+		if((int)(m_ReadPos.load() - Target) >= 0)
+			break;
+		if(time_get_impl() > End)
+			return false;
+		thread_sleep(1000);
+	}
+	return true;
+}
+
+void CSoundMixer::ApplyCommands()
+{
+	unsigned Read = m_ReadPos.load(std::memory_order_relaxed);
+	unsigned Write = m_WritePos.load(std::memory_order_acquire);
+	for(; Read != Write; Read++)
+		Apply(m_aQueue[Read % QUEUE_SIZE]);
+	m_ReadPos.store(Read, std::memory_order_release);
+}
+
+void CSoundMixer::StopVoiceAudio(CVoice *pVoice, bool Pause)
+{
+	if(!pVoice->m_pSample)
+		return;
+	if(Pause)
+		pVoice->m_pSample->m_PausedAt = pVoice->m_Flags & ISound::FLAG_LOOP ? pVoice->m_Tick : 0;
+	pVoice->m_pSample = 0;
+}
+
+void CSoundMixer::Apply(const CCommand &Command)
+{
+	CVoice *v = &m_aVoices[Command.m_Voice];
+	switch(Command.m_Type)
+	{
+	case COMMAND_PLAY:
+		v->m_pSample = Command.m_pSample;
+		v->m_pChannel = &m_aChannels[Command.m_Channel];
+		v->m_Age = Command.m_Age;
+		v->m_Flags = Command.m_Flags;
+		if(v->m_Flags & ISound::FLAG_LOOP)
+			v->m_Tick = v->m_pSample->m_PausedAt;
+		else
+			v->m_Tick = 0;
+		break;
+	case COMMAND_STOP:
+		StopVoiceAudio(v, Command.m_Flags != 0);
+		break;
+	}
+}
+
+void CSoundMixer::ApplyParams(int Voice)
+{
+	CVoice *v = &m_aVoices[Voice];
+	if(!v->m_pSample)
+		return;
+
+	// only take the settings of the age this voice is playing, the game
+	// thread may already have started it again
+	CVoiceParams *pParams = &m_aVoiceParams[Voice];
+	unsigned Changed = pParams->m_Changed.load(std::memory_order_acquire);
+	unsigned Mask = (1u << PARAM_BITS) - 1;
+	if(!(Changed & Mask) || (Changed >> PARAM_BITS) != ((unsigned)v->m_Age & (~0u >> PARAM_BITS)))
+		return;
+	if(!pParams->m_Changed.compare_exchange_strong(Changed, Changed & ~Mask, std::memory_order_acquire))
+		return;
+
+	if(Changed & PARAM_VOLUME)
+		v->m_Vol = (int)(pParams->m_Volume * 255.0f);
+	if(Changed & PARAM_FALLOFF)
+		v->m_Falloff = pParams->m_Falloff;
+	if(Changed & PARAM_LOCATION)
+	{
+		v->m_X = pParams->m_X;
+		v->m_Y = pParams->m_Y;
+	}
+	if(Changed & PARAM_SHAPE)
+	{
+		v->m_Shape = pParams->m_Shape;
+		if(v->m_Shape == ISound::SHAPE_CIRCLE)
+			v->m_Circle.m_Radius = pParams->m_aShapeArgs[0];
+		else
+		{
+			v->m_Rectangle.m_Width = pParams->m_aShapeArgs[0];
+			v->m_Rectangle.m_Height = pParams->m_aShapeArgs[1];
+		}
+	}
+	if(Changed & PARAM_TIME_OFFSET)
+	{
+		int Tick = 0;
+		bool IsLooping = v->m_Flags & ISound::FLAG_LOOP;
+		uint64 TickOffset = v->m_pSample->m_Rate * pParams->m_TimeOffset;
+		if(v->m_pSample->m_NumFrames > 0 && IsLooping)
+			Tick = TickOffset % v->m_pSample->m_NumFrames;
+		else
+			Tick = clamp(TickOffset, (uint64)0, (uint64)v->m_pSample->m_NumFrames);
+
+		// at least 200msec off, else depend on buffer size
+		float Threshold = maximum(0.2f * v->m_pSample->m_Rate, (float)m_MaxFrames);
+		if(abs(v->m_Tick - Tick) > Threshold)
+		{
+			// take care of looping (modulo!)
+			if(!(IsLooping && (minimum(v->m_Tick, Tick) + v->m_pSample->m_NumFrames - maximum(v->m_Tick, Tick)) <= Threshold))
+			{
+				v->m_Tick = Tick;
+			}
+		}
+	}
+}
+
+void CSoundMixer::VoiceVolume(const CVoice *v, int *pLvol, int *pRvol) const
+{
+	int Rvol = (int)(v->m_pChannel->m_Vol * (v->m_Vol / 255.0f));
+	int Lvol = (int)(v->m_pChannel->m_Vol * (v->m_Vol / 255.0f));
+
+	if(v->m_Flags & ISound::FLAG_POS && v->m_pChannel->m_Pan)
+	{
+		// TODO: we should respect the channel panning value
+		int dx = v->m_X - m_CenterX;
+		int dy = v->m_Y - m_CenterY;
+		//
+		int p = abs(dx);
+		float FalloffX = 0.0f;
+		float FalloffY = 0.0f;
+
+		int RangeX = 0; // for panning
+		bool InVoiceField = false;
+
+		switch(v->m_Shape)
+		{
+		case ISound::SHAPE_CIRCLE:
+		{
+			float r = v->m_Circle.m_Radius;
+			RangeX = r;
+
+			int Dist = (int)sqrtf((float)dx * dx + dy * dy); // nasty float
+			if(Dist < r)
+			{
+				InVoiceField = true;
+
+				// falloff
+				int FalloffDistance = r * v->m_Falloff;
+				if(Dist > FalloffDistance)
+					FalloffX = FalloffY = (r - Dist) / (r - FalloffDistance);
+				else
+					FalloffX = FalloffY = 1.0f;
+			}
+			break;
+		}
+
+		case ISound::SHAPE_RECTANGLE:
+		{
+			RangeX = v->m_Rectangle.m_Width / 2.0f;
+
+			int abs_dx = abs(dx);
+			int abs_dy = abs(dy);
+
+			int w = v->m_Rectangle.m_Width / 2.0f;
+			int h = v->m_Rectangle.m_Height / 2.0f;
+
+			if(abs_dx < w && abs_dy < h)
+			{
+				InVoiceField = true;
+
+				// falloff
+				int fx = v->m_Falloff * w;
+				int fy = v->m_Falloff * h;
+
+				FalloffX = abs_dx > fx ? (float)(w - abs_dx) / (w - fx) : 1.0f;
+				FalloffY = abs_dy > fy ? (float)(h - abs_dy) / (h - fy) : 1.0f;
+			}
+			break;
+		}
+		};
+
+		if(InVoiceField)
+		{
+			// panning
+			if(!(v->m_Flags & ISound::FLAG_NO_PANNING))
+			{
+				if(dx > 0)
+					Lvol = ((RangeX - p) * Lvol) / RangeX;
+				else
+					Rvol = ((RangeX - p) * Rvol) / RangeX;
+			}
+
+			Lvol *= FalloffX * FalloffY;
+			Rvol *= FalloffX * FalloffY;
+		}
+		else
+		{
+			Lvol = 0;
+			Rvol = 0;
+		}
+	}
+
+	*pLvol = Lvol;
+	*pRvol = Rvol;
+}
+
+void CSoundMixer::MixVoice(int *pOut, const short *pIn, int Channels, unsigned Frames, int Lvol, int Rvol)
+{
+	unsigned s = 0;
+	// the vector paths multiply 16 bit values, which covers every volume the
+	// mixer produces
+	bool Vectorize = Lvol >= -0x8000 && Lvol <= 0x7fff && Rvol >= -0x8000 && Rvol <= 0x7fff;
+#if defined(__SSE2__)
+	if(Vectorize)
+	{
+		const __m128i Vol = _mm_set_epi16(Rvol, Lvol, Rvol, Lvol, Rvol, Lvol, Rvol, Lvol);
+		if(Channels == 2)
+		{
+			for(; s + 4 <= Frames; s += 4)
+			{
+				__m128i In = _mm_loadu_si128((const __m128i *)(pIn + s * 2));
+				__m128i Lo = _mm_mullo_epi16(In, Vol);
+				__m128i Hi = _mm_mulhi_epi16(In, Vol);
+				__m128i *pDest = (__m128i *)(pOut + s * 2);
+				_mm_storeu_si128(pDest, _mm_add_epi32(_mm_loadu_si128(pDest), _mm_unpacklo_epi16(Lo, Hi)));
+				_mm_storeu_si128(pDest + 1, _mm_add_epi32(_mm_loadu_si128(pDest + 1), _mm_unpackhi_epi16(Lo, Hi)));
+			}
+		}
+		else
+		{
+			for(; s + 8 <= Frames; s += 8)
+			{
+				__m128i In = _mm_loadu_si128((const __m128i *)(pIn + s));
+				// duplicate every sample for both sides
+				__m128i aIn[2] = {_mm_unpacklo_epi16(In, In), _mm_unpackhi_epi16(In, In)};
+				__m128i *pDest = (__m128i *)(pOut + s * 2);
+				for(int i = 0; i < 2; i++)
+				{
+					__m128i Lo = _mm_mullo_epi16(aIn[i], Vol);
+					__m128i Hi = _mm_mulhi_epi16(aIn[i], Vol);
+					_mm_storeu_si128(pDest + i * 2, _mm_add_epi32(_mm_loadu_si128(pDest + i * 2), _mm_unpacklo_epi16(Lo, Hi)));
+					_mm_storeu_si128(pDest + i * 2 + 1, _mm_add_epi32(_mm_loadu_si128(pDest + i * 2 + 1), _mm_unpackhi_epi16(Lo, Hi)));
+				}
+			}
+		}
+	}
+#elif defined(SOUNDMIXER_NEON)
+	if(Vectorize)
+	{
+		const int16_t aVol[4] = {(int16_t)Lvol, (int16_t)Rvol, (int16_t)Lvol, (int16_t)Rvol};
+		const int16x4_t Vol = vld1_s16(aVol);
+		if(Channels == 2)
+		{
+			for(; s + 4 <= Frames; s += 4)
+			{
+				int16x8_t In = vld1q_s16(pIn + s * 2);
+				int32_t *pDest = (int32_t *)pOut + s * 2;
+				vst1q_s32(pDest, vmlal_s16(vld1q_s32(pDest), vget_low_s16(In), Vol));
+				vst1q_s32(pDest + 4, vmlal_s16(vld1q_s32(pDest + 4), vget_high_s16(In), Vol));
+			}
+		}
+		else
+		{
+			for(; s + 4 <= Frames; s += 4)
+			{
+				int16x4_t In = vld1_s16(pIn + s);
+				// duplicate every sample for both sides
+				int16x4x2_t Both = vzip_s16(In, In);
+				int32_t *pDest = (int32_t *)pOut + s * 2;
+				vst1q_s32(pDest, vmlal_s16(vld1q_s32(pDest), Both.val[0], Vol));
+				vst1q_s32(pDest + 4, vmlal_s16(vld1q_s32(pDest + 4), Both.val[1], Vol));
+			}
+		}
+	}
+#else
+	(void)Vectorize;
+#endif
+
+	const short *pInL = pIn + s * Channels;
+	const short *pInR = pInL + Channels - 1;
+	pOut += s * 2;
+	for(; s < Frames; s++)
+	{
+		*pOut++ += (*pInL) * Lvol;
+		*pOut++ += (*pInR) * Rvol;
+		pInL += Channels;
+		pInR += Channels;
+	}
+}
+
+void CSoundMixer::Mix(short *pFinalOut, unsigned Frames)
+{
+	mem_zero(m_pMixBuffer, m_MaxFrames * 2 * sizeof(int));
+	Frames = minimum(Frames, m_MaxFrames);
+
+	ApplyCommands();
+	for(int i = 0; i < NUM_CHANNELS; i++)
+	{
+		m_aChannels[i].m_Vol = (int)(m_aChannelParams[i].m_Vol * 255.0f);
+		m_aChannels[i].m_Pan = (int)(m_aChannelParams[i].m_Pan * 255.0f); // TODO: this is only on and off right now
+	}
+	m_CenterX = m_ListenerX;
+	m_CenterY = m_ListenerY;
+	int MasterVol = m_Volume;
+
+	for(int i = 0; i < NUM_VOICES; i++)
+	{
+		ApplyParams(i);
+		CVoice *v = &m_aVoices[i];
+		if(!v->m_pSample)
+			continue;
+
+		// make sure that we don't go outside the sound data
+		unsigned End = minimum((unsigned)(v->m_pSample->m_NumFrames - v->m_Tick), Frames);
+
+		// the volume only changes between buffers
+		int Lvol, Rvol;
+		VoiceVolume(v, &Lvol, &Rvol);
+		if(Lvol || Rvol)
+			MixVoice(m_pMixBuffer, &v->m_pSample->m_pData[v->m_Tick * v->m_pSample->m_Channels], v->m_pSample->m_Channels, End, Lvol, Rvol);
+		v->m_Tick += End;
+
+		// free voice if not used any more
+		if(v->m_Tick == v->m_pSample->m_NumFrames)
+		{
+			if(v->m_Flags & ISound::FLAG_LOOP)
+				v->m_Tick = 0;
+			else
+			{
+				v->m_pSample = 0;
+				FreeVoice(i, v->m_Age);
+			}
+		}
+	}
+
+	// clamp accumulated values
+	for(unsigned i = 0; i < Frames; i++)
+	{
+		int j = i << 1;
+		int vl = ((m_pMixBuffer[j] * MasterVol) / 101) >> 8;
+		int vr = ((m_pMixBuffer[j + 1] * MasterVol) / 101) >> 8;
+
+		pFinalOut[j] = Int2Short(vl);
+		pFinalOut[j + 1] = Int2Short(vr);
+	}
+
+#if defined(CONF_ARCH_ENDIAN_BIG)
+	swap_endian(pFinalOut, sizeof(short), Frames * 2);
+#endif
+}
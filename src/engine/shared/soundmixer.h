@@ -0,0 +1,193 @@
+#ifndef ENGINE_SHARED_SOUNDMIXER_H
+#define ENGINE_SHARED_SOUNDMIXER_H
+
+#include <base/system.h>
+#include <engine/sound.h>
+
+#include <atomic>
+#include <vector>
+
+// Mixes the playing voices for the audio callback without taking a lock.
+// The voices belong to the audio thread. The game thread sends play and stop
+// through a queue that is applied at the start of every mix, those are never
+// dropped: if the queue is full they wait on the game thread until there is
+// room again. Volume, location and the other voice settings only keep their
+// latest value in a slot per voice, so setting them every frame can't fill
+// the queue. Only one thread at a time may send commands.
+//
+// The game thread keeps the age of every voice and whether it's playing in
+// one atomic, so finding a free voice or checking a handle never waits for
+// the audio thread.
+class CSoundMixer
+{
+public:
+	enum
+	{
+		NUM_VOICES = 256,
+		NUM_CHANNELS = 16,
+		QUEUE_SIZE = 4096,
+	};
+
+	struct CSample
+	{
+		short *m_pData;
+		int m_NumFrames;
+		int m_Rate;
+		int m_Channels;
+		int m_LoopStart;
+		int m_LoopEnd;
+		// only used by the audio thread
+		int m_PausedAt;
+	};
+
+private:
+	enum
+	{
+		COMMAND_PLAY = 0,
+		COMMAND_STOP,
+
+		PARAM_VOLUME = 1,
+		PARAM_FALLOFF = 2,
+		PARAM_LOCATION = 4,
+		PARAM_TIME_OFFSET = 8,
+		PARAM_SHAPE = 16,
+		PARAM_DEFAULTS = PARAM_VOLUME | PARAM_FALLOFF | PARAM_LOCATION | PARAM_SHAPE,
+		PARAM_BITS = 8,
+	};
+
+	struct CCommand
+	{
+		int m_Type;
+		int m_Voice;
+		int m_Age;
+		int m_Flags;
+		int m_Channel;
+		CSample *m_pSample;
+	};
+
+	struct CChannel
+	{
+		int m_Vol;
+		int m_Pan;
+	};
+
+	struct CVoice
+	{
+		CSample *m_pSample;
+		CChannel *m_pChannel;
+		int m_Age; // the age it was played with
+		int m_Tick;
+		int m_Vol; // 0 - 255
+		int m_Flags;
+		int m_X, m_Y;
+		float m_Falloff; // [0.0, 1.0]
+
+		int m_Shape;
+		union
+		{
+			ISound::CVoiceShapeCircle m_Circle;
+			ISound::CVoiceShapeRectangle m_Rectangle;
+		};
+	};
+
+	// the latest settings of a voice, written by the game thread
+	struct CVoiceParams
+	{
+		// the age the settings are for, shifted by PARAM_BITS, and the
+		// PARAM_* that changed since the audio thread looked last
+		std::atomic<unsigned> m_Changed;
+		std::atomic<float> m_Volume;
+		std::atomic<float> m_Falloff;
+		std::atomic<float> m_X;
+		std::atomic<float> m_Y;
+		std::atomic<float> m_TimeOffset;
+		std::atomic<int> m_Shape;
+		std::atomic<float> m_aShapeArgs[2];
+	};
+
+	struct CChannelParams
+	{
+		std::atomic<float> m_Vol;
+		std::atomic<float> m_Pan;
+	};
+
+	// audio thread
+	CVoice m_aVoices[NUM_VOICES];
+	CChannel m_aChannels[NUM_CHANNELS];
+	int m_CenterX;
+	int m_CenterY;
+	int *m_pMixBuffer;
+	unsigned m_MaxFrames;
+
+	// game thread, the sample a voice was played with
+	CSample *m_apVoiceSamples[NUM_VOICES];
+	int m_NextVoice;
+	// commands that didn't fit into the queue yet
+	std::vector<CCommand> m_vPending;
+
+	CVoiceParams m_aVoiceParams[NUM_VOICES];
+	CChannelParams m_aChannelParams[NUM_CHANNELS];
+	std::atomic<int> m_ListenerX;
+	std::atomic<int> m_ListenerY;
+
+	// age * 2, plus one while the voice is playing
+	std::atomic<int> m_aVoiceStates[NUM_VOICES];
+	std::atomic<int> m_Volume;
+	std::atomic<bool> m_Running;
+
+	CCommand m_aQueue[QUEUE_SIZE];
+	std::atomic<unsigned> m_ReadPos;
+	std::atomic<unsigned> m_WritePos;
+
+	static CCommand MakeCommand(int Type, int Voice);
+	bool Push(const CCommand &Command);
+	void SetParams(int Voice, int Changed);
+	void ApplyCommands();
+	void Apply(const CCommand &Command);
+	void ApplyParams(int Voice);
+	void StopVoiceAudio(CVoice *pVoice, bool Pause);
+	bool FreeVoice(int Voice, int Age);
+	void VoiceVolume(const CVoice *pVoice, int *pLvol, int *pRvol) const;
+	bool CheckVoice(int Voice, int Age) const;
+
+public:
+	CSoundMixer();
+	~CSoundMixer();
+
+	// MaxFrames is the most frames a single mix can produce
+	void Init(unsigned MaxFrames);
+	void Shutdown();
+	// commands are only queued while the mixer is running
+	bool IsRunning() const { return m_Running; }
+
+	// game thread
+	// returns the voice or -1 if all are in use
+	int Play(int ChannelID, CSample *pSample, int Flags, float x, float y, int *pAge);
+	void StopVoice(int Voice, int Age);
+	// returns the number of voices that were stopped
+	int StopSample(CSample *pSample);
+	void StopAll();
+	void SetVoiceVolume(int Voice, int Age, float Volume);
+	void SetVoiceFalloff(int Voice, int Age, float Falloff);
+	void SetVoiceLocation(int Voice, int Age, float x, float y);
+	void SetVoiceTimeOffset(int Voice, int Age, float Offset);
+	void SetVoiceCircle(int Voice, int Age, float Radius);
+	void SetVoiceRectangle(int Voice, int Age, float Width, float Height);
+	void SetChannel(int ChannelID, float Vol, float Pan);
+	void SetListenerPos(float x, float y);
+	void SetVolume(int Volume) { m_Volume = Volume; }
+	// moves commands that waited for room into the queue
+	void Flush();
+	// waits until the audio thread applied all commands sent so far,
+	// returns false if it didn't within the timeout
+	bool Sync(int TimeoutMs);
+
+	// audio thread
+	void Mix(short *pFinalOut, unsigned Frames);
+
+	// adds Frames frames of a mono or stereo sample, scaled by the volumes,
+	// to the interleaved stereo buffer
+	static void MixVoice(int *pOut, const short *pIn, int Channels, unsigned Frames, int Lvol, int Rvol);
+};
+
+#endif // ENGINE_SHARED_SOUNDMIXER_H
@@ -55,11 +55,19 @@ public:
 
 	virtual bool IsSoundEnabled() = 0;
 
+	// samples are decoded in the background, they can't be played until
+	// they are ready. files that are missing return -1 right away, data that
+	// can't be decoded only shows up later with IsSampleFailed. the editor's
+	// FromEditor loads decode right away and still return -1 for it
 	virtual int LoadWV(const char *pFilename) = 0;
 	virtual int LoadOpus(const char *pFilename) = 0;
 	virtual int LoadWVFromMem(const void *pData, unsigned DataSize, bool FromEditor = false) = 0;
 	virtual int LoadOpusFromMem(const void *pData, unsigned DataSize, bool FromEditor = false) = 0;
 	virtual void UnloadSample(int SampleID) = 0;
+	// false while the sample is decoding or if decoding failed
+	virtual bool IsSampleReady(int SampleID) = 0;
+	// true once decoding failed, the ID stays in use until it's unloaded
+	virtual bool IsSampleFailed(int SampleID) = 0;
 
 	virtual float GetSampleDuration(int SampleID) = 0; // in s
 
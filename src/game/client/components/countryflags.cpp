@@ -4,14 +4,18 @@
 #include <base/system.h>
 
 #include <engine/console.h>
+#include <engine/engine.h>
 #include <engine/graphics.h>
 #include <engine/shared/config.h>
+#include <engine/shared/jobs.h>
 #include <engine/shared/linereader.h>
 #include <engine/storage.h>
 #include <engine/textrender.h>
 
 #include "countryflags.h"
 
+#include <vector>
+
 void CCountryFlags::LoadCountryflagsIndexfile()
 {
 	IOHANDLE File = Storage()->OpenFile("countryflags/index.txt", IOFLAG_READ, IStorage::TYPE_ALL);
@@ -21,6 +25,15 @@ void CCountryFlags::LoadCountryflagsIndexfile()
 		return;
 	}
 
+	struct CCountryFlagImage
+	{
+		char m_aOrigin[128];
+		int m_CountryCode;
+		bool m_Success;
+		CImageInfo m_Info;
+	};
+	std::vector<CCountryFlagImage> vFlags;
+
 	char aOrigin[128];
 	CLineReader LineReader;
 	LineReader.Init(File);
@@ -55,39 +68,61 @@ void CCountryFlags::LoadCountryflagsIndexfile()
 			continue;
 		}
 
-		// load the graphic file
+		CCountryFlagImage Flag;
+		str_copy(Flag.m_aOrigin, aOrigin, sizeof(Flag.m_aOrigin));
+		Flag.m_CountryCode = CountryCode;
+		Flag.m_Success = false;
+		vFlags.push_back(Flag);
+	}
+	io_close(File);
+
+	// decode the graphic files on the job pool and here, upload them in order
+	int64 StartTime = time_get_impl();
+	IGraphics *pGraphics = Graphics();
+	CParallelWork Work(g_Config.m_ClLoadCountryFlags ? vFlags.size() : 0, [&](int i) {
+		char aPath[128];
+		str_format(aPath, sizeof(aPath), "countryflags/%s.png", vFlags[i].m_aOrigin);
+		vFlags[i].m_Success = pGraphics->LoadPNG(&vFlags[i].m_Info, aPath, IStorage::TYPE_ALL);
+	});
+	m_pClient->Engine()->AddJobs(Work.HelperJobs(), CJobPool::PRIORITY_HIGH);
+	for(int i = 0; i < (int)vFlags.size(); i++)
+	{
 		char aBuf[128];
-		CImageInfo Info;
+		CImageInfo *pInfo = &vFlags[i].m_Info;
 		if(g_Config.m_ClLoadCountryFlags)
 		{
-			str_format(aBuf, sizeof(aBuf), "countryflags/%s.png", aOrigin);
-			if(!Graphics()->LoadPNG(&Info, aBuf, IStorage::TYPE_ALL))
+			Work.Wait(i);
+			if(!vFlags[i].m_Success)
 			{
-				char aMsg[128];
-				str_format(aMsg, sizeof(aMsg), "failed to load '%s'", aBuf);
-				Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "countryflags", aMsg);
+				str_format(aBuf, sizeof(aBuf), "failed to load 'countryflags/%s.png'", vFlags[i].m_aOrigin);
+				Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "countryflags", aBuf);
 				continue;
 			}
 		}
 
 		// add entry
 		CCountryFlag CountryFlag;
-		CountryFlag.m_CountryCode = CountryCode;
-		str_copy(CountryFlag.m_aCountryCodeString, aOrigin, sizeof(CountryFlag.m_aCountryCodeString));
+		CountryFlag.m_CountryCode = vFlags[i].m_CountryCode;
+		str_copy(CountryFlag.m_aCountryCodeString, vFlags[i].m_aOrigin, sizeof(CountryFlag.m_aCountryCodeString));
 		if(g_Config.m_ClLoadCountryFlags)
 		{
-			CountryFlag.m_Texture = Graphics()->LoadTextureRaw(Info.m_Width, Info.m_Height, Info.m_Format, Info.m_pData, Info.m_Format, 0);
-			free(Info.m_pData);
+			CountryFlag.m_Texture = Graphics()->LoadTextureRaw(pInfo->m_Width, pInfo->m_Height, pInfo->m_Format, pInfo->m_pData, pInfo->m_Format, 0);
+			free(pInfo->m_pData);
 		}
 
 		if(g_Config.m_Debug)
 		{
-			str_format(aBuf, sizeof(aBuf), "loaded country flag '%s'", aOrigin);
+			str_format(aBuf, sizeof(aBuf), "loaded country flag '%s'", vFlags[i].m_aOrigin);
 			Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "countryflags", aBuf);
 		}
 		m_aCountryFlags.add_unsorted(CountryFlag);
 	}
-	io_close(File);
+	if(g_Config.m_ClLoadCountryFlags)
+	{
+		char aBuf[128];
+		str_format(aBuf, sizeof(aBuf), "loaded %d country flags in %.2fms", m_aCountryFlags.size(), (time_get_impl() - StartTime) * 1000.0 / time_freq());
+		Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "countryflags", aBuf);
+	}
 	m_aCountryFlags.sort_range();
 
 	// find index of default item
@@ -2,6 +2,7 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include <engine/graphics.h>
 #include <engine/shared/config.h>
+#include <engine/shared/profiler.h>
 #include <engine/textrender.h>
 
 #include <game/generated/client_data.h>
@@ -143,8 +144,87 @@ void CDebugHud::RenderTuning()
 	TextRender()->TextColor(1, 1, 1, 1);
 }
 
+void CDebugHud::RenderProfiler()
+{
+	if(!g_Config.m_DbgProfile || !g_Profiler.NumFrames())
+		return;
+
+	Graphics()->MapScreen(0, 0, 300 * Graphics()->ScreenAspect(), 300);
+
+	// slowest zones first
+	int aZones[CProfiler::MAX_ZONES];
+	float aAverages[CProfiler::MAX_ZONES];
+	int NumZones = g_Profiler.NumZones();
+	for(int i = 0; i < NumZones; i++)
+	{
+		float Average = g_Profiler.Average(i);
+		int j = i;
+		for(; j > 0 && aAverages[j - 1] < Average; j--)
+		{
+			aZones[j] = aZones[j - 1];
+			aAverages[j] = aAverages[j - 1];
+		}
+		aZones[j] = i;
+		aAverages[j] = Average;
+	}
+
+	const float LineHeight = 6.0f;
+	const float FontSize = 5.0f;
+	const float GraphWidth = 40.0f;
+	const int MaxLines = 30;
+	float y = 27.0f;
+
+	TextRender()->Text(0, 5.0f, y, FontSize, "zone", -1.0f);
+	TextRender()->Text(0, 95.0f, y, FontSize, "avg ms", -1.0f);
+	TextRender()->Text(0, 120.0f, y, FontSize, "max ms", -1.0f);
+	y += LineHeight;
+
+	int NumLines = minimum(NumZones, MaxLines);
+	for(int i = 0; i < NumLines; i++)
+	{
+		char aBuf[32];
+		int Zone = aZones[i];
+		TextRender()->Text(0, 5.0f, y + i * LineHeight, FontSize, g_Profiler.ZoneName(Zone), -1.0f);
+		str_format(aBuf, sizeof(aBuf), "%.3f", aAverages[i] * 1000.0f);
+		float w = TextRender()->TextWidth(0, FontSize, aBuf, -1, -1.0f);
+		TextRender()->Text(0, 115.0f - w, y + i * LineHeight, FontSize, aBuf, -1.0f);
+		str_format(aBuf, sizeof(aBuf), "%.3f", g_Profiler.Max(Zone) * 1000.0f);
+		w = TextRender()->TextWidth(0, FontSize, aBuf, -1, -1.0f);
+		TextRender()->Text(0, 140.0f - w, y + i * LineHeight, FontSize, aBuf, -1.0f);
+	}
+
+	// the history of every zone, scaled to its own maximum
+	Graphics()->TextureClear();
+	Graphics()->BlendNormal();
+	Graphics()->LinesBegin();
+	Graphics()->SetColor(0.5f, 1.0f, 0.5f, 1.0f);
+	for(int i = 0; i < NumLines; i++)
+	{
+		int Zone = aZones[i];
+		float Max = g_Profiler.Max(Zone);
+		if(Max <= 0.0f)
+			continue;
+		IGraphics::CLineItem aLines[CProfiler::HISTORY_SIZE];
+		int NumFrames = g_Profiler.NumFrames();
+		float Bottom = y + (i + 1) * LineHeight - 1.0f;
+		float Scale = (LineHeight - 2.0f) / Max;
+		float Step = GraphWidth / CProfiler::HISTORY_SIZE;
+		float x = 150.0f + GraphWidth;
+		float Prev = g_Profiler.FrameTime(Zone, 0);
+		for(int f = 1; f < NumFrames; f++)
+		{
+			float Cur = g_Profiler.FrameTime(Zone, f);
+			aLines[f - 1] = IGraphics::CLineItem(x - (f - 1) * Step, Bottom - Prev * Scale, x - f * Step, Bottom - Cur * Scale);
+			Prev = Cur;
+		}
+		Graphics()->LinesDraw(aLines, NumFrames - 1);
+	}
+	Graphics()->LinesEnd();
+}
+
 void CDebugHud::OnRender()
 {
 	RenderTuning();
+	RenderProfiler();
 	RenderNetCorrections();
 }
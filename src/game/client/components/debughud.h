@@ -8,6 +8,7 @@ class CDebugHud : public CComponent
 {
 	void RenderNetCorrections();
 	void RenderTuning();
+	void RenderProfiler();
 
 public:
 	virtual void OnRender();
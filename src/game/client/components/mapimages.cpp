@@ -1,8 +1,10 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <engine/engine.h>
 #include <engine/graphics.h>
 #include <engine/map.h>
 #include <engine/serverbrowser.h>
+#include <engine/shared/jobs.h>
 #include <engine/storage.h>
 #include <engine/textrender.h>
 #include <game/client/component.h>
@@ -10,6 +12,8 @@
 
 #include "mapimages.h"
 
+#include <vector>
+
 CMapImages::CMapImages() :
 	CMapImages(100)
 {
@@ -89,17 +93,53 @@ void CMapImages::OnMapLoadImpl(class CLayers *pLayers, IMap *pMap)
 
 	int TextureLoadFlag = Graphics()->HasTextureArrays() ? IGraphics::TEXLOAD_TO_2D_ARRAY_TEXTURE : IGraphics::TEXLOAD_TO_3D_TEXTURE;
 
+	// the external images are decoded on the job pool while the embedded ones
+	// are loaded here, the map data can only be read from the main thread
+	int64 StartTime = time_get_impl();
+	struct CExternalImage
+	{
+		char m_aPath[256];
+		bool m_Success;
+		CImageInfo m_Info;
+	};
+	CExternalImage aExternal[64];
+	std::vector<int> vExternal;
+	for(int i = 0; i < m_Count; i++)
+	{
+		CMapItemImage *pImg = (CMapItemImage *)pMap->GetItem(Start + i, 0, 0);
+		if(pImg->m_External)
+		{
+			char *pName = (char *)pMap->GetData(pImg->m_ImageName);
+			str_format(aExternal[i].m_aPath, sizeof(aExternal[i].m_aPath), "mapres/%s.png", pName);
+			aExternal[i].m_Success = false;
+			vExternal.push_back(i);
+		}
+	}
+	IGraphics *pGraphics = Graphics();
+	CParallelWork Work(vExternal.size(), [&](int j) {
+		CExternalImage *pExternal = &aExternal[vExternal[j]];
+		pExternal->m_Success = pGraphics->LoadPNG(&pExternal->m_Info, pExternal->m_aPath, IStorage::TYPE_ALL);
+	});
+	m_pClient->Engine()->AddJobs(Work.HelperJobs(), CJobPool::PRIORITY_HIGH);
+
 	// load new textures
+	int NextExternal = 0;
 	for(int i = 0; i < m_Count; i++)
 	{
 		int LoadFlag = (((m_aTextureUsedByTileOrQuadLayerFlag[i] & 1) != 0) ? TextureLoadFlag : 0) | (((m_aTextureUsedByTileOrQuadLayerFlag[i] & 2) != 0) ? 0 : (Graphics()->IsTileBufferingEnabled() ? IGraphics::TEXLOAD_NO_2D_TEXTURE : 0));
 		CMapItemImage *pImg = (CMapItemImage *)pMap->GetItem(Start + i, 0, 0);
 		if(pImg->m_External)
 		{
-			char Buf[256];
-			char *pName = (char *)pMap->GetData(pImg->m_ImageName);
-			str_format(Buf, sizeof(Buf), "mapres/%s.png", pName);
-			m_aTextures[i] = Graphics()->LoadTexture(Buf, IStorage::TYPE_ALL, CImageInfo::FORMAT_AUTO, LoadFlag);
+			Work.Wait(NextExternal++);
+			CExternalImage *pExternal = &aExternal[i];
+			if(pExternal->m_Success)
+			{
+				CImageInfo *pInfo = &pExternal->m_Info;
+				m_aTextures[i] = Graphics()->LoadTextureRaw(pInfo->m_Width, pInfo->m_Height, pInfo->m_Format, pInfo->m_pData, pInfo->m_Format, LoadFlag, pExternal->m_aPath);
+				free(pInfo->m_pData);
+			}
+			else
+				m_aTextures[i] = Graphics()->LoadTexture(pExternal->m_aPath, IStorage::TYPE_ALL, CImageInfo::FORMAT_AUTO, LoadFlag);
 		}
 		else
 		{
@@ -111,6 +151,10 @@ void CMapImages::OnMapLoadImpl(class CLayers *pLayers, IMap *pMap)
 			pMap->UnloadData(pImg->m_ImageData);
 		}
 	}
+
+	char aBuf[128];
+	str_format(aBuf, sizeof(aBuf), "loaded %d map images (%d external) in %.2fms", m_Count, (int)vExternal.size(), (time_get_impl() - StartTime) * 1000.0 / time_freq());
+	Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "mapimages", aBuf);
 }
 
 void CMapImages::OnMapLoad()
@@ -119,9 +119,16 @@ void CMapSounds::OnRender()
 				// currently playing, set offset
 				Sound()->SetVoiceTimeOffset(pSource->m_Voice, Offset);
 			}
-			else
+			else if(Sound()->IsSampleFailed(m_aSounds[pSource->m_Sound]))
 			{
-				// need to enqueue
+				// free the slot, the other sources of the sample skip it then
+				dbg_msg("mapsounds", "failed to decode sound %d", pSource->m_Sound);
+				Sound()->UnloadSample(m_aSounds[pSource->m_Sound]);
+				m_aSounds[pSource->m_Sound] = -1;
+			}
+			else if(Sound()->IsSampleReady(m_aSounds[pSource->m_Sound]))
+			{
+				// need to enqueue, once the sample is decoded
 				int Flags = 0;
 				if(pSource->m_pSource->m_Loop)
 					Flags |= ISound::FLAG_LOOP;
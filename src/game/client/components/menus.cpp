@@ -96,6 +96,11 @@ CMenus::CMenus()
 	m_ServerProcess.Initialized = false;
 }
 
+CMenus::~CMenus()
+{
+	DemolistStopFetch(true);
+}
+
 float CMenus::ButtonColorMul(const void *pID)
 {
 	if(UI()->ActiveItem() == pID)
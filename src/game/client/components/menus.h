@@ -16,6 +16,8 @@
 #include <game/client/ui.h>
 #include <game/voting.h>
 
+#include <memory>
+
 struct CServerProcess
 {
 	PROCESS Process;
@@ -248,6 +250,8 @@ protected:
 
 		bool m_InfosLoaded;
 		bool m_Valid;
+		// the result of the background fetch for this demo, -1 if none
+		int m_FetchIndex;
 		CDemoHeader m_Info;
 		CTimelineMarkers m_TimelineMarkers;
 		CMapInfo m_MapInfo;
@@ -310,6 +314,15 @@ protected:
 	//void DemolistPopulate();
 	static int DemolistFetchCallback(const char *pName, time_t Date, int IsDir, int StorageType, void *pUser);
 
+	// the headers of the demo folder are fetched in the background and
+	// remembered in the demo index
+	std::shared_ptr<struct CDemolistFetch> m_pDemolistFetch;
+	std::vector<std::shared_ptr<IJob>> m_vpDemolistFetchJobs;
+	std::shared_ptr<class CDemoIndex> m_pDemoIndex;
+	// with Wait, returns once no job uses the storage or demo player anymore
+	void DemolistStopFetch(bool Wait = false);
+	void DemolistUpdateFetch();
+
 	// friends
 	struct CFriendItem
 	{
@@ -407,6 +420,7 @@ public:
 	static CMenusKeyBinder m_Binder;
 
 	CMenus();
+	~CMenus();
 
 	void RenderLoading();
 	void RenderUpdating(const char *pCaption, int current = 0, int total = 0);
@@ -7,8 +7,10 @@
 #include <base/math.h>
 
 #include <engine/demo.h>
+#include <engine/engine.h>
 #include <engine/graphics.h>
 #include <engine/keys.h>
+#include <engine/shared/demoindex.h>
 #include <engine/storage.h>
 #include <engine/textrender.h>
 
@@ -741,6 +743,76 @@ int CMenus::UiDoListboxEnd(float *pScrollValue, bool *pItemActivated, bool *pLis
 	return gs_ListBoxNewSelected;
 }
 
+static const char *DEMO_INDEX_FILE = "demos.index";
+
+enum
+{
+	// demos per job, so other jobs still get their turn on the pool
+	DEMOLIST_FETCH_CHUNK = 64,
+	// how often the list gets sorted while the headers come in
+	DEMOLIST_SORTS_PER_SECOND = 2,
+};
+
+struct CDemolistFetch
+{
+	struct CDemo
+	{
+		std::string m_Path;
+		int m_StorageType;
+		time_t m_Date;
+		CDemoIndex::CEntry m_Entry;
+	};
+
+	IStorage *m_pStorage;
+	IDemoPlayer *m_pDemoPlayer;
+	std::shared_ptr<CDemoIndex> m_pIndex;
+	std::vector<CDemo> m_vDemos;
+	std::unique_ptr<std::atomic<bool>[]> m_pDone;
+	std::atomic<int> m_NumDone;
+	std::atomic<bool> m_Abort;
+
+	// only used by the menu
+	int m_NumMerged;
+	int64 m_LastSort;
+};
+
+class CDemolistFetchJob : public IJob
+{
+	std::shared_ptr<CDemolistFetch> m_pFetch;
+	int m_First;
+	int m_Last;
+
+	void Run()
+	{
+		CDemolistFetch *pFetch = m_pFetch.get();
+		for(int i = m_First; i < m_Last && !pFetch->m_Abort; i++)
+		{
+			CDemolistFetch::CDemo *pDemo = &pFetch->m_vDemos[i];
+			IOHANDLE File = pFetch->m_pStorage->OpenFile(pDemo->m_Path.c_str(), IOFLAG_READ, pDemo->m_StorageType);
+			if(File)
+			{
+				// only read the demo if it changed since it was indexed
+				int64 Size = io_length(File);
+				io_close(File);
+				if(!pFetch->m_pIndex->Find(pDemo->m_Path.c_str(), pDemo->m_StorageType, Size, pDemo->m_Date, &pDemo->m_Entry))
+				{
+					CDemoIndex::CEntry *pEntry = &pDemo->m_Entry;
+					pEntry->m_Size = Size;
+					pEntry->m_Time = pDemo->m_Date;
+					pEntry->m_Valid = pFetch->m_pDemoPlayer->GetDemoInfo(pFetch->m_pStorage, pDemo->m_Path.c_str(), pDemo->m_StorageType, &pEntry->m_Header, &pEntry->m_TimelineMarkers, &pEntry->m_MapInfo);
+					pFetch->m_pIndex->Add(pDemo->m_Path.c_str(), pDemo->m_StorageType, *pEntry);
+				}
+			}
+			pFetch->m_pDone[i] = true;
+			pFetch->m_NumDone++;
+		}
+	}
+
+public:
+	CDemolistFetchJob(std::shared_ptr<CDemolistFetch> pFetch, int First, int Last) :
+		m_pFetch(std::move(pFetch)), m_First(First), m_Last(Last) {}
+};
+
 int CMenus::DemolistFetchCallback(const char *pName, time_t Date, int IsDir, int StorageType, void *pUser)
 {
 	CMenus *pSelf = (CMenus *)pUser;
@@ -763,6 +835,7 @@ int CMenus::DemolistFetchCallback(const char *pName, time_t Date, int IsDir, int
 		Item.m_InfosLoaded = false;
 		Item.m_Date = Date;
 	}
+	Item.m_FetchIndex = -1;
 	Item.m_IsDir = IsDir != 0;
 	Item.m_StorageType = StorageType;
 	pSelf->m_lDemos.add_unsorted(Item);
@@ -772,6 +845,7 @@ int CMenus::DemolistFetchCallback(const char *pName, time_t Date, int IsDir, int
 
 void CMenus::DemolistPopulate()
 {
+	DemolistStopFetch();
 	m_lDemos.clear();
 	if(!str_comp(m_aCurrentDemoFolder, "demos"))
 		m_DemolistStorageType = IStorage::TYPE_ALL;
@@ -826,11 +900,137 @@ bool CMenus::FetchHeader(CDemoItem &Item)
 
 void CMenus::FetchAllHeaders()
 {
+	DemolistStopFetch();
+	if(!m_pDemoIndex)
+	{
+		m_pDemoIndex = std::make_shared<CDemoIndex>();
+		IOHANDLE File = Storage()->OpenFile(DEMO_INDEX_FILE, IOFLAG_READ, IStorage::TYPE_SAVE);
+		if(File)
+		{
+			m_pDemoIndex->Load(File);
+			io_close(File);
+		}
+	}
+
+	// every demo of the folder is looked at, so deleted ones can be removed
+	// from the index afterwards
+	std::shared_ptr<CDemolistFetch> pFetch = std::make_shared<CDemolistFetch>();
+	pFetch->m_pStorage = Storage();
+	pFetch->m_pDemoPlayer = DemoPlayer();
+	pFetch->m_pIndex = m_pDemoIndex;
 	for(sorted_array<CDemoItem>::range r = m_lDemos.all(); !r.empty(); r.pop_front())
 	{
-		FetchHeader(r.front());
+		CDemoItem &Item = r.front();
+		if(Item.m_IsDir)
+			continue;
+		char aPath[MAX_PATH_LENGTH];
+		str_format(aPath, sizeof(aPath), "%s/%s", m_aCurrentDemoFolder, Item.m_aFilename);
+		CDemolistFetch::CDemo Demo;
+		Demo.m_Path = aPath;
+		Demo.m_StorageType = Item.m_StorageType;
+		Demo.m_Date = Item.m_Date;
+		mem_zero(&Demo.m_Entry, sizeof(Demo.m_Entry));
+		Item.m_FetchIndex = pFetch->m_vDemos.size();
+		pFetch->m_vDemos.push_back(Demo);
+	}
+	int NumDemos = pFetch->m_vDemos.size();
+	if(NumDemos == 0)
+		return;
+	pFetch->m_pDone.reset(new std::atomic<bool>[NumDemos]);
+	for(int i = 0; i < NumDemos; i++)
+		pFetch->m_pDone[i] = false;
+	pFetch->m_NumDone = 0;
+	pFetch->m_Abort = false;
+	pFetch->m_NumMerged = 0;
+	pFetch->m_LastSort = time_get();
+
+	std::vector<std::shared_ptr<IJob>> vpJobs;
+	for(int i = 0; i < NumDemos; i += DEMOLIST_FETCH_CHUNK)
+		vpJobs.push_back(std::make_shared<CDemolistFetchJob>(pFetch, i, minimum(i + (int)DEMOLIST_FETCH_CHUNK, NumDemos)));
+	m_pClient->Engine()->AddJobs(vpJobs);
+	m_pDemolistFetch = pFetch;
+	m_vpDemolistFetchJobs = vpJobs;
+}
+
+void CMenus::DemolistStopFetch(bool Wait)
+{
+	if(!m_pDemolistFetch)
+		return;
+	// jobs that already run finish their current demo, the others don't
+	// touch anything once they see the abort
+	m_pDemolistFetch->m_Abort = true;
+	if(Wait)
+	{
+		for(auto &pJob : m_vpDemolistFetchJobs)
+			while(pJob->Status() == IJob::STATE_RUNNING)
+				thread_yield();
+	}
+	m_vpDemolistFetchJobs.clear();
+	m_pDemolistFetch = nullptr;
+	for(sorted_array<CDemoItem>::range r = m_lDemos.all(); !r.empty(); r.pop_front())
+		r.front().m_FetchIndex = -1;
+}
+
+void CMenus::DemolistUpdateFetch()
+{
+	if(!m_pDemolistFetch)
+		return;
+	CDemolistFetch *pFetch = m_pDemolistFetch.get();
+	int NumDone = pFetch->m_NumDone;
+	if(NumDone == pFetch->m_NumMerged)
+		return;
+	pFetch->m_NumMerged = NumDone;
+
+	for(sorted_array<CDemoItem>::range r = m_lDemos.all(); !r.empty(); r.pop_front())
+	{
+		CDemoItem &Item = r.front();
+		if(Item.m_FetchIndex < 0 || !pFetch->m_pDone[Item.m_FetchIndex])
+			continue;
+		if(!Item.m_InfosLoaded)
+		{
+			const CDemoIndex::CEntry &Entry = pFetch->m_vDemos[Item.m_FetchIndex].m_Entry;
+			Item.m_Valid = Entry.m_Valid;
+			Item.m_Info = Entry.m_Header;
+			Item.m_TimelineMarkers = Entry.m_TimelineMarkers;
+			Item.m_MapInfo = Entry.m_MapInfo;
+			Item.m_InfosLoaded = true;
+		}
+		Item.m_FetchIndex = -1;
+	}
+
+	bool Finished = NumDone == (int)pFetch->m_vDemos.size();
+	if((g_Config.m_BrDemoSort == SORT_MARKERS || g_Config.m_BrDemoSort == SORT_LENGTH) &&
+		(Finished || time_get() - pFetch->m_LastSort > time_freq() / DEMOLIST_SORTS_PER_SECOND))
+	{
+		m_lDemos.sort_range();
+		DemolistOnUpdate(false);
+		pFetch->m_LastSort = time_get();
+	}
+	if(!Finished)
+		return;
+
+	std::vector<std::pair<std::string, int>> vDemos;
+	for(const CDemolistFetch::CDemo &Demo : pFetch->m_vDemos)
+		vDemos.emplace_back(Demo.m_Path, Demo.m_StorageType);
+	m_pDemoIndex->RemoveMissing(m_aCurrentDemoFolder, vDemos);
+	m_pDemolistFetch = nullptr;
+	if(!m_pDemoIndex->Modified())
+		return;
+
+	char aTmpFile[64];
+	str_format(aTmpFile, sizeof(aTmpFile), "%s.tmp", DEMO_INDEX_FILE);
+	IOHANDLE File = Storage()->OpenFile(aTmpFile, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	bool Saved = false;
+	if(File)
+	{
+		Saved = m_pDemoIndex->Save(File);
+		io_close(File);
+	}
+	if(!Saved || !Storage()->RenameFile(aTmpFile, DEMO_INDEX_FILE, IStorage::TYPE_SAVE))
+	{
+		Storage()->RemoveFile(aTmpFile, IStorage::TYPE_SAVE);
+		Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "demo", "failed to write the demo index");
 	}
-	m_lDemos.sort_range();
 }
 
 void CMenus::RenderDemoList(CUIRect MainView)
@@ -842,6 +1042,7 @@ void CMenus::RenderDemoList(CUIRect MainView)
 		DemolistOnUpdate(true);
 		s_Inited = 1;
 	}
+	DemolistUpdateFetch();
 
 	char aFooterLabel[128] = {0};
 	if(m_DemolistSelectedIndex >= 0)
@@ -1277,6 +1478,8 @@ void CMenus::RenderDemoList(CUIRect MainView)
 		g_Config.m_BrDemoFetchInfo ^= 1;
 		if(g_Config.m_BrDemoFetchInfo)
 			FetchAllHeaders();
+		else
+			DemolistStopFetch();
 	}
 
 	static int s_PlayButton = 0;
@@ -9,6 +9,8 @@
 #include <engine/engine.h>
 #include <engine/graphics.h>
 #include <engine/shared/config.h>
+#include <engine/shared/jobs.h>
+#include <engine/shared/skincache.h>
 #include <engine/storage.h>
 
 #include "skins.h"
@@ -30,9 +32,37 @@ static bool IsVanillaSkin(const char *pName)
 	return false;
 }
 
-int CSkins::SkinScan(const char *pName, int IsDir, int DirType, void *pUser)
+static const char *SKIN_CACHE_FILE = "skins.cache";
+
+// a skin decoded and prepared off the main thread or taken from the skin
+// cache, only the texture uploads are left to do
+struct CSkinImage
+{
+	char m_aName[24];
+	char m_aPath[MAX_PATH_LENGTH];
+	int m_DirType;
+	int64 m_FileSize;
+	int64 m_FileTime;
+
+	bool m_Success;
+	// the pixels belong to the skin cache then
+	bool m_Cached;
+	CImageInfo m_Info;
+	// the gray scale version
+	unsigned char *m_pColorData;
+	ColorRGBA m_BloodColor;
+	int64 m_Time;
+};
+
+struct CSkinScanInfo
 {
-	CSkins *pSelf = (CSkins *)pUser;
+	IStorage *m_pStorage;
+	std::vector<CSkinImage> m_vSkins;
+};
+
+int CSkins::SkinScan(const char *pName, time_t Date, int IsDir, int DirType, void *pUser)
+{
+	CSkinScanInfo *pInfo = (CSkinScanInfo *)pUser;
 
 	if(IsDir || !str_endswith(pName, ".png"))
 		return 0;
@@ -43,115 +73,99 @@ int CSkins::SkinScan(const char *pName, int IsDir, int DirType, void *pUser)
 
 	// Don't add duplicate skins (one from user's config directory, other from
 	// client itself)
-	for(int i = 0; i < pSelf->Num(); i++)
+	for(const CSkinImage &Skin : pInfo->m_vSkins)
 	{
-		const char *pExName = pSelf->Get(i)->m_aName;
-		if(str_comp(pExName, aNameWithoutPng) == 0)
+		if(str_comp(Skin.m_aName, aNameWithoutPng) == 0)
 			return 0;
 	}
 
-	char aBuf[MAX_PATH_LENGTH];
-	str_format(aBuf, sizeof(aBuf), "skins/%s", pName);
-	return pSelf->LoadSkin(aNameWithoutPng, aBuf, DirType);
+	CSkinImage Skin;
+	mem_zero(&Skin, sizeof(Skin));
+	str_copy(Skin.m_aName, aNameWithoutPng, sizeof(Skin.m_aName));
+	str_format(Skin.m_aPath, sizeof(Skin.m_aPath), "skins/%s", pName);
+	Skin.m_DirType = DirType;
+	Skin.m_FileTime = Date;
+	IOHANDLE File = pInfo->m_pStorage->OpenFile(Skin.m_aPath, IOFLAG_READ, DirType);
+	if(File)
+	{
+		Skin.m_FileSize = io_length(File);
+		io_close(File);
+	}
+	pInfo->m_vSkins.push_back(Skin);
+	return 0;
 }
 
-int CSkins::LoadSkin(const char *pName, const char *pPath, int DirType)
+// decodes the skin and creates its colorless version, safe to call from any
+// thread
+static void LoadSkinImage(IGraphics *pGraphics, CSkinImage *pSkin)
 {
-	char aBuf[512];
+	int64 StartTime = time_get_impl();
 	CImageInfo Info;
-	if(!Graphics()->LoadPNG(&Info, pPath, DirType))
-	{
-		str_format(aBuf, sizeof(aBuf), "failed to load skin from %s", pName);
-		Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "game", aBuf);
-		return 0;
-	}
-
-	CSkin Skin;
-	Skin.m_IsVanilla = IsVanillaSkin(pName);
-	Skin.m_OrgTexture = Graphics()->LoadTextureRaw(Info.m_Width, Info.m_Height, Info.m_Format, Info.m_pData, Info.m_Format, 0);
-
-	int BodySize = 96; // body size
-	if(BodySize > Info.m_Height)
-		return 0;
-	unsigned char *d = (unsigned char *)Info.m_pData;
-	int Pitch = Info.m_Width * 4;
+	pSkin->m_Success = false;
+	if(!pGraphics->LoadPNG(&Info, pSkin->m_aPath, pSkin->m_DirType))
+		return;
 
-	// dig out blood color
+	unsigned char *pColorData = (unsigned char *)malloc(CSkinCache::DataSize(Info.m_Width, Info.m_Height, Info.m_Format));
+	if(!CSkinCache::PrepareSkin(&Info, pColorData, &pSkin->m_BloodColor))
 	{
-		int aColors[3] = {0};
-		for(int y = 0; y < BodySize; y++)
-			for(int x = 0; x < BodySize; x++)
-			{
-				if(d[y * Pitch + x * 4 + 3] > 128)
-				{
-					aColors[0] += d[y * Pitch + x * 4 + 0];
-					aColors[1] += d[y * Pitch + x * 4 + 1];
-					aColors[2] += d[y * Pitch + x * 4 + 2];
-				}
-			}
-
-		Skin.m_BloodColor = ColorRGBA(normalize(vec3(aColors[0], aColors[1], aColors[2])));
+		free(Info.m_pData);
+		free(pColorData);
+		return;
 	}
+	pSkin->m_Info = Info;
+	pSkin->m_pColorData = pColorData;
+	pSkin->m_Success = true;
+	pSkin->m_Time = time_get_impl() - StartTime;
+}
 
-	// create colorless version
-	int Step = Info.m_Format == CImageInfo::FORMAT_RGBA ? 4 : 3;
-
-	// make the texture gray scale
-	for(int i = 0; i < Info.m_Width * Info.m_Height; i++)
+static void FreeSkinImage(CSkinImage *pSkin)
+{
+	if(pSkin->m_Success && !pSkin->m_Cached)
 	{
-		int v = (d[i * Step] + d[i * Step + 1] + d[i * Step + 2]) / 3;
-		d[i * Step] = v;
-		d[i * Step + 1] = v;
-		d[i * Step + 2] = v;
+		free(pSkin->m_Info.m_pData);
+		free(pSkin->m_pColorData);
 	}
+	pSkin->m_Info.m_pData = 0;
+	pSkin->m_pColorData = 0;
+}
 
-	int Freq[256] = {0};
-	int OrgWeight = 0;
-	int NewWeight = 192;
-
-	// find most common frequence
-	for(int y = 0; y < BodySize; y++)
-		for(int x = 0; x < BodySize; x++)
-		{
-			if(d[y * Pitch + x * 4 + 3] > 128)
-				Freq[d[y * Pitch + x * 4]]++;
-		}
-
-	for(int i = 1; i < 256; i++)
+void CSkins::AddSkin(CSkinImage *pSkin)
+{
+	char aBuf[512];
+	if(!pSkin->m_Success)
 	{
-		if(Freq[OrgWeight] < Freq[i])
-			OrgWeight = i;
+		str_format(aBuf, sizeof(aBuf), "failed to load skin from %s", pSkin->m_aName);
+		Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "game", aBuf);
+		return;
 	}
 
-	// reorder
-	int InvOrgWeight = 255 - OrgWeight;
-	int InvNewWeight = 255 - NewWeight;
-	for(int y = 0; y < BodySize; y++)
-		for(int x = 0; x < BodySize; x++)
-		{
-			int v = d[y * Pitch + x * 4];
-			if(v <= OrgWeight)
-				v = (int)(((v / (float)OrgWeight) * NewWeight));
-			else
-				v = (int)(((v - OrgWeight) / (float)InvOrgWeight) * InvNewWeight + NewWeight);
-			d[y * Pitch + x * 4] = v;
-			d[y * Pitch + x * 4 + 1] = v;
-			d[y * Pitch + x * 4 + 2] = v;
-		}
-
-	Skin.m_ColorTexture = Graphics()->LoadTextureRaw(Info.m_Width, Info.m_Height, Info.m_Format, Info.m_pData, Info.m_Format, 0);
-	free(Info.m_pData);
+	CImageInfo *pInfo = &pSkin->m_Info;
+	CSkin Skin;
+	Skin.m_IsVanilla = IsVanillaSkin(pSkin->m_aName);
+	Skin.m_OrgTexture = Graphics()->LoadTextureRaw(pInfo->m_Width, pInfo->m_Height, pInfo->m_Format, pInfo->m_pData, pInfo->m_Format, 0);
+	Skin.m_ColorTexture = Graphics()->LoadTextureRaw(pInfo->m_Width, pInfo->m_Height, pInfo->m_Format, pSkin->m_pColorData, pInfo->m_Format, 0);
+	Skin.m_BloodColor = pSkin->m_BloodColor;
 
 	// set skin data
-	str_copy(Skin.m_aName, pName, sizeof(Skin.m_aName));
+	str_copy(Skin.m_aName, pSkin->m_aName, sizeof(Skin.m_aName));
 	if(g_Config.m_Debug)
 	{
 		str_format(aBuf, sizeof(aBuf), "load skin %s", Skin.m_aName);
 		Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "game", aBuf);
 	}
 	m_aSkins.add(Skin);
+}
 
-	return 0;
+void CSkins::LoadSkin(const char *pName, const char *pPath, int DirType)
+{
+	CSkinImage Skin;
+	mem_zero(&Skin, sizeof(Skin));
+	str_copy(Skin.m_aName, pName, sizeof(Skin.m_aName));
+	str_copy(Skin.m_aPath, pPath, sizeof(Skin.m_aPath));
+	Skin.m_DirType = DirType;
+	LoadSkinImage(Graphics(), &Skin);
+	AddSkin(&Skin);
+	FreeSkinImage(&Skin);
 }
 
 void CSkins::OnInit()
@@ -187,7 +201,116 @@ void CSkins::Refresh()
 	}
 
 	m_aSkins.clear();
-	Storage()->ListDirectory(IStorage::TYPE_ALL, "skins", SkinScan, this);
+
+	int64 StartTime = time_get_impl();
+	CSkinScanInfo ScanInfo;
+	ScanInfo.m_pStorage = Storage();
+	Storage()->ListDirectoryInfo(IStorage::TYPE_ALL, "skins", SkinScan, &ScanInfo);
+	std::vector<CSkinImage> &vSkins = ScanInfo.m_vSkins;
+
+	// take the unchanged skins from the cache
+	CSkinCache Cache;
+	IOHANDLE File = Storage()->OpenFile(SKIN_CACHE_FILE, IOFLAG_READ, IStorage::TYPE_SAVE);
+	if(File)
+	{
+		Cache.Load(File);
+		io_close(File);
+	}
+	std::vector<int> vDecode;
+	for(int i = 0; i < (int)vSkins.size(); i++)
+	{
+		CSkinImage *pSkin = &vSkins[i];
+		const CSkinCache::CEntry *pEntry = Cache.Find(pSkin->m_aPath, pSkin->m_FileSize, pSkin->m_FileTime);
+		if(!pEntry)
+		{
+			vDecode.push_back(i);
+			continue;
+		}
+		// skins that failed to load before aren't tried again until they change
+		pSkin->m_Cached = true;
+		pSkin->m_Success = pEntry->m_pData != 0;
+		if(!pSkin->m_Success)
+			continue;
+		pSkin->m_Info.m_Width = pEntry->m_Width;
+		pSkin->m_Info.m_Height = pEntry->m_Height;
+		pSkin->m_Info.m_Format = pEntry->m_Format;
+		pSkin->m_Info.m_pData = (void *)pEntry->m_pData;
+		pSkin->m_pColorData = (unsigned char *)pEntry->m_pColorData;
+		pSkin->m_BloodColor = pEntry->m_BloodColor;
+	}
+	int64 ScanTime = time_get_impl() - StartTime;
+
+	// decode the rest on the job pool and here, upload in order as they get
+	// ready
+	IGraphics *pGraphics = Graphics();
+	CParallelWork Work(vDecode.size(), [&](int i) { LoadSkinImage(pGraphics, &vSkins[vDecode[i]]); });
+	m_pClient->Engine()->AddJobs(Work.HelperJobs(), CJobPool::PRIORITY_HIGH);
+	int NextDecode = 0;
+	int64 DecodeTime = 0;
+	int64 UploadTime = 0;
+	for(int i = 0; i < (int)vSkins.size(); i++)
+	{
+		if(!vSkins[i].m_Cached)
+		{
+			Work.Wait(NextDecode++);
+			DecodeTime += vSkins[i].m_Time;
+		}
+		int64 UploadStart = time_get_impl();
+		AddSkin(&vSkins[i]);
+		UploadTime += time_get_impl() - UploadStart;
+	}
+
+	// write a new cache if anything changed
+	int NumCached = vSkins.size() - vDecode.size();
+	if(!vDecode.empty() || Cache.Num() != NumCached)
+	{
+		std::vector<CSkinCache::CEntry> vEntries;
+		for(const CSkinImage &Skin : vSkins)
+		{
+			CSkinCache::CEntry Entry;
+			Entry.m_pPath = Skin.m_aPath;
+			Entry.m_Size = Skin.m_FileSize;
+			Entry.m_Time = Skin.m_FileTime;
+			if(!Skin.m_Success)
+			{
+				Entry.m_pData = 0;
+				Entry.m_pColorData = 0;
+				vEntries.push_back(Entry);
+				continue;
+			}
+			Entry.m_Width = Skin.m_Info.m_Width;
+			Entry.m_Height = Skin.m_Info.m_Height;
+			Entry.m_Format = Skin.m_Info.m_Format;
+			Entry.m_BloodColor = Skin.m_BloodColor;
+			Entry.m_pData = (const unsigned char *)Skin.m_Info.m_pData;
+			Entry.m_pColorData = Skin.m_pColorData;
+			vEntries.push_back(Entry);
+		}
+
+		char aTmpFile[64];
+		str_format(aTmpFile, sizeof(aTmpFile), "%s.tmp", SKIN_CACHE_FILE);
+		File = Storage()->OpenFile(aTmpFile, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+		bool Saved = false;
+		if(File)
+		{
+			Saved = CSkinCache::Save(File, vEntries);
+			io_close(File);
+		}
+		if(!Saved || !Storage()->RenameFile(aTmpFile, SKIN_CACHE_FILE, IStorage::TYPE_SAVE))
+		{
+			Storage()->RemoveFile(aTmpFile, IStorage::TYPE_SAVE);
+			Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "skins", "failed to write the skin cache");
+		}
+	}
+	for(CSkinImage &Skin : vSkins)
+		FreeSkinImage(&Skin);
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "loaded %d skins (%d cached) in %.2fms: scanning %.2fms, decoding %.2fms in total, uploading %.2fms",
+		m_aSkins.size(), NumCached, (time_get_impl() - StartTime) * 1000.0 / time_freq(), ScanTime * 1000.0 / time_freq(),
+		DecodeTime * 1000.0 / time_freq(), UploadTime * 1000.0 / time_freq());
+	Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "skins", aBuf);
+
 	if(!m_aSkins.size())
 	{
 		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "gameclient", "failed to load skins. folder='skins/'");
@@ -277,7 +400,7 @@ int CSkins::FindImpl(const char *pName)
 	str_format(aUrl, sizeof(aUrl), "%s%s.png", g_Config.m_ClSkinDownloadUrl, pName);
 	str_format(Skin.m_aPath, sizeof(Skin.m_aPath), "downloadedskins/%s.%d.tmp", pName, pid());
 	Skin.m_pTask = std::make_shared<CGetFile>(Storage(), aUrl, Skin.m_aPath, IStorage::TYPE_SAVE, CTimeout{0, 0, 0}, false);
-	m_pClient->Engine()->AddJob(Skin.m_pTask);
+	m_pClient->Engine()->AddJob(Skin.m_pTask, CJobPool::PRIORITY_HIGH);
 	m_aDownloadSkins.add(Skin);
 	return -1;
 }
@@ -49,8 +49,9 @@ private:
 	sorted_array<CDownloadSkin> m_aDownloadSkins;
 	char m_EventSkinPrefix[24];
 
-	int LoadSkin(const char *pName, const char *pPath, int DirType);
+	void AddSkin(struct CSkinImage *pSkin);
+	void LoadSkin(const char *pName, const char *pPath, int DirType);
 	int FindImpl(const char *pName);
-	static int SkinScan(const char *pName, int IsDir, int DirType, void *pUser);
+	static int SkinScan(const char *pName, time_t Date, int IsDir, int DirType, void *pUser);
 };
 #endif
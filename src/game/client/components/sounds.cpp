@@ -42,17 +42,27 @@ int CSounds::GetSampleId(int SetId)
 	if(!pSet->m_NumSounds)
 		return -1;
 
-	if(pSet->m_NumSounds == 1)
-		return pSet->m_aSounds[0].m_Id;
-
 	// return random one
-	int Id;
-	do
+	int Id = 0;
+	if(pSet->m_NumSounds > 1)
+	{
+		do
+		{
+			Id = rand() % pSet->m_NumSounds;
+		} while(Id == pSet->m_Last);
+		pSet->m_Last = Id;
+	}
+
+	// the sounds are decoded in the background, a broken one is only noticed
+	// once it's done
+	CDataSound *pSound = &pSet->m_aSounds[Id];
+	if(Sound()->IsSampleFailed(pSound->m_Id))
 	{
-		Id = rand() % pSet->m_NumSounds;
-	} while(Id == pSet->m_Last);
-	pSet->m_Last = Id;
-	return pSet->m_aSounds[Id].m_Id;
+		dbg_msg("sounds", "failed to decode sound. filename='%s'", pSound->m_pFilename);
+		Sound()->UnloadSample(pSound->m_Id);
+		pSound->m_Id = -1;
+	}
+	return pSound->m_Id;
 }
 
 void CSounds::OnInit()
@@ -75,7 +85,7 @@ void CSounds::OnInit()
 	if(g_Config.m_ClThreadsoundloading)
 	{
 		m_pSoundJob = std::make_shared<CSoundLoading>(m_pClient, false);
-		m_pClient->Engine()->AddJob(m_pSoundJob);
+		m_pClient->Engine()->AddJob(m_pSoundJob, CJobPool::PRIORITY_HIGH);
 		m_WaitForSoundJob = true;
 	}
 	else
@@ -12,6 +12,7 @@
 #include <engine/serverbrowser.h>
 #include <engine/shared/config.h>
 #include <engine/shared/demo.h>
+#include <engine/shared/profiler.h>
 #include <engine/sound.h>
 #include <engine/storage.h>
 #include <engine/textrender.h>
@@ -110,7 +111,22 @@ static CRaceDemo gs_RaceDemo;
 static CGhost gs_Ghost;
 
 CGameClient::CStack::CStack() { m_Num = 0; }
-void CGameClient::CStack::Add(class CComponent *pComponent) { m_paComponents[m_Num++] = pComponent; }
+void CGameClient::CStack::Add(class CComponent *pComponent, const char *pName)
+{
+	if(pName)
+	{
+		str_format(m_aaRenderZoneNames[m_Num], sizeof(m_aaRenderZoneNames[m_Num]), "render/%s", pName);
+		str_format(m_aaMessageZoneNames[m_Num], sizeof(m_aaMessageZoneNames[m_Num]), "message/%s", pName);
+		m_aRenderZones[m_Num] = g_Profiler.RegisterZone(m_aaRenderZoneNames[m_Num]);
+		m_aMessageZones[m_Num] = g_Profiler.RegisterZone(m_aaMessageZoneNames[m_Num]);
+	}
+	else
+	{
+		m_aRenderZones[m_Num] = -1;
+		m_aMessageZones[m_Num] = -1;
+	}
+	m_paComponents[m_Num++] = pComponent;
+}
 
 const char *CGameClient::Version() { return GAME_VERSION; }
 const char *CGameClient::NetVersion() { return GAME_NETVERSION; }
@@ -172,47 +188,47 @@ void CGameClient::OnConsoleInit()
 	gs_NamePlates.SetPlayers(m_pPlayers);
 
 	// make a list of all the systems, make sure to add them in the correct render order
-	m_All.Add(m_pSkins);
-	m_All.Add(m_pCountryFlags);
-	m_All.Add(m_pMapimages);
-	m_All.Add(m_pEffects); // doesn't render anything, just updates effects
-	m_All.Add(m_pParticles);
-	m_All.Add(m_pBinds);
-	m_All.Add(&m_pBinds->m_SpecialBinds);
-	m_All.Add(m_pControls);
-	m_All.Add(m_pCamera);
-	m_All.Add(m_pSounds);
-	m_All.Add(m_pVoting);
-	m_All.Add(m_pParticles); // doesn't render anything, just updates all the particles
-	m_All.Add(m_pRaceDemo);
-	m_All.Add(m_pMapSounds);
-
-	m_All.Add(&gs_BackGround); //render instead of gs_MapLayersBackGround when g_Config.m_ClOverlayEntities == 100
-	m_All.Add(&gs_MapLayersBackGround); // first to render
-	m_All.Add(&m_pParticles->m_RenderTrail);
-	m_All.Add(m_pItems);
-	m_All.Add(m_pPlayers);
-	m_All.Add(m_pGhost);
-	m_All.Add(&gs_MapLayersForeGround);
-	m_All.Add(&m_pParticles->m_RenderExplosions);
-	m_All.Add(&gs_NamePlates);
-	m_All.Add(&m_pParticles->m_RenderGeneral);
-	m_All.Add(m_pDamageind);
-	m_All.Add(&gs_Hud);
-	m_All.Add(&gs_Spectator);
-	m_All.Add(&gs_Emoticon);
-	m_All.Add(&gs_KillMessages);
-	m_All.Add(m_pChat);
-	m_All.Add(&gs_Broadcast);
-	m_All.Add(&gs_DebugHud);
-	m_All.Add(&gs_Scoreboard);
-	m_All.Add(&gs_Statboard);
-	m_All.Add(m_pMotd);
-	m_All.Add(m_pMenus);
-	m_All.Add(&m_pMenus->m_Binder);
-	m_All.Add(m_pGameConsole);
-
-	m_All.Add(m_pMenuBackground);
+	m_All.Add(m_pSkins, "skins");
+	m_All.Add(m_pCountryFlags, "countryflags");
+	m_All.Add(m_pMapimages, "mapimages");
+	m_All.Add(m_pEffects, "effects"); // doesn't render anything, just updates effects
+	m_All.Add(m_pParticles, "particles");
+	m_All.Add(m_pBinds, "binds");
+	m_All.Add(&m_pBinds->m_SpecialBinds, "specialbinds");
+	m_All.Add(m_pControls, "controls");
+	m_All.Add(m_pCamera, "camera");
+	m_All.Add(m_pSounds, "sounds");
+	m_All.Add(m_pVoting, "voting");
+	m_All.Add(m_pParticles, "particles"); // doesn't render anything, just updates all the particles
+	m_All.Add(m_pRaceDemo, "racedemo");
+	m_All.Add(m_pMapSounds, "mapsounds");
+
+	m_All.Add(&gs_BackGround, "background"); //render instead of gs_MapLayersBackGround when g_Config.m_ClOverlayEntities == 100
+	m_All.Add(&gs_MapLayersBackGround, "maplayers_background"); // first to render
+	m_All.Add(&m_pParticles->m_RenderTrail, "particles_trail");
+	m_All.Add(m_pItems, "items");
+	m_All.Add(m_pPlayers, "players");
+	m_All.Add(m_pGhost, "ghost");
+	m_All.Add(&gs_MapLayersForeGround, "maplayers_foreground");
+	m_All.Add(&m_pParticles->m_RenderExplosions, "particles_explosions");
+	m_All.Add(&gs_NamePlates, "nameplates");
+	m_All.Add(&m_pParticles->m_RenderGeneral, "particles_general");
+	m_All.Add(m_pDamageind, "damageind");
+	m_All.Add(&gs_Hud, "hud");
+	m_All.Add(&gs_Spectator, "spectator");
+	m_All.Add(&gs_Emoticon, "emoticon");
+	m_All.Add(&gs_KillMessages, "killmessages");
+	m_All.Add(m_pChat, "chat");
+	m_All.Add(&gs_Broadcast, "broadcast");
+	m_All.Add(&gs_DebugHud, "debughud");
+	m_All.Add(&gs_Scoreboard, "scoreboard");
+	m_All.Add(&gs_Statboard, "statboard");
+	m_All.Add(m_pMotd, "motd");
+	m_All.Add(m_pMenus, "menus");
+	m_All.Add(&m_pMenus->m_Binder, "binder");
+	m_All.Add(m_pGameConsole, "gameconsole");
+
+	m_All.Add(m_pMenuBackground, "menubackground");
 
 	// build the input stack
 	m_Input.Add(&m_pMenus->m_Binder); // this will take over all input when we want to bind a key
@@ -388,6 +404,9 @@ void CGameClient::OnInit()
 
 void CGameClient::OnUpdate()
 {
+	static int s_ProfileZone = g_Profiler.RegisterZone("gameclient/update");
+	CProfileScope Scope(s_ProfileZone);
+
 	// handle mouse movement
 	float x = 0.0f, y = 0.0f;
 	Input()->MouseRelative(&x, &y);
@@ -519,6 +538,7 @@ void CGameClient::OnConnected()
 	m_GameWorld.Clear();
 	m_GameWorld.m_WorldConfig.m_InfiniteAmmo = true;
 	m_PredictedDummyID = -1;
+	m_PredictionCached = false;
 	for(int i = 0; i < MAX_CLIENTS; i++)
 		m_aLastWorldCharacters[i].m_Alive = false;
 	LoadMapSettings();
@@ -531,6 +551,9 @@ void CGameClient::OnReset()
 {
 	m_LastNewPredictedTick[0] = -1;
 	m_LastNewPredictedTick[1] = -1;
+	m_PredictionCached = false;
+	for(auto &Input : m_aPredictedInputs)
+		Input.m_Tick = -1;
 
 	InvalidateSnapshot();
 
@@ -668,7 +691,10 @@ void CGameClient::OnRender()
 
 	// render all systems
 	for(int i = 0; i < m_All.m_Num; i++)
+	{
+		CProfileScope Scope(m_All.m_aRenderZones[i]);
 		m_All.m_paComponents[i]->OnRender();
+	}
 
 	// clear all events/input for this frame
 	Input()->Clear();
@@ -815,7 +841,10 @@ void CGameClient::OnMessage(int MsgId, CUnpacker *pUnpacker, bool IsDummy)
 
 	// TODO: this should be done smarter
 	for(int i = 0; i < m_All.m_Num; i++)
+	{
+		CProfileScope Scope(m_All.m_aMessageZones[i]);
 		m_All.m_paComponents[i]->OnMessage(MsgId, pRawMsg);
+	}
 
 	if(MsgId == NETMSGTYPE_SV_READYTOENTER)
 	{
@@ -887,6 +916,7 @@ void CGameClient::OnMessage(int MsgId, CUnpacker *pUnpacker, bool IsDummy)
 		{
 			m_CharOrder.GiveWeak(pMsg->m_Victim);
 			m_aLastWorldCharacters[pMsg->m_Victim].m_Alive = false;
+			m_PredictionCached = false;
 			if(CCharacter *pChar = m_GameWorld.GetCharacterByID(pMsg->m_Victim))
 				pChar->ResetPrediction();
 			m_GameWorld.ReleaseHooked(pMsg->m_Victim);
@@ -1150,6 +1180,9 @@ void CGameClient::InvalidateSnapshot()
 
 void CGameClient::OnNewSnapshot()
 {
+	static int s_ProfileZone = g_Profiler.RegisterZone("gameclient/snapshot");
+	CProfileScope Scope(s_ProfileZone);
+
 	InvalidateSnapshot();
 
 	m_NewTick = true;
@@ -1671,6 +1704,9 @@ void CGameClient::OnNewSnapshot()
 
 void CGameClient::OnPredict()
 {
+	static int s_ProfileZone = g_Profiler.RegisterZone("gameclient/predict");
+	CProfileScope Scope(s_ProfileZone);
+
 	// store the previous values so we can detect prediction errors
 	CCharacterCore BeforePrevChar = m_PredictedPrevChar;
 	CCharacterCore BeforeChar = m_PredictedChar;
@@ -1701,23 +1737,45 @@ void CGameClient::OnPredict()
 
 	// init
 	bool Dummy = g_Config.m_ClDummy ^ m_IsDummySwapping;
-	m_PredictedWorld.CopyWorld(&m_GameWorld);
+	int FirstTick = Client()->GameTick(g_Config.m_ClDummy) + 1;
+	if(CanContinuePrediction())
+	{
+		// only the ticks that weren't predicted yet are left
+		FirstTick = m_PredictedWorld.GameTick() + 1;
+	}
+	else
+	{
+		m_PredictionCached = false;
+		m_PredictedWorld.CopyWorld(&m_GameWorld);
 
-	// don't predict inactive players
-	for(int i = 0; i < MAX_CLIENTS; i++)
-		if(CCharacter *pChar = m_PredictedWorld.GetCharacterByID(i))
-			if(!m_Snap.m_aCharacters[i].m_Active && pChar->m_SnapTicks > 10)
-				pChar->Destroy();
+		// don't predict inactive players
+		for(int i = 0; i < MAX_CLIENTS; i++)
+			if(CCharacter *pChar = m_PredictedWorld.GetCharacterByID(i))
+				if(!m_Snap.m_aCharacters[i].m_Active && pChar->m_SnapTicks > 10)
+					pChar->Destroy();
+	}
 
 	CCharacter *pLocalChar = m_PredictedWorld.GetCharacterByID(m_Snap.m_LocalClientID);
 	if(!pLocalChar)
+	{
+		m_PredictionCached = false;
 		return;
+	}
 	CCharacter *pDummyChar = 0;
 	if(PredictDummy())
 		pDummyChar = m_PredictedWorld.GetCharacterByID(m_PredictedDummyID);
 
+	if(!m_PredictionCached)
+	{
+		m_PredictionCached = true;
+		m_PredictionBaseTick = Client()->GameTick(g_Config.m_ClDummy);
+		m_PredictionLocalID = m_Snap.m_LocalClientID;
+		m_PredictionDummyID = pDummyChar ? m_PredictedDummyID : -1;
+		m_PredictionDummy = Dummy;
+	}
+
 	// predict
-	for(int Tick = Client()->GameTick(g_Config.m_ClDummy) + 1; Tick <= Client()->PredGameTick(g_Config.m_ClDummy); Tick++)
+	for(int Tick = FirstTick; Tick <= Client()->PredGameTick(g_Config.m_ClDummy); Tick++)
 	{
 		// fetch the previous characters
 		if(Tick == Client()->PredGameTick(g_Config.m_ClDummy))
@@ -1737,6 +1795,7 @@ void CGameClient::OnPredict()
 		CNetObj_PlayerInput *pInputData = (CNetObj_PlayerInput *)Client()->GetDirectInput(Tick, m_IsDummySwapping);
 		CNetObj_PlayerInput *pDummyInputData = !pDummyChar ? 0 : (CNetObj_PlayerInput *)Client()->GetDirectInput(Tick, m_IsDummySwapping ^ 1);
 		bool DummyFirst = pInputData && pDummyInputData && pDummyChar->GetCID() < pLocalChar->GetCID();
+		StorePredictedInput(Tick, pInputData, pDummyInputData);
 
 		if(DummyFirst)
 			pDummyChar->OnDirectInput(pDummyInputData);
@@ -1789,6 +1848,12 @@ void CGameClient::OnPredict()
 		}
 	}
 
+	if(pDummyChar && !m_PredictedWorld.GetCharacterByID(m_PredictedDummyID))
+	{
+		// the dummy pointer used above isn't valid for continuing
+		m_PredictionCached = false;
+	}
+
 	// detect mispredictions of other players and make corrections smoother when possible
 	static vec2 s_aLastPos[MAX_CLIENTS] = {{0, 0}};
 	static bool s_aLastActive[MAX_CLIENTS] = {0};
@@ -1887,6 +1952,54 @@ void CGameClient::OnPredict()
 		m_pGhost->OnNewPredictedSnapshot();
 }
 
+bool CGameClient::CanContinuePrediction()
+{
+	// the game world mustn't have changed since it was copied
+	if(!m_PredictionCached || !m_PredictedWorld.m_IsValidCopy || m_PredictedWorld.m_pParent != &m_GameWorld || m_GameWorld.m_pChild != &m_PredictedWorld)
+		return false;
+	if(m_PredictionBaseTick != Client()->GameTick(g_Config.m_ClDummy) || m_PredictedWorld.GameTick() > Client()->PredGameTick(g_Config.m_ClDummy))
+		return false;
+	if(m_PredictionLocalID != m_Snap.m_LocalClientID || m_PredictionDummy != (g_Config.m_ClDummy ^ m_IsDummySwapping))
+		return false;
+	if(m_PredictionDummyID != -1 && (!PredictDummy() || m_PredictionDummyID != m_PredictedDummyID))
+		return false;
+	// moving in freeze depends on the last predicted tick
+	if(g_Config.m_ClPredictFreeze == 2)
+		return false;
+
+	// and the inputs of the predicted ticks must be the same
+	for(int Tick = m_PredictionBaseTick + 1; Tick <= m_PredictedWorld.GameTick(); Tick++)
+	{
+		const CPredictedInput &Used = m_aPredictedInputs[Tick % 200];
+		if(Used.m_Tick != Tick)
+			return false;
+		const int *apInput[2] = {
+			Client()->GetDirectInput(Tick, m_IsDummySwapping),
+			m_PredictionDummyID != -1 ? Client()->GetDirectInput(Tick, m_IsDummySwapping ^ 1) : 0};
+		for(int i = 0; i < 2; i++)
+		{
+			if((apInput[i] != 0) != Used.m_aHasInput[i])
+				return false;
+			if(apInput[i] && mem_comp(apInput[i], &Used.m_aInput[i], sizeof(Used.m_aInput[i])) != 0)
+				return false;
+		}
+	}
+	return true;
+}
+
+void CGameClient::StorePredictedInput(int Tick, const CNetObj_PlayerInput *pInput, const CNetObj_PlayerInput *pDummyInput)
+{
+	CPredictedInput &Used = m_aPredictedInputs[Tick % 200];
+	Used.m_Tick = Tick;
+	const CNetObj_PlayerInput *apInput[2] = {pInput, pDummyInput};
+	for(int i = 0; i < 2; i++)
+	{
+		Used.m_aHasInput[i] = apInput[i] != 0;
+		if(apInput[i])
+			Used.m_aInput[i] = *apInput[i];
+	}
+}
+
 void CGameClient::OnActivateEditor()
 {
 	OnRelease();
@@ -2175,6 +2288,8 @@ ColorRGBA CalculateNameColor(ColorHSLA TextColorHSL)
 
 void CGameClient::UpdatePrediction()
 {
+	m_PredictionCached = false;
+
 	if(!m_Snap.m_pLocalCharacter)
 	{
 		if(CCharacter *pLocalChar = m_GameWorld.GetCharacterByID(m_Snap.m_LocalClientID))
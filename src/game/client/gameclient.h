@@ -67,10 +67,16 @@ class CGameClient : public IGameClient
 		};
 
 		CStack();
-		void Add(class CComponent *pComponent);
+		void Add(class CComponent *pComponent, const char *pName = 0);
 
 		class CComponent *m_paComponents[MAX_COMPONENTS];
 		int m_Num;
+
+		// profiler zones of the callbacks, only for named components
+		char m_aaRenderZoneNames[MAX_COMPONENTS][32];
+		char m_aaMessageZoneNames[MAX_COMPONENTS][32];
+		int m_aRenderZones[MAX_COMPONENTS];
+		int m_aMessageZones[MAX_COMPONENTS];
 	};
 
 	CStack m_All;
@@ -467,6 +473,23 @@ private:
 
 	int m_PredictedDummyID;
 	int m_IsDummySwapping;
+
+	// the predicted world is continued from the previous prediction as long
+	// as the game world and the inputs it was predicted with stay the same
+	struct CPredictedInput
+	{
+		int m_Tick;
+		bool m_aHasInput[2];
+		CNetObj_PlayerInput m_aInput[2];
+	};
+	CPredictedInput m_aPredictedInputs[200];
+	bool m_PredictionCached;
+	int m_PredictionBaseTick;
+	int m_PredictionLocalID;
+	int m_PredictionDummyID;
+	int m_PredictionDummy;
+	bool CanContinuePrediction();
+	void StorePredictedInput(int Tick, const CNetObj_PlayerInput *pInput, const CNetObj_PlayerInput *pDummyInput);
 	CCharOrder m_CharOrder;
 	class CCharacter m_aLastWorldCharacters[MAX_CLIENTS];
 
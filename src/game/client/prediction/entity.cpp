@@ -3,6 +3,98 @@
 
 #include "entity.h"
 
+//////////////////////////////////////////////////
+// Entity pool
+//////////////////////////////////////////////////
+class CEntityPool
+{
+	enum
+	{
+		MAX_SIZES = 16,
+		SLAB_ENTITIES = 64,
+		ALIGNMENT = 16,
+	};
+
+	struct CFreeEntity
+	{
+		CFreeEntity *m_pNext;
+	};
+
+	struct CSizeClass
+	{
+		size_t m_Size;
+		CFreeEntity *m_pFirstFree;
+	};
+
+	CSizeClass m_aSizes[MAX_SIZES];
+	int m_NumSizes;
+
+	CSizeClass *Find(size_t Size)
+	{
+		for(int i = 0; i < m_NumSizes; i++)
+			if(m_aSizes[i].m_Size == Size)
+				return &m_aSizes[i];
+		if(m_NumSizes == MAX_SIZES)
+			return 0;
+		m_aSizes[m_NumSizes].m_Size = Size;
+		m_aSizes[m_NumSizes].m_pFirstFree = 0;
+		return &m_aSizes[m_NumSizes++];
+	}
+
+public:
+	// the slabs are never freed, the free lists only grow to the largest
+	// number of entities alive at once
+	void *Allocate(size_t Size)
+	{
+		CSizeClass *pClass = Find(Size);
+		if(!pClass)
+			return malloc(Size);
+		if(!pClass->m_pFirstFree)
+		{
+			size_t Stride = (Size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+			char *pSlab = (char *)malloc(Stride * SLAB_ENTITIES);
+			for(int i = SLAB_ENTITIES - 1; i >= 0; i--)
+			{
+				CFreeEntity *pFree = (CFreeEntity *)(pSlab + i * Stride);
+				pFree->m_pNext = pClass->m_pFirstFree;
+				pClass->m_pFirstFree = pFree;
+			}
+		}
+		CFreeEntity *pFree = pClass->m_pFirstFree;
+		pClass->m_pFirstFree = pFree->m_pNext;
+		return pFree;
+	}
+
+	void Free(void *pPtr, size_t Size)
+	{
+		CSizeClass *pClass = Find(Size);
+		if(!pClass)
+		{
+			free(pPtr);
+			return;
+		}
+		CFreeEntity *pFree = (CFreeEntity *)pPtr;
+		pFree->m_pNext = pClass->m_pFirstFree;
+		pClass->m_pFirstFree = pFree;
+	}
+};
+
+// zero-initialized and trivially destructible, usable before and after static construction
+static CEntityPool s_EntityPool;
+
+void *CEntity::operator new(size_t Size)
+{
+	void *p = s_EntityPool.Allocate(Size);
+	mem_zero(p, Size);
+	return p;
+}
+
+void CEntity::operator delete(void *pPtr, size_t Size)
+{
+	if(pPtr)
+		s_EntityPool.Free(pPtr, Size);
+}
+
 //////////////////////////////////////////////////
 // Entity
 //////////////////////////////////////////////////
@@ -7,26 +7,15 @@
 #include <base/vmath.h>
 #include <new>
 
-#define MACRO_ALLOC_HEAP() \
-public: \
-	void *operator new(size_t Size) \
-	{ \
-		void *p = malloc(Size); \
-		/*dbg_msg("", "++ %p %d", p, size);*/ \
-		mem_zero(p, Size); \
-		return p; \
-	} \
-	void operator delete(void *pPtr) \
-	{ \
-		/*dbg_msg("", "-- %p", p);*/ \
-		free(pPtr); \
-	} \
-\
-private:
-
 class CEntity
 {
-	MACRO_ALLOC_HEAP()
+public:
+	// the prediction worlds are copied every frame, so entity memory is
+	// recycled through free lists instead of going to the heap each time
+	void *operator new(size_t Size);
+	void operator delete(void *pPtr, size_t Size);
+
+private:
 	friend class CGameWorld; // entity list handling
 	CEntity *m_pPrevTypeEntity;
 	CEntity *m_pNextTypeEntity;
@@ -505,6 +505,15 @@ void CGameWorld::NetObjEnd(int LocalID)
 	}
 }
 
+template<class T>
+static CEntity *CopyEntity(CEntity *pReuse, CEntity *pFrom)
+{
+	if(!pReuse)
+		return new T(*((T *)pFrom));
+	*((T *)pReuse) = *((T *)pFrom);
+	return pReuse;
+}
+
 void CGameWorld::CopyWorld(CGameWorld *pFrom)
 {
 	if(pFrom == this || !pFrom)
@@ -526,10 +535,14 @@ void CGameWorld::CopyWorld(CGameWorld *pFrom)
 	}
 	m_pTuningList = pFrom->m_pTuningList;
 	m_Teams = pFrom->m_Teams;
-	// delete the previous entities
+	// keep the previous entities to copy into, so copying a world of the
+	// same shape doesn't allocate or construct anything
+	CEntity *apReuse[NUM_ENTTYPES];
 	for(int i = 0; i < NUM_ENTTYPES; i++)
-		while(m_apFirstEntityTypes[i])
-			delete m_apFirstEntityTypes[i];
+	{
+		apReuse[i] = m_apFirstEntityTypes[i];
+		m_apFirstEntityTypes[i] = 0;
+	}
 	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
 		m_apCharacters[i] = 0;
@@ -540,15 +553,20 @@ void CGameWorld::CopyWorld(CGameWorld *pFrom)
 	{
 		for(CEntity *pEnt = pFrom->FindLast(Type); pEnt; pEnt = pEnt->TypePrev())
 		{
+			CEntity *pReuse = apReuse[Type];
+			if(pReuse)
+				apReuse[Type] = pReuse->m_pNextTypeEntity;
 			CEntity *pCopy = 0;
 			if(Type == ENTTYPE_PROJECTILE)
-				pCopy = new CProjectile(*((CProjectile *)pEnt));
+				pCopy = CopyEntity<CProjectile>(pReuse, pEnt);
 			else if(Type == ENTTYPE_LASER)
-				pCopy = new CLaser(*((CLaser *)pEnt));
+				pCopy = CopyEntity<CLaser>(pReuse, pEnt);
 			else if(Type == ENTTYPE_CHARACTER)
-				pCopy = new CCharacter(*((CCharacter *)pEnt));
+				pCopy = CopyEntity<CCharacter>(pReuse, pEnt);
 			else if(Type == ENTTYPE_PICKUP)
-				pCopy = new CPickup(*((CPickup *)pEnt));
+				pCopy = CopyEntity<CPickup>(pReuse, pEnt);
+			else if(pReuse)
+				apReuse[Type] = pReuse;
 			if(pCopy)
 			{
 				pCopy->m_pParent = pEnt;
@@ -556,6 +574,16 @@ void CGameWorld::CopyWorld(CGameWorld *pFrom)
 			}
 		}
 	}
+	// delete the previous entities that weren't needed
+	for(int i = 0; i < NUM_ENTTYPES; i++)
+		while(apReuse[i])
+		{
+			CEntity *pEnt = apReuse[i];
+			apReuse[i] = pEnt->m_pNextTypeEntity;
+			pEnt->m_pPrevTypeEntity = 0;
+			pEnt->m_pNextTypeEntity = 0;
+			delete pEnt;
+		}
 	m_IsValidCopy = true;
 }
 
@@ -1,12 +1,17 @@
 #include <inttypes.h>
 #include <stdio.h> // sscanf
 
+#include <base/math.h>
+#include <base/system.h>
+
 #include <engine/console.h>
+#include <engine/shared/jobs.h>
 #include <engine/shared/linereader.h>
 #include <engine/storage.h>
 
+#include <game/mapitems.h>
+
 #include "auto_map.h"
-#include "editor.h"
 
 // Based on triple32inc from https://github.com/skeeto/hash-prospector/tree/79a6074062a84907df6e45b756134b74e2956760
 static uint32_t HashUInt32(uint32_t Num)
@@ -37,9 +42,11 @@ static int HashLocation(uint32_t Seed, uint32_t Run, uint32_t Rule, uint32_t X,
 	return Hash % HASH_MAX;
 }
 
-CAutoMapper::CAutoMapper(CEditor *pEditor)
+CAutoMapper::CAutoMapper(IStorage *pStorage, IConsole *pConsole, CJobPool *pJobPool)
 {
-	m_pEditor = pEditor;
+	m_pStorage = pStorage;
+	m_pConsole = pConsole;
+	m_pJobPool = pJobPool;
 	m_FileLoaded = false;
 }
 
@@ -47,7 +54,7 @@ void CAutoMapper::Load(const char *pTileName)
 {
 	char aPath[256];
 	str_format(aPath, sizeof(aPath), "editor/%s.rules", pTileName);
-	IOHANDLE RulesFile = m_pEditor->Storage()->OpenFile(aPath, IOFLAG_READ, IStorage::TYPE_ALL);
+	IOHANDLE RulesFile = m_pStorage->OpenFile(aPath, IOFLAG_READ, IStorage::TYPE_ALL);
 	if(!RulesFile)
 		return;
 
@@ -76,23 +83,23 @@ void CAutoMapper::Load(const char *pTileName)
 				NewConf.m_StartY = 0;
 				NewConf.m_EndX = 0;
 				NewConf.m_EndY = 0;
-				int ConfigurationID = m_lConfigs.add(NewConf);
-				pCurrentConf = &m_lConfigs[ConfigurationID];
+				m_vConfigs.push_back(NewConf);
+				pCurrentConf = &m_vConfigs.back();
 				str_copy(pCurrentConf->m_aName, pLine, str_length(pLine));
 
 				// add start run
 				CRun NewRun;
 				NewRun.m_AutomapCopy = true;
-				int RunID = pCurrentConf->m_aRuns.add(NewRun);
-				pCurrentRun = &pCurrentConf->m_aRuns[RunID];
+				pCurrentConf->m_vRuns.push_back(NewRun);
+				pCurrentRun = &pCurrentConf->m_vRuns.back();
 			}
 			else if(str_startswith(pLine, "NewRun"))
 			{
 				// add new run
 				CRun NewRun;
 				NewRun.m_AutomapCopy = true;
-				int RunID = pCurrentConf->m_aRuns.add(NewRun);
-				pCurrentRun = &pCurrentConf->m_aRuns[RunID];
+				pCurrentConf->m_vRuns.push_back(NewRun);
+				pCurrentRun = &pCurrentConf->m_vRuns.back();
 			}
 			else if(str_startswith(pLine, "Index") && pCurrentRun)
 			{
@@ -143,15 +150,15 @@ void CAutoMapper::Load(const char *pTileName)
 				}
 
 				// add the index rule object and make it current
-				int IndexRuleID = pCurrentRun->m_aIndexRules.add(NewIndexRule);
-				pCurrentIndex = &pCurrentRun->m_aIndexRules[IndexRuleID];
+				pCurrentRun->m_vIndexRules.push_back(NewIndexRule);
+				pCurrentIndex = &pCurrentRun->m_vIndexRules.back();
 			}
 			else if(str_startswith(pLine, "Pos") && pCurrentIndex)
 			{
 				int x = 0, y = 0;
 				char aValue[128];
 				int Value = CPosRule::NORULE;
-				array<CIndexInfo> NewIndexList;
+				std::vector<CIndexInfo> vNewIndexList;
 
 				sscanf(pLine, "Pos %d %d %127s", &x, &y, aValue);
 
@@ -159,15 +166,15 @@ void CAutoMapper::Load(const char *pTileName)
 				{
 					Value = CPosRule::INDEX;
 					CIndexInfo NewIndexInfo = {0, 0, false};
-					NewIndexList.add(NewIndexInfo);
+					vNewIndexList.push_back(NewIndexInfo);
 				}
 				else if(!str_comp(aValue, "FULL"))
 				{
 					Value = CPosRule::NOTINDEX;
 					CIndexInfo NewIndexInfo1 = {0, 0, false};
 					//CIndexInfo NewIndexInfo2 = {-1, 0};
-					NewIndexList.add(NewIndexInfo1);
-					//NewIndexList.add(NewIndexInfo2);
+					vNewIndexList.push_back(NewIndexInfo1);
+					//vNewIndexList.push_back(NewIndexInfo2);
 				}
 				else if(!str_comp(aValue, "INDEX") || !str_comp(aValue, "NOTINDEX"))
 				{
@@ -193,7 +200,7 @@ void CAutoMapper::Load(const char *pTileName)
 
 						if(!str_comp(aOrientation1, "OR"))
 						{
-							NewIndexList.add(NewIndexInfo);
+							vNewIndexList.push_back(NewIndexInfo);
 							pWord += 2;
 							continue;
 						}
@@ -213,13 +220,13 @@ void CAutoMapper::Load(const char *pTileName)
 						}
 						else
 						{
-							NewIndexList.add(NewIndexInfo);
+							vNewIndexList.push_back(NewIndexInfo);
 							break;
 						}
 
 						if(!str_comp(aOrientation2, "OR"))
 						{
-							NewIndexList.add(NewIndexInfo);
+							vNewIndexList.push_back(NewIndexInfo);
 							pWord += 3;
 							continue;
 						}
@@ -234,13 +241,13 @@ void CAutoMapper::Load(const char *pTileName)
 						}
 						else
 						{
-							NewIndexList.add(NewIndexInfo);
+							vNewIndexList.push_back(NewIndexInfo);
 							break;
 						}
 
 						if(!str_comp(aOrientation3, "OR"))
 						{
-							NewIndexList.add(NewIndexInfo);
+							vNewIndexList.push_back(NewIndexInfo);
 							pWord += 4;
 							continue;
 						}
@@ -255,19 +262,19 @@ void CAutoMapper::Load(const char *pTileName)
 						}
 						else
 						{
-							NewIndexList.add(NewIndexInfo);
+							vNewIndexList.push_back(NewIndexInfo);
 							break;
 						}
 
 						if(!str_comp(aOrientation4, "OR"))
 						{
-							NewIndexList.add(NewIndexInfo);
+							vNewIndexList.push_back(NewIndexInfo);
 							pWord += 5;
 							continue;
 						}
 						else
 						{
-							NewIndexList.add(NewIndexInfo);
+							vNewIndexList.push_back(NewIndexInfo);
 							break;
 						}
 					}
@@ -275,8 +282,8 @@ void CAutoMapper::Load(const char *pTileName)
 
 				if(Value != CPosRule::NORULE)
 				{
-					CPosRule NewPosRule = {x, y, Value, NewIndexList};
-					pCurrentIndex->m_aRules.add(NewPosRule);
+					CPosRule NewPosRule = {x, y, Value, vNewIndexList};
+					pCurrentIndex->m_vRules.push_back(NewPosRule);
 
 					pCurrentConf->m_StartX = minimum(pCurrentConf->m_StartX, NewPosRule.m_X);
 					pCurrentConf->m_StartY = minimum(pCurrentConf->m_StartY, NewPosRule.m_Y);
@@ -285,9 +292,9 @@ void CAutoMapper::Load(const char *pTileName)
 
 					if(x == 0 && y == 0)
 					{
-						for(int i = 0; i < NewIndexList.size(); ++i)
+						for(int i = 0; i < (int)vNewIndexList.size(); ++i)
 						{
-							if(Value == CPosRule::INDEX && NewIndexList[i].m_ID == 0)
+							if(Value == CPosRule::INDEX && vNewIndexList[i].m_ID == 0)
 								pCurrentIndex->m_SkipFull = true;
 							else
 								pCurrentIndex->m_SkipEmpty = true;
@@ -321,17 +328,17 @@ void CAutoMapper::Load(const char *pTileName)
 	}
 
 	// add default rule for Pos 0 0 if there is none
-	for(int g = 0; g < m_lConfigs.size(); ++g)
+	for(int g = 0; g < (int)m_vConfigs.size(); ++g)
 	{
-		for(int h = 0; h < m_lConfigs[g].m_aRuns.size(); ++h)
+		for(int h = 0; h < (int)m_vConfigs[g].m_vRuns.size(); ++h)
 		{
-			for(int i = 0; i < m_lConfigs[g].m_aRuns[h].m_aIndexRules.size(); ++i)
+			for(int i = 0; i < (int)m_vConfigs[g].m_vRuns[h].m_vIndexRules.size(); ++i)
 			{
-				CIndexRule *pIndexRule = &m_lConfigs[g].m_aRuns[h].m_aIndexRules[i];
+				CIndexRule *pIndexRule = &m_vConfigs[g].m_vRuns[h].m_vIndexRules[i];
 				bool Found = false;
-				for(int j = 0; j < pIndexRule->m_aRules.size(); ++j)
+				for(int j = 0; j < (int)pIndexRule->m_vRules.size(); ++j)
 				{
-					CPosRule *pRule = &pIndexRule->m_aRules[j];
+					CPosRule *pRule = &pIndexRule->m_vRules[j];
 					if(pRule && pRule->m_X == 0 && pRule->m_Y == 0)
 					{
 						Found = true;
@@ -340,11 +347,11 @@ void CAutoMapper::Load(const char *pTileName)
 				}
 				if(!Found && pIndexRule->m_DefaultRule)
 				{
-					array<CIndexInfo> NewIndexList;
+					std::vector<CIndexInfo> vNewIndexList;
 					CIndexInfo NewIndexInfo = {0, 0, false};
-					NewIndexList.add(NewIndexInfo);
-					CPosRule NewPosRule = {0, 0, CPosRule::NOTINDEX, NewIndexList};
-					pIndexRule->m_aRules.add(NewPosRule);
+					vNewIndexList.push_back(NewIndexInfo);
+					CPosRule NewPosRule = {0, 0, CPosRule::NOTINDEX, vNewIndexList};
+					pIndexRule->m_vRules.push_back(NewPosRule);
 
 					pIndexRule->m_SkipEmpty = true;
 					pIndexRule->m_SkipFull = false;
@@ -355,193 +362,219 @@ void CAutoMapper::Load(const char *pTileName)
 					pIndexRule->m_SkipFull = false;
 				}
 			}
+			Compile(&m_vConfigs[g].m_vRuns[h]);
 		}
 	}
 
 	io_close(RulesFile);
 
 	str_format(aBuf, sizeof(aBuf), "loaded %s", aPath);
-	m_pEditor->Console()->Print(IConsole::OUTPUT_LEVEL_DEBUG, "editor", aBuf);
+	m_pConsole->Print(IConsole::OUTPUT_LEVEL_DEBUG, "editor", aBuf);
 
 	m_FileLoaded = true;
 }
 
 const char *CAutoMapper::GetConfigName(int Index)
 {
-	if(Index < 0 || Index >= m_lConfigs.size())
+	if(Index < 0 || Index >= (int)m_vConfigs.size())
 		return "";
 
-	return m_lConfigs[Index].m_aName;
+	return m_vConfigs[Index].m_aName;
+}
+
+void CAutoMapper::Compile(CRun *pRun)
+{
+	pRun->m_vCompiledRules.clear();
+	pRun->m_vCompiledPosRules.clear();
+	pRun->m_vCompiledIndices.clear();
+	for(int i = 0; i < (int)pRun->m_vIndexRules.size(); ++i)
+	{
+		const CIndexRule *pIndexRule = &pRun->m_vIndexRules[i];
+		CCompiledIndexRule Rule;
+		Rule.m_ID = pIndexRule->m_ID;
+		Rule.m_Flag = pIndexRule->m_Flag;
+		Rule.m_RandomProbability = pIndexRule->m_RandomProbability;
+		Rule.m_SkipEmpty = pIndexRule->m_SkipEmpty;
+		Rule.m_SkipFull = pIndexRule->m_SkipFull;
+		Rule.m_FirstPosRule = pRun->m_vCompiledPosRules.size();
+		Rule.m_NumPosRules = pIndexRule->m_vRules.size();
+		pRun->m_vCompiledRules.push_back(Rule);
+
+		for(int j = 0; j < (int)pIndexRule->m_vRules.size(); ++j)
+		{
+			const CPosRule *pRule = &pIndexRule->m_vRules[j];
+			CCompiledPosRule PosRule;
+			PosRule.m_X = pRule->m_X;
+			PosRule.m_Y = pRule->m_Y;
+			PosRule.m_Value = pRule->m_Value;
+			PosRule.m_FirstIndex = pRun->m_vCompiledIndices.size();
+			PosRule.m_NumIndices = pRule->m_vIndexList.size();
+			pRun->m_vCompiledPosRules.push_back(PosRule);
+			for(int k = 0; k < (int)pRule->m_vIndexList.size(); ++k)
+				pRun->m_vCompiledIndices.push_back(pRule->m_vIndexList[k]);
+		}
+	}
 }
 
-void CAutoMapper::ProceedLocalized(CLayerTiles *pLayer, int ConfigID, int Seed, int X, int Y, int Width, int Height)
+void CAutoMapper::ProceedLocalized(CTile *pTiles, int LayerWidth, int LayerHeight, int ConfigID, int Seed, int X, int Y, int Width, int Height)
 {
-	if(!m_FileLoaded || pLayer->m_Readonly || ConfigID < 0 || ConfigID >= m_lConfigs.size())
+	if(!m_FileLoaded || ConfigID < 0 || ConfigID >= (int)m_vConfigs.size())
 		return;
 
 	if(Width < 0)
-		Width = pLayer->m_Width;
+		Width = LayerWidth;
 
 	if(Height < 0)
-		Height = pLayer->m_Height;
+		Height = LayerHeight;
 
-	CConfiguration *pConf = &m_lConfigs[ConfigID];
+	CConfiguration *pConf = &m_vConfigs[ConfigID];
 
-	int CommitFromX = clamp(X + pConf->m_StartX, 0, pLayer->m_Width);
-	int CommitFromY = clamp(Y + pConf->m_StartY, 0, pLayer->m_Height);
-	int CommitToX = clamp(X + Width + pConf->m_EndX, 0, pLayer->m_Width);
-	int CommitToY = clamp(Y + Height + pConf->m_EndY, 0, pLayer->m_Height);
+	int CommitFromX = clamp(X + pConf->m_StartX, 0, LayerWidth);
+	int CommitFromY = clamp(Y + pConf->m_StartY, 0, LayerHeight);
+	int CommitToX = clamp(X + Width + pConf->m_EndX, 0, LayerWidth);
+	int CommitToY = clamp(Y + Height + pConf->m_EndY, 0, LayerHeight);
 
-	int UpdateFromX = clamp(X + 3 * pConf->m_StartX, 0, pLayer->m_Width);
-	int UpdateFromY = clamp(Y + 3 * pConf->m_StartY, 0, pLayer->m_Height);
-	int UpdateToX = clamp(X + Width + 3 * pConf->m_EndX, 0, pLayer->m_Width);
-	int UpdateToY = clamp(Y + Height + 3 * pConf->m_EndY, 0, pLayer->m_Height);
+	int UpdateFromX = clamp(X + 3 * pConf->m_StartX, 0, LayerWidth);
+	int UpdateFromY = clamp(Y + 3 * pConf->m_StartY, 0, LayerHeight);
+	int UpdateToX = clamp(X + Width + 3 * pConf->m_EndX, 0, LayerWidth);
+	int UpdateToY = clamp(Y + Height + 3 * pConf->m_EndY, 0, LayerHeight);
 
-	CLayerTiles *pUpdateLayer;
-	if(UpdateFromX != 0 || UpdateFromY != 0 || UpdateToX != pLayer->m_Width || UpdateToY != pLayer->m_Width)
+	CTile *pUpdateTiles;
+	int UpdateWidth = UpdateToX - UpdateFromX;
+	int UpdateHeight = UpdateToY - UpdateFromY;
+	std::vector<CTile> vUpdateTiles;
+	if(UpdateFromX != 0 || UpdateFromY != 0 || UpdateToX != LayerWidth || UpdateToY != LayerWidth)
 	{ // Needs a layer to work on
-		pUpdateLayer = new CLayerTiles(UpdateToX - UpdateFromX, UpdateToY - UpdateFromY);
+		vUpdateTiles.resize(UpdateWidth * UpdateHeight);
+		pUpdateTiles = vUpdateTiles.data();
 
 		for(int y = UpdateFromY; y < UpdateToY; y++)
-		{
-			for(int x = UpdateFromX; x < UpdateToX; x++)
-			{
-				CTile *in = &pLayer->m_pTiles[y * pLayer->m_Width + x];
-				CTile *out = &pUpdateLayer->m_pTiles[(y - UpdateFromY) * pUpdateLayer->m_Width + x - UpdateFromX];
-				out->m_Index = in->m_Index;
-				out->m_Flags = in->m_Flags;
-			}
-		}
+			mem_copy(&pUpdateTiles[(y - UpdateFromY) * UpdateWidth], &pTiles[y * LayerWidth + UpdateFromX], UpdateWidth * sizeof(CTile));
 	}
 	else
 	{
-		pUpdateLayer = pLayer;
+		pUpdateTiles = pTiles;
+		UpdateHeight = LayerHeight;
 	}
 
-	Proceed(pUpdateLayer, ConfigID, Seed, UpdateFromX, UpdateFromY);
+	Proceed(pUpdateTiles, UpdateWidth, UpdateHeight, ConfigID, Seed, UpdateFromX, UpdateFromY);
 
 	for(int y = CommitFromY; y < CommitToY; y++)
 	{
 		for(int x = CommitFromX; x < CommitToX; x++)
 		{
-			CTile *in = &pUpdateLayer->m_pTiles[(y - UpdateFromY) * pUpdateLayer->m_Width + x - UpdateFromX];
-			CTile *out = &pLayer->m_pTiles[y * pLayer->m_Width + x];
+			CTile *in = &pUpdateTiles[(y - UpdateFromY) * UpdateWidth + x - UpdateFromX];
+			CTile *out = &pTiles[y * LayerWidth + x];
 			out->m_Index = in->m_Index;
 			out->m_Flags = in->m_Flags;
 		}
 	}
 }
 
-void CAutoMapper::Proceed(CLayerTiles *pLayer, int ConfigID, int Seed, int SeedOffsetX, int SeedOffsetY)
+void CAutoMapper::ProceedRows(const CRun *pRun, int RunID, const CTile *pReadTiles, CTile *pTiles, int Width, int Height, int Seed, int SeedOffsetX, int SeedOffsetY, int FromY, int ToY) const
 {
-	if(!m_FileLoaded || pLayer->m_Readonly || ConfigID < 0 || ConfigID >= m_lConfigs.size())
-		return;
-
-	if(Seed == 0)
-		Seed = rand();
-
-	CConfiguration *pConf = &m_lConfigs[ConfigID];
-
-	// for every run: copy tiles, automap, overwrite tiles
-	for(int h = 0; h < pConf->m_aRuns.size(); ++h)
+	const CCompiledPosRule *pPosRules = pRun->m_vCompiledPosRules.data();
+	const CIndexInfo *pIndices = pRun->m_vCompiledIndices.data();
+	for(int y = FromY; y < ToY; y++)
 	{
-		CRun *pRun = &pConf->m_aRuns[h];
-
-		// don't make copy if it's requested
-		CLayerTiles *pReadLayer;
-		if(pRun->m_AutomapCopy)
+		for(int x = 0; x < Width; x++)
 		{
-			pReadLayer = new CLayerTiles(pLayer->m_Width, pLayer->m_Height);
+			CTile *pTile = &pTiles[y * Width + x];
 
-			for(int y = 0; y < pLayer->m_Height; y++)
+			for(int i = 0; i < (int)pRun->m_vCompiledRules.size(); ++i)
 			{
-				for(int x = 0; x < pLayer->m_Width; x++)
+				const CCompiledIndexRule *pIndexRule = &pRun->m_vCompiledRules[i];
+				if(pIndexRule->m_SkipEmpty && pTile->m_Index == 0) // skip empty tiles
+					continue;
+				if(pIndexRule->m_SkipFull && pTile->m_Index != 0) // skip full tiles
+					continue;
+
+				bool RespectRules = true;
+				for(int j = 0; j < pIndexRule->m_NumPosRules && RespectRules; ++j)
 				{
-					CTile *in = &pLayer->m_pTiles[y * pLayer->m_Width + x];
-					CTile *out = &pReadLayer->m_pTiles[y * pLayer->m_Width + x];
-					out->m_Index = in->m_Index;
-					out->m_Flags = in->m_Flags;
-				}
-			}
-		}
-		else
-		{
-			pReadLayer = pLayer;
-		}
+					const CCompiledPosRule *pRule = &pPosRules[pIndexRule->m_FirstPosRule + j];
 
-		// auto map
-		for(int y = 0; y < pLayer->m_Height; y++)
-		{
-			for(int x = 0; x < pLayer->m_Width; x++)
-			{
-				CTile *pTile = &(pLayer->m_pTiles[y * pLayer->m_Width + x]);
-				m_pEditor->m_Map.m_Modified = true;
-
-				for(int i = 0; i < pRun->m_aIndexRules.size(); ++i)
-				{
-					CIndexRule *pIndexRule = &pRun->m_aIndexRules[i];
-					if(pIndexRule->m_SkipEmpty && pTile->m_Index == 0) // skip empty tiles
-						continue;
-					if(pIndexRule->m_SkipFull && pTile->m_Index != 0) // skip full tiles
-						continue;
-
-					bool RespectRules = true;
-					for(int j = 0; j < pIndexRule->m_aRules.size() && RespectRules; ++j)
+					int CheckIndex, CheckFlags;
+					int CheckX = x + pRule->m_X;
+					int CheckY = y + pRule->m_Y;
+					if(CheckX >= 0 && CheckX < Width && CheckY >= 0 && CheckY < Height)
 					{
-						CPosRule *pRule = &pIndexRule->m_aRules[j];
-
-						int CheckIndex, CheckFlags;
-						int CheckX = x + pRule->m_X;
-						int CheckY = y + pRule->m_Y;
-						if(CheckX >= 0 && CheckX < pLayer->m_Width && CheckY >= 0 && CheckY < pLayer->m_Height)
-						{
-							int CheckTile = CheckY * pLayer->m_Width + CheckX;
-							CheckIndex = pReadLayer->m_pTiles[CheckTile].m_Index;
-							CheckFlags = pReadLayer->m_pTiles[CheckTile].m_Flags & (TILEFLAG_ROTATE | TILEFLAG_VFLIP | TILEFLAG_HFLIP);
-						}
-						else
-						{
-							CheckIndex = -1;
-							CheckFlags = 0;
-						}
+						int CheckTile = CheckY * Width + CheckX;
+						CheckIndex = pReadTiles[CheckTile].m_Index;
+						CheckFlags = pReadTiles[CheckTile].m_Flags & (TILEFLAG_ROTATE | TILEFLAG_VFLIP | TILEFLAG_HFLIP);
+					}
+					else
+					{
+						CheckIndex = -1;
+						CheckFlags = 0;
+					}
 
-						if(pRule->m_Value == CPosRule::INDEX)
-						{
-							RespectRules = false;
-							for(int i = 0; i < pRule->m_aIndexList.size(); ++i)
-							{
-								if(CheckIndex == pRule->m_aIndexList[i].m_ID && (!pRule->m_aIndexList[i].m_TestFlag || CheckFlags == pRule->m_aIndexList[i].m_Flag))
-								{
-									RespectRules = true;
-									break;
-								}
-							}
-						}
-						else if(pRule->m_Value == CPosRule::NOTINDEX)
+					// INDEX needs one of the indices to match, NOTINDEX none
+					bool Match = false;
+					const CIndexInfo *pIndex = &pIndices[pRule->m_FirstIndex];
+					for(int k = 0; k < pRule->m_NumIndices; ++k, ++pIndex)
+					{
+						if(CheckIndex == pIndex->m_ID && (!pIndex->m_TestFlag || CheckFlags == pIndex->m_Flag))
 						{
-							for(int i = 0; i < pRule->m_aIndexList.size(); ++i)
-							{
-								if(CheckIndex == pRule->m_aIndexList[i].m_ID && (!pRule->m_aIndexList[i].m_TestFlag || CheckFlags == pRule->m_aIndexList[i].m_Flag))
-								{
-									RespectRules = false;
-									break;
-								}
-							}
+							Match = true;
+							break;
 						}
 					}
+					RespectRules = pRule->m_Value == CPosRule::INDEX ? Match : !Match;
+				}
 
-					if(RespectRules &&
-						(pIndexRule->m_RandomProbability >= 1.0f || HashLocation(Seed, h, i, x + SeedOffsetX, y + SeedOffsetY) < HASH_MAX * pIndexRule->m_RandomProbability))
-					{
-						pTile->m_Index = pIndexRule->m_ID;
-						pTile->m_Flags = pIndexRule->m_Flag;
-					}
+				if(RespectRules &&
+					(pIndexRule->m_RandomProbability >= 1.0f || HashLocation(Seed, RunID, i, x + SeedOffsetX, y + SeedOffsetY) < HASH_MAX * pIndexRule->m_RandomProbability))
+				{
+					pTile->m_Index = pIndexRule->m_ID;
+					pTile->m_Flags = pIndexRule->m_Flag;
 				}
 			}
 		}
+	}
+}
+
+void CAutoMapper::Proceed(CTile *pTiles, int Width, int Height, int ConfigID, int Seed, int SeedOffsetX, int SeedOffsetY)
+{
+	if(!m_FileLoaded || ConfigID < 0 || ConfigID >= (int)m_vConfigs.size())
+		return;
+
+	if(Seed == 0)
+		Seed = rand();
+
+	CConfiguration *pConf = &m_vConfigs[ConfigID];
+
+	// for every run: copy tiles, automap, overwrite tiles
+	std::vector<CTile> vReadTiles;
+	for(int h = 0; h < (int)pConf->m_vRuns.size(); ++h)
+	{
+		const CRun *pRun = &pConf->m_vRuns[h];
+
+		// without a copy every tile sees the already mapped ones before it,
+		// so the rows can only be mapped in order
+		if(!pRun->m_AutomapCopy)
+		{
+			ProceedRows(pRun, h, pTiles, pTiles, Width, Height, Seed, SeedOffsetX, SeedOffsetY, 0, Height);
+			continue;
+		}
+
+		vReadTiles.assign(pTiles, pTiles + Width * Height);
+		const CTile *pReadTiles = vReadTiles.data();
+
+		// the copy doesn't change, so stripes of rows can be mapped at once
+		int NumStripes = 1;
+		if(m_pJobPool)
+			NumStripes = clamp(Height / 32, 1, 4 * (minimum(m_pJobPool->NumThreads(), (int)CParallelWork::MAX_HELPERS) + 1));
+		if(NumStripes == 1)
+		{
+			ProceedRows(pRun, h, pReadTiles, pTiles, Width, Height, Seed, SeedOffsetX, SeedOffsetY, 0, Height);
+			continue;
+		}
 
-		// clean-up
-		if(pRun->m_AutomapCopy)
-			delete pReadLayer;
+		CParallelWork Work(NumStripes, [&](int Stripe) {
+			ProceedRows(pRun, h, pReadTiles, pTiles, Width, Height, Seed, SeedOffsetX, SeedOffsetY, Height * Stripe / NumStripes, Height * (Stripe + 1) / NumStripes);
+		});
+		m_pJobPool->Add(Work.HelperJobs(), CJobPool::PRIORITY_HIGH);
+		Work.WaitAll();
 	}
 }
@@ -1,7 +1,7 @@
 #ifndef GAME_EDITOR_AUTO_MAP_H
 #define GAME_EDITOR_AUTO_MAP_H
 
-#include <base/tl/array.h>
+#include <vector>
 
 class CAutoMapper
 {
@@ -17,7 +17,7 @@ class CAutoMapper
 		int m_X;
 		int m_Y;
 		int m_Value;
-		array<CIndexInfo> m_aIndexList;
+		std::vector<CIndexInfo> m_vIndexList;
 
 		enum
 		{
@@ -30,7 +30,7 @@ class CAutoMapper
 	struct CIndexRule
 	{
 		int m_ID;
-		array<CPosRule> m_aRules;
+		std::vector<CPosRule> m_vRules;
 		int m_Flag;
 		float m_RandomProbability;
 		bool m_DefaultRule;
@@ -38,15 +38,42 @@ class CAutoMapper
 		bool m_SkipFull;
 	};
 
+	// the index rules of a run flattened into plain tables, the position
+	// rules of an index rule and the indices of a position rule follow each
+	// other
+	struct CCompiledPosRule
+	{
+		int m_X;
+		int m_Y;
+		int m_Value;
+		int m_FirstIndex;
+		int m_NumIndices;
+	};
+
+	struct CCompiledIndexRule
+	{
+		int m_ID;
+		int m_Flag;
+		float m_RandomProbability;
+		bool m_SkipEmpty;
+		bool m_SkipFull;
+		int m_FirstPosRule;
+		int m_NumPosRules;
+	};
+
 	struct CRun
 	{
-		array<CIndexRule> m_aIndexRules;
+		std::vector<CIndexRule> m_vIndexRules;
 		bool m_AutomapCopy;
+
+		std::vector<CCompiledIndexRule> m_vCompiledRules;
+		std::vector<CCompiledPosRule> m_vCompiledPosRules;
+		std::vector<CIndexInfo> m_vCompiledIndices;
 	};
 
 	struct CConfiguration
 	{
-		array<CRun> m_aRuns;
+		std::vector<CRun> m_vRuns;
 		char m_aName[128];
 		int m_StartX;
 		int m_StartY;
@@ -54,21 +81,28 @@ class CAutoMapper
 		int m_EndY;
 	};
 
+	void Compile(CRun *pRun);
+	void ProceedRows(const CRun *pRun, int RunID, const class CTile *pReadTiles, class CTile *pTiles, int Width, int Height, int Seed, int SeedOffsetX, int SeedOffsetY, int FromY, int ToY) const;
+
 public:
-	CAutoMapper(class CEditor *pEditor);
+	// with a job pool, runs that work on a copy of the layer are spread over
+	// its workers in stripes of rows
+	CAutoMapper(class IStorage *pStorage, class IConsole *pConsole, class CJobPool *pJobPool = 0);
 
 	void Load(const char *pTileName);
-	void ProceedLocalized(class CLayerTiles *pLayer, int ConfigID, int Seed = 0, int X = 0, int Y = 0, int Width = -1, int Height = -1);
-	void Proceed(class CLayerTiles *pLayer, int ConfigID, int Seed = 0, int SeedOffsetX = 0, int SeedOffsetY = 0);
+	void ProceedLocalized(class CTile *pTiles, int LayerWidth, int LayerHeight, int ConfigID, int Seed = 0, int X = 0, int Y = 0, int Width = -1, int Height = -1);
+	void Proceed(class CTile *pTiles, int Width, int Height, int ConfigID, int Seed = 0, int SeedOffsetX = 0, int SeedOffsetY = 0);
 
-	int ConfigNamesNum() const { return m_lConfigs.size(); }
+	int ConfigNamesNum() const { return m_vConfigs.size(); }
 	const char *GetConfigName(int Index);
 
 	bool IsLoaded() const { return m_FileLoaded; }
 
 private:
-	array<CConfiguration> m_lConfigs;
-	class CEditor *m_pEditor;
+	std::vector<CConfiguration> m_vConfigs;
+	class IStorage *m_pStorage;
+	class IConsole *m_pConsole;
+	class CJobPool *m_pJobPool;
 	bool m_FileLoaded;
 };
 
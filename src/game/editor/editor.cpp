@@ -2,6 +2,7 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 
 #include <algorithm>
+#include <thread>
 
 #include <base/color.h>
 #include <base/system.h>
@@ -13,6 +14,7 @@
 
 #include <engine/client.h>
 #include <engine/console.h>
+#include <engine/engine.h>
 #include <engine/graphics.h>
 #include <engine/input.h>
 #include <engine/keys.h>
@@ -88,6 +90,18 @@ enum
 	BUTTON_CONTEXT = 1,
 };
 
+CEditorImage::CEditorImage(CEditor *pEditor) :
+	m_AutoMapper(pEditor->Storage(), pEditor->Console(), pEditor->Engine() ? pEditor->Engine()->JobPool() : 0)
+{
+	m_pEditor = pEditor;
+	m_aName[0] = 0;
+	m_External = 0;
+	m_Width = 0;
+	m_Height = 0;
+	m_pData = 0;
+	m_Format = 0;
+}
+
 CEditorImage::~CEditorImage()
 {
 	m_pEditor->Graphics()->UnloadTexture(m_Texture);
@@ -3606,7 +3620,7 @@ void CEditor::ReplaceImage(const char *pFileName, int StorageType, void *pUser)
 		if(ImgInfo.m_Format == CImageInfo::FORMAT_RGBA)
 			ColorChannelCount = 4;
 
-		DilateImage((unsigned char *)ImgInfo.m_pData, ImgInfo.m_Width, ImgInfo.m_Height, ColorChannelCount);
+		DilateImage((unsigned char *)ImgInfo.m_pData, ImgInfo.m_Width, ImgInfo.m_Height, ColorChannelCount, pEditor->Engine()->JobPool());
 	}
 
 	pImg->m_AutoMapper.Load(pImg->m_aName);
@@ -3657,7 +3671,7 @@ void CEditor::AddImage(const char *pFileName, int StorageType, void *pUser)
 		if(ImgInfo.m_Format == CImageInfo::FORMAT_RGBA)
 			ColorChannelCount = 4;
 
-		DilateImage((unsigned char *)ImgInfo.m_pData, ImgInfo.m_Width, ImgInfo.m_Height, ColorChannelCount);
+		DilateImage((unsigned char *)ImgInfo.m_pData, ImgInfo.m_Width, ImgInfo.m_Height, ColorChannelCount, pEditor->Engine()->JobPool());
 	}
 
 	int TextureLoadFlag = pEditor->Graphics()->HasTextureArrays() ? IGraphics::TEXLOAD_TO_2D_ARRAY_TEXTURE : IGraphics::TEXLOAD_TO_3D_TEXTURE;
@@ -6380,6 +6394,14 @@ void CEditorMap::CreateDefault(IGraphics::CTextureHandle EntitiesTexture)
 	m_pTuneLayer = 0x0;
 }
 
+CJobPool *CEditor::SavePool()
+{
+	// the threads are only started by the first save
+	if(!m_SavePool.NumThreads())
+		m_SavePool.Init(clamp((int)std::thread::hardware_concurrency() - 1, 1, 4));
+	return &m_SavePool;
+}
+
 void CEditor::Init()
 {
 	m_pInput = Kernel()->RequestInterface<IInput>();
@@ -6389,6 +6411,7 @@ void CEditor::Init()
 	m_pTextRender = Kernel()->RequestInterface<ITextRender>();
 	m_pStorage = Kernel()->RequestInterface<IStorage>();
 	m_pSound = Kernel()->RequestInterface<ISound>();
+	m_pEngine = Kernel()->RequestInterface<IEngine>();
 	m_RenderTools.Init(m_pGraphics, &m_UI);
 	m_UI.SetGraphics(m_pGraphics, m_pTextRender);
 	m_Map.m_pEditor = this;
@@ -23,6 +23,7 @@
 #include <engine/graphics.h>
 #include <engine/shared/config.h>
 #include <engine/shared/datafile.h>
+#include <engine/shared/jobs.h>
 #include <engine/sound.h>
 #include <engine/storage.h>
 
@@ -281,18 +282,7 @@ class CEditorImage : public CImageInfo
 public:
 	CEditor *m_pEditor;
 
-	CEditorImage(CEditor *pEditor) :
-		m_AutoMapper(pEditor)
-	{
-		m_pEditor = pEditor;
-		m_aName[0] = 0;
-		m_External = 0;
-		m_Width = 0;
-		m_Height = 0;
-		m_pData = 0;
-		m_Format = 0;
-	}
-
+	CEditorImage(CEditor *pEditor);
 	~CEditorImage();
 
 	void AnalyseTileFlags();
@@ -638,8 +628,12 @@ class CEditor : public IEditor
 	class ITextRender *m_pTextRender;
 	class ISound *m_pSound;
 	class IStorage *m_pStorage;
+	class IEngine *m_pEngine;
 	CRenderTools m_RenderTools;
 	CUI m_UI;
+	// compresses the map data when saving, not the engine pool so a save
+	// never waits for a download
+	CJobPool m_SavePool;
 
 public:
 	class IInput *Input() { return m_pInput; };
@@ -649,6 +643,8 @@ public:
 	class ISound *Sound() { return m_pSound; }
 	class ITextRender *TextRender() { return m_pTextRender; };
 	class IStorage *Storage() { return m_pStorage; };
+	class IEngine *Engine() { return m_pEngine; }
+	CJobPool *SavePool();
 	CUI *UI() { return &m_UI; }
 	CRenderTools *RenderTools() { return &m_RenderTools; }
 
@@ -660,6 +656,7 @@ public:
 		m_pGraphics = 0;
 		m_pTextRender = 0;
 		m_pSound = 0;
+		m_pEngine = 0;
 
 		m_Mode = MODE_LAYERS;
 		m_Dialog = 0;
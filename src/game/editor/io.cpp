@@ -6,6 +6,7 @@
 #include "editor.h"
 #include <engine/client.h>
 #include <engine/console.h>
+#include <engine/engine.h>
 #include <engine/graphics.h>
 #include <engine/serverbrowser.h>
 #include <engine/storage.h>
@@ -231,6 +232,7 @@ int CEditorMap::Save(class IStorage *pStorage, const char *pFileName)
 		m_pEditor->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "editor", aBuf);
 		return 0;
 	}
+	df.SetJobPool(m_pEditor->SavePool());
 
 	// save version
 	{
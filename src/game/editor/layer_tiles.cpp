@@ -828,7 +828,11 @@ int CLayerTiles::RenderProperties(CUIRect *pToolBox)
 			}
 			if(m_pEditor->DoButton_Editor(&s_AutoMapperButton, "Automap", 0, &Button, 0, "Run the automapper"))
 			{
-				m_pEditor->m_Map.m_lImages[m_Image]->m_AutoMapper.Proceed(this, m_AutoMapperConfig, m_Seed);
+				if(!m_Readonly)
+				{
+					m_pEditor->m_Map.m_lImages[m_Image]->m_AutoMapper.Proceed(m_pTiles, m_Width, m_Height, m_AutoMapperConfig, m_Seed);
+					m_pEditor->m_Map.m_Modified = true;
+				}
 				return 1;
 			}
 		}
@@ -1083,9 +1087,9 @@ int CLayerTiles::RenderCommonProperties(SCommonPropState &State, CEditor *pEdito
 void CLayerTiles::FlagModified(int x, int y, int w, int h)
 {
 	m_pEditor->m_Map.m_Modified = true;
-	if(m_Seed != 0 && m_AutoMapperConfig != -1 && m_AutoAutoMap)
+	if(m_Seed != 0 && m_AutoMapperConfig != -1 && m_AutoAutoMap && !m_Readonly)
 	{
-		m_pEditor->m_Map.m_lImages[m_Image]->m_AutoMapper.ProceedLocalized(this, m_AutoMapperConfig, m_Seed, x, y, w, h);
+		m_pEditor->m_Map.m_lImages[m_Image]->m_AutoMapper.ProceedLocalized(m_pTiles, m_Width, m_Height, m_AutoMapperConfig, m_Seed, x, y, w, h);
 	}
 }
 
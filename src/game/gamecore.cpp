@@ -56,6 +56,15 @@ float VelocityRamp(float Value, float Start, float Range, float Curvature)
 	return 1.0f / powf(Curvature, (Value - Start) / Range);
 }
 
+// whether Pos is further than Reach away from the box around the line
+// between A and B on either axis, then it's also further than that from
+// every point on the line
+static bool OutsideLineBox(vec2 Pos, vec2 A, vec2 B, float Reach)
+{
+	return Pos.x < minimum(A.x, B.x) - Reach || Pos.x > maximum(A.x, B.x) + Reach ||
+		Pos.y < minimum(A.y, B.y) - Reach || Pos.y > maximum(A.y, B.y) + Reach;
+}
+
 void CCharacterCore::Init(CWorldCore *pWorld, CCollision *pCollision, CTeamsCore *pTeams)
 {
 	m_pWorld = pWorld;
@@ -100,6 +109,7 @@ void CCharacterCore::Reset()
 	m_TriggeredEvents = 0;
 	m_Hook = true;
 	m_Collision = true;
+	m_MoveRestrictions = 0;
 
 	// DDNet Character
 	m_Solo = false;
@@ -276,6 +286,9 @@ void CCharacterCore::Tick(bool UseInput)
 				CCharacterCore *pCharCore = m_pWorld->m_apCharacters[i];
 				if(!pCharCore || pCharCore == this || (!(m_Super || pCharCore->m_Super) && (!m_pTeams->CanCollide(i, m_Id) || pCharCore->m_Solo || m_Solo)))
 					continue;
+				// one more unit than the check below to cover rounding
+				if(m_pWorld->m_BroadPhase && OutsideLineBox(pCharCore->m_Pos, m_HookPos, NewPos, PhysSize + 3.0f))
+					continue;
 
 				vec2 ClosestPoint = closest_point_on_line(m_HookPos, NewPos, pCharCore->m_Pos);
 				if(distance(pCharCore->m_Pos, ClosestPoint) < PhysSize + 2.0f)
@@ -393,6 +406,12 @@ void CCharacterCore::Tick(bool UseInput)
 			if(!(m_Super || pCharCore->m_Super) && (m_Solo || pCharCore->m_Solo))
 				continue;
 
+			// players that are too far away to collide are only pulled by
+			// our hook
+			if(m_pWorld->m_BroadPhase && i != m_HookedPlayer &&
+				(absolute(m_Pos.x - pCharCore->m_Pos.x) > PhysSize * 1.25f + 1.0f || absolute(m_Pos.y - pCharCore->m_Pos.y) > PhysSize * 1.25f + 1.0f))
+				continue;
+
 			// handle player <-> player collision
 			float Distance = distance(m_Pos, pCharCore->m_Pos);
 			vec2 Dir = normalize(m_Pos - pCharCore->m_Pos);
@@ -471,27 +490,42 @@ void CCharacterCore::Move()
 
 	if(m_pWorld && (m_Super || (m_pWorld->m_Tuning[g_Config.m_ClDummy].m_PlayerCollision && m_Collision && !m_NoCollision && !m_Solo)))
 	{
+		// collect the players we can run into once, instead of checking
+		// every player at every step
+		float aBlockerX[MAX_CLIENTS];
+		float aBlockerY[MAX_CLIENTS];
+		int NumBlockers = 0;
+		for(int p = 0; p < MAX_CLIENTS; p++)
+		{
+			CCharacterCore *pCharCore = m_pWorld->m_apCharacters[p];
+			if(!pCharCore || pCharCore == this)
+				continue;
+			if((!(pCharCore->m_Super || m_Super) && (m_Solo || pCharCore->m_Solo || !pCharCore->m_Collision || pCharCore->m_NoCollision || (m_Id != -1 && !m_pTeams->CanCollide(m_Id, p)))))
+				continue;
+			if(m_pWorld->m_BroadPhase && OutsideLineBox(pCharCore->m_Pos, m_Pos, NewPos, 28.0f + 1.0f))
+				continue;
+			aBlockerX[NumBlockers] = pCharCore->m_Pos.x;
+			aBlockerY[NumBlockers] = pCharCore->m_Pos.y;
+			NumBlockers++;
+		}
+
 		// check player collision
 		float Distance = distance(m_Pos, NewPos);
-		int End = Distance + 1;
+		int End = NumBlockers ? Distance + 1 : 0;
 		vec2 LastPos = m_Pos;
 		for(int i = 0; i < End; i++)
 		{
 			float a = i / Distance;
 			vec2 Pos = mix(m_Pos, NewPos, a);
-			for(int p = 0; p < MAX_CLIENTS; p++)
+			for(int b = 0; b < NumBlockers; b++)
 			{
-				CCharacterCore *pCharCore = m_pWorld->m_apCharacters[p];
-				if(!pCharCore || pCharCore == this)
-					continue;
-				if((!(pCharCore->m_Super || m_Super) && (m_Solo || pCharCore->m_Solo || !pCharCore->m_Collision || pCharCore->m_NoCollision || (m_Id != -1 && !m_pTeams->CanCollide(m_Id, p)))))
-					continue;
-				float D = distance(Pos, pCharCore->m_Pos);
+				vec2 BlockerPos = vec2(aBlockerX[b], aBlockerY[b]);
+				float D = distance(Pos, BlockerPos);
 				if(D < 28.0f && D >= 0.0f)
 				{
 					if(a > 0.0f)
 						m_Pos = LastPos;
-					else if(distance(NewPos, pCharCore->m_Pos) > D)
+					else if(distance(NewPos, BlockerPos) > D)
 						m_Pos = NewPos;
 					return;
 				}
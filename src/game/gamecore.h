@@ -195,6 +195,7 @@ public:
 	{
 		mem_zero(m_apCharacters, sizeof(m_apCharacters));
 		m_pPrng = 0;
+		m_BroadPhase = true;
 	}
 
 	int RandomOr0(int BelowThis)
@@ -212,6 +213,9 @@ public:
 	CTuningParams m_Tuning[2];
 	class CCharacterCore *m_apCharacters[MAX_CLIENTS];
 	CPrng *m_pPrng;
+	// skip players that are too far away before the exact player checks,
+	// this doesn't change the outcome
+	bool m_BroadPhase;
 };
 
 class CCharacterCore
@@ -6,6 +6,8 @@
 
 #include "door.h"
 
+MACRO_ALLOC_POOL_IMPL(CDoor)
+
 CDoor::CDoor(CGameWorld *pGameWorld, vec2 Pos, float Rotation, int Length,
 	int Number) :
 	CEntity(pGameWorld, CGameWorld::ENTTYPE_LASER)
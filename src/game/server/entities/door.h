@@ -8,6 +8,8 @@ class CTrigger;
 
 class CDoor : public CEntity
 {
+	MACRO_ALLOC_POOL()
+
 	vec2 m_To;
 	int m_EvalTick;
 	void ResetCollision();
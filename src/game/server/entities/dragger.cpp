@@ -8,6 +8,8 @@
 #include <game/server/gamemodes/DDRace.h>
 #include <game/server/teams.h>
 
+MACRO_ALLOC_POOL_IMPL(CDragger)
+
 CDragger::CDragger(CGameWorld *pGameWorld, vec2 Pos, float Strength, bool NW,
 	int CaughtTeam, int Layer, int Number) :
 	CEntity(pGameWorld, CGameWorld::ENTTYPE_LASER)
@@ -29,30 +31,31 @@ CDragger::CDragger(CGameWorld *pGameWorld, vec2 Pos, float Strength, bool NW,
 
 void CDragger::Move()
 {
-	if(m_Target && (!m_Target->IsAlive() || (m_Target->IsAlive() && (m_Target->m_Super || m_Target->IsPaused() || (m_Layer == LAYER_SWITCH && m_Number && !GameServer()->Collision()->m_pSwitchers[m_Number].m_Status[m_Target->Team()])))))
-		m_Target = 0;
+	CCharacter *pTarget = m_Target.Get();
+	if(pTarget && (!pTarget->IsAlive() || (pTarget->IsAlive() && (pTarget->m_Super || pTarget->IsPaused() || (m_Layer == LAYER_SWITCH && m_Number && !GameServer()->Collision()->m_pSwitchers[m_Number].m_Status[pTarget->Team()])))))
+		pTarget = 0;
 
-	mem_zero(m_SoloEnts, sizeof(m_SoloEnts));
+	CCharacter *apSoloEnts[MAX_CLIENTS] = {0};
 	CCharacter *TempEnts[MAX_CLIENTS];
 
 	int Num = GameServer()->m_World.FindEntities(m_Pos, g_Config.m_SvDraggerRange,
-		(CEntity **)m_SoloEnts, MAX_CLIENTS, CGameWorld::ENTTYPE_CHARACTER);
-	mem_copy(TempEnts, m_SoloEnts, sizeof(TempEnts));
+		(CEntity **)apSoloEnts, MAX_CLIENTS, CGameWorld::ENTTYPE_CHARACTER);
+	mem_copy(TempEnts, apSoloEnts, sizeof(TempEnts));
 
 	int Id = -1;
 	int MinLen = 0;
 	CCharacter *Temp;
 	for(int i = 0; i < Num; i++)
 	{
-		Temp = m_SoloEnts[i];
+		Temp = apSoloEnts[i];
 		if(Temp->Team() != m_CaughtTeam)
 		{
-			m_SoloEnts[i] = 0;
+			apSoloEnts[i] = 0;
 			continue;
 		}
 		if(m_Layer == LAYER_SWITCH && m_Number && !GameServer()->Collision()->m_pSwitchers[m_Number].m_Status[Temp->Team()])
 		{
-			m_SoloEnts[i] = 0;
+			apSoloEnts[i] = 0;
 			continue;
 		}
 		int Res =
@@ -71,37 +74,42 @@ void CDragger::Move()
 			}
 
 			if(!Temp->Teams()->m_Core.GetSolo(Temp->GetPlayer()->GetCID()))
-				m_SoloEnts[i] = 0;
+				apSoloEnts[i] = 0;
 		}
 		else
 		{
-			m_SoloEnts[i] = 0;
+			apSoloEnts[i] = 0;
 		}
 	}
 
-	if(!m_Target)
-		m_Target = Id != -1 ? TempEnts[Id] : 0;
+	if(!pTarget)
+		pTarget = Id != -1 ? TempEnts[Id] : 0;
 
-	if(m_Target)
+	if(pTarget)
 	{
 		for(int i = 0; i < MAX_CLIENTS; i++)
 		{
-			if(m_SoloEnts[i] == m_Target)
-				m_SoloEnts[i] = 0;
+			if(apSoloEnts[i] == pTarget)
+				apSoloEnts[i] = 0;
 		}
 	}
+
+	m_Target = pTarget;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+		m_SoloEnts[i] = apSoloEnts[i];
 }
 
 void CDragger::Drag()
 {
-	if(m_Target)
+	CCharacter *pTarget = m_Target.Get();
+	if(pTarget)
 	{
-		CCharacter *Target = m_Target;
+		CCharacter *Target = pTarget;
 
 		for(int i = -1; i < MAX_CLIENTS; i++)
 		{
 			if(i >= 0)
-				Target = m_SoloEnts[i];
+				Target = m_SoloEnts[i].Get();
 
 			if(!Target)
 				continue;
@@ -161,7 +169,7 @@ void CDragger::Snap(int SnappingClient)
 	if(((CGameControllerDDRace *)GameServer()->m_pController)->m_Teams.GetTeamState(m_CaughtTeam) == CGameTeams::TEAMSTATE_EMPTY)
 		return;
 
-	CCharacter *Target = m_Target;
+	CCharacter *Target = m_Target.Get();
 
 	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
@@ -178,7 +186,7 @@ void CDragger::Snap(int SnappingClient)
 	{
 		if(i >= 0)
 		{
-			Target = m_SoloEnts[i];
+			Target = m_SoloEnts[i].Get();
 
 			if(!Target)
 				continue;
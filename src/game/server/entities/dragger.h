@@ -7,16 +7,19 @@ class CCharacter;
 
 class CDragger : public CEntity
 {
+	MACRO_ALLOC_POOL()
+
 	vec2 m_Core;
 	float m_Strength;
 	int m_EvalTick;
 	void Move();
 	void Drag();
-	CCharacter *m_Target;
+	// the characters can die between the evaluations
+	CEntityHandle<CCharacter> m_Target;
 	bool m_NW;
 	int m_CaughtTeam;
 
-	CCharacter *m_SoloEnts[MAX_CLIENTS];
+	CEntityHandle<CCharacter> m_SoloEnts[MAX_CLIENTS];
 	int m_SoloIDs[MAX_CLIENTS];
 
 public:
@@ -4,6 +4,8 @@
 #include "flag.h"
 #include <game/server/gamecontext.h>
 
+MACRO_ALLOC_POOL_IMPL(CFlag)
+
 CFlag::CFlag(CGameWorld *pGameWorld, int Team)
 : CEntity(pGameWorld, CGameWorld::ENTTYPE_FLAG)
 {
@@ -8,6 +8,8 @@
 #include "gun.h"
 #include "plasma.h"
 
+MACRO_ALLOC_POOL_IMPL(CGun)
+
 //////////////////////////////////////////////////
 // CGun
 //////////////////////////////////////////////////
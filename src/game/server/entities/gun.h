@@ -10,6 +10,8 @@ class CCharacter;
 
 class CGun : public CEntity
 {
+	MACRO_ALLOC_POOL()
+
 	int m_EvalTick;
 
 	vec2 m_Core;
@@ -6,6 +6,8 @@
 
 class CLight : public CEntity
 {
+	MACRO_ALLOC_POOL()
+
 	float m_Rotation;
 	vec2 m_To;
 	vec2 m_Core;
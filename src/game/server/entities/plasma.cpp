@@ -7,6 +7,8 @@
 #include <game/server/gamemodes/DDRace.h>
 #include <game/server/teams.h>
 
+MACRO_ALLOC_POOL_IMPL(CPlasma)
+
 const float PLASMA_ACCEL = 1.1f;
 
 CPlasma::CPlasma(CGameWorld *pGameWorld, vec2 Pos, vec2 Dir, bool Freeze,
@@ -8,6 +8,8 @@
 #include <engine/shared/config.h>
 #include <game/server/teams.h>
 
+MACRO_ALLOC_POOL_IMPL(CProjectile)
+
 CProjectile::CProjectile(
 	CGameWorld *pGameWorld,
 	int Type,
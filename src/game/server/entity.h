@@ -4,23 +4,33 @@
 #define GAME_SERVER_ENTITY_H
 
 #include <base/vmath.h>
+#include <game/server/entitypool.h>
 #include <game/server/gameworld.h>
 #include <new>
 
-#define MACRO_ALLOC_HEAP() \
+/*
+	Every entity class and CPlayer allocate their objects from a pool of
+	their own, see CEntityPool. Entities with an id given from outside,
+	like the client id, use the _ID variants.
+*/
+#define MACRO_ALLOC_POOL() \
 public: \
-	void *operator new(size_t Size) \
+	void *operator new(size_t Size); \
+	void operator delete(void *p); \
+\
+private:
+
+#define MACRO_ALLOC_POOL_IMPL(POOLTYPE) \
+	static CEntityPool ms_Pool##POOLTYPE(sizeof(POOLTYPE)); \
+	void *POOLTYPE::operator new(size_t Size) \
 	{ \
-		void *p = malloc(Size); \
-		mem_zero(p, Size); \
-		return p; \
+		dbg_assert(sizeof(POOLTYPE) == Size, "size error"); \
+		return ms_Pool##POOLTYPE.Allocate(); \
 	} \
-	void operator delete(void *pPtr) \
+	void POOLTYPE::operator delete(void *p) \
 	{ \
-		free(pPtr); \
-	} \
-\
-private:
+		ms_Pool##POOLTYPE.Free(p); \
+	}
 
 #define MACRO_ALLOC_POOL_ID() \
 public: \
@@ -31,32 +41,20 @@ public: \
 private:
 
 #define MACRO_ALLOC_POOL_ID_IMPL(POOLTYPE, PoolSize) \
-	static char ms_PoolData##POOLTYPE[PoolSize][sizeof(POOLTYPE)] = {{0}}; \
-	static int ms_PoolUsed##POOLTYPE[PoolSize] = {0}; \
+	static CEntityPool ms_Pool##POOLTYPE(sizeof(POOLTYPE), PoolSize); \
 	void *POOLTYPE::operator new(size_t Size, int id) \
 	{ \
 		dbg_assert(sizeof(POOLTYPE) == Size, "size error"); \
-		dbg_assert(!ms_PoolUsed##POOLTYPE[id], "already used"); \
-		/*dbg_msg("pool", "++ %s %d", #POOLTYPE, id);*/ \
-		ms_PoolUsed##POOLTYPE[id] = 1; \
-		mem_zero(ms_PoolData##POOLTYPE[id], Size); \
-		return ms_PoolData##POOLTYPE[id]; \
+		return ms_Pool##POOLTYPE.Allocate(id); \
 	} \
 	void POOLTYPE::operator delete(void *p, int id) \
 	{ \
-		dbg_assert(ms_PoolUsed##POOLTYPE[id], "not used"); \
-		dbg_assert(id == (POOLTYPE *)p - (POOLTYPE *)ms_PoolData##POOLTYPE, "invalid id"); \
-		/*dbg_msg("pool", "-- %s %d", #POOLTYPE, id);*/ \
-		ms_PoolUsed##POOLTYPE[id] = 0; \
-		mem_zero(ms_PoolData##POOLTYPE[id], sizeof(POOLTYPE)); \
+		dbg_assert(id == CEntityPool::IndexOf(p), "invalid id"); \
+		ms_Pool##POOLTYPE.Free(p); \
 	} \
 	void POOLTYPE::operator delete(void *p) \
 	{ \
-		int id = (POOLTYPE *)p - (POOLTYPE *)ms_PoolData##POOLTYPE; \
-		dbg_assert(ms_PoolUsed##POOLTYPE[id], "not used"); \
-		/*dbg_msg("pool", "-- %s %d", #POOLTYPE, id);*/ \
-		ms_PoolUsed##POOLTYPE[id] = 0; \
-		mem_zero(ms_PoolData##POOLTYPE[id], sizeof(POOLTYPE)); \
+		ms_Pool##POOLTYPE.Free(p); \
 	}
 
 /*
@@ -65,8 +63,13 @@ private:
 */
 class CEntity
 {
-	MACRO_ALLOC_HEAP()
+public:
+	// entities come from the pool of their class, a class without
+	// MACRO_ALLOC_POOL can't be created
+	void *operator new(size_t Size) = delete;
+	void operator delete(void *pPtr) { dbg_assert(0, "entity without pool"); }
 
+private:
 	friend class CGameWorld; // entity list handling
 	CEntity *m_pPrevTypeEntity;
 	CEntity *m_pNextTypeEntity;
@@ -0,0 +1,124 @@
+#include "entitypool.h"
+
+#include <base/math.h>
+
+CEntityPool::CEntityPool(int ObjectSize)
+{
+	m_ObjectSize = ObjectSize;
+	m_SlotSize = HEADER_SIZE + ((ObjectSize + 15) & ~15);
+	m_SlabSlots = maximum(SLAB_SIZE / m_SlotSize, 1);
+	m_Fixed = false;
+	m_NumSlots = 0;
+	m_NumUsed = 0;
+	m_FirstFree = -1;
+}
+
+CEntityPool::CEntityPool(int ObjectSize, int NumSlots) :
+	CEntityPool(ObjectSize)
+{
+	m_Fixed = true;
+	m_SlabSlots = NumSlots;
+	AddSlab(NumSlots);
+}
+
+CEntityPool::~CEntityPool()
+{
+	for(char *pSlab : m_vpSlabs)
+		free(pSlab);
+}
+
+CEntityPool::CSlot *CEntityPool::Slot(int Index) const
+{
+	return (CSlot *)(m_vpSlabs[Index / m_SlabSlots] + (Index % m_SlabSlots) * m_SlotSize);
+}
+
+CEntityPool::CSlot *CEntityPool::SlotOf(const void *pObject)
+{
+	return (CSlot *)((char *)pObject - HEADER_SIZE);
+}
+
+void CEntityPool::AddSlab(int NumSlots)
+{
+	char *pSlab = (char *)calloc(NumSlots, m_SlotSize);
+	m_vpSlabs.push_back(pSlab);
+
+	// chain the new slots in order, so they are used front to back
+	for(int i = NumSlots - 1; i >= 0; i--)
+	{
+		CSlot *pSlot = (CSlot *)(pSlab + i * m_SlotSize);
+		pSlot->m_pPool = this;
+		pSlot->m_Index = m_NumSlots + i;
+		pSlot->m_Generation = 0;
+		pSlot->m_Used = false;
+		pSlot->m_NextFree = m_Fixed ? -1 : m_FirstFree;
+		if(!m_Fixed)
+			m_FirstFree = pSlot->m_Index;
+	}
+	m_NumSlots += NumSlots;
+}
+
+void *CEntityPool::Use(CSlot *pSlot)
+{
+	pSlot->m_Used = true;
+	m_NumUsed++;
+	return (char *)pSlot + HEADER_SIZE;
+}
+
+void *CEntityPool::Allocate()
+{
+	dbg_assert(!m_Fixed, "pool is allocated by index");
+	if(m_FirstFree == -1)
+		AddSlab(m_SlabSlots);
+
+	CSlot *pSlot = Slot(m_FirstFree);
+	m_FirstFree = pSlot->m_NextFree;
+	return Use(pSlot);
+}
+
+void *CEntityPool::Allocate(int Index)
+{
+	dbg_assert(m_Fixed && Index >= 0 && Index < m_NumSlots, "invalid index");
+	CSlot *pSlot = Slot(Index);
+	dbg_assert(!pSlot->m_Used, "already used");
+	return Use(pSlot);
+}
+
+void CEntityPool::Free(void *pObject)
+{
+	if(!pObject)
+		return;
+
+	CSlot *pSlot = SlotOf(pObject);
+	dbg_assert(pSlot->m_pPool == this && pSlot->m_Used, "not used");
+	pSlot->m_Used = false;
+	pSlot->m_Generation++;
+	m_NumUsed--;
+
+	// objects start out zeroed, and raw pointers to a freed object see a
+	// zeroed one, like with the old static pools
+	mem_zero(pObject, m_ObjectSize);
+
+	// the slot that was freed last is used first, its memory is likely
+	// still in the cache
+	if(!m_Fixed)
+	{
+		pSlot->m_NextFree = m_FirstFree;
+		m_FirstFree = pSlot->m_Index;
+	}
+}
+
+void *CEntityPool::Get(int Index) const
+{
+	if(Index < 0 || Index >= m_NumSlots)
+		return 0;
+	CSlot *pSlot = Slot(Index);
+	return pSlot->m_Used ? (char *)pSlot + HEADER_SIZE : 0;
+}
+
+void *CEntityPool::Get(int Index, int Generation) const
+{
+	if(Index < 0 || Index >= m_NumSlots)
+		return 0;
+	CSlot *pSlot = Slot(Index);
+	return pSlot->m_Used && pSlot->m_Generation == Generation ? (char *)pSlot + HEADER_SIZE : 0;
+}
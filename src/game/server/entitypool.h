@@ -0,0 +1,113 @@
+#ifndef GAME_SERVER_ENTITYPOOL_H
+#define GAME_SERVER_ENTITYPOOL_H
+
+#include <base/system.h>
+
+#include <vector>
+
+/*
+	Class: Entity Pool
+		Memory for the objects of one class. The objects live in slabs that
+		never move and freed slots are kept in a free list, so allocating
+		and freeing is O(1) and objects of a class stay close together.
+
+		Every slot has a generation that changes when its object is freed.
+		A handle remembers the generation, so it resolves to null instead of
+		a different object once the one it was made for is gone.
+*/
+class CEntityPool
+{
+	struct CSlot
+	{
+		CEntityPool *m_pPool;
+		int m_Index;
+		int m_Generation;
+		int m_NextFree;
+		bool m_Used;
+	};
+
+	enum
+	{
+		// objects start this far into their slot
+		HEADER_SIZE = (sizeof(CSlot) + 15) & ~15,
+		SLAB_SIZE = 64 * 1024,
+	};
+
+	int m_ObjectSize;
+	int m_SlotSize;
+	int m_SlabSlots;
+	bool m_Fixed;
+	std::vector<char *> m_vpSlabs;
+	int m_NumSlots;
+	int m_NumUsed;
+	int m_FirstFree;
+
+	CSlot *Slot(int Index) const;
+	static CSlot *SlotOf(const void *pObject);
+	void AddSlab(int NumSlots);
+	void *Use(CSlot *pSlot);
+
+public:
+	// a pool that grows as needed
+	CEntityPool(int ObjectSize);
+	// a pool with a fixed number of slots, allocated by index, e.g. by the
+	// client id
+	CEntityPool(int ObjectSize, int NumSlots);
+	~CEntityPool();
+
+	// both return zeroed memory, a freed object is zeroed as well
+	void *Allocate();
+	void *Allocate(int Index);
+	void Free(void *pObject);
+
+	int Num() const { return m_NumUsed; }
+	int NumSlots() const { return m_NumSlots; }
+	// the object in the slot, null if the slot is free
+	void *Get(int Index) const;
+	// null if the object was freed since the handle was made
+	void *Get(int Index, int Generation) const;
+
+	// only for objects from a pool
+	static CEntityPool *PoolOf(const void *pObject) { return SlotOf(pObject)->m_pPool; }
+	static int IndexOf(const void *pObject) { return SlotOf(pObject)->m_Index; }
+	static int GenerationOf(const void *pObject) { return SlotOf(pObject)->m_Generation; }
+};
+
+/*
+	Class: Entity Handle
+		Refers to an object from a pool without keeping it alive. T has to
+		be the class the pool belongs to.
+*/
+template<class T>
+class CEntityHandle
+{
+	CEntityPool *m_pPool;
+	int m_Index;
+	int m_Generation;
+
+public:
+	CEntityHandle() :
+		m_pPool(0), m_Index(-1), m_Generation(-1)
+	{
+	}
+
+	CEntityHandle(const T *pObject)
+	{
+		*this = pObject;
+	}
+
+	CEntityHandle &operator=(const T *pObject)
+	{
+		m_pPool = pObject ? CEntityPool::PoolOf(pObject) : 0;
+		m_Index = pObject ? CEntityPool::IndexOf(pObject) : -1;
+		m_Generation = pObject ? CEntityPool::GenerationOf(pObject) : -1;
+		return *this;
+	}
+
+	T *Get() const { return m_pPool ? (T *)m_pPool->Get(m_Index, m_Generation) : 0; }
+
+	bool operator==(const CEntityHandle &Other) const { return m_pPool == Other.m_pPool && m_Index == Other.m_Index && m_Generation == Other.m_Generation; }
+	bool operator!=(const CEntityHandle &Other) const { return !(*this == Other); }
+};
+
+#endif
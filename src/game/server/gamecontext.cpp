@@ -13,6 +13,7 @@
 #include <engine/shared/config.h>
 #include <engine/shared/datafile.h>
 #include <engine/shared/linereader.h>
+#include <engine/shared/profiler.h>
 #include <engine/storage.h>
 #include <game/collision.h>
 #include <game/gamecore.h>
@@ -746,12 +747,23 @@ void CGameContext::OnTick()
 		m_TeeHistorian.BeginPlayers();
 	}
 
+	static int s_WorldZone = g_Profiler.RegisterZone("game/world");
+	static int s_ControllerZone = g_Profiler.RegisterZone("game/controller");
+	static int s_PlayersZone = g_Profiler.RegisterZone("game/players");
+	static int s_VotesZone = g_Profiler.RegisterZone("game/votes");
+
 	// copy tuning
 	m_World.m_Core.m_Tuning[0] = m_Tuning;
-	m_World.Tick();
+	{
+		CProfileScope Scope(s_WorldZone);
+		m_World.Tick();
+	}
 
 	//if(world.paused) // make sure that the game object always updates
-	m_pController->Tick();
+	{
+		CProfileScope Scope(s_ControllerZone);
+		m_pController->Tick();
+	}
 
 	if(m_TeeHistorianActive)
 	{
@@ -772,27 +784,31 @@ void CGameContext::OnTick()
 		m_TeeHistorian.BeginInputs();
 	}
 
-	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
-		if(m_apPlayers[i])
+		CProfileScope Scope(s_PlayersZone);
+		for(int i = 0; i < MAX_CLIENTS; i++)
 		{
-			// send vote options
-			ProgressVoteOptions(i);
+			if(m_apPlayers[i])
+			{
+				// send vote options
+				ProgressVoteOptions(i);
 
-			m_apPlayers[i]->Tick();
-			m_apPlayers[i]->PostTick();
+				m_apPlayers[i]->Tick();
+				m_apPlayers[i]->PostTick();
+			}
 		}
-	}
 
-	for(int i = 0; i < MAX_CLIENTS; i++)
-	{
-		if(m_apPlayers[i])
-			m_apPlayers[i]->PostPostTick();
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			if(m_apPlayers[i])
+				m_apPlayers[i]->PostPostTick();
+		}
 	}
 
 	// update voting
 	if(m_VoteCloseTime)
 	{
+		CProfileScope Scope(s_VotesZone);
 		// abort the kick-vote on player-leave
 		if(m_VoteEnforce == VOTE_ENFORCE_ABORT)
 		{
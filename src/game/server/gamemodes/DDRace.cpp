@@ -4,6 +4,7 @@
 #include "gamemode.h"
 #include <engine/server.h>
 #include <engine/shared/config.h>
+#include <engine/shared/profiler.h>
 #include <game/mapitems.h>
 #include <game/server/entities/character.h>
 #include <game/server/gamecontext.h>
@@ -25,7 +26,11 @@ CGameControllerDDRace::~CGameControllerDDRace()
 void CGameControllerDDRace::Tick()
 {
 	IGameController::Tick();
-	m_Teams.ProcessSaveTeam();
+	{
+		static int s_TeamsZone = g_Profiler.RegisterZone("game/teams");
+		CProfileScope Scope(s_TeamsZone);
+		m_Teams.ProcessSaveTeam();
+	}
 
 	if(m_pInitResult != nullptr && m_pInitResult.use_count() == 1)
 	{
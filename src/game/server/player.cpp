@@ -2,6 +2,7 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include "player.h"
 #include <engine/shared/config.h>
+#include <engine/shared/profiler.h>
 #include <new>
 
 #include "gamecontext.h"
@@ -166,16 +167,19 @@ static int PlayerFlags_SixToSeven(int Flags)
 
 void CPlayer::Tick()
 {
+	static int s_ScoreZone = g_Profiler.RegisterZone("game/score");
 #ifdef CONF_DEBUG
 	if(!g_Config.m_DbgDummies || m_ClientID < MAX_CLIENTS - g_Config.m_DbgDummies)
 #endif
 		if(m_ScoreQueryResult != nullptr && m_ScoreQueryResult.use_count() == 1)
 		{
+			CProfileScope Scope(s_ScoreZone);
 			ProcessScoreResult(*m_ScoreQueryResult);
 			m_ScoreQueryResult = nullptr;
 		}
 	if(m_ScoreFinishResult != nullptr && m_ScoreFinishResult.use_count() == 1)
 	{
+		CProfileScope Scope(s_ScoreZone);
 		ProcessScoreResult(*m_ScoreFinishResult);
 		m_ScoreFinishResult = nullptr;
 	}
@@ -1,5 +1,6 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
 #include <base/system.h>
 
 #include <engine/config.h>
@@ -13,13 +14,39 @@
 
 #include "mastersrv.h"
 
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
 enum
 {
 	MTU = 1400,
 	MAX_SERVERS_PER_PACKET = 75,
-	MAX_PACKETS = 16,
-	MAX_SERVERS = MAX_SERVERS_PER_PACKET * MAX_PACKETS,
-	EXPIRE_TIME = 90
+	NUM_SERVERTYPES = 2,
+	EXPIRE_TIME = 90,
+	CHECK_TRIES = 10,
+	CHECK_INTERVAL = 5,
+	// the count packet has 16 bits for the number of servers
+	MAX_SERVERS = 0xffff
+};
+
+struct CAddrHash
+{
+	size_t operator()(const NETADDR &Addr) const
+	{
+		size_t Hash = Addr.type * 31 + Addr.port;
+		for(unsigned i = 0; i < sizeof(Addr.ip); i++)
+			Hash = Hash * 31 + Addr.ip[i];
+		return Hash;
+	}
+};
+
+struct CAddrEqual
+{
+	bool operator()(const NETADDR &A, const NETADDR &B) const
+	{
+		return net_addr_comp(&A, &B) == 0;
+	}
 };
 
 struct CCheckServer
@@ -31,18 +58,32 @@ struct CCheckServer
 	int64 m_TryTime;
 };
 
-static CCheckServer m_aCheckServers[MAX_SERVERS];
-static int m_NumCheckServers = 0;
+// check servers by address, and their address by alternative address
+static std::unordered_map<NETADDR, CCheckServer, CAddrHash, CAddrEqual> m_CheckServers;
+static std::unordered_map<NETADDR, NETADDR, CAddrHash, CAddrEqual> m_CheckServersAlt;
 
 struct CServerEntry
 {
 	enum ServerType m_Type;
 	NETADDR m_Address;
 	int64 m_Expire;
+	// position in the list packets of its type
+	int m_Index;
+};
+
+static std::unordered_map<NETADDR, CServerEntry, CAddrHash, CAddrEqual> m_Servers;
+static std::vector<CServerEntry *> m_avpServers[NUM_SERVERTYPES];
+
+// servers and check servers time out in the order they were last touched,
+// so plain queues are enough. an entry is stale if the time doesn't match
+struct CTimeout
+{
+	int64 m_Time;
+	NETADDR m_Address;
 };
 
-static CServerEntry m_aServers[MAX_SERVERS];
-static int m_NumServers = 0;
+static std::deque<CTimeout> m_ExpireQueue;
+static std::deque<CTimeout> m_CheckQueue;
 
 struct CPacketData
 {
@@ -54,8 +95,7 @@ struct CPacketData
 	} m_Data;
 };
 
-CPacketData m_aPackets[MAX_PACKETS];
-static int m_NumPackets = 0;
+static std::vector<CPacketData> m_vPackets;
 
 // legacy code
 struct CPacketDataLegacy
@@ -68,8 +108,7 @@ struct CPacketDataLegacy
 	} m_Data;
 };
 
-CPacketDataLegacy m_aPacketsLegacy[MAX_PACKETS];
-static int m_NumPacketsLegacy = 0;
+static std::vector<CPacketDataLegacy> m_vPacketsLegacy;
 
 struct CCountPacketData
 {
@@ -88,82 +127,76 @@ static CNetClient m_NetOp; // main
 
 IConsole *m_pConsole;
 
-void BuildPackets()
+static int NumServers()
 {
-	CServerEntry *pCurrent = &m_aServers[0];
-	int ServersLeft = m_NumServers;
-	m_NumPackets = 0;
-	m_NumPacketsLegacy = 0;
-	int PacketIndex = 0;
-	int PacketIndexLegacy = 0;
-	while(ServersLeft-- && (m_NumPackets + m_NumPacketsLegacy) < MAX_PACKETS)
-	{
-		if(pCurrent->m_Type == SERVERTYPE_NORMAL)
-		{
-			if(PacketIndex % MAX_SERVERS_PER_PACKET == 0)
-			{
-				PacketIndex = 0;
-				m_NumPackets++;
-			}
-
-			// copy header
-			mem_copy(m_aPackets[m_NumPackets - 1].m_Data.m_aHeader, SERVERBROWSE_LIST, sizeof(SERVERBROWSE_LIST));
-
-			// copy server addresses
-			if(pCurrent->m_Address.type == NETTYPE_IPV6)
-			{
-				mem_copy(m_aPackets[m_NumPackets - 1].m_Data.m_aServers[PacketIndex].m_aIp, pCurrent->m_Address.ip,
-					sizeof(m_aPackets[m_NumPackets - 1].m_Data.m_aServers[PacketIndex].m_aIp));
-			}
-			else
-			{
-				static char IPV4Mapping[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, (char)0xFF, (char)0xFF};
-
-				mem_copy(m_aPackets[m_NumPackets - 1].m_Data.m_aServers[PacketIndex].m_aIp, IPV4Mapping, sizeof(IPV4Mapping));
-				m_aPackets[m_NumPackets - 1].m_Data.m_aServers[PacketIndex].m_aIp[12] = pCurrent->m_Address.ip[0];
-				m_aPackets[m_NumPackets - 1].m_Data.m_aServers[PacketIndex].m_aIp[13] = pCurrent->m_Address.ip[1];
-				m_aPackets[m_NumPackets - 1].m_Data.m_aServers[PacketIndex].m_aIp[14] = pCurrent->m_Address.ip[2];
-				m_aPackets[m_NumPackets - 1].m_Data.m_aServers[PacketIndex].m_aIp[15] = pCurrent->m_Address.ip[3];
-			}
-
-			m_aPackets[m_NumPackets - 1].m_Data.m_aServers[PacketIndex].m_aPort[0] = (pCurrent->m_Address.port >> 8) & 0xff;
-			m_aPackets[m_NumPackets - 1].m_Data.m_aServers[PacketIndex].m_aPort[1] = pCurrent->m_Address.port & 0xff;
-
-			PacketIndex++;
+	return m_Servers.size();
+}
 
-			m_aPackets[m_NumPackets - 1].m_Size = sizeof(SERVERBROWSE_LIST) + sizeof(CMastersrvAddr) * PacketIndex;
+// writes the server at the given index into its slot of the list packets
+static void WritePacketEntry(int Type, int Index)
+{
+	const NETADDR *pAddr = &m_avpServers[Type][Index]->m_Address;
+	if(Type == SERVERTYPE_NORMAL)
+	{
+		CMastersrvAddr *pEntry = &m_vPackets[Index / MAX_SERVERS_PER_PACKET].m_Data.m_aServers[Index % MAX_SERVERS_PER_PACKET];
 
-			pCurrent++;
+		// copy server addresses
+		if(pAddr->type == NETTYPE_IPV6)
+		{
+			mem_copy(pEntry->m_aIp, pAddr->ip, sizeof(pEntry->m_aIp));
 		}
-		else if(pCurrent->m_Type == SERVERTYPE_LEGACY)
+		else
 		{
-			if(PacketIndexLegacy % MAX_SERVERS_PER_PACKET == 0)
-			{
-				PacketIndexLegacy = 0;
-				m_NumPacketsLegacy++;
-			}
-
-			// copy header
-			mem_copy(m_aPacketsLegacy[m_NumPacketsLegacy - 1].m_Data.m_aHeader, SERVERBROWSE_LIST_LEGACY, sizeof(SERVERBROWSE_LIST_LEGACY));
+			static char IPV4Mapping[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, (char)0xFF, (char)0xFF};
 
-			// copy server addresses
-			mem_copy(m_aPacketsLegacy[m_NumPacketsLegacy - 1].m_Data.m_aServers[PacketIndexLegacy].m_aIp, pCurrent->m_Address.ip,
-				sizeof(m_aPacketsLegacy[m_NumPacketsLegacy - 1].m_Data.m_aServers[PacketIndexLegacy].m_aIp));
-			// 0.5 has the port in little endian on the network
-			m_aPacketsLegacy[m_NumPacketsLegacy - 1].m_Data.m_aServers[PacketIndexLegacy].m_aPort[0] = pCurrent->m_Address.port & 0xff;
-			m_aPacketsLegacy[m_NumPacketsLegacy - 1].m_Data.m_aServers[PacketIndexLegacy].m_aPort[1] = (pCurrent->m_Address.port >> 8) & 0xff;
+			mem_copy(pEntry->m_aIp, IPV4Mapping, sizeof(IPV4Mapping));
+			pEntry->m_aIp[12] = pAddr->ip[0];
+			pEntry->m_aIp[13] = pAddr->ip[1];
+			pEntry->m_aIp[14] = pAddr->ip[2];
+			pEntry->m_aIp[15] = pAddr->ip[3];
+		}
 
-			PacketIndexLegacy++;
+		pEntry->m_aPort[0] = (pAddr->port >> 8) & 0xff;
+		pEntry->m_aPort[1] = pAddr->port & 0xff;
+	}
+	else
+	{
+		CMastersrvAddrLegacy *pEntry = &m_vPacketsLegacy[Index / MAX_SERVERS_PER_PACKET].m_Data.m_aServers[Index % MAX_SERVERS_PER_PACKET];
 
-			m_aPacketsLegacy[m_NumPacketsLegacy - 1].m_Size = sizeof(SERVERBROWSE_LIST_LEGACY) + sizeof(CMastersrvAddrLegacy) * PacketIndexLegacy;
+		// copy server addresses
+		mem_copy(pEntry->m_aIp, pAddr->ip, sizeof(pEntry->m_aIp));
+		// 0.5 has the port in little endian on the network
+		pEntry->m_aPort[0] = pAddr->port & 0xff;
+		pEntry->m_aPort[1] = (pAddr->port >> 8) & 0xff;
+	}
+}
 
-			pCurrent++;
+// adjusts the number of list packets and the size of the last ones
+// after a server of the given type was added or removed
+static void ResizePackets(int Type)
+{
+	int Num = m_avpServers[Type].size();
+	int NumPackets = (Num + MAX_SERVERS_PER_PACKET - 1) / MAX_SERVERS_PER_PACKET;
+	if(Type == SERVERTYPE_NORMAL)
+	{
+		int OldNumPackets = m_vPackets.size();
+		m_vPackets.resize(NumPackets);
+		for(int i = maximum(minimum(OldNumPackets, NumPackets) - 1, 0); i < NumPackets; i++)
+		{
+			int NumEntries = minimum(Num - i * MAX_SERVERS_PER_PACKET, (int)MAX_SERVERS_PER_PACKET);
+			mem_copy(m_vPackets[i].m_Data.m_aHeader, SERVERBROWSE_LIST, sizeof(SERVERBROWSE_LIST));
+			m_vPackets[i].m_Size = sizeof(SERVERBROWSE_LIST) + sizeof(CMastersrvAddr) * NumEntries;
 		}
-		else
+	}
+	else
+	{
+		int OldNumPackets = m_vPacketsLegacy.size();
+		m_vPacketsLegacy.resize(NumPackets);
+		for(int i = maximum(minimum(OldNumPackets, NumPackets) - 1, 0); i < NumPackets; i++)
 		{
-			*pCurrent = m_aServers[m_NumServers - 1];
-			m_NumServers--;
-			dbg_msg("mastersrv", "ERROR: server of invalid type, dropping it");
+			int NumEntries = minimum(Num - i * MAX_SERVERS_PER_PACKET, (int)MAX_SERVERS_PER_PACKET);
+			mem_copy(m_vPacketsLegacy[i].m_Data.m_aHeader, SERVERBROWSE_LIST_LEGACY, sizeof(SERVERBROWSE_LIST_LEGACY));
+			m_vPacketsLegacy[i].m_Size = sizeof(SERVERBROWSE_LIST_LEGACY) + sizeof(CMastersrvAddrLegacy) * NumEntries;
 		}
 	}
 }
@@ -206,88 +239,150 @@ void SendCheck(NETADDR *pAddr)
 
 void AddCheckserver(NETADDR *pInfo, NETADDR *pAlt, ServerType Type)
 {
-	// add server
-	if(m_NumCheckServers == MAX_SERVERS)
+	// already being checked, the pending check covers the new heartbeat
+	auto Existing = m_CheckServers.find(*pInfo);
+	if(Existing != m_CheckServers.end())
 	{
-		dbg_msg("mastersrv", "ERROR: mastersrv is full");
+		Existing->second.m_Type = Type;
+		if(net_addr_comp(&Existing->second.m_AltAddress, pAlt) != 0)
+		{
+			auto Alt = m_CheckServersAlt.find(Existing->second.m_AltAddress);
+			if(Alt != m_CheckServersAlt.end() && net_addr_comp(&Alt->second, pInfo) == 0)
+				m_CheckServersAlt.erase(Alt);
+			Existing->second.m_AltAddress = *pAlt;
+			m_CheckServersAlt[*pAlt] = *pInfo;
+		}
 		return;
 	}
+	if(m_CheckServers.size() >= MAX_SERVERS)
+		return;
 
 	char aAddrStr[NETADDR_MAXSTRSIZE];
 	net_addr_str(pInfo, aAddrStr, sizeof(aAddrStr), true);
 	char aAltAddrStr[NETADDR_MAXSTRSIZE];
 	net_addr_str(pAlt, aAltAddrStr, sizeof(aAltAddrStr), true);
 	dbg_msg("mastersrv", "checking: %s (%s)", aAddrStr, aAltAddrStr);
-	m_aCheckServers[m_NumCheckServers].m_Address = *pInfo;
-	m_aCheckServers[m_NumCheckServers].m_AltAddress = *pAlt;
-	m_aCheckServers[m_NumCheckServers].m_TryCount = 0;
-	m_aCheckServers[m_NumCheckServers].m_TryTime = 0;
-	m_aCheckServers[m_NumCheckServers].m_Type = Type;
-	m_NumCheckServers++;
+
+	CCheckServer *pCheck = &m_CheckServers[*pInfo];
+	pCheck->m_Address = *pInfo;
+	pCheck->m_AltAddress = *pAlt;
+	pCheck->m_TryCount = 0;
+	pCheck->m_TryTime = 0;
+	pCheck->m_Type = Type;
+	m_CheckServersAlt[*pAlt] = *pInfo;
+
+	// due right away
+	CTimeout Timeout = {0, *pInfo};
+	m_CheckQueue.push_front(Timeout);
+}
+
+void RemoveCheckserver(const NETADDR *pAddr)
+{
+	auto Check = m_CheckServers.find(*pAddr);
+	if(Check == m_CheckServers.end())
+		return;
+
+	auto Alt = m_CheckServersAlt.find(Check->second.m_AltAddress);
+	if(Alt != m_CheckServersAlt.end() && net_addr_comp(&Alt->second, pAddr) == 0)
+		m_CheckServersAlt.erase(Alt);
+	m_CheckServers.erase(Check);
 }
 
 void AddServer(NETADDR *pInfo, ServerType Type)
 {
-	// see if server already exists in list
-	for(int i = 0; i < m_NumServers; i++)
+	if(NumServers() >= MAX_SERVERS && m_Servers.find(*pInfo) == m_Servers.end())
 	{
-		if(net_addr_comp(&m_aServers[i].m_Address, pInfo) == 0)
-		{
-			char aAddrStr[NETADDR_MAXSTRSIZE];
-			net_addr_str(pInfo, aAddrStr, sizeof(aAddrStr), true);
-			dbg_msg("mastersrv", "updated: %s", aAddrStr);
-			m_aServers[i].m_Expire = time_get() + time_freq() * EXPIRE_TIME;
-			return;
-		}
+		char aAddrStr[NETADDR_MAXSTRSIZE];
+		net_addr_str(pInfo, aAddrStr, sizeof(aAddrStr), true);
+		dbg_msg("mastersrv", "list full, not adding: %s", aAddrStr);
+		return;
 	}
 
-	// add server
-	if(m_NumServers == MAX_SERVERS)
+	int64 Expire = time_get() + time_freq() * EXPIRE_TIME;
+	CTimeout Timeout = {Expire, *pInfo};
+	m_ExpireQueue.push_back(Timeout);
+
+	// see if server already exists in list
+	auto Existing = m_Servers.find(*pInfo);
+	if(Existing != m_Servers.end())
 	{
-		dbg_msg("mastersrv", "ERROR: mastersrv is full");
+		char aAddrStr[NETADDR_MAXSTRSIZE];
+		net_addr_str(pInfo, aAddrStr, sizeof(aAddrStr), true);
+		dbg_msg("mastersrv", "updated: %s", aAddrStr);
+		Existing->second.m_Expire = Expire;
 		return;
 	}
 
+	// add server
 	char aAddrStr[NETADDR_MAXSTRSIZE];
 	net_addr_str(pInfo, aAddrStr, sizeof(aAddrStr), true);
 	dbg_msg("mastersrv", "added: %s", aAddrStr);
-	m_aServers[m_NumServers].m_Address = *pInfo;
-	m_aServers[m_NumServers].m_Expire = time_get() + time_freq() * EXPIRE_TIME;
-	m_aServers[m_NumServers].m_Type = Type;
-	m_NumServers++;
+	CServerEntry *pEntry = &m_Servers[*pInfo];
+	pEntry->m_Address = *pInfo;
+	pEntry->m_Expire = Expire;
+	pEntry->m_Type = Type;
+	pEntry->m_Index = m_avpServers[Type].size();
+	m_avpServers[Type].push_back(pEntry);
+
+	// only the packet holding the new server changes
+	ResizePackets(Type);
+	WritePacketEntry(Type, pEntry->m_Index);
+}
+
+void RemoveServer(CServerEntry *pEntry)
+{
+	// fill the gap with the last server of the same type
+	int Type = pEntry->m_Type;
+	int Index = pEntry->m_Index;
+	std::vector<CServerEntry *> &vpServers = m_avpServers[Type];
+	vpServers[Index] = vpServers.back();
+	vpServers[Index]->m_Index = Index;
+	vpServers.pop_back();
+
+	if(Index < (int)vpServers.size())
+		WritePacketEntry(Type, Index);
+	ResizePackets(Type);
+	NETADDR Addr = pEntry->m_Address;
+	m_Servers.erase(Addr);
 }
 
 void UpdateServers()
 {
 	int64 Now = time_get();
 	int64 Freq = time_freq();
-	for(int i = 0; i < m_NumCheckServers; i++)
+	while(!m_CheckQueue.empty() && Now > m_CheckQueue.front().m_Time + Freq * CHECK_INTERVAL)
 	{
-		if(Now > m_aCheckServers[i].m_TryTime + Freq)
+		CTimeout Timeout = m_CheckQueue.front();
+		m_CheckQueue.pop_front();
+
+		auto Check = m_CheckServers.find(Timeout.m_Address);
+		if(Check == m_CheckServers.end() || Check->second.m_TryTime != Timeout.m_Time)
+			continue;
+
+		CCheckServer *pCheck = &Check->second;
+		if(pCheck->m_TryCount == CHECK_TRIES)
 		{
-			if(m_aCheckServers[i].m_TryCount == 10)
-			{
-				char aAddrStr[NETADDR_MAXSTRSIZE];
-				net_addr_str(&m_aCheckServers[i].m_Address, aAddrStr, sizeof(aAddrStr), true);
-				char aAltAddrStr[NETADDR_MAXSTRSIZE];
-				net_addr_str(&m_aCheckServers[i].m_AltAddress, aAltAddrStr, sizeof(aAltAddrStr), true);
-				dbg_msg("mastersrv", "check failed: %s (%s)", aAddrStr, aAltAddrStr);
-
-				// FAIL!!
-				SendError(&m_aCheckServers[i].m_Address);
-				m_aCheckServers[i] = m_aCheckServers[m_NumCheckServers - 1];
-				m_NumCheckServers--;
-				i--;
-			}
+			char aAddrStr[NETADDR_MAXSTRSIZE];
+			net_addr_str(&pCheck->m_Address, aAddrStr, sizeof(aAddrStr), true);
+			char aAltAddrStr[NETADDR_MAXSTRSIZE];
+			net_addr_str(&pCheck->m_AltAddress, aAltAddrStr, sizeof(aAltAddrStr), true);
+			dbg_msg("mastersrv", "check failed: %s (%s)", aAddrStr, aAltAddrStr);
+
+			// FAIL!!
+			SendError(&pCheck->m_Address);
+			RemoveCheckserver(&Timeout.m_Address);
+		}
+		else
+		{
+			pCheck->m_TryCount++;
+			pCheck->m_TryTime = Now;
+			if(pCheck->m_TryCount & 1)
+				SendCheck(&pCheck->m_Address);
 			else
-			{
-				m_aCheckServers[i].m_TryCount++;
-				m_aCheckServers[i].m_TryTime = Now;
-				if(m_aCheckServers[i].m_TryCount & 1)
-					SendCheck(&m_aCheckServers[i].m_Address);
-				else
-					SendCheck(&m_aCheckServers[i].m_AltAddress);
-			}
+				SendCheck(&pCheck->m_AltAddress);
+
+			Timeout.m_Time = Now;
+			m_CheckQueue.push_back(Timeout);
 		}
 	}
 }
@@ -295,20 +390,21 @@ void UpdateServers()
 void PurgeServers()
 {
 	int64 Now = time_get();
-	int i = 0;
-	while(i < m_NumServers)
+	while(!m_ExpireQueue.empty() && m_ExpireQueue.front().m_Time < Now)
 	{
-		if(m_aServers[i].m_Expire < Now)
-		{
-			// remove server
-			char aAddrStr[NETADDR_MAXSTRSIZE];
-			net_addr_str(&m_aServers[i].m_Address, aAddrStr, sizeof(aAddrStr), true);
-			dbg_msg("mastersrv", "expired: %s", aAddrStr);
-			m_aServers[i] = m_aServers[m_NumServers - 1];
-			m_NumServers--;
-		}
-		else
-			i++;
+		CTimeout Timeout = m_ExpireQueue.front();
+		m_ExpireQueue.pop_front();
+
+		// refreshed since then
+		auto Server = m_Servers.find(Timeout.m_Address);
+		if(Server == m_Servers.end() || Server->second.m_Expire != Timeout.m_Time)
+			continue;
+
+		// remove server
+		char aAddrStr[NETADDR_MAXSTRSIZE];
+		net_addr_str(&Timeout.m_Address, aAddrStr, sizeof(aAddrStr), true);
+		dbg_msg("mastersrv", "expired: %s", aAddrStr);
+		RemoveServer(&Server->second);
 	}
 }
 
@@ -320,7 +416,7 @@ void ReloadBans()
 
 int main(int argc, const char **argv) // ignore_convention
 {
-	int64 LastBuild = 0, LastBanReload = 0;
+	int64 LastBanReload = 0;
 	ServerType Type = SERVERTYPE_INVALID;
 	NETADDR BindAddr;
 
@@ -420,7 +516,7 @@ int main(int argc, const char **argv) // ignore_convention
 			else if(Packet.m_DataSize == sizeof(SERVERBROWSE_GETCOUNT) &&
 				mem_comp(Packet.m_pData, SERVERBROWSE_GETCOUNT, sizeof(SERVERBROWSE_GETCOUNT)) == 0)
 			{
-				dbg_msg("mastersrv", "count requested, responding with %d", m_NumServers);
+				dbg_msg("mastersrv", "count requested, responding with %d", NumServers());
 
 				CNetChunk p;
 				p.m_ClientID = -1;
@@ -428,14 +524,14 @@ int main(int argc, const char **argv) // ignore_convention
 				p.m_Flags = NETSENDFLAG_CONNLESS;
 				p.m_DataSize = sizeof(m_CountData);
 				p.m_pData = &m_CountData;
-				m_CountData.m_High = (m_NumServers >> 8) & 0xff;
-				m_CountData.m_Low = m_NumServers & 0xff;
+				m_CountData.m_High = (NumServers() >> 8) & 0xff;
+				m_CountData.m_Low = NumServers() & 0xff;
 				m_NetOp.Send(&p);
 			}
 			else if(Packet.m_DataSize == sizeof(SERVERBROWSE_GETCOUNT_LEGACY) &&
 				mem_comp(Packet.m_pData, SERVERBROWSE_GETCOUNT_LEGACY, sizeof(SERVERBROWSE_GETCOUNT_LEGACY)) == 0)
 			{
-				dbg_msg("mastersrv", "count requested, responding with %d", m_NumServers);
+				dbg_msg("mastersrv", "count requested, responding with %d", NumServers());
 
 				CNetChunk p;
 				p.m_ClientID = -1;
@@ -443,25 +539,25 @@ int main(int argc, const char **argv) // ignore_convention
 				p.m_Flags = NETSENDFLAG_CONNLESS;
 				p.m_DataSize = sizeof(m_CountData);
 				p.m_pData = &m_CountDataLegacy;
-				m_CountDataLegacy.m_High = (m_NumServers >> 8) & 0xff;
-				m_CountDataLegacy.m_Low = m_NumServers & 0xff;
+				m_CountDataLegacy.m_High = (NumServers() >> 8) & 0xff;
+				m_CountDataLegacy.m_Low = NumServers() & 0xff;
 				m_NetOp.Send(&p);
 			}
 			else if(Packet.m_DataSize == sizeof(SERVERBROWSE_GETLIST) &&
 				mem_comp(Packet.m_pData, SERVERBROWSE_GETLIST, sizeof(SERVERBROWSE_GETLIST)) == 0)
 			{
 				// someone requested the list
-				dbg_msg("mastersrv", "requested, responding with %d m_aServers", m_NumServers);
+				dbg_msg("mastersrv", "requested, responding with %d m_aServers", NumServers());
 
 				CNetChunk p;
 				p.m_ClientID = -1;
 				p.m_Address = Packet.m_Address;
 				p.m_Flags = NETSENDFLAG_CONNLESS;
 
-				for(int i = 0; i < m_NumPackets; i++)
+				for(auto &Data : m_vPackets)
 				{
-					p.m_DataSize = m_aPackets[i].m_Size;
-					p.m_pData = &m_aPackets[i].m_Data;
+					p.m_DataSize = Data.m_Size;
+					p.m_pData = &Data.m_Data;
 					m_NetOp.Send(&p);
 				}
 			}
@@ -469,17 +565,17 @@ int main(int argc, const char **argv) // ignore_convention
 				mem_comp(Packet.m_pData, SERVERBROWSE_GETLIST_LEGACY, sizeof(SERVERBROWSE_GETLIST_LEGACY)) == 0)
 			{
 				// someone requested the list
-				dbg_msg("mastersrv", "requested, responding with %d m_aServers", m_NumServers);
+				dbg_msg("mastersrv", "requested, responding with %d m_aServers", NumServers());
 
 				CNetChunk p;
 				p.m_ClientID = -1;
 				p.m_Address = Packet.m_Address;
 				p.m_Flags = NETSENDFLAG_CONNLESS;
 
-				for(int i = 0; i < m_NumPacketsLegacy; i++)
+				for(auto &Data : m_vPacketsLegacy)
 				{
-					p.m_DataSize = m_aPacketsLegacy[i].m_Size;
-					p.m_pData = &m_aPacketsLegacy[i].m_Data;
+					p.m_DataSize = Data.m_Size;
+					p.m_pData = &Data.m_Data;
 					m_NetOp.Send(&p);
 				}
 			}
@@ -497,16 +593,18 @@ int main(int argc, const char **argv) // ignore_convention
 			{
 				Type = SERVERTYPE_INVALID;
 				// remove it from checking
-				for(int i = 0; i < m_NumCheckServers; i++)
+				auto Check = m_CheckServers.find(Packet.m_Address);
+				if(Check == m_CheckServers.end())
 				{
-					if(net_addr_comp(&m_aCheckServers[i].m_Address, &Packet.m_Address) == 0 ||
-						net_addr_comp(&m_aCheckServers[i].m_AltAddress, &Packet.m_Address) == 0)
-					{
-						Type = m_aCheckServers[i].m_Type;
-						m_NumCheckServers--;
-						m_aCheckServers[i] = m_aCheckServers[m_NumCheckServers];
-						break;
-					}
+					auto Alt = m_CheckServersAlt.find(Packet.m_Address);
+					if(Alt != m_CheckServersAlt.end())
+						Check = m_CheckServers.find(Alt->second);
+				}
+				if(Check != m_CheckServers.end())
+				{
+					Type = Check->second.m_Type;
+					NETADDR CheckAddr = Check->first;
+					RemoveCheckserver(&CheckAddr);
 				}
 
 				// drops servers that were not in the CheckServers list
@@ -525,14 +623,10 @@ int main(int argc, const char **argv) // ignore_convention
 			ReloadBans();
 		}
 
-		if(time_get() - LastBuild > time_freq() * 5)
-		{
-			LastBuild = time_get();
-
-			PurgeServers();
-			UpdateServers();
-			BuildPackets();
-		}
+		// only touches servers that are due, so it's cheap to do every
+		// iteration and spreads the checks out instead of sending bursts
+		PurgeServers();
+		UpdateServers();
 
 		// be nice to the CPU
 		thread_sleep(1000);
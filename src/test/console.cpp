@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/config.h>
+#include <engine/shared/console.h>
+
+struct CRecorded
+{
+	int m_Calls;
+	int m_NumArgs;
+	char m_aArg0[64];
+	int m_Arg1;
+	char m_aRest[64];
+};
+
+static void ConRecord(IConsole::IResult *pResult, void *pUserData)
+{
+	CRecorded *pRecorded = (CRecorded *)pUserData;
+	pRecorded->m_Calls++;
+	pRecorded->m_NumArgs = pResult->NumArguments();
+	str_copy(pRecorded->m_aArg0, pResult->GetString(0), sizeof(pRecorded->m_aArg0));
+	pRecorded->m_Arg1 = pResult->GetInteger(1);
+	str_copy(pRecorded->m_aRest, pResult->GetString(2), sizeof(pRecorded->m_aRest));
+}
+
+TEST(Console, FindCommandNoCase)
+{
+	CConsole Console(CFGFLAG_SERVER);
+	Console.StoreCommands(false);
+	CRecorded Recorded = {};
+	Console.Register("test_record", "s[name] i[number] ?r[rest]", CFGFLAG_SERVER, ConRecord, &Recorded, "");
+
+	Console.ExecuteLine("Test_Record abc 5");
+	EXPECT_EQ(Recorded.m_Calls, 1);
+	EXPECT_STREQ(Recorded.m_aArg0, "abc");
+	EXPECT_EQ(Recorded.m_Arg1, 5);
+	EXPECT_TRUE(Console.GetCommandInfo("TEST_RECORD", CFGFLAG_SERVER, false));
+	EXPECT_FALSE(Console.GetCommandInfo("test_record", CFGFLAG_CLIENT, false));
+}
+
+TEST(Console, ParseCacheRepeated)
+{
+	CConsole Console(CFGFLAG_SERVER);
+	Console.StoreCommands(false);
+	CRecorded Recorded = {};
+	Console.Register("test_record", "s[name] i[number] ?r[rest]", CFGFLAG_SERVER, ConRecord, &Recorded, "");
+
+	for(int i = 0; i < 3; i++)
+	{
+		Console.ExecuteLine("test_record \"quoted \\\"arg\\\"\" 7 some rest; test_record x 1");
+		EXPECT_STREQ(Recorded.m_aArg0, "x");
+		EXPECT_EQ(Recorded.m_NumArgs, 2);
+
+		Console.ExecuteLine("test_record \"quoted \\\"arg\\\"\" 7 some rest");
+		EXPECT_STREQ(Recorded.m_aArg0, "quoted \"arg\"");
+		EXPECT_EQ(Recorded.m_Arg1, 7);
+		EXPECT_STREQ(Recorded.m_aRest, "some rest");
+		EXPECT_EQ(Recorded.m_NumArgs, 3);
+	}
+	EXPECT_EQ(Recorded.m_Calls, 9);
+}
+
+TEST(Console, ParseCacheTempCommands)
+{
+	CConsole Console(CFGFLAG_SERVER);
+	Console.StoreCommands(false);
+	CRecorded Recorded = {};
+
+	Console.RegisterTemp("temp_cmd", "i[number]", CFGFLAG_SERVER, "");
+	EXPECT_TRUE(Console.GetCommandInfo("temp_cmd", CFGFLAG_SERVER, true));
+	Console.DeregisterTemp("temp_cmd");
+	EXPECT_FALSE(Console.GetCommandInfo("temp_cmd", CFGFLAG_SERVER, true));
+
+	Console.RegisterTemp("temp_cmd", "i[number]", CFGFLAG_SERVER, "");
+	Console.RegisterTemp("temp_cmd2", "i[number]", CFGFLAG_SERVER, "");
+	Console.DeregisterTempAll();
+	EXPECT_FALSE(Console.GetCommandInfo("temp_cmd", CFGFLAG_SERVER, true));
+	EXPECT_FALSE(Console.GetCommandInfo("temp_cmd2", CFGFLAG_SERVER, true));
+
+	// re-registering with different parameters must not reuse cached parses
+	Console.Register("test_record", "s[name] i[number]", CFGFLAG_SERVER, ConRecord, &Recorded, "");
+	Console.ExecuteLine("test_record a 3");
+	EXPECT_EQ(Recorded.m_NumArgs, 2);
+	Console.Register("test_record", "r[rest]", CFGFLAG_SERVER, ConRecord, &Recorded, "");
+	Console.ExecuteLine("test_record a 3");
+	EXPECT_EQ(Recorded.m_NumArgs, 1);
+	EXPECT_STREQ(Recorded.m_aArg0, "a 3");
+}
@@ -2,6 +2,7 @@
 #include <gtest/gtest.h>
 
 #include <engine/shared/datafile.h>
+#include <engine/shared/jobs.h>
 #include <engine/storage.h>
 #include <game/mapitems_ex.h>
 
@@ -59,3 +60,61 @@ TEST(Datafile, ExtendedType)
 
 	delete pStorage;
 }
+
+TEST(Datafile, JobPoolCompression)
+{
+	IStorage *pStorage = CreateLocalStorage();
+	CTestInfo Info;
+	char aFilename[2][128];
+	str_format(aFilename[0], sizeof(aFilename[0]), "%s-sync", Info.m_aFilename);
+	str_format(aFilename[1], sizeof(aFilename[1]), "%s-pool", Info.m_aFilename);
+
+	CJobPool Pool;
+	Pool.Init(4);
+
+	int aaData[8][1024];
+	for(int i = 0; i < 8; i++)
+		for(int j = 0; j < 1024; j++)
+			aaData[i][j] = i * j % 7;
+
+	for(int f = 0; f < 2; f++)
+	{
+		CDataFileWriter Writer;
+		ASSERT_TRUE(Writer.Open(pStorage, aFilename[f]));
+		if(f == 1)
+			Writer.SetJobPool(&Pool);
+		for(int i = 0; i < 8; i++)
+		{
+			// the data may change right after adding it
+			int aData[1024];
+			mem_copy(aData, aaData[i], sizeof(aData));
+			Writer.AddData(sizeof(aData), aData);
+			mem_zero(aData, sizeof(aData));
+		}
+		Writer.Finish();
+	}
+
+	{
+		CDataFileReader Reader;
+		ASSERT_TRUE(Reader.Open(pStorage, aFilename[1], IStorage::TYPE_ALL));
+		ASSERT_EQ(Reader.NumData(), 8);
+		for(int i = 0; i < 8; i++)
+		{
+			ASSERT_EQ(Reader.GetDataSize(i), (int)sizeof(aaData[i]));
+			EXPECT_EQ(mem_comp(Reader.GetData(i), aaData[i], sizeof(aaData[i])), 0);
+		}
+
+		// same file as with compression on the calling thread
+		CDataFileReader SyncReader;
+		ASSERT_TRUE(SyncReader.Open(pStorage, aFilename[0], IStorage::TYPE_ALL));
+		EXPECT_EQ(SyncReader.Sha256(), Reader.Sha256());
+	}
+
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile(aFilename[0], IStorage::TYPE_SAVE);
+		pStorage->RemoveFile(aFilename[1], IStorage::TYPE_SAVE);
+	}
+
+	delete pStorage;
+}
@@ -0,0 +1,114 @@
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include <engine/shared/demoindex.h>
+
+static CDemoIndex::CEntry MakeEntry(int NumMarkers)
+{
+	CDemoIndex::CEntry Entry;
+	mem_zero(&Entry, sizeof(Entry));
+	Entry.m_Size = 1234;
+	Entry.m_Time = 5678;
+	Entry.m_Valid = true;
+	str_copy((char *)Entry.m_Header.m_aMarker, "TWDEMO", sizeof(Entry.m_Header.m_aMarker));
+	Entry.m_Header.m_Version = 6;
+	str_copy(Entry.m_Header.m_aMapName, "Tutorial", sizeof(Entry.m_Header.m_aMapName));
+	Entry.m_Header.m_aMapSize[3] = 42;
+	Entry.m_Header.m_aMapCrc[0] = 0x12;
+	Entry.m_Header.m_aLength[3] = 90;
+	Entry.m_TimelineMarkers.m_aNumTimelineMarkers[3] = NumMarkers;
+	for(int i = 0; i < NumMarkers; i++)
+		Entry.m_TimelineMarkers.m_aTimelineMarkers[i][3] = i + 1;
+	Entry.m_MapInfo.m_Sha256.data[0] = 0xab;
+	return Entry;
+}
+
+static void SaveLoad(CDemoIndex *pIndex, CDemoIndex *pLoaded)
+{
+	CTestInfo Info;
+	IOHANDLE File = io_open(Info.m_aFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	EXPECT_TRUE(pIndex->Save(File));
+	io_close(File);
+
+	File = io_open(Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	EXPECT_TRUE(pLoaded->Load(File));
+	io_close(File);
+	fs_remove(Info.m_aFilename);
+}
+
+TEST(DemoIndex, SaveLoad)
+{
+	CDemoIndex Index;
+	EXPECT_FALSE(Index.Modified());
+	Index.Add("demos/a.demo", 0, MakeEntry(3));
+	Index.Add("demos/b.demo", 1, MakeEntry(0));
+	EXPECT_TRUE(Index.Modified());
+
+	CDemoIndex Loaded;
+	SaveLoad(&Index, &Loaded);
+	EXPECT_FALSE(Index.Modified());
+	EXPECT_FALSE(Loaded.Modified());
+	ASSERT_EQ(Loaded.Num(), 2);
+
+	CDemoIndex::CEntry Expected = MakeEntry(3);
+	CDemoIndex::CEntry Entry;
+	ASSERT_TRUE(Loaded.Find("demos/a.demo", 0, 1234, 5678, &Entry));
+	EXPECT_TRUE(Entry.m_Valid);
+	EXPECT_EQ(mem_comp(&Entry.m_Header, &Expected.m_Header, sizeof(Entry.m_Header)), 0);
+	EXPECT_EQ(mem_comp(&Entry.m_TimelineMarkers, &Expected.m_TimelineMarkers, sizeof(Entry.m_TimelineMarkers)), 0);
+	EXPECT_STREQ(Entry.m_MapInfo.m_aName, "Tutorial");
+	EXPECT_EQ(Entry.m_MapInfo.m_Size, 42);
+	EXPECT_EQ(Entry.m_MapInfo.m_Crc, 0x12000000);
+	EXPECT_EQ(Entry.m_MapInfo.m_Sha256.data[0], 0xab);
+
+	// changed or unknown demos aren't found
+	EXPECT_TRUE(Loaded.Find("demos/b.demo", 1, 1234, 5678, &Entry));
+	EXPECT_FALSE(Loaded.Find("demos/b.demo", 0, 1234, 5678, &Entry));
+	EXPECT_FALSE(Loaded.Find("demos/a.demo", 0, 1235, 5678, &Entry));
+	EXPECT_FALSE(Loaded.Find("demos/a.demo", 0, 1234, 5679, &Entry));
+	EXPECT_FALSE(Loaded.Find("demos/c.demo", 0, 1234, 5678, &Entry));
+}
+
+TEST(DemoIndex, RemoveMissing)
+{
+	CDemoIndex Index;
+	Index.Add("demos/a.demo", 0, MakeEntry(0));
+	Index.Add("demos/b.demo", 0, MakeEntry(0));
+	Index.Add("demos/b.demo", 1, MakeEntry(0));
+	Index.Add("demos/auto/c.demo", 0, MakeEntry(0));
+	Index.Add("demosx/d.demo", 0, MakeEntry(0));
+
+	// only demos directly in the folder are affected
+	std::vector<std::pair<std::string, int>> vDemos;
+	vDemos.emplace_back("demos/b.demo", 1);
+	Index.RemoveMissing("demos", vDemos);
+	EXPECT_EQ(Index.Num(), 3);
+
+	CDemoIndex::CEntry Entry;
+	EXPECT_FALSE(Index.Find("demos/a.demo", 0, 1234, 5678, &Entry));
+	EXPECT_FALSE(Index.Find("demos/b.demo", 0, 1234, 5678, &Entry));
+	EXPECT_TRUE(Index.Find("demos/b.demo", 1, 1234, 5678, &Entry));
+	EXPECT_TRUE(Index.Find("demos/auto/c.demo", 0, 1234, 5678, &Entry));
+	EXPECT_TRUE(Index.Find("demosx/d.demo", 0, 1234, 5678, &Entry));
+}
+
+TEST(DemoIndex, Invalid)
+{
+	CTestInfo Info;
+	IOHANDLE File = io_open(Info.m_aFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	const char aGarbage[] = "this is not a demo index at all";
+	io_write(File, aGarbage, sizeof(aGarbage));
+	io_close(File);
+
+	CDemoIndex Index;
+	Index.Add("demos/a.demo", 0, MakeEntry(0));
+	File = io_open(Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	EXPECT_FALSE(Index.Load(File));
+	io_close(File);
+	fs_remove(Info.m_aFilename);
+	EXPECT_EQ(Index.Num(), 0);
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/shared/dilate.h>
+#include <engine/shared/jobs.h>
+
+#include <vector>
+
+// the original implementation, DilateImage must match it exactly
+static void ReferenceDilate(int w, int h, int BPP, unsigned char *pSrc, unsigned char *pDest)
+{
+	const int xo[] = {0, -1, 1, 0};
+	const int yo[] = {-1, 0, 0, 1};
+	int AlphaCompIndex = BPP - 1;
+	int m = 0;
+	for(int y = 0; y < h; y++)
+	{
+		for(int x = 0; x < w; x++, m += BPP)
+		{
+			for(int i = 0; i < BPP; ++i)
+				pDest[m + i] = pSrc[m + i];
+			if(pSrc[m + AlphaCompIndex] > 30)
+				continue;
+			for(int c = 0; c < 4; c++)
+			{
+				int ix = clamp(x + xo[c], 0, w - 1);
+				int iy = clamp(y + yo[c], 0, h - 1);
+				int k = iy * w * BPP + ix * BPP;
+				if(pSrc[k + AlphaCompIndex] > 30)
+				{
+					for(int p = 0; p < BPP - 1; ++p)
+						pDest[m + p] = pSrc[k + p];
+					pDest[m + AlphaCompIndex] = 255;
+					break;
+				}
+			}
+		}
+	}
+}
+
+static void ReferenceDilateImage(unsigned char *pImageBuff, int w, int h, int BPP)
+{
+	std::vector<unsigned char> vBuffer0(w * h * BPP);
+	std::vector<unsigned char> vBuffer1(w * h * BPP);
+	ReferenceDilate(w, h, BPP, pImageBuff, &vBuffer0[0]);
+	for(int i = 0; i < 5; i++)
+	{
+		ReferenceDilate(w, h, BPP, &vBuffer0[0], &vBuffer1[0]);
+		ReferenceDilate(w, h, BPP, &vBuffer1[0], &vBuffer0[0]);
+	}
+	for(int i = 0; i < w * h; i++)
+		for(int c = 0; c < BPP - 1; c++)
+			pImageBuff[i * BPP + c] = vBuffer0[i * BPP + c];
+}
+
+static void ExpectSameAsReference(int w, int h, int BPP, CJobPool *pJobPool)
+{
+	// a few opaque pixels in a mostly transparent image, like a tileset
+	unsigned Seed = w * 31 + h * 17 + BPP;
+	std::vector<unsigned char> vImage(w * h * BPP);
+	for(unsigned i = 0; i < vImage.size(); i++)
+	{
+		Seed = Seed * 1103515245 + 12345;
+		vImage[i] = Seed >> 16;
+		if(i % BPP == (unsigned)BPP - 1 && (Seed >> 8) % 16 != 0)
+			vImage[i] %= 31;
+	}
+	std::vector<unsigned char> vExpected = vImage;
+	ReferenceDilateImage(&vExpected[0], w, h, BPP);
+	DilateImage(&vImage[0], w, h, BPP, pJobPool);
+	EXPECT_TRUE(vImage == vExpected) << "w=" << w << " h=" << h << " BPP=" << BPP;
+}
+
+TEST(Dilate, SameAsReference)
+{
+	const int aaSizes[][2] = {{1, 1}, {2, 5}, {3, 3}, {17, 9}, {9, 17}, {130, 70}};
+	for(const auto &Size : aaSizes)
+	{
+		ExpectSameAsReference(Size[0], Size[1], 4, 0);
+		ExpectSameAsReference(Size[0], Size[1], 3, 0);
+	}
+}
+
+TEST(Dilate, JobPool)
+{
+	CJobPool Pool;
+	Pool.Init(3);
+	ExpectSameAsReference(64, 300, 4, &Pool);
+	ExpectSameAsReference(33, 257, 3, &Pool);
+	ExpectSameAsReference(5, 1000, 4, &Pool);
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include <game/server/entitypool.h>
+
+#include <vector>
+
+struct CObject
+{
+	int m_aData[10];
+};
+
+TEST(EntityPool, Allocate)
+{
+	CEntityPool Pool(sizeof(CObject));
+	std::vector<CObject *> vpObjects;
+	for(int i = 0; i < 1000; i++)
+	{
+		CObject *pObject = (CObject *)Pool.Allocate();
+		ASSERT_TRUE(pObject);
+		EXPECT_EQ((uintptr_t)pObject % 16, 0u);
+		for(int Value : pObject->m_aData)
+			EXPECT_EQ(Value, 0);
+		pObject->m_aData[9] = i;
+		vpObjects.push_back(pObject);
+	}
+	EXPECT_EQ(Pool.Num(), 1000);
+	EXPECT_GE(Pool.NumSlots(), 1000);
+
+	for(int i = 0; i < 1000; i++)
+	{
+		EXPECT_EQ(vpObjects[i]->m_aData[9], i);
+		EXPECT_EQ(CEntityPool::PoolOf(vpObjects[i]), &Pool);
+		EXPECT_EQ(Pool.Get(CEntityPool::IndexOf(vpObjects[i])), vpObjects[i]);
+	}
+
+	// the last freed slot is used first
+	Pool.Free(vpObjects[500]);
+	Pool.Free(vpObjects[10]);
+	EXPECT_EQ(Pool.Num(), 998);
+	EXPECT_EQ(Pool.Allocate(), vpObjects[10]);
+	CObject *pReused = (CObject *)Pool.Allocate();
+	EXPECT_EQ(pReused, vpObjects[500]);
+	EXPECT_EQ(pReused->m_aData[9], 0);
+	Pool.Free(0);
+	EXPECT_EQ(Pool.Num(), 1000);
+}
+
+TEST(EntityPool, Handle)
+{
+	CEntityPool Pool(sizeof(CObject));
+	CObject *pObject = (CObject *)Pool.Allocate();
+	CEntityHandle<CObject> Handle = pObject;
+	CEntityHandle<CObject> Copy = Handle;
+	EXPECT_EQ(Handle.Get(), pObject);
+	EXPECT_TRUE(Handle == Copy);
+
+	// a new object in the same slot isn't found through the old handle
+	Pool.Free(pObject);
+	EXPECT_FALSE(Handle.Get());
+	CObject *pNew = (CObject *)Pool.Allocate();
+	ASSERT_EQ(pNew, pObject);
+	EXPECT_FALSE(Handle.Get());
+	CEntityHandle<CObject> NewHandle = pNew;
+	EXPECT_EQ(NewHandle.Get(), pNew);
+	EXPECT_TRUE(NewHandle != Handle);
+
+	NewHandle = 0;
+	EXPECT_FALSE(NewHandle.Get());
+	EXPECT_FALSE(CEntityHandle<CObject>().Get());
+}
+
+TEST(EntityPool, Fixed)
+{
+	CEntityPool Pool(sizeof(CObject), 64);
+	EXPECT_EQ(Pool.NumSlots(), 64);
+	CObject *pObject = (CObject *)Pool.Allocate(42);
+	EXPECT_EQ(CEntityPool::IndexOf(pObject), 42);
+	EXPECT_EQ(Pool.Get(42), pObject);
+	EXPECT_FALSE(Pool.Get(41));
+	pObject->m_aData[0] = 7;
+
+	CEntityHandle<CObject> Handle = pObject;
+	Pool.Free(pObject);
+	EXPECT_EQ(pObject->m_aData[0], 0);
+	EXPECT_FALSE(Pool.Get(42));
+	EXPECT_EQ(Pool.Allocate(42), pObject);
+	EXPECT_FALSE(Handle.Get());
+}
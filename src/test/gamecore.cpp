@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <game/collision.h>
+#include <game/gamecore.h>
+#include <game/layers.h>
+#include <game/teamscore.h>
+
+#include <vector>
+
+enum
+{
+	MAP_WIDTH = 80,
+	MAP_HEIGHT = 40,
+	NUM_TICKS = 2000,
+};
+
+// a map with only a game layer, walls around it and a few platforms
+class CTestMap : public IMap
+{
+	CMapItemGroup m_Group;
+	CMapItemLayerTilemap m_Layer;
+	std::vector<CTile> m_vTiles;
+
+public:
+	CTestMap()
+	{
+		mem_zero(&m_Group, sizeof(m_Group));
+		m_Group.m_Version = CMapItemGroup::CURRENT_VERSION;
+		m_Group.m_NumLayers = 1;
+
+		mem_zero(&m_Layer, sizeof(m_Layer));
+		m_Layer.m_Layer.m_Type = LAYERTYPE_TILES;
+		m_Layer.m_Width = MAP_WIDTH;
+		m_Layer.m_Height = MAP_HEIGHT;
+		m_Layer.m_Flags = TILESLAYERFLAG_GAME;
+
+		CTile Empty;
+		mem_zero(&Empty, sizeof(Empty));
+		m_vTiles.resize(MAP_WIDTH * MAP_HEIGHT, Empty);
+		for(int y = 0; y < MAP_HEIGHT; y++)
+		{
+			for(int x = 0; x < MAP_WIDTH; x++)
+			{
+				bool Border = x < 2 || x >= MAP_WIDTH - 2 || y < 2 || y >= MAP_HEIGHT - 2;
+				bool Platform = y % 8 == 0 && x % 20 < 12;
+				if(Border || Platform)
+					m_vTiles[y * MAP_WIDTH + x].m_Index = x % 7 == 0 && !Border ? TILE_NOHOOK : TILE_SOLID;
+			}
+		}
+	}
+
+	void *GetData(int Index) { return Index == 0 ? &m_vTiles[0] : 0; }
+	int GetDataSize(int Index) { return Index == 0 ? m_vTiles.size() * sizeof(CTile) : 0; }
+	void *GetDataSwapped(int Index) { return GetData(Index); }
+	void UnloadData(int Index) {}
+	void *GetItem(int Index, int *pType, int *pID)
+	{
+		if(Index == 0)
+			return &m_Group;
+		if(Index == 1)
+			return &m_Layer;
+		return 0;
+	}
+	int GetItemSize(int Index) { return Index == 0 ? sizeof(m_Group) : Index == 1 ? sizeof(m_Layer) : 0; }
+	void GetType(int Type, int *pStart, int *pNum)
+	{
+		*pStart = Type == MAPITEMTYPE_GROUP ? 0 : 1;
+		*pNum = Type == MAPITEMTYPE_GROUP || Type == MAPITEMTYPE_LAYER ? 1 : 0;
+	}
+	void *FindItem(int Type, int ID) { return 0; }
+	int NumItems() { return 2; }
+};
+
+class CTestWorld
+{
+public:
+	CWorldCore m_Core;
+	CTeamsCore m_Teams;
+	CCharacterCore m_aCharacters[MAX_CLIENTS];
+
+	CTestWorld(CCollision *pCollision, bool BroadPhase)
+	{
+		m_Core.m_BroadPhase = BroadPhase;
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			m_aCharacters[i].Init(&m_Core, pCollision, &m_Teams);
+			m_aCharacters[i].Reset();
+			m_aCharacters[i].m_Id = i;
+			m_aCharacters[i].m_Pos = vec2((4 + (i % 32) * 2) * 32.0f + 16.0f, (i < 32 ? 6 : 14) * 32.0f + 16.0f);
+			m_Core.m_apCharacters[i] = &m_aCharacters[i];
+		}
+	}
+
+	void Tick(const CNetObj_PlayerInput *pInputs)
+	{
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			if(!m_Core.m_apCharacters[i])
+				continue;
+			m_aCharacters[i].m_Input = pInputs[i];
+			m_aCharacters[i].Tick(true);
+		}
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			if(!m_Core.m_apCharacters[i])
+				continue;
+			m_aCharacters[i].Move();
+			m_aCharacters[i].Quantize();
+		}
+	}
+};
+
+// the recorded inputs, players run around, jump and hook in random directions
+static void GenerateInputs(std::vector<CNetObj_PlayerInput> *pvInputs, unsigned Seed)
+{
+	pvInputs->resize(NUM_TICKS * MAX_CLIENTS);
+	CNetObj_PlayerInput *pInput = &(*pvInputs)[0];
+	for(int t = 0; t < NUM_TICKS; t++)
+	{
+		for(int i = 0; i < MAX_CLIENTS; i++, pInput++)
+		{
+			// keep most of the input for a few ticks
+			if(t > 0 && t % 10 != i % 10)
+			{
+				*pInput = *(pInput - MAX_CLIENTS);
+				continue;
+			}
+			Seed = Seed * 1103515245 + 12345;
+			mem_zero(pInput, sizeof(*pInput));
+			pInput->m_Direction = (int)((Seed >> 8) % 3) - 1;
+			pInput->m_TargetX = (int)((Seed >> 10) % 400) - 200;
+			pInput->m_TargetY = (int)((Seed >> 12) % 400) - 200;
+			pInput->m_Jump = (Seed >> 20) % 4 == 0;
+			pInput->m_Hook = (Seed >> 22) % 3 != 0;
+		}
+	}
+}
+
+static void ExpectSameCharacter(const CCharacterCore *pExpected, const CCharacterCore *pCore, int Tick, int ClientID)
+{
+	// the tick isn't part of the core
+	CNetObj_CharacterCore Expected, Core;
+	mem_zero(&Expected, sizeof(Expected));
+	mem_zero(&Core, sizeof(Core));
+	const_cast<CCharacterCore *>(pExpected)->Write(&Expected);
+	const_cast<CCharacterCore *>(pCore)->Write(&Core);
+	EXPECT_EQ(mem_comp(&Expected, &Core, sizeof(Core)), 0) << "Tick=" << Tick << " ClientID=" << ClientID;
+	EXPECT_EQ(mem_comp(&pExpected->m_Vel, &pCore->m_Vel, sizeof(pCore->m_Vel)), 0) << "Tick=" << Tick << " ClientID=" << ClientID;
+	EXPECT_EQ(pExpected->m_HookedPlayer, pCore->m_HookedPlayer) << "Tick=" << Tick << " ClientID=" << ClientID;
+	EXPECT_EQ(pExpected->m_TriggeredEvents, pCore->m_TriggeredEvents) << "Tick=" << Tick << " ClientID=" << ClientID;
+}
+
+TEST(GameCore, BroadPhaseReplay)
+{
+	CTestMap Map;
+	CLayers Layers;
+	Layers.InitBackground(&Map);
+	CCollision Collision;
+	Collision.Init(&Layers);
+
+	std::vector<CNetObj_PlayerInput> vInputs;
+	GenerateInputs(&vInputs, 1);
+
+	CTestWorld *pExpected = new CTestWorld(&Collision, false);
+	CTestWorld *pWorld = new CTestWorld(&Collision, true);
+	int NumHooked = 0;
+	for(int t = 0; t < NUM_TICKS; t++)
+	{
+		// players leave and come back, some of them play solo
+		int ClientID = t % MAX_CLIENTS;
+		if(t % 97 == 96)
+		{
+			pExpected->m_Core.m_apCharacters[ClientID] = 0;
+			pWorld->m_Core.m_apCharacters[ClientID] = 0;
+		}
+		else if(t % 97 == 49)
+		{
+			int Rejoin = (t - 50) % MAX_CLIENTS;
+			pExpected->m_Core.m_apCharacters[Rejoin] = &pExpected->m_aCharacters[Rejoin];
+			pWorld->m_Core.m_apCharacters[Rejoin] = &pWorld->m_aCharacters[Rejoin];
+		}
+		if(t % 211 == 0)
+		{
+			pExpected->m_aCharacters[ClientID].m_Solo = !pExpected->m_aCharacters[ClientID].m_Solo;
+			pWorld->m_aCharacters[ClientID].m_Solo = !pWorld->m_aCharacters[ClientID].m_Solo;
+		}
+
+		pExpected->Tick(&vInputs[t * MAX_CLIENTS]);
+		pWorld->Tick(&vInputs[t * MAX_CLIENTS]);
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			ExpectSameCharacter(&pExpected->m_aCharacters[i], &pWorld->m_aCharacters[i], t, i);
+			if(pWorld->m_aCharacters[i].m_HookedPlayer != -1)
+				NumHooked++;
+		}
+		if(::testing::Test::HasFailure())
+			break;
+	}
+	// the replay has to cover players hooking each other
+	EXPECT_GT(NumHooked, 0);
+	delete pExpected;
+	delete pWorld;
+}
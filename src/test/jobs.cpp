@@ -106,3 +106,179 @@ TEST_F(Jobs, Many)
 	}
 	new(&m_Pool) CJobPool();
 }
+
+TEST(JobsPool, PriorityOrder)
+{
+	// the only worker is busy until all jobs are queued
+	CJobPool Pool;
+	Pool.Init(1);
+	std::atomic<bool> Release(false);
+	auto pBlocker = std::make_shared<CJob>([&] {
+		while(!Release)
+			thread_yield();
+	});
+	Pool.Add(pBlocker);
+
+	SEMAPHORE Sphore;
+	sphore_init(&Sphore);
+	std::vector<int> vOrder;
+	auto pLow = std::make_shared<CJob>([&] {
+		vOrder.push_back(CJobPool::PRIORITY_LOW);
+		sphore_signal(&Sphore);
+	});
+	auto pNormal = std::make_shared<CJob>([&] { vOrder.push_back(CJobPool::PRIORITY_NORMAL); });
+	auto pHigh = std::make_shared<CJob>([&] { vOrder.push_back(CJobPool::PRIORITY_HIGH); });
+	Pool.Add(pLow, CJobPool::PRIORITY_LOW);
+	Pool.Add(pNormal, CJobPool::PRIORITY_NORMAL);
+	Pool.Add(pHigh, CJobPool::PRIORITY_HIGH);
+	Release = true;
+	sphore_wait(&Sphore);
+	sphore_destroy(&Sphore);
+	ASSERT_EQ(vOrder.size(), 3u);
+	EXPECT_EQ(vOrder[0], CJobPool::PRIORITY_HIGH);
+	EXPECT_EQ(vOrder[1], CJobPool::PRIORITY_NORMAL);
+	EXPECT_EQ(vOrder[2], CJobPool::PRIORITY_LOW);
+}
+
+TEST(JobsPool, WaitOnlyRunsItsJob)
+{
+	// without threads, jobs only run when waiting for them
+	CJobPool Pool;
+	Pool.Init(0);
+	auto pOther = std::make_shared<CJob>([] {});
+	auto pJob = std::make_shared<CJob>([] {});
+	Pool.Add(pOther, CJobPool::PRIORITY_HIGH);
+	Pool.Add(pJob, CJobPool::PRIORITY_LOW);
+	Pool.Wait(pJob);
+	EXPECT_EQ(pJob->Status(), IJob::STATE_DONE);
+	EXPECT_EQ(pOther->Status(), IJob::STATE_PENDING);
+	Pool.Wait(pOther);
+	EXPECT_EQ(pOther->Status(), IJob::STATE_DONE);
+}
+
+TEST(JobsPool, WaitBlocksForRunningJob)
+{
+	// the waiting thread must not pick up the queued download
+	CJobPool Pool;
+	Pool.Init(1);
+	std::atomic<bool> Started(false);
+	std::atomic<bool> Release(false);
+	auto pRunning = std::make_shared<CJob>([&] {
+		Started = true;
+		while(!Release)
+			thread_yield();
+	});
+	auto pDownload = std::make_shared<CJob>([] {});
+	Pool.Add(pRunning);
+	while(!Started)
+		thread_yield();
+	Pool.Add(pDownload, CJobPool::PRIORITY_LOW);
+
+	void *pThread = thread_init([](void *pUser) {
+		thread_sleep(50000);
+		*(std::atomic<bool> *)pUser = true;
+	},
+		&Release, "release");
+	Pool.Wait(pRunning);
+	thread_wait(pThread);
+	EXPECT_EQ(pRunning->Status(), IJob::STATE_DONE);
+	Pool.Wait(pDownload);
+	EXPECT_EQ(pDownload->Status(), IJob::STATE_DONE);
+}
+
+TEST_F(Jobs, Batch)
+{
+	std::atomic<int> Counter(0);
+	std::vector<std::shared_ptr<IJob>> vpJobs;
+	for(int i = 0; i < 1000; i++)
+		vpJobs.push_back(std::make_shared<CJob>([&] { Counter++; }));
+	m_Pool.Add(vpJobs, CJobPool::PRIORITY_LOW);
+	m_Pool.Wait(vpJobs);
+	EXPECT_EQ(Counter.load(), 1000);
+	for(auto &pJob : vpJobs)
+		EXPECT_EQ(pJob->Status(), IJob::STATE_DONE);
+}
+
+TEST_F(Jobs, ParallelWork)
+{
+	std::vector<int> vResults(1000, 0);
+	CParallelWork Work(vResults.size(), [&](int i) { vResults[i] = i * 2; });
+	m_Pool.Add(Work.HelperJobs());
+	Work.Wait(500);
+	EXPECT_TRUE(Work.IsDone(500));
+	EXPECT_EQ(vResults[500], 1000);
+	Work.WaitAll();
+	for(int i = 0; i < (int)vResults.size(); i++)
+		ASSERT_EQ(vResults[i], i * 2);
+}
+
+TEST(JobsPool, ParallelWorkBusyPool)
+{
+	// waiting must not run the unrelated job blocking the only worker
+	CJobPool Pool;
+	Pool.Init(1);
+	std::atomic<bool> Release(false);
+	auto pBlocker = std::make_shared<CJob>([&] {
+		while(!Release)
+			thread_yield();
+	});
+	Pool.Add(pBlocker);
+
+	int Sum = 0;
+	CParallelWork Work(100, [&](int i) { Sum += i; });
+	Pool.Add(Work.HelperJobs());
+	Work.WaitAll();
+	EXPECT_EQ(Sum, 4950);
+
+	Release = true;
+	Pool.Wait(pBlocker);
+}
+
+TEST(JobsPool, NestedWait)
+{
+	// a single worker waiting for its own sub jobs must not deadlock
+	CJobPool Pool;
+	Pool.Init(1);
+	std::atomic<int> Counter(0);
+	auto pOuter = std::make_shared<CJob>([&] {
+		std::vector<std::shared_ptr<IJob>> vpInner;
+		for(int i = 0; i < 16; i++)
+			vpInner.push_back(std::make_shared<CJob>([&] { Counter++; }));
+		Pool.Add(vpInner);
+		Pool.Wait(vpInner);
+	});
+	Pool.Add(pOuter);
+	Pool.Wait(pOuter);
+	EXPECT_EQ(Counter.load(), 16);
+}
+
+// run with --gtest_also_run_disabled_tests, the times are recorded as test
+// properties and show up with --gtest_output=xml
+TEST_F(Jobs, DISABLED_Benchmark)
+{
+	static const int NUM_JOBS = 200000;
+	std::atomic<int> Counter(0);
+	std::vector<std::shared_ptr<IJob>> vpJobs;
+	for(int i = 0; i < NUM_JOBS; i++)
+		vpJobs.push_back(std::make_shared<CJob>([&] { Counter++; }));
+
+	int64 Start = time_get();
+	for(auto &pJob : vpJobs)
+		m_Pool.Add(pJob);
+	m_Pool.Wait(vpJobs);
+	int64 Single = time_get() - Start;
+
+	for(auto &pJob : vpJobs)
+		pJob = std::make_shared<CJob>([&] { Counter++; });
+	Start = time_get();
+	m_Pool.Add(vpJobs);
+	m_Pool.Wait(vpJobs);
+	int64 Batch = time_get() - Start;
+
+	EXPECT_EQ(Counter.load(), NUM_JOBS * 2);
+	char aBuf[32];
+	str_format(aBuf, sizeof(aBuf), "%.1f", Single * 1e9 / time_freq() / NUM_JOBS);
+	RecordProperty("NsPerJobSingle", aBuf);
+	str_format(aBuf, sizeof(aBuf), "%.1f", Batch * 1e9 / time_freq() / NUM_JOBS);
+	RecordProperty("NsPerJobBatch", aBuf);
+}
@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+
+#include <string>
+#include <vector>
+
+static bool s_Collect = false;
+static std::vector<std::string> s_vLines;
+
+static void CollectLine(const char *pLine, void *pUser)
+{
+	if(s_Collect)
+		s_vLines.push_back(pLine);
+}
+
+static void LogLines(void *pUser)
+{
+	for(int i = 0; i < 100; i++)
+		dbg_msg("test/thread", "line %d", i);
+}
+
+TEST(Logger, Async)
+{
+	s_vLines.clear();
+	dbg_logger(CollectLine, 0, 0);
+	dbg_logger_async();
+	s_Collect = true;
+
+	dbg_msg("test", "first");
+	void *pThread = thread_init(LogLines, 0, "logger test");
+	thread_wait(pThread);
+	dbg_msg("test", "last");
+	dbg_logger_sync();
+	dbg_logger_remove(CollectLine, 0);
+
+	// the other tests log synchronously without the collecting logger
+	dbg_msg("test", "not collected");
+	s_Collect = false;
+
+	ASSERT_EQ(s_vLines.size(), 102u);
+	EXPECT_NE(s_vLines[0].find("[test]: first"), std::string::npos);
+	EXPECT_EQ(s_vLines[0][0], '[');
+	for(int i = 0; i < 100; i++)
+	{
+		char aBuf[64];
+		str_format(aBuf, sizeof(aBuf), "[test/thread]: line %d", i);
+		EXPECT_NE(s_vLines[i + 1].find(aBuf), std::string::npos);
+	}
+	EXPECT_NE(s_vLines[101].find("[test]: last"), std::string::npos);
+}
@@ -2,6 +2,8 @@
 
 #include <engine/server/name_ban.h>
 
+#include <vector>
+
 TEST(NameBan, Empty)
 {
 	EXPECT_FALSE(IsNameBanned("", 0, 0));
@@ -27,3 +29,57 @@ TEST(NameBan, Substring)
 	EXPECT_TRUE(IsNameBanned("abcxyzdef", &Xyz, 1));
 	EXPECT_FALSE(IsNameBanned("abcdef", &Xyz, 1));
 }
+
+TEST(NameBan, IndexSubstring)
+{
+	CNameBan aBans[] = {
+		CNameBan("abc", 0, 1),
+		CNameBan("BC", 0, 1),
+		CNameBan("xyz", 0, 0),
+	};
+	CNameBanIndex Index;
+	Index.Build(aBans, 3);
+	EXPECT_EQ(Index.IsNameBanned("aBcd"), &aBans[1]);
+	EXPECT_EQ(Index.IsNameBanned("ab"), nullptr);
+	EXPECT_EQ(Index.IsNameBanned("fooxyz"), nullptr);
+	EXPECT_EQ(Index.IsNameBanned(" xyz "), &aBans[2]);
+	EXPECT_EQ(Index.IsNameBanned(""), nullptr);
+}
+
+TEST(NameBan, IndexMatchesLinear)
+{
+	// small alphabet with confusables and case differences, so that
+	// many names are close to each other
+	const char *apParts[] = {"a", "A", "ä", "b", "c", "d", "e", "f", "g", "l", "I", "1", "o", "0", " ", "xy"};
+	unsigned Seed = 12345;
+	auto Random = [&Seed]() {
+		// xorshift32
+		Seed ^= Seed << 13;
+		Seed ^= Seed >> 17;
+		Seed ^= Seed << 5;
+		return Seed;
+	};
+	auto RandomName = [&](char *pBuf, int Size, int MinLength) {
+		pBuf[0] = 0;
+		int Length = MinLength + Random() % 6;
+		for(int i = 0; i < Length; i++)
+			str_append(pBuf, apParts[Random() % (sizeof(apParts) / sizeof(apParts[0]))], Size);
+	};
+
+	std::vector<CNameBan> vBans;
+	for(int i = 0; i < 300; i++)
+	{
+		char aName[MAX_NAME_LENGTH];
+		RandomName(aName, sizeof(aName), 4);
+		vBans.emplace_back(aName, Random() % 3, Random() % 16 == 0);
+	}
+
+	CNameBanIndex Index;
+	Index.Build(vBans.data(), vBans.size());
+	for(int i = 0; i < 5000; i++)
+	{
+		char aName[MAX_NAME_LENGTH * 2];
+		RandomName(aName, sizeof(aName), 2);
+		EXPECT_EQ(Index.IsNameBanned(aName), IsNameBanned(aName, vBans.data(), vBans.size())) << aName;
+	}
+}
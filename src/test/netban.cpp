@@ -0,0 +1,168 @@
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/console.h>
+#include <engine/shared/config.h>
+#include <engine/shared/netban.h>
+#include <engine/storage.h>
+
+#include <vector>
+
+extern IConsole *CreateConsole(int FlagMask);
+
+class NetBan : public ::testing::Test
+{
+protected:
+	IConsole *m_pConsole;
+	IStorage *m_pStorage;
+	CNetBan m_NetBan;
+	unsigned m_Seed;
+
+	NetBan()
+	{
+		m_pConsole = CreateConsole(CFGFLAG_SERVER);
+		m_pStorage = CreateLocalStorage();
+		m_NetBan.Init(m_pConsole, m_pStorage);
+		m_Seed = 12345;
+	}
+
+	~NetBan()
+	{
+		delete m_pStorage;
+		delete m_pConsole;
+	}
+
+	unsigned Random()
+	{
+		// xorshift32
+		m_Seed ^= m_Seed << 13;
+		m_Seed ^= m_Seed >> 17;
+		m_Seed ^= m_Seed << 5;
+		return m_Seed;
+	}
+
+	NETADDR RandomAddr(int Type)
+	{
+		NETADDR Addr;
+		mem_zero(&Addr, sizeof(Addr));
+		Addr.type = Type;
+		for(int i = 0; i < (Type == NETTYPE_IPV4 ? 4 : 16); i++)
+			Addr.ip[i] = Random() & 0xFF;
+		// keep the addresses in a small space so ranges get hit
+		Addr.ip[0] = 10 + (Random() & 1);
+		return Addr;
+	}
+
+	static bool InRange(const CNetRange *pRange, const NETADDR *pAddr)
+	{
+		int Length = pAddr->type == NETTYPE_IPV4 ? 4 : 16;
+		return pRange->m_LB.type == pAddr->type && mem_comp(pRange->m_LB.ip, pAddr->ip, Length) <= 0 && mem_comp(pRange->m_UB.ip, pAddr->ip, Length) >= 0;
+	}
+};
+
+TEST_F(NetBan, Ranges)
+{
+	for(int Type : {NETTYPE_IPV4, NETTYPE_IPV6})
+	{
+		std::vector<CNetRange> vRanges;
+		for(int i = 0; i < 200; i++)
+		{
+			CNetRange Range;
+			Range.m_LB = RandomAddr(Type);
+			Range.m_UB = Range.m_LB;
+			// random width between a few addresses and a few /16s
+			int Width = 1 + Random() % 3;
+			for(int j = 0; j < Width; j++)
+				Range.m_UB.ip[Width - j] = Random() & 0xFF;
+			if(!Range.IsValid())
+				continue;
+			vRanges.push_back(Range);
+			EXPECT_EQ(m_NetBan.BanRange(&Range, 0, "test"), 0);
+		}
+
+		for(int Remove = 0; Remove < 2; Remove++)
+		{
+			for(int i = 0; i < 5000; i++)
+			{
+				NETADDR Addr = RandomAddr(Type);
+				bool Expected = false;
+				for(const auto &Range : vRanges)
+					Expected = Expected || InRange(&Range, &Addr);
+				EXPECT_EQ(m_NetBan.IsBanned(&Addr, 0, 0), Expected);
+			}
+
+			// unban every other range and check again
+			for(unsigned i = 0; i < vRanges.size(); i++)
+			{
+				m_NetBan.UnbanByRange(&vRanges[i]);
+				vRanges.erase(vRanges.begin() + i);
+			}
+		}
+		m_NetBan.UnbanAll();
+	}
+}
+
+TEST_F(NetBan, NoLimit)
+{
+	for(int i = 0; i < 3000; i++)
+	{
+		NETADDR Addr;
+		mem_zero(&Addr, sizeof(Addr));
+		Addr.type = NETTYPE_IPV4;
+		Addr.ip[0] = 10;
+		Addr.ip[2] = i >> 8;
+		Addr.ip[3] = i & 0xFF;
+		EXPECT_EQ(m_NetBan.BanAddr(&Addr, 0, "test"), 0);
+	}
+	EXPECT_EQ(m_NetBan.NumBans(), 3000);
+
+	NETADDR Addr;
+	ASSERT_EQ(net_addr_from_str(&Addr, "10.0.11.183"), 0);
+	EXPECT_TRUE(m_NetBan.IsBanned(&Addr, 0, 0));
+	ASSERT_EQ(net_addr_from_str(&Addr, "10.0.11.184"), 0);
+	EXPECT_FALSE(m_NetBan.IsBanned(&Addr, 0, 0));
+}
+
+TEST_F(NetBan, Import)
+{
+	CTestInfo Info;
+	IOHANDLE File = m_pStorage->OpenFile(Info.m_aFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	ASSERT_TRUE(File);
+	const char aList[] =
+		"# comment\n"
+		"1.2.3.0/24\n"
+		"5.6.7.8\n"
+		"9.9.9.1 - 9.9.9.5 # trailing comment\n"
+		"2001:db8::/32\n"
+		"\n"
+		"not an address\n"
+		"4.4.4.4/\n"
+		"4.4.4.5/abc\n"
+		"4.4.4.6/-8\n"
+		"4.4.4.7/33\n"
+		"2001:db8::/129\n";
+	io_write(File, aList, str_length(aList));
+	io_close(File);
+
+	EXPECT_EQ(m_NetBan.ImportBans(Info.m_aFilename, 0, "imported"), 4);
+	EXPECT_EQ(m_NetBan.NumBans(), 4);
+
+	const char *apBanned[] = {"1.2.3.0", "1.2.3.255", "5.6.7.8", "9.9.9.1", "9.9.9.5", "[2001:db8:ffff::1]"};
+	const char *apNotBanned[] = {"1.2.4.0", "5.6.7.9", "9.9.9.6", "[2001:db9::]", "4.4.4.4", "8.8.8.8"};
+	for(const char *pAddr : apBanned)
+	{
+		NETADDR Addr;
+		ASSERT_EQ(net_addr_from_str(&Addr, pAddr), 0);
+		EXPECT_TRUE(m_NetBan.IsBanned(&Addr, 0, 0)) << pAddr;
+	}
+	for(const char *pAddr : apNotBanned)
+	{
+		NETADDR Addr;
+		ASSERT_EQ(net_addr_from_str(&Addr, pAddr), 0);
+		EXPECT_FALSE(m_NetBan.IsBanned(&Addr, 0, 0)) << pAddr;
+	}
+
+	if(!HasFailure())
+		m_pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+}
@@ -0,0 +1,102 @@
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include <engine/shared/json.h>
+#include <engine/shared/profiler.h>
+
+TEST(Profiler, RegisterZone)
+{
+	CProfiler Profiler;
+	int Zone = Profiler.RegisterZone("a");
+	EXPECT_EQ(Profiler.RegisterZone("b"), Zone + 1);
+	EXPECT_EQ(Profiler.RegisterZone("a"), Zone);
+	EXPECT_EQ(Profiler.NumZones(), 2);
+	EXPECT_STREQ(Profiler.ZoneName(Zone + 1), "b");
+}
+
+TEST(Profiler, History)
+{
+	CProfiler Profiler;
+	int Zone = Profiler.RegisterZone("zone");
+
+	// nothing is kept while disabled
+	Profiler.AddSample(Zone, 0, time_freq());
+	Profiler.NextFrame();
+	EXPECT_EQ(Profiler.NumFrames(), 0);
+
+	Profiler.SetEnabled(true);
+	Profiler.AddSample(Zone, 0, time_freq());
+	Profiler.AddSample(Zone, 0, time_freq());
+	Profiler.NextFrame();
+	Profiler.NextFrame();
+	EXPECT_EQ(Profiler.NumFrames(), 2);
+	EXPECT_FLOAT_EQ(Profiler.FrameTime(Zone, 0), 0.0f);
+	EXPECT_FLOAT_EQ(Profiler.FrameTime(Zone, 1), 2.0f);
+	EXPECT_FLOAT_EQ(Profiler.Average(Zone), 1.0f);
+	EXPECT_FLOAT_EQ(Profiler.Max(Zone), 2.0f);
+
+	for(int i = 0; i < CProfiler::HISTORY_SIZE; i++)
+		Profiler.NextFrame();
+	EXPECT_EQ(Profiler.NumFrames(), (int)CProfiler::HISTORY_SIZE);
+	EXPECT_FLOAT_EQ(Profiler.Max(Zone), 0.0f);
+}
+
+TEST(Profiler, Percentile)
+{
+	CProfiler Profiler;
+	int Zone = Profiler.RegisterZone("zone");
+	EXPECT_FLOAT_EQ(Profiler.Percentile(Zone, 50), 0.0f);
+
+	Profiler.SetEnabled(true);
+	for(int i = 1; i <= 100; i++)
+	{
+		Profiler.AddSample(Zone, 0, i * time_freq() / 1000);
+		Profiler.NextFrame();
+	}
+	EXPECT_NEAR(Profiler.Percentile(Zone, 50), 0.051f, 0.0001f);
+	EXPECT_NEAR(Profiler.Percentile(Zone, 99), 0.1f, 0.0001f);
+	EXPECT_NEAR(Profiler.Percentile(Zone, 0), 0.001f, 0.0001f);
+}
+
+TEST(Profiler, Trace)
+{
+	CTestInfo Info;
+	CProfiler Profiler;
+	int Zone = Profiler.RegisterZone("quote\"d");
+
+	Profiler.AddSample(Zone, 0, 1);
+	EXPECT_EQ(Profiler.NumTraceEvents(), 0);
+	Profiler.StartTrace();
+	EXPECT_TRUE(Profiler.IsTracing());
+	for(int i = 0; i < 3; i++)
+	{
+		int64 Start = time_get_impl();
+		Profiler.AddSample(Zone, Start, Start + time_freq() / 1000);
+	}
+	EXPECT_EQ(Profiler.NumTraceEvents(), 3);
+
+	IOHANDLE File = io_open(Info.m_aFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	EXPECT_TRUE(Profiler.StopTrace(File));
+	io_close(File);
+	EXPECT_FALSE(Profiler.IsTracing());
+	EXPECT_EQ(Profiler.NumTraceEvents(), 0);
+
+	char aBuf[4096];
+	File = io_open(Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	int Read = io_read(File, aBuf, sizeof(aBuf) - 1);
+	io_close(File);
+	fs_remove(Info.m_aFilename);
+	aBuf[Read] = 0;
+
+	json_value *pJson = json_parse(aBuf, Read);
+	ASSERT_TRUE(pJson);
+	const json_value &Events = (*pJson)["traceEvents"];
+	ASSERT_EQ(Events.type, json_array);
+	ASSERT_EQ(Events.u.array.length, 3u);
+	EXPECT_STREQ(Events[0]["name"], "quote\"d");
+	EXPECT_STREQ(Events[0]["ph"], "X");
+	EXPECT_NEAR((double)Events[2]["dur"], 1000.0, 0.01);
+	json_value_free(pJson);
+}
@@ -0,0 +1,121 @@
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include <engine/graphics.h>
+#include <engine/shared/skincache.h>
+
+static CSkinCache::CEntry MakeEntry(const char *pPath, int Width, int Height, unsigned char *pData, unsigned char *pColorData)
+{
+	CSkinCache::CEntry Entry;
+	Entry.m_pPath = pPath;
+	Entry.m_Size = 1234;
+	Entry.m_Time = 5678;
+	Entry.m_Width = Width;
+	Entry.m_Height = Height;
+	Entry.m_Format = CImageInfo::FORMAT_RGBA;
+	Entry.m_BloodColor = ColorRGBA(0.5f, 0.25f, 0.125f, 1.0f);
+	Entry.m_pData = pData;
+	Entry.m_pColorData = pColorData;
+	return Entry;
+}
+
+TEST(SkinCache, SaveLoad)
+{
+	CTestInfo Info;
+	unsigned char aData[3 * 5 * 4];
+	unsigned char aColorData[3 * 5 * 4];
+	for(unsigned i = 0; i < sizeof(aData); i++)
+	{
+		aData[i] = i;
+		aColorData[i] = 255 - i;
+	}
+	std::vector<CSkinCache::CEntry> vEntries;
+	vEntries.push_back(MakeEntry("skins/a.png", 3, 5, aData, aColorData));
+	vEntries.push_back(MakeEntry("skins/b.png", 5, 3, aColorData, aData));
+	vEntries.push_back(MakeEntry("skins/broken.png", 0, 0, 0, 0));
+
+	IOHANDLE File = io_open(Info.m_aFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	EXPECT_TRUE(CSkinCache::Save(File, vEntries));
+	io_close(File);
+
+	CSkinCache Cache;
+	File = io_open(Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	EXPECT_TRUE(Cache.Load(File));
+	io_close(File);
+	fs_remove(Info.m_aFilename);
+
+	ASSERT_EQ(Cache.Num(), 3);
+	const CSkinCache::CEntry *pEntry = Cache.Find("skins/b.png", 1234, 5678);
+	ASSERT_TRUE(pEntry);
+	EXPECT_EQ(pEntry->m_Width, 5);
+	EXPECT_EQ(pEntry->m_Height, 3);
+	EXPECT_FLOAT_EQ(pEntry->m_BloodColor.g, 0.25f);
+	EXPECT_EQ(mem_comp(pEntry->m_pData, aColorData, sizeof(aColorData)), 0);
+	EXPECT_EQ(mem_comp(pEntry->m_pColorData, aData, sizeof(aData)), 0);
+	EXPECT_EQ((uintptr_t)pEntry->m_pData % 16, (uintptr_t)Cache.Get(0)->m_pData % 16);
+
+	// changed or unknown skins aren't found
+	EXPECT_TRUE(Cache.Find("skins/a.png", 1234, 5678));
+	EXPECT_FALSE(Cache.Find("skins/a.png", 1235, 5678));
+	EXPECT_FALSE(Cache.Find("skins/a.png", 1234, 5679));
+	EXPECT_FALSE(Cache.Find("skins/c.png", 1234, 5678));
+
+	// a skin that failed to load is known, but has no data
+	pEntry = Cache.Find("skins/broken.png", 1234, 5678);
+	ASSERT_TRUE(pEntry);
+	EXPECT_FALSE(pEntry->m_pData);
+	EXPECT_FALSE(pEntry->m_pColorData);
+}
+
+TEST(SkinCache, Invalid)
+{
+	CTestInfo Info;
+	IOHANDLE File = io_open(Info.m_aFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	const char aGarbage[] = "this is not a skin cache at all";
+	io_write(File, aGarbage, sizeof(aGarbage));
+	io_close(File);
+
+	CSkinCache Cache;
+	File = io_open(Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	EXPECT_FALSE(Cache.Load(File));
+	io_close(File);
+	fs_remove(Info.m_aFilename);
+	EXPECT_EQ(Cache.Num(), 0);
+}
+
+TEST(SkinCache, PrepareSkin)
+{
+	const int Size = 96;
+	unsigned char *pData = (unsigned char *)malloc(Size * Size * 4);
+	unsigned char *pColorData = (unsigned char *)malloc(Size * Size * 4);
+	for(int i = 0; i < Size * Size; i++)
+	{
+		pData[i * 4 + 0] = 200;
+		pData[i * 4 + 1] = 0;
+		pData[i * 4 + 2] = 0;
+		pData[i * 4 + 3] = 255;
+	}
+	CImageInfo Img;
+	Img.m_Width = Size;
+	Img.m_Height = Size;
+	Img.m_Format = CImageInfo::FORMAT_RGBA;
+	Img.m_pData = pData;
+
+	ColorRGBA BloodColor;
+	EXPECT_TRUE(CSkinCache::PrepareSkin(&Img, pColorData, &BloodColor));
+	EXPECT_FLOAT_EQ(BloodColor.r, 1.0f);
+	EXPECT_FLOAT_EQ(BloodColor.g, 0.0f);
+	EXPECT_EQ(pColorData[0], pColorData[1]);
+	EXPECT_EQ(pColorData[1], pColorData[2]);
+	EXPECT_EQ(pColorData[3], 255);
+	EXPECT_EQ(pData[0], 200);
+
+	Img.m_Height = Size - 1;
+	EXPECT_FALSE(CSkinCache::PrepareSkin(&Img, pColorData, &BloodColor));
+	free(pData);
+	free(pColorData);
+}
@@ -0,0 +1,108 @@
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include <engine/shared/soundcache.h>
+#include <engine/storage.h>
+
+static const short s_aData[] = {1, -2, 300, -400, 32767, -32768};
+
+static void WriteSample(const char *pFilename, const SHA256_DIGEST &Hash)
+{
+	CSoundMixer::CSample Sample;
+	mem_zero(&Sample, sizeof(Sample));
+	Sample.m_pData = (short *)s_aData;
+	Sample.m_NumFrames = 3;
+	Sample.m_Rate = 44100;
+	Sample.m_Channels = 2;
+
+	IOHANDLE File = io_open(pFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	EXPECT_TRUE(CSoundCache::Save(File, Hash, &Sample));
+	io_close(File);
+}
+
+static bool ReadSample(const char *pFilename, const SHA256_DIGEST &Hash, int Rate, CSoundMixer::CSample *pSample)
+{
+	IOHANDLE File = io_open(pFilename, IOFLAG_READ);
+	if(!File)
+		return false;
+	bool Result = CSoundCache::Load(File, Hash, Rate, pSample);
+	io_close(File);
+	return Result;
+}
+
+TEST(SoundCache, SaveLoad)
+{
+	CTestInfo Info;
+	SHA256_DIGEST Hash = sha256("sound", 5);
+	WriteSample(Info.m_aFilename, Hash);
+
+	CSoundMixer::CSample Sample;
+	ASSERT_TRUE(ReadSample(Info.m_aFilename, Hash, 44100, &Sample));
+	EXPECT_EQ(Sample.m_NumFrames, 3);
+	EXPECT_EQ(Sample.m_Rate, 44100);
+	EXPECT_EQ(Sample.m_Channels, 2);
+	EXPECT_EQ(Sample.m_LoopStart, -1);
+	EXPECT_EQ(Sample.m_LoopEnd, -1);
+	EXPECT_EQ(mem_comp(Sample.m_pData, s_aData, sizeof(s_aData)), 0);
+	free(Sample.m_pData);
+	fs_remove(Info.m_aFilename);
+}
+
+TEST(SoundCache, Mismatch)
+{
+	CTestInfo Info;
+	SHA256_DIGEST Hash = sha256("sound", 5);
+	WriteSample(Info.m_aFilename, Hash);
+
+	CSoundMixer::CSample Sample;
+	EXPECT_FALSE(ReadSample(Info.m_aFilename, sha256("other", 5), 44100, &Sample));
+	EXPECT_FALSE(ReadSample(Info.m_aFilename, Hash, 48000, &Sample));
+
+	// a file with the wrong length isn't used either
+	IOHANDLE File = io_open(Info.m_aFilename, IOFLAG_APPEND);
+	ASSERT_TRUE(File);
+	io_write(File, "x", 1);
+	io_close(File);
+	EXPECT_FALSE(ReadSample(Info.m_aFilename, Hash, 44100, &Sample));
+	fs_remove(Info.m_aFilename);
+}
+
+TEST(SoundCache, Filename)
+{
+	char aFilename[128];
+	CSoundCache::Filename(SHA256_ZEROED, 48000, aFilename, sizeof(aFilename));
+	EXPECT_STREQ(aFilename, "soundcache/0000000000000000000000000000000000000000000000000000000000000000_48000.pcm");
+}
+
+TEST(SoundCache, Prune)
+{
+	IStorage *pStorage = CreateLocalStorage();
+	CTestInfo Info;
+	ASSERT_TRUE(pStorage->CreateFolder(Info.m_aFilename, IStorage::TYPE_SAVE));
+	char aFilename[3][128];
+	for(int i = 0; i < 3; i++)
+	{
+		str_format(aFilename[i], sizeof(aFilename[i]), "%s/%d.pcm", Info.m_aFilename, i);
+		WriteSample(aFilename[i], sha256("sound", 5));
+	}
+	// other files stay
+	char aOther[128];
+	str_format(aOther, sizeof(aOther), "%s/other.tmp", Info.m_aFilename);
+	IOHANDLE File = io_open(aOther, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	io_close(File);
+
+	File = io_open(aFilename[0], IOFLAG_READ);
+	ASSERT_TRUE(File);
+	int64 FileSize = io_length(File);
+	io_close(File);
+	EXPECT_EQ(CSoundCache::Prune(pStorage, Info.m_aFilename, 3 * FileSize), 0);
+	EXPECT_EQ(CSoundCache::Prune(pStorage, Info.m_aFilename, 2 * FileSize + 1), 1);
+	EXPECT_EQ(CSoundCache::Prune(pStorage, Info.m_aFilename, 0), 2);
+	for(int i = 0; i < 3; i++)
+		EXPECT_FALSE(fs_remove(aFilename[i]) == 0);
+	EXPECT_EQ(fs_remove(aOther), 0);
+	fs_remove(Info.m_aFilename);
+	delete pStorage;
+}
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include <engine/shared/soundmixer.h>
+
+#include <vector>
+
+static void ReferenceMixVoice(int *pOut, const short *pIn, int Channels, unsigned Frames, int Lvol, int Rvol)
+{
+	for(unsigned s = 0; s < Frames; s++)
+	{
+		pOut[s * 2] += pIn[s * Channels] * Lvol;
+		pOut[s * 2 + 1] += pIn[s * Channels + Channels - 1] * Rvol;
+	}
+}
+
+static void MakeSample(CSoundMixer::CSample *pSample, std::vector<short> *pvData, int Channels, int NumFrames)
+{
+	pvData->resize(NumFrames * Channels);
+	for(int i = 0; i < NumFrames * Channels; i++)
+		(*pvData)[i] = (i * 7919) % 65536 - 32768;
+	mem_zero(pSample, sizeof(*pSample));
+	pSample->m_pData = &(*pvData)[0];
+	pSample->m_NumFrames = NumFrames;
+	pSample->m_Rate = 48000;
+	pSample->m_Channels = Channels;
+}
+
+TEST(SoundMixer, MixVoice)
+{
+	const int aVolumes[][2] = {{255, 255}, {0, 128}, {37, 0}, {70000, 3}};
+	for(int Channels = 1; Channels <= 2; Channels++)
+	{
+		for(unsigned Frames = 0; Frames < 20; Frames++)
+		{
+			for(const auto &Volume : aVolumes)
+			{
+				CSoundMixer::CSample Sample;
+				std::vector<short> vData;
+				MakeSample(&Sample, &vData, Channels, 20);
+				std::vector<int> vExpected(40, 11);
+				std::vector<int> vOut(40, 11);
+				ReferenceMixVoice(&vExpected[0], Sample.m_pData, Channels, Frames, Volume[0], Volume[1]);
+				CSoundMixer::MixVoice(&vOut[0], Sample.m_pData, Channels, Frames, Volume[0], Volume[1]);
+				EXPECT_TRUE(vOut == vExpected) << "Channels=" << Channels << " Frames=" << Frames << " Lvol=" << Volume[0];
+			}
+		}
+	}
+}
+
+TEST(SoundMixer, Voices)
+{
+	CSoundMixer::CSample Sample;
+	std::vector<short> vData;
+	MakeSample(&Sample, &vData, 1, 100);
+
+	CSoundMixer Mixer;
+	int Age;
+	EXPECT_EQ(Mixer.Play(0, &Sample, 0, 0, 0, &Age), -1);
+	Mixer.Init(64);
+
+	int Voice = Mixer.Play(0, &Sample, 0, 0, 0, &Age);
+	ASSERT_GE(Voice, 0);
+	short aOut[64 * 2];
+	Mixer.Mix(aOut, 64);
+	EXPECT_EQ(aOut[2], (short)(((vData[1] * 255 * 100) / 101) >> 8));
+	EXPECT_EQ(aOut[2], aOut[3]);
+
+	// the mixer frees the voice once the sample ended, so every voice can
+	// be played again
+	Mixer.Mix(aOut, 64);
+	int ReusedAge = -1;
+	for(int i = 0; i < CSoundMixer::NUM_VOICES; i++)
+	{
+		int NewAge;
+		int NewVoice = Mixer.Play(0, &Sample, ISound::FLAG_LOOP, 0, 0, &NewAge);
+		ASSERT_GE(NewVoice, 0);
+		if(NewVoice == Voice)
+			ReusedAge = NewAge;
+	}
+	EXPECT_EQ(ReusedAge, Age + 1);
+	EXPECT_EQ(Mixer.Play(0, &Sample, 0, 0, 0, &Age), -1);
+
+	// an old handle doesn't stop the new voice
+	Mixer.StopVoice(Voice, ReusedAge - 1);
+	EXPECT_EQ(Mixer.Play(0, &Sample, 0, 0, 0, &Age), -1);
+	Mixer.StopVoice(Voice, ReusedAge);
+	EXPECT_EQ(Mixer.Play(0, &Sample, 0, 0, 0, &Age), Voice);
+	EXPECT_EQ(Age, ReusedAge + 1);
+
+	Mixer.StopAll();
+	EXPECT_EQ(Mixer.StopSample(&Sample), 0);
+}
+
+TEST(SoundMixer, PausedLoop)
+{
+	CSoundMixer::CSample Sample;
+	std::vector<short> vData;
+	MakeSample(&Sample, &vData, 2, 100);
+
+	CSoundMixer Mixer;
+	Mixer.Init(64);
+	Mixer.SetVolume(101);
+	int Age;
+	ASSERT_GE(Mixer.Play(0, &Sample, ISound::FLAG_LOOP, 0, 0, &Age), 0);
+	short aOut[64 * 2];
+	Mixer.Mix(aOut, 64);
+
+	// a stopped loop continues where it was
+	EXPECT_EQ(Mixer.StopSample(&Sample), 1);
+	EXPECT_FALSE(Mixer.Sync(0));
+	ASSERT_GE(Mixer.Play(0, &Sample, ISound::FLAG_LOOP, 0, 0, &Age), 0);
+	Mixer.Mix(aOut, 64);
+	EXPECT_EQ(aOut[0], (short)((vData[64 * 2] * 255) >> 8));
+	EXPECT_EQ(aOut[1], (short)((vData[64 * 2 + 1] * 255) >> 8));
+	EXPECT_TRUE(Mixer.Sync(0));
+}
+
+TEST(SoundMixer, FullQueue)
+{
+	CSoundMixer::CSample Sample;
+	std::vector<short> vData;
+	MakeSample(&Sample, &vData, 1, 100);
+
+	CSoundMixer Mixer;
+	Mixer.Init(64);
+	int Age;
+	for(int i = 0; i < CSoundMixer::QUEUE_SIZE; i++)
+	{
+		int Voice = Mixer.Play(0, &Sample, 0, 0, 0, &Age);
+		ASSERT_GE(Voice, 0);
+		Mixer.StopVoice(Voice, Age);
+	}
+
+	// the last play waits behind the others instead of getting lost
+	int Voice = Mixer.Play(0, &Sample, 0, 0, 0, &Age);
+	ASSERT_GE(Voice, 0);
+	for(int i = 0; i < CSoundMixer::QUEUE_SIZE; i++)
+		Mixer.SetVoiceVolume(Voice, Age, i % 2 ? 0.0f : 0.5f);
+	Mixer.SetVoiceVolume(Voice, Age, 1.0f);
+	short aOut[64 * 2];
+	int NumMixes = 0;
+	do
+	{
+		Mixer.Mix(aOut, 64);
+		NumMixes++;
+	} while(!Mixer.Sync(0) && NumMixes < 10);
+	EXPECT_EQ(NumMixes, 3);
+	EXPECT_EQ(aOut[2], (short)(((vData[1] * 255 * 100) / 101) >> 8));
+}
@@ -3,8 +3,13 @@
 #include <base/math.h>
 #include <base/system.h>
 #include <engine/shared/dilate.h>
+#include <engine/shared/jobs.h>
 #include <pnglite.h>
 
+#include <thread>
+
+static CJobPool s_JobPool;
+
 int DilateFile(const char *pFileName)
 {
 	png_t Png;
@@ -40,7 +45,7 @@ int DilateFile(const char *pFileName)
 	int w = Png.width;
 	int h = Png.height;
 
-	DilateImage(pBuffer, w, h, 4);
+	DilateImage(pBuffer, w, h, 4, &s_JobPool);
 
 	// save here
 	png_open_file_write(&Png, pFileName);
@@ -61,6 +66,7 @@ int main(int argc, const char **argv)
 		return -1;
 	}
 
+	s_JobPool.Init(maximum((int)std::thread::hardware_concurrency(), 1));
 	for(int i = 1; i < argc; i++)
 		DilateFile(argv[i]);
 	return 0;
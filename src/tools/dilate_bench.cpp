@@ -0,0 +1,87 @@
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/shared/dilate.h>
+#include <engine/shared/jobs.h>
+
+#include <thread>
+#include <vector>
+
+/*
+	Usage: dilate_bench [threads] [runs]
+	Dilates generated 1024x1024 and 4096x4096 tilesets, on the calling
+	thread only and spread over a job pool.
+*/
+
+static void GenerateTileset(std::vector<unsigned char> *pvImage, int Size)
+{
+	// 16x16 tiles, each with an opaque block of varying size and color in a
+	// transparent border, like the tiles of a typical tileset
+	int TileSize = Size / 16;
+	pvImage->assign(Size * Size * 4, 0);
+	unsigned Seed = 1;
+	for(int Tile = 0; Tile < 16 * 16; Tile++)
+	{
+		Seed = Seed * 1103515245 + 12345;
+		int Border = (Seed >> 16) % (TileSize / 4 + 1);
+		int x0 = (Tile % 16) * TileSize;
+		int y0 = (Tile / 16) * TileSize;
+		for(int y = y0 + Border; y < y0 + TileSize - Border; y++)
+			for(int x = x0 + Border; x < x0 + TileSize - Border; x++)
+			{
+				unsigned char *pPixel = &(*pvImage)[(y * Size + x) * 4];
+				pPixel[0] = Seed >> 8;
+				pPixel[1] = x;
+				pPixel[2] = y;
+				pPixel[3] = 255;
+			}
+	}
+}
+
+static double Run(const std::vector<unsigned char> &vImage, int Size, int NumRuns, CJobPool *pJobPool, std::vector<unsigned char> *pvResult)
+{
+	double Best = -1.0;
+	for(int i = 0; i < NumRuns; i++)
+	{
+		*pvResult = vImage;
+		int64 Start = time_get_impl();
+		DilateImage(&(*pvResult)[0], Size, Size, 4, pJobPool);
+		double Time = (time_get_impl() - Start) * 1000.0 / time_freq();
+		if(Best < 0.0 || Time < Best)
+			Best = Time;
+	}
+	return Best;
+}
+
+int main(int argc, const char **argv)
+{
+	dbg_logger_stdout();
+	if(argc > 3)
+	{
+		dbg_msg("usage", "%s [threads] [runs]", argv[0]);
+		return -1;
+	}
+	int NumThreads = argc > 1 ? str_toint(argv[1]) : maximum((int)std::thread::hardware_concurrency(), 1);
+	int NumRuns = argc > 2 ? maximum(str_toint(argv[2]), 1) : 5;
+
+	CJobPool Pool;
+	Pool.Init(NumThreads);
+
+	const int aSizes[] = {1024, 4096};
+	int Result = 0;
+	for(int Size : aSizes)
+	{
+		std::vector<unsigned char> vImage;
+		std::vector<unsigned char> vSingle;
+		std::vector<unsigned char> vPool;
+		GenerateTileset(&vImage, Size);
+		double SingleTime = Run(vImage, Size, NumRuns, 0, &vSingle);
+		double PoolTime = Run(vImage, Size, NumRuns, &Pool, &vPool);
+		dbg_msg("dilate_bench", "%dx%d: %.2fms on one thread, %.2fms with %d pool threads", Size, Size, SingleTime, PoolTime, NumThreads);
+		if(vSingle != vPool)
+		{
+			dbg_msg("dilate_bench", "%dx%d: results differ", Size, Size);
+			Result = -1;
+		}
+	}
+	return Result;
+}
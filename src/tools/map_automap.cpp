@@ -0,0 +1,183 @@
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/console.h>
+#include <engine/shared/config.h>
+#include <engine/shared/datafile.h>
+#include <engine/shared/jobs.h>
+#include <engine/storage.h>
+#include <game/editor/auto_map.h>
+#include <game/mapitems.h>
+#include <game/mapitems_ex.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+/*
+	Usage: map_automap [-j threads] [-c config] [-s seed] <source map> <destination map>
+	Automaps the tile layers of a map with the rules of their images, like
+	the editor's automap button. Every layer is mapped on the calling thread
+	and spread over the job pool, both results are compared and timed.
+	Layers use the rule configuration and seed saved with the map, -c and
+	-s are used for layers without one.
+*/
+
+extern IConsole *CreateConsole(int FlagMask);
+
+static double Milliseconds(int64 Start)
+{
+	return (time_get_impl() - Start) * 1000.0 / time_freq();
+}
+
+static int Usage(const char *pProgram)
+{
+	dbg_msg("usage", "%s [-j threads] [-c config] [-s seed] <source map> <destination map>", pProgram);
+	return -1;
+}
+
+int main(int argc, const char **argv)
+{
+	dbg_logger_stdout();
+
+	int NumThreads = maximum((int)std::thread::hardware_concurrency(), 1);
+	int DefaultConfig = -1;
+	int DefaultSeed = 1;
+	int Arg = 1;
+	for(; Arg < argc && argv[Arg][0] == '-'; Arg++)
+	{
+		if(str_comp(argv[Arg], "-j") == 0 && Arg + 1 < argc)
+			NumThreads = maximum(str_toint(argv[++Arg]), 1);
+		else if(str_comp(argv[Arg], "-c") == 0 && Arg + 1 < argc)
+			DefaultConfig = str_toint(argv[++Arg]);
+		else if(str_comp(argv[Arg], "-s") == 0 && Arg + 1 < argc)
+			DefaultSeed = str_toint(argv[++Arg]);
+		else
+			return Usage(argv[0]);
+	}
+	if(argc - Arg != 2)
+		return Usage(argv[0]);
+	const char *pSource = argv[Arg];
+	const char *pDestination = argv[Arg + 1];
+
+	IStorage *pStorage = CreateStorage("Teeworlds", IStorage::STORAGETYPE_BASIC, argc, argv);
+	if(!pStorage)
+		return -1;
+	IConsole *pConsole = CreateConsole(CFGFLAG_SERVER);
+	CJobPool Pool;
+	Pool.Init(NumThreads);
+
+	CDataFileReader Reader;
+	if(!Reader.Open(pStorage, pSource, IStorage::TYPE_ABSOLUTE))
+	{
+		dbg_msg("map_automap", "failed to open source map '%s'", pSource);
+		return -1;
+	}
+
+	// one automapper per image, loaded once for each mode
+	int ImagesStart, ImagesNum;
+	Reader.GetType(MAPITEMTYPE_IMAGE, &ImagesStart, &ImagesNum);
+	std::vector<std::unique_ptr<CAutoMapper>> vpSequential(ImagesNum);
+	std::vector<std::unique_ptr<CAutoMapper>> vpParallel(ImagesNum);
+	for(int i = 0; i < ImagesNum; i++)
+	{
+		CMapItemImage *pImage = (CMapItemImage *)Reader.GetItem(ImagesStart + i, 0, 0);
+		const char *pName = (const char *)Reader.GetData(pImage->m_ImageName);
+		vpSequential[i].reset(new CAutoMapper(pStorage, pConsole));
+		vpSequential[i]->Load(pName);
+		vpParallel[i].reset(new CAutoMapper(pStorage, pConsole, &Pool));
+		vpParallel[i]->Load(pName);
+	}
+
+	int GroupsStart, GroupsNum, LayersStart, LayersNum, ConfigsStart, ConfigsNum;
+	Reader.GetType(MAPITEMTYPE_GROUP, &GroupsStart, &GroupsNum);
+	Reader.GetType(MAPITEMTYPE_LAYER, &LayersStart, &LayersNum);
+	Reader.GetType(MAPITEMTYPE_AUTOMAPPER_CONFIG, &ConfigsStart, &ConfigsNum);
+
+	// the new tiles by data index
+	std::vector<std::vector<CTile>> vvNewTiles(Reader.NumData());
+	int NumLayers = 0;
+	int NumDifferent = 0;
+	double SequentialTime = 0.0;
+	double ParallelTime = 0.0;
+	for(int g = 0; g < GroupsNum; g++)
+	{
+		CMapItemGroup *pGroup = (CMapItemGroup *)Reader.GetItem(GroupsStart + g, 0, 0);
+		for(int l = 0; l < pGroup->m_NumLayers; l++)
+		{
+			if(pGroup->m_StartLayer + l >= LayersNum)
+				break;
+			CMapItemLayer *pLayer = (CMapItemLayer *)Reader.GetItem(LayersStart + pGroup->m_StartLayer + l, 0, 0);
+			if(pLayer->m_Type != LAYERTYPE_TILES)
+				continue;
+			CMapItemLayerTilemap *pTilemap = (CMapItemLayerTilemap *)pLayer;
+			if(pTilemap->m_Flags || pTilemap->m_Image < 0 || pTilemap->m_Image >= ImagesNum || !vpParallel[pTilemap->m_Image]->IsLoaded())
+				continue;
+
+			int Config = DefaultConfig;
+			int Seed = DefaultSeed;
+			for(int i = 0; i < ConfigsNum; i++)
+			{
+				CMapItemAutoMapperConfig *pItem = (CMapItemAutoMapperConfig *)Reader.GetItem(ConfigsStart + i, 0, 0);
+				if(pItem->m_Version == CMapItemAutoMapperConfig::CURRENT_VERSION && pItem->m_GroupId == g && pItem->m_LayerId == l && pItem->m_AutomapperConfig != -1)
+				{
+					Config = pItem->m_AutomapperConfig;
+					if(pItem->m_AutomapperSeed != 0)
+						Seed = pItem->m_AutomapperSeed;
+				}
+			}
+			if(Config < 0 || Config >= vpParallel[pTilemap->m_Image]->ConfigNamesNum())
+				continue;
+
+			int NumTiles = pTilemap->m_Width * pTilemap->m_Height;
+			if(Reader.GetDataSize(pTilemap->m_Data) < NumTiles * (int)sizeof(CTile))
+			{
+				dbg_msg("map_automap", "group %d layer %d: tile data is too small", g, l);
+				continue;
+			}
+			CTile *pTiles = (CTile *)Reader.GetData(pTilemap->m_Data);
+			std::vector<CTile> vSequential(pTiles, pTiles + NumTiles);
+			std::vector<CTile> vParallel(pTiles, pTiles + NumTiles);
+
+			int64 Start = time_get_impl();
+			vpSequential[pTilemap->m_Image]->Proceed(vSequential.data(), pTilemap->m_Width, pTilemap->m_Height, Config, Seed);
+			double Sequential = Milliseconds(Start);
+			Start = time_get_impl();
+			vpParallel[pTilemap->m_Image]->Proceed(vParallel.data(), pTilemap->m_Width, pTilemap->m_Height, Config, Seed);
+			double Parallel = Milliseconds(Start);
+
+			bool Same = mem_comp(vSequential.data(), vParallel.data(), NumTiles * sizeof(CTile)) == 0;
+			dbg_msg("map_automap", "group %d layer %d: %dx%d with '%s', %.2fms on one thread, %.2fms with %d pool threads%s",
+				g, l, pTilemap->m_Width, pTilemap->m_Height, vpParallel[pTilemap->m_Image]->GetConfigName(Config),
+				Sequential, Parallel, NumThreads, Same ? "" : ", results differ");
+			SequentialTime += Sequential;
+			ParallelTime += Parallel;
+			NumDifferent += !Same;
+			NumLayers++;
+			vvNewTiles[pTilemap->m_Data] = vParallel;
+		}
+	}
+	dbg_msg("map_automap", "automapped %d layers, %.2fms on one thread, %.2fms with %d pool threads", NumLayers, SequentialTime, ParallelTime, NumThreads);
+
+	CDataFileWriter Writer;
+	if(!Writer.Open(pStorage, pDestination))
+	{
+		dbg_msg("map_automap", "failed to open destination map '%s'", pDestination);
+		return -1;
+	}
+	for(int Index = 0; Index < Reader.NumItems(); Index++)
+	{
+		int Type, ID;
+		void *pPtr = Reader.GetItem(Index, &Type, &ID);
+		Writer.AddItem(Type, ID, Reader.GetItemSize(Index), pPtr);
+	}
+	for(int Index = 0; Index < Reader.NumData(); Index++)
+	{
+		if(!vvNewTiles[Index].empty())
+			Writer.AddData(vvNewTiles[Index].size() * sizeof(CTile), vvNewTiles[Index].data());
+		else
+			Writer.AddData(Reader.GetDataSize(Index), Reader.GetData(Index));
+	}
+	Reader.Close();
+	Writer.Finish();
+	return NumDifferent ? -1 : 0;
+}
@@ -5,10 +5,13 @@
 #include <base/system.h>
 #include <engine/graphics.h>
 #include <engine/shared/datafile.h>
+#include <engine/shared/jobs.h>
 #include <engine/storage.h>
 #include <game/mapitems.h>
 
 #include <pnglite.h>
+
+#include <thread>
 /*
 	Usage: map_convert_07 <source map filepath> <dest map filepath>
 */
@@ -215,6 +218,11 @@ int main(int argc, const char **argv)
 		return -1;
 	}
 
+	// compress the data blocks in parallel
+	CJobPool JobPool;
+	JobPool.Init(maximum((int)std::thread::hardware_concurrency(), 1));
+	g_DataWriter.SetJobPool(&JobPool);
+
 	png_init(0, 0);
 
 	g_NextDataItemID = g_DataReader.NumData();
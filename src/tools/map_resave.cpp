@@ -1,27 +1,38 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
 #include <base/system.h>
 #include <engine/shared/datafile.h>
+#include <engine/shared/jobs.h>
 #include <engine/storage.h>
 
-int main(int argc, const char **argv)
+#include <string>
+#include <thread>
+#include <vector>
+
+static IStorage *s_pStorage;
+static CJobPool s_JobPool;
+static int s_CompressionLevel = -1;
+
+static bool ResaveMap(const char *pSource, const char *pDestination)
 {
-	IStorage *pStorage = CreateStorage("Teeworlds", IStorage::STORAGETYPE_BASIC, argc, argv);
 	int Index, ID = 0, Type = 0, Size;
 	void *pPtr;
-	char aFileName[1024];
 	CDataFileReader DataFile;
 	CDataFileWriter df;
 
-	if(!pStorage || argc != 3)
-		return -1;
-
-	str_format(aFileName, sizeof(aFileName), "%s", argv[2]);
-
-	if(!DataFile.Open(pStorage, argv[1], IStorage::TYPE_ABSOLUTE))
-		return -1;
-	if(!df.Open(pStorage, aFileName))
-		return -1;
+	if(!DataFile.Open(s_pStorage, pSource, IStorage::TYPE_ABSOLUTE))
+	{
+		dbg_msg("map_resave", "failed to open source map '%s'", pSource);
+		return false;
+	}
+	if(!df.Open(s_pStorage, pDestination))
+	{
+		dbg_msg("map_resave", "failed to open destination map '%s'", pDestination);
+		return false;
+	}
+	df.SetJobPool(&s_JobPool);
+	df.SetCompressionLevel(s_CompressionLevel);
 
 	// add all items
 	for(Index = 0; Index < DataFile.NumItems(); Index++)
@@ -37,9 +48,94 @@ int main(int argc, const char **argv)
 		pPtr = DataFile.GetData(Index);
 		Size = DataFile.GetDataSize(Index);
 		df.AddData(Size, pPtr);
+		DataFile.UnloadData(Index);
 	}
 
 	DataFile.Close();
 	df.Finish();
+	return true;
+}
+
+struct CListDirInfo
+{
+	const char *m_pSourceDir;
+	const char *m_pDestinationDir;
+	std::vector<std::pair<std::string, std::string>> m_vMaps;
+};
+
+static int AddMap(const char *pName, int IsDir, int StorageType, void *pUser)
+{
+	CListDirInfo *pInfo = (CListDirInfo *)pUser;
+	if(IsDir || !str_endswith(pName, ".map"))
+		return 0;
+
+	char aSource[MAX_PATH_LENGTH];
+	char aDestination[MAX_PATH_LENGTH];
+	str_format(aSource, sizeof(aSource), "%s/%s", pInfo->m_pSourceDir, pName);
+	str_format(aDestination, sizeof(aDestination), "%s/%s", pInfo->m_pDestinationDir, pName);
+	pInfo->m_vMaps.emplace_back(aSource, aDestination);
 	return 0;
 }
+
+static int Usage(const char *pProgram)
+{
+	dbg_msg("usage", "%s [-l level] [-j jobs] <source map> <destination map>", pProgram);
+	dbg_msg("usage", "%s [-l level] [-j jobs] -d <source directory> <destination directory>", pProgram);
+	dbg_msg("usage", "level is the zlib compression level from 0 to 9, jobs the number of threads");
+	return -1;
+}
+
+int main(int argc, const char **argv)
+{
+	dbg_logger_stdout();
+
+	bool Directory = false;
+	int NumJobs = maximum((int)std::thread::hardware_concurrency(), 1);
+	int Arg = 1;
+	for(; Arg < argc && argv[Arg][0] == '-'; Arg++)
+	{
+		if(str_comp(argv[Arg], "-d") == 0)
+			Directory = true;
+		else if(str_comp(argv[Arg], "-l") == 0 && Arg + 1 < argc)
+			s_CompressionLevel = clamp(str_toint(argv[++Arg]), -1, 9);
+		else if(str_comp(argv[Arg], "-j") == 0 && Arg + 1 < argc)
+			NumJobs = maximum(str_toint(argv[++Arg]), 1);
+		else
+			return Usage(argv[0]);
+	}
+	if(argc - Arg != 2)
+		return Usage(argv[0]);
+	const char *pSource = argv[Arg];
+	const char *pDestination = argv[Arg + 1];
+
+	s_pStorage = CreateStorage("Teeworlds", IStorage::STORAGETYPE_BASIC, argc, argv);
+	if(!s_pStorage)
+		return -1;
+	s_JobPool.Init(NumJobs);
+
+	if(!Directory)
+		return ResaveMap(pSource, pDestination) ? 0 : -1;
+
+	// one map after the other, only their data is compressed on the pool.
+	// this keeps a single map in memory at a time
+	CListDirInfo Info;
+	Info.m_pSourceDir = pSource;
+	Info.m_pDestinationDir = pDestination;
+	fs_listdir(pSource, AddMap, IStorage::TYPE_ABSOLUTE, &Info);
+	if(!s_pStorage->CreateFolder(pDestination, IStorage::TYPE_SAVE))
+	{
+		dbg_msg("map_resave", "failed to create directory '%s'", pDestination);
+		return -1;
+	}
+
+	int64 StartTime = time_get_impl();
+	int NumFailed = 0;
+	for(const auto &Map : Info.m_vMaps)
+	{
+		if(!ResaveMap(Map.first.c_str(), Map.second.c_str()))
+			NumFailed++;
+	}
+	dbg_msg("map_resave", "resaved %d of %d maps in %.2fs with %d threads", (int)Info.m_vMaps.size() - NumFailed, (int)Info.m_vMaps.size(),
+		(time_get_impl() - StartTime) / (double)time_freq(), NumJobs);
+	return NumFailed ? -1 : 0;
+}
@@ -0,0 +1,172 @@
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/shared/network.h>
+#include <mastersrv/mastersrv.h>
+
+#include <vector>
+
+// Simulates many game servers heartbeating to a locally running master
+// server, answers its firewall checks and then measures list requests.
+// Every simulated server needs its own socket, so raise the open file
+// limit (ulimit -n) for large numbers of servers.
+
+// the server sockets are always drained completely and can share one
+static MMSGS s_ServerMMSGS;
+static MMSGS s_ClientMMSGS;
+
+static void SendConnless(NETSOCKET Socket, NETADDR *pAddr, const void *pData, int Size)
+{
+	unsigned char aExtra[4] = {0};
+	CNetBase::SendPacketConnless(Socket, pAddr, pData, Size, false, aExtra);
+}
+
+// returns the size of the next connless packet, 0 if there is none
+static int RecvConnless(NETSOCKET Socket, MMSGS *pMMSGS, NETADDR *pAddr, CNetPacketConstruct *pPacket)
+{
+	static unsigned char s_aBuffer[NET_MAX_PACKETSIZE];
+	while(1)
+	{
+		unsigned char *pData;
+		int Bytes = net_udp_recv(Socket, pAddr, s_aBuffer, sizeof(s_aBuffer), pMMSGS, &pData);
+		if(Bytes <= 0)
+			return 0;
+		bool Sixup = false;
+		if(CNetBase::UnpackPacket(pData, Bytes, pPacket, Sixup) == 0 && pPacket->m_Flags & NET_PACKETFLAG_CONNLESS)
+			return pPacket->m_DataSize;
+	}
+}
+
+static bool IsPacket(const CNetPacketConstruct *pPacket, const unsigned char *pHeader, int Size)
+{
+	return pPacket->m_DataSize >= Size && mem_comp(pPacket->m_aChunkData, pHeader, Size) == 0;
+}
+
+int main(int argc, const char **argv)
+{
+	dbg_logger_stdout();
+	if(argc > 4)
+	{
+		dbg_msg("usage", "%s [num servers] [num list requests] [master address]", argv[0]);
+		return -1;
+	}
+	int NumServers = argc > 1 ? str_toint(argv[1]) : 1000;
+	int NumRequests = argc > 2 ? str_toint(argv[2]) : 100;
+
+	net_init();
+	CNetBase::Init();
+	net_init_mmsgs(&s_ServerMMSGS);
+	net_init_mmsgs(&s_ClientMMSGS);
+
+	NETADDR Master;
+	if(net_addr_from_str(&Master, argc > 3 ? argv[3] : "127.0.0.1"))
+	{
+		dbg_msg("mastersrv_loadtest", "invalid master address");
+		return -1;
+	}
+	if(!Master.port)
+		Master.port = MASTERSERVER_PORT;
+
+	NETADDR BindAddr;
+	mem_zero(&BindAddr, sizeof(BindAddr));
+	BindAddr.type = Master.type;
+
+	std::vector<NETSOCKET> vSockets;
+	for(int i = 0; i < NumServers; i++)
+	{
+		NETSOCKET Socket = net_udp_create(BindAddr);
+		if(!Socket.type)
+		{
+			dbg_msg("mastersrv_loadtest", "couldn't open socket %d, check the open file limit", i);
+			return -1;
+		}
+		vSockets.push_back(Socket);
+	}
+
+	unsigned char aHeartbeat[sizeof(SERVERBROWSE_HEARTBEAT) + 2];
+	mem_copy(aHeartbeat, SERVERBROWSE_HEARTBEAT, sizeof(SERVERBROWSE_HEARTBEAT));
+	aHeartbeat[sizeof(SERVERBROWSE_HEARTBEAT)] = 8303 >> 8;
+	aHeartbeat[sizeof(SERVERBROWSE_HEARTBEAT) + 1] = 8303 & 0xff;
+
+	// register all servers, the master checks them every few seconds
+	std::vector<bool> vRegistered(NumServers, false);
+	int NumRegistered = 0;
+	int64 Start = time_get();
+	int64 LastHeartbeat = 0;
+	CNetPacketConstruct Packet;
+	NETADDR From;
+	while(NumRegistered < NumServers && time_get() - Start < time_freq() * 60)
+	{
+		bool Heartbeat = time_get() - LastHeartbeat > time_freq() * 10;
+		if(Heartbeat)
+			LastHeartbeat = time_get();
+		for(int i = 0; i < NumServers; i++)
+		{
+			if(Heartbeat && !vRegistered[i])
+				SendConnless(vSockets[i], &Master, aHeartbeat, sizeof(aHeartbeat));
+			while(RecvConnless(vSockets[i], &s_ServerMMSGS, &From, &Packet))
+			{
+				if(IsPacket(&Packet, SERVERBROWSE_FWCHECK, sizeof(SERVERBROWSE_FWCHECK)))
+					SendConnless(vSockets[i], &From, SERVERBROWSE_FWRESPONSE, sizeof(SERVERBROWSE_FWRESPONSE));
+				else if(IsPacket(&Packet, SERVERBROWSE_FWOK, sizeof(SERVERBROWSE_FWOK)) && !vRegistered[i])
+				{
+					vRegistered[i] = true;
+					NumRegistered++;
+				}
+			}
+		}
+		thread_sleep(1000);
+	}
+	dbg_msg("mastersrv_loadtest", "%d/%d servers registered in %.2f s", NumRegistered, NumServers, (double)(time_get() - Start) / time_freq());
+
+	// request the list while all servers keep heartbeating
+	NETSOCKET Client = net_udp_create(BindAddr);
+	int64 TotalLatency = 0;
+	int64 MaxLatency = 0;
+	int TotalEntries = 0;
+	int NextHeartbeat = 0;
+	for(int r = 0; r < NumRequests; r++)
+	{
+		for(int i = 0; i < NumServers / 10 + 1; i++, NextHeartbeat = (NextHeartbeat + 1) % NumServers)
+		{
+			SendConnless(vSockets[NextHeartbeat], &Master, aHeartbeat, sizeof(aHeartbeat));
+			while(RecvConnless(vSockets[NextHeartbeat], &s_ServerMMSGS, &From, &Packet))
+			{
+				if(IsPacket(&Packet, SERVERBROWSE_FWCHECK, sizeof(SERVERBROWSE_FWCHECK)))
+					SendConnless(vSockets[NextHeartbeat], &From, SERVERBROWSE_FWRESPONSE, sizeof(SERVERBROWSE_FWRESPONSE));
+			}
+		}
+
+		int64 RequestStart = time_get();
+		SendConnless(Client, &Master, SERVERBROWSE_GETLIST, sizeof(SERVERBROWSE_GETLIST));
+		int Entries = 0;
+		int64 LastPacket = RequestStart;
+		while(Entries < NumRegistered && time_get() - LastPacket < time_freq() / 2)
+		{
+			if(!RecvConnless(Client, &s_ClientMMSGS, &From, &Packet))
+			{
+				thread_yield();
+				continue;
+			}
+			if(IsPacket(&Packet, SERVERBROWSE_LIST, sizeof(SERVERBROWSE_LIST)))
+			{
+				Entries += (Packet.m_DataSize - sizeof(SERVERBROWSE_LIST)) / sizeof(CMastersrvAddr);
+				LastPacket = time_get();
+			}
+		}
+		int64 Latency = LastPacket - RequestStart;
+		TotalLatency += Latency;
+		MaxLatency = maximum(MaxLatency, Latency);
+		TotalEntries += Entries;
+	}
+
+	if(NumRequests > 0)
+	{
+		dbg_msg("mastersrv_loadtest", "%d list requests, %.1f servers per list, %.2f ms average, %.2f ms max",
+			NumRequests, (double)TotalEntries / NumRequests, TotalLatency * 1000.0 / time_freq() / NumRequests, MaxLatency * 1000.0 / time_freq());
+	}
+
+	net_udp_close(Client);
+	for(auto &Socket : vSockets)
+		net_udp_close(Socket);
+	return 0;
+}
@@ -0,0 +1,124 @@
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/shared/soundmixer.h>
+
+#include <vector>
+
+/*
+	Usage: mixer_bench [voices] [buffers]
+	Mixes looping voices into 1024 frame buffers without an audio device.
+	The voice kernel is compared to the plain per frame loop the mixer used
+	before, then whole mixes are timed with every voice being moved between
+	the buffers like the game does.
+*/
+
+enum
+{
+	BUFFER_FRAMES = 1024,
+	SAMPLE_FRAMES = 48000,
+};
+
+static void GenerateSample(CSoundMixer::CSample *pSample, int Channels, unsigned Seed)
+{
+	mem_zero(pSample, sizeof(*pSample));
+	pSample->m_pData = (short *)malloc(SAMPLE_FRAMES * Channels * sizeof(short));
+	for(int i = 0; i < SAMPLE_FRAMES * Channels; i++)
+	{
+		Seed = Seed * 1103515245 + 12345;
+		pSample->m_pData[i] = (short)(Seed >> 16);
+	}
+	pSample->m_NumFrames = SAMPLE_FRAMES;
+	pSample->m_Rate = 48000;
+	pSample->m_Channels = Channels;
+	pSample->m_LoopStart = -1;
+	pSample->m_LoopEnd = -1;
+}
+
+// the loop CSound::Mix ran for every voice before
+static void ReferenceMixVoice(int *pOut, const short *pIn, int Channels, unsigned Frames, int Lvol, int Rvol)
+{
+	const short *pInL = pIn;
+	const short *pInR = pIn + Channels - 1;
+	for(unsigned s = 0; s < Frames; s++)
+	{
+		*pOut++ += (*pInL) * Lvol;
+		*pOut++ += (*pInR) * Rvol;
+		pInL += Channels;
+		pInR += Channels;
+	}
+}
+
+static double Milliseconds(int64 Start)
+{
+	return (time_get_impl() - Start) * 1000.0 / time_freq();
+}
+
+int main(int argc, const char **argv)
+{
+	dbg_logger_stdout();
+	if(argc > 3)
+	{
+		dbg_msg("usage", "%s [voices] [buffers]", argv[0]);
+		return -1;
+	}
+	int NumVoices = argc > 1 ? clamp(str_toint(argv[1]), 1, (int)CSoundMixer::NUM_VOICES) : 64;
+	int NumBuffers = argc > 2 ? maximum(str_toint(argv[2]), 1) : 1000;
+
+	std::vector<CSoundMixer::CSample> vSamples(NumVoices);
+	for(int i = 0; i < NumVoices; i++)
+		GenerateSample(&vSamples[i], i % 2 + 1, i + 1);
+
+	// the voice kernel against the old loop
+	std::vector<int> vReference(BUFFER_FRAMES * 2);
+	std::vector<int> vKernel(BUFFER_FRAMES * 2);
+	double ReferenceTime = 0.0;
+	double KernelTime = 0.0;
+	for(int b = 0; b < NumBuffers; b++)
+	{
+		int Tick = (b * BUFFER_FRAMES) % (SAMPLE_FRAMES - BUFFER_FRAMES);
+		mem_zero(&vReference[0], vReference.size() * sizeof(int));
+		mem_zero(&vKernel[0], vKernel.size() * sizeof(int));
+
+		int64 Start = time_get_impl();
+		for(int i = 0; i < NumVoices; i++)
+			ReferenceMixVoice(&vReference[0], &vSamples[i].m_pData[Tick * vSamples[i].m_Channels], vSamples[i].m_Channels, BUFFER_FRAMES, 255 - i, i);
+		ReferenceTime += Milliseconds(Start);
+
+		Start = time_get_impl();
+		for(int i = 0; i < NumVoices; i++)
+			CSoundMixer::MixVoice(&vKernel[0], &vSamples[i].m_pData[Tick * vSamples[i].m_Channels], vSamples[i].m_Channels, BUFFER_FRAMES, 255 - i, i);
+		KernelTime += Milliseconds(Start);
+
+		if(vReference != vKernel)
+		{
+			dbg_msg("mixer_bench", "kernel result differs in buffer %d", b);
+			return -1;
+		}
+	}
+	dbg_msg("mixer_bench", "%d voices, %d buffers: %.2fms with the old loop, %.2fms with the kernel (%.1fx)",
+		NumVoices, NumBuffers, ReferenceTime, KernelTime, ReferenceTime / maximum(KernelTime, 0.001));
+
+	// whole mixes, with the voices placed around the listener
+	CSoundMixer Mixer;
+	Mixer.Init(BUFFER_FRAMES);
+	Mixer.SetChannel(0, 1.0f, 1.0f);
+	std::vector<int> vVoices(NumVoices);
+	std::vector<int> vAges(NumVoices);
+	for(int i = 0; i < NumVoices; i++)
+		vVoices[i] = Mixer.Play(0, &vSamples[i], ISound::FLAG_LOOP | ISound::FLAG_POS, (i % 16) * 100.0f - 800.0f, (i / 16) * 100.0f - 800.0f, &vAges[i]);
+	std::vector<short> vOut(BUFFER_FRAMES * 2);
+	int64 Start = time_get_impl();
+	for(int b = 0; b < NumBuffers; b++)
+	{
+		for(int i = 0; i < NumVoices; i++)
+			Mixer.SetVoiceLocation(vVoices[i], vAges[i], (i % 16) * 100.0f - 800.0f + b % 100, (i / 16) * 100.0f - 800.0f);
+		Mixer.Mix(&vOut[0], BUFFER_FRAMES);
+	}
+	double MixTime = Milliseconds(Start);
+	dbg_msg("mixer_bench", "%d voices, %d buffers: %.2fms for whole mixes, %.1fus per buffer", NumVoices, NumBuffers, MixTime, MixTime * 1000.0 / NumBuffers);
+
+	Mixer.Shutdown();
+	for(CSoundMixer::CSample &Sample : vSamples)
+		free(Sample.m_pData);
+	return 0;
+}
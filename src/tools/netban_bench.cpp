@@ -0,0 +1,79 @@
+#include <base/system.h>
+#include <engine/console.h>
+#include <engine/shared/config.h>
+#include <engine/shared/netban.h>
+
+extern IConsole *CreateConsole(int FlagMask);
+
+static unsigned s_Seed = 1;
+
+static unsigned Random()
+{
+	// xorshift32
+	s_Seed ^= s_Seed << 13;
+	s_Seed ^= s_Seed >> 17;
+	s_Seed ^= s_Seed << 5;
+	return s_Seed;
+}
+
+static void RandomAddr(NETADDR *pAddr)
+{
+	mem_zero(pAddr, sizeof(*pAddr));
+	pAddr->type = NETTYPE_IPV4;
+	for(int i = 0; i < 4; i++)
+		pAddr->ip[i] = Random() & 0xFF;
+}
+
+int main(int argc, const char **argv)
+{
+	if(argc > 3)
+	{
+		dbg_logger_stdout();
+		dbg_msg("usage", "%s [num ranges] [num lookups]", argv[0]);
+		return -1;
+	}
+	int NumRanges = argc > 1 ? str_toint(argv[1]) : 100000;
+	int NumLookups = argc > 2 ? str_toint(argv[2]) : 10000000;
+
+	IConsole *pConsole = CreateConsole(CFGFLAG_SERVER);
+	CNetBan NetBan;
+	NetBan.Init(pConsole, 0);
+
+	// ranges between /16 and /28, like typical vpn and hosting lists
+	int64 Start = time_get();
+	for(int i = 0; i < NumRanges; i++)
+	{
+		CNetRange Range;
+		RandomAddr(&Range.m_LB);
+		int PrefixLength = 16 + Random() % 13;
+		Range.m_UB = Range.m_LB;
+		for(int Bit = PrefixLength; Bit < 32; Bit++)
+		{
+			Range.m_LB.ip[Bit / 8] &= ~(1 << (7 - Bit % 8));
+			Range.m_UB.ip[Bit / 8] |= 1 << (7 - Bit % 8);
+		}
+		NetBan.BanRange(&Range, 0, "benchmark");
+	}
+	int64 End = time_get();
+
+	// only log from here on, every ban is printed to the console
+	dbg_logger_stdout();
+	dbg_msg("netban_bench", "added %d ranges in %.2f ms", NetBan.NumBans(), (End - Start) * 1000.0 / time_freq());
+
+	NETADDR *pAddrs = (NETADDR *)malloc(sizeof(NETADDR) * 1024);
+	for(int i = 0; i < 1024; i++)
+		RandomAddr(&pAddrs[i]);
+
+	int Banned = 0;
+	Start = time_get();
+	for(int i = 0; i < NumLookups; i++)
+		Banned += NetBan.IsBanned(&pAddrs[i % 1024], 0, 0);
+	End = time_get();
+
+	double Seconds = (double)(End - Start) / time_freq();
+	dbg_msg("netban_bench", "%d lookups in %.2f ms, %.1f ns per packet, %d banned", NumLookups, Seconds * 1000.0, Seconds * 1e9 / NumLookups, Banned);
+
+	free(pAddrs);
+	delete pConsole;
+	return 0;
+}
@@ -0,0 +1,142 @@
+#include <base/system.h>
+#include <engine/config.h>
+#include <engine/shared/config.h>
+#include <engine/shared/network.h>
+
+static int NewClientCallback(int ClientID, void *pUser, bool Sixup)
+{
+	(*(int *)pUser)++;
+	return 0;
+}
+
+static int DelClientCallback(int ClientID, const char *pReason, void *pUser)
+{
+	(*(int *)pUser)--;
+	return 0;
+}
+
+static int PumpServer(CNetServer *pServer)
+{
+	CNetChunk Packet;
+	SECURITY_TOKEN ResponseToken;
+	int Chunks = 0;
+	pServer->Update();
+	while(pServer->Recv(&Packet, &ResponseToken))
+		Chunks++;
+	return Chunks;
+}
+
+int main(int argc, const char **argv)
+{
+	dbg_logger_stdout();
+	if(argc > 3)
+	{
+		dbg_msg("usage", "%s [num clients] [num rounds]", argv[0]);
+		return -1;
+	}
+	int NumClients = clamp(argc > 1 ? str_toint(argv[1]) : (int)NET_MAX_CLIENTS, 1, (int)NET_MAX_CLIENTS);
+	int NumRounds = argc > 2 ? str_toint(argv[2]) : 2000;
+
+	if(secure_random_init() != 0)
+	{
+		dbg_msg("netserver_bench", "could not initialize secure RNG");
+		return -1;
+	}
+	net_init();
+	IConfig *pConfig = CreateConfig();
+	pConfig->Reset();
+	CNetBase::Init();
+
+	NETADDR BindAddr;
+	mem_zero(&BindAddr, sizeof(BindAddr));
+	net_addr_from_str(&BindAddr, "127.0.0.1");
+	NETADDR ServerAddr = BindAddr;
+
+	CNetServer Server;
+	for(ServerAddr.port = 18303; ServerAddr.port < 18403; ServerAddr.port++)
+		if(Server.Open(ServerAddr, 0, NumClients, NumClients, 0))
+			break;
+	if(ServerAddr.port == 18403)
+	{
+		dbg_msg("netserver_bench", "couldn't open server socket");
+		return -1;
+	}
+	int Connected = 0;
+	Server.SetCallbacks(NewClientCallback, DelClientCallback, &Connected);
+
+	// fill all slots with clients from the same ip, the worst case for per-ip checks
+	CNetClient *pClients = new CNetClient[NumClients];
+	for(int i = 0; i < NumClients; i++)
+	{
+		if(!pClients[i].Open(BindAddr, 0))
+		{
+			dbg_msg("netserver_bench", "couldn't open client socket");
+			return -1;
+		}
+		pClients[i].Connect(&ServerAddr);
+	}
+
+	int64 Timeout = time_get() + time_freq() * 5;
+	while(Connected < NumClients && time_get() < Timeout)
+	{
+		for(int i = 0; i < NumClients; i++)
+		{
+			CNetChunk Packet;
+			pClients[i].Update();
+			while(pClients[i].Recv(&Packet))
+				;
+		}
+		PumpServer(&Server);
+		thread_sleep(1000);
+	}
+	dbg_msg("netserver_bench", "%d/%d clients connected", Connected, NumClients);
+
+	// every round each client sends one packet, and a flood of connection
+	// attempts from a fresh socket hits the slot lookup without a match
+	CNetClient Flooder;
+	Flooder.Open(BindAddr, 0);
+	unsigned char aData[16] = {0};
+	CNetChunk Packet;
+	Packet.m_ClientID = 0;
+	Packet.m_Flags = NETSENDFLAG_FLUSH;
+	Packet.m_DataSize = sizeof(aData);
+	Packet.m_pData = aData;
+
+	int64 ServerTime = 0;
+	int Packets = 0;
+	int Chunks = 0;
+	for(int Round = 0; Round < NumRounds; Round++)
+	{
+		for(int i = 0; i < NumClients; i++)
+			pClients[i].Send(&Packet);
+		for(int i = 0; i < NumClients; i++)
+			CNetBase::SendControlMsg(Flooder.m_Socket, &ServerAddr, 0, NET_CTRLMSG_CONNECT, SECURITY_TOKEN_MAGIC, sizeof(SECURITY_TOKEN_MAGIC), NET_SECURITY_TOKEN_UNSUPPORTED);
+		Packets += NumClients * 2;
+
+		int64 Start = time_get();
+		Chunks += PumpServer(&Server);
+		ServerTime += time_get() - Start;
+
+		// drain the replies so the socket buffers don't fill up
+		for(int i = 0; i < NumClients; i++)
+		{
+			CNetChunk Reply;
+			while(pClients[i].Recv(&Reply))
+				;
+		}
+		CNetChunk Reply;
+		while(Flooder.Recv(&Reply))
+			;
+	}
+
+	double Seconds = (double)ServerTime / time_freq();
+	dbg_msg("netserver_bench", "%d packets (%d chunks) in %.2f ms, %.1f ns per packet", Packets, Chunks, Seconds * 1000.0, Seconds * 1e9 / Packets);
+
+	for(int i = 0; i < NumClients; i++)
+		pClients[i].Close();
+	Flooder.Close();
+	Server.Close();
+	delete[] pClients;
+	delete pConfig;
+	return 0;
+}
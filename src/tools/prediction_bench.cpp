@@ -0,0 +1,135 @@
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/config.h>
+#include <engine/kernel.h>
+#include <engine/map.h>
+#include <engine/shared/config.h>
+#include <engine/storage.h>
+#include <game/client/prediction/entities/character.h>
+#include <game/client/prediction/gameworld.h>
+#include <game/collision.h>
+#include <game/layers.h>
+
+// Runs the client prediction the way CGameClient::OnPredict does, one world
+// copy and a number of predicted ticks per rendered frame, on a real map
+// without the rest of the client.
+
+int main(int argc, const char **argv)
+{
+	dbg_logger_stdout();
+	if(argc > 6)
+	{
+		dbg_msg("usage", "%s [map] [num characters] [num projectiles] [num frames] [predicted ticks]", argv[0]);
+		return -1;
+	}
+	const char *pMapName = argc > 1 ? argv[1] : "ctf1";
+	int NumCharacters = clamp(argc > 2 ? str_toint(argv[2]) : (int)MAX_CLIENTS, 1, (int)MAX_CLIENTS);
+	int NumProjectiles = argc > 3 ? str_toint(argv[3]) : 500;
+	int NumFrames = argc > 4 ? str_toint(argv[4]) : 2000;
+	int PredictedTicks = maximum(argc > 5 ? str_toint(argv[5]) : 10, 1);
+
+	IKernel *pKernel = IKernel::Create();
+	IStorage *pStorage = CreateStorage("Teeworlds", IStorage::STORAGETYPE_BASIC, argc, argv);
+	IEngineMap *pMap = CreateEngineMap();
+	IConfig *pConfig = CreateConfig();
+	pKernel->RegisterInterface(pStorage);
+	pKernel->RegisterInterface(pMap);
+	pKernel->RegisterInterface(static_cast<IMap *>(pMap), false);
+	pKernel->RegisterInterface(pConfig);
+	pConfig->Reset();
+
+	char aPath[MAX_PATH_LENGTH];
+	str_format(aPath, sizeof(aPath), "maps/%s.map", pMapName);
+	if(!pStorage || !pMap->Load(aPath))
+	{
+		dbg_msg("prediction_bench", "couldn't load map '%s'", aPath);
+		return -1;
+	}
+
+	CLayers Layers;
+	Layers.Init(pKernel);
+	CCollision Collision;
+	Collision.Init(&Layers);
+	CTuningParams aTuningList[256]; // like CGameClient::m_aTuningList
+
+	CGameWorld GameWorld;
+	GameWorld.m_GameTick = SERVER_TICK_SPEED * 60;
+	GameWorld.m_GameTickSpeed = SERVER_TICK_SPEED;
+	GameWorld.m_pCollision = &Collision;
+	GameWorld.m_pTuningList = aTuningList;
+	mem_zero(&GameWorld.m_WorldConfig, sizeof(GameWorld.m_WorldConfig));
+	GameWorld.m_WorldConfig.m_IsDDRace = true;
+	GameWorld.m_WorldConfig.m_PredictDDRace = true;
+	GameWorld.m_WorldConfig.m_PredictTiles = true;
+	GameWorld.m_WorldConfig.m_PredictWeapons = true;
+	GameWorld.m_WorldConfig.m_InfiniteAmmo = true;
+
+	// a snapshot with characters spread over the map and projectiles flying around
+	unsigned Seed = 1;
+	int Width = Collision.GetWidth() * 32;
+	int Height = Collision.GetHeight() * 32;
+	GameWorld.NetObjBegin();
+	for(int i = 0; i < NumCharacters; i++)
+	{
+		CNetObj_Character Char;
+		mem_zero(&Char, sizeof(Char));
+		Char.m_X = 64 + i * (Width - 128) / NumCharacters;
+		Char.m_Y = Height / 2;
+		Char.m_Tick = GameWorld.GameTick();
+		Char.m_Weapon = WEAPON_GUN;
+		Char.m_HookState = HOOK_IDLE;
+		Char.m_HookedPlayer = -1;
+		GameWorld.NetCharAdd(i, &Char, 0, 0, i == 0);
+	}
+	for(int i = 0; i < NumProjectiles; i++)
+	{
+		Seed = Seed * 1103515245 + 12345;
+		CNetObj_Projectile Proj;
+		Proj.m_X = 64 + (Seed >> 8) % (Width - 128);
+		Proj.m_Y = 64 + (Seed >> 4) % (Height - 128);
+		float Angle = (Seed % 628) / 100.0f;
+		Proj.m_VelX = (int)(cosf(Angle) * 100.0f);
+		Proj.m_VelY = (int)(sinf(Angle) * 100.0f);
+		Proj.m_Type = i % 2 ? WEAPON_GRENADE : WEAPON_GUN;
+		Proj.m_StartTick = GameWorld.GameTick();
+		GameWorld.NetObjAdd(i, NETOBJTYPE_PROJECTILE, &Proj);
+	}
+	GameWorld.NetObjEnd(0);
+
+	CGameWorld PredictedWorld;
+	CGameWorld PrevPredictedWorld;
+	int64 CopyTime = 0;
+	int64 TickTime = 0;
+	int NumEntities = 0;
+	for(int Frame = 0; Frame < NumFrames; Frame++)
+	{
+		int64 Start = time_get();
+		PredictedWorld.CopyWorld(&GameWorld);
+		CopyTime += time_get() - Start;
+
+		for(int Tick = GameWorld.GameTick() + 1; Tick <= GameWorld.GameTick() + PredictedTicks; Tick++)
+		{
+			if(Tick == GameWorld.GameTick() + PredictedTicks)
+			{
+				Start = time_get();
+				PrevPredictedWorld.CopyWorld(&PredictedWorld);
+				CopyTime += time_get() - Start;
+			}
+			Start = time_get();
+			PredictedWorld.m_GameTick = Tick;
+			PredictedWorld.Tick();
+			TickTime += time_get() - Start;
+		}
+
+		for(int Type = 0; Type < CGameWorld::NUM_ENTTYPES; Type++)
+			for(CEntity *pEnt = PredictedWorld.FindFirst(Type); pEnt; pEnt = pEnt->TypeNext())
+				NumEntities++;
+	}
+
+	dbg_msg("prediction_bench", "%d frames with %d predicted ticks, %.1f entities left per frame", NumFrames, PredictedTicks, (double)NumEntities / NumFrames);
+	dbg_msg("prediction_bench", "copy %.2f us per frame, tick %.2f us per frame",
+		CopyTime * 1e6 / time_freq() / NumFrames, TickTime * 1e6 / time_freq() / NumFrames);
+
+	delete pKernel;
+	return 0;
+}
@@ -0,0 +1,202 @@
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/graphics.h>
+#include <engine/shared/skincache.h>
+#include <engine/storage.h>
+
+#include <pnglite.h>
+
+#include <vector>
+
+/*
+	Usage: skin_cache_bench [skins directory] [cache file] [warm runs]
+	Compares a cold start, decoding and preparing every skin like the client
+	does, to a warm start that takes all skins from the skin cache.
+*/
+
+struct CBenchSkin
+{
+	char m_aPath[MAX_PATH_LENGTH];
+	int64 m_FileSize;
+	int64 m_FileTime;
+	CImageInfo m_Info;
+	unsigned char *m_pColorData;
+	ColorRGBA m_BloodColor;
+};
+
+struct CScanInfo
+{
+	const char *m_pDirectory;
+	std::vector<CBenchSkin> m_vSkins;
+};
+
+static int LoadPNG(CImageInfo *pImg, const char *pFilename)
+{
+	png_t Png;
+	int Error = png_open_file(&Png, pFilename);
+	if(Error != PNG_NO_ERROR)
+	{
+		dbg_msg("skin_cache_bench", "failed to open image file. filename='%s', pnglite: %s", pFilename, png_error_string(Error));
+		if(Error != PNG_FILE_ERROR)
+			png_close_file(&Png);
+		return 0;
+	}
+
+	if(Png.depth != 8 || (Png.color_type != PNG_TRUECOLOR && Png.color_type != PNG_TRUECOLOR_ALPHA) || Png.width > (2 << 12) || Png.height > (2 << 12))
+	{
+		dbg_msg("skin_cache_bench", "invalid image format. filename='%s'", pFilename);
+		png_close_file(&Png);
+		return 0;
+	}
+
+	unsigned char *pBuffer = (unsigned char *)malloc(Png.width * Png.height * Png.bpp);
+	Error = png_get_data(&Png, pBuffer);
+	png_close_file(&Png);
+	if(Error != PNG_NO_ERROR)
+	{
+		dbg_msg("skin_cache_bench", "failed to read image. filename='%s', pnglite: %s", pFilename, png_error_string(Error));
+		free(pBuffer);
+		return 0;
+	}
+
+	pImg->m_Width = Png.width;
+	pImg->m_Height = Png.height;
+	pImg->m_Format = Png.color_type == PNG_TRUECOLOR ? CImageInfo::FORMAT_RGB : CImageInfo::FORMAT_RGBA;
+	pImg->m_pData = pBuffer;
+	return 1;
+}
+
+// the client looks at the size and the modification time of every skin even
+// if it's cached, so this is part of both runs
+static int ScanSkin(const char *pName, time_t Date, int IsDir, int DirType, void *pUser)
+{
+	CScanInfo *pInfo = (CScanInfo *)pUser;
+	if(IsDir || !str_endswith(pName, ".png"))
+		return 0;
+
+	CBenchSkin Skin;
+	mem_zero(&Skin, sizeof(Skin));
+	str_format(Skin.m_aPath, sizeof(Skin.m_aPath), "%s/%s", pInfo->m_pDirectory, pName);
+	Skin.m_FileTime = Date;
+	IOHANDLE File = io_open(Skin.m_aPath, IOFLAG_READ);
+	if(!File)
+		return 0;
+	Skin.m_FileSize = io_length(File);
+	io_close(File);
+	pInfo->m_vSkins.push_back(Skin);
+	return 0;
+}
+
+static double Milliseconds(int64 Start)
+{
+	return (time_get_impl() - Start) * 1000.0 / time_freq();
+}
+
+int main(int argc, const char **argv)
+{
+	dbg_logger_stdout();
+	if(argc > 4)
+	{
+		dbg_msg("usage", "%s [skins directory] [cache file] [warm runs]", argv[0]);
+		return -1;
+	}
+	const char *pDirectory = argc > 1 ? argv[1] : "data/skins";
+	const char *pCacheFile = argc > 2 ? argv[2] : "skins.cache";
+	int NumWarmRuns = argc > 3 ? str_toint(argv[3]) : 10;
+	png_init(0, 0);
+
+	// cold start: decode and prepare everything, then write the cache
+	int64 Start = time_get_impl();
+	CScanInfo Cold;
+	Cold.m_pDirectory = pDirectory;
+	fs_listdir_info(pDirectory, ScanSkin, 0, &Cold);
+	std::vector<CSkinCache::CEntry> vEntries;
+	for(CBenchSkin &Skin : Cold.m_vSkins)
+	{
+		if(!LoadPNG(&Skin.m_Info, Skin.m_aPath))
+			continue;
+		Skin.m_pColorData = (unsigned char *)malloc(CSkinCache::DataSize(Skin.m_Info.m_Width, Skin.m_Info.m_Height, Skin.m_Info.m_Format));
+		if(!CSkinCache::PrepareSkin(&Skin.m_Info, Skin.m_pColorData, &Skin.m_BloodColor))
+			continue;
+
+		CSkinCache::CEntry Entry;
+		Entry.m_pPath = Skin.m_aPath;
+		Entry.m_Size = Skin.m_FileSize;
+		Entry.m_Time = Skin.m_FileTime;
+		Entry.m_Width = Skin.m_Info.m_Width;
+		Entry.m_Height = Skin.m_Info.m_Height;
+		Entry.m_Format = Skin.m_Info.m_Format;
+		Entry.m_BloodColor = Skin.m_BloodColor;
+		Entry.m_pData = (const unsigned char *)Skin.m_Info.m_pData;
+		Entry.m_pColorData = Skin.m_pColorData;
+		vEntries.push_back(Entry);
+	}
+	double DecodeTime = Milliseconds(Start);
+
+	int64 SaveStart = time_get_impl();
+	IOHANDLE File = io_open(pCacheFile, IOFLAG_WRITE);
+	if(!File || !CSkinCache::Save(File, vEntries))
+	{
+		dbg_msg("skin_cache_bench", "failed to write '%s'", pCacheFile);
+		if(File)
+			io_close(File);
+		return -1;
+	}
+	io_close(File);
+	double SaveTime = Milliseconds(SaveStart);
+	dbg_msg("skin_cache_bench", "cold: %d skins decoded in %.2fms, cache written in %.2fms", (int)vEntries.size(), DecodeTime, SaveTime);
+
+	// warm start: every skin comes out of the cache
+	double BestTime = -1.0;
+	double TotalTime = 0.0;
+	int NumMismatches = 0;
+	for(int Run = 0; Run < NumWarmRuns; Run++)
+	{
+		Start = time_get_impl();
+		CScanInfo Warm;
+		Warm.m_pDirectory = pDirectory;
+		fs_listdir_info(pDirectory, ScanSkin, 0, &Warm);
+		CSkinCache Cache;
+		File = io_open(pCacheFile, IOFLAG_READ);
+		if(File)
+		{
+			Cache.Load(File);
+			io_close(File);
+		}
+		int NumFound = 0;
+		for(const CBenchSkin &Skin : Warm.m_vSkins)
+			if(Cache.Find(Skin.m_aPath, Skin.m_FileSize, Skin.m_FileTime))
+				NumFound++;
+		double Time = Milliseconds(Start);
+		TotalTime += Time;
+		if(BestTime < 0.0 || Time < BestTime)
+			BestTime = Time;
+		if(NumFound != (int)vEntries.size())
+			NumMismatches++;
+
+		// the cached pixels must match what was decoded
+		if(Run == 0)
+		{
+			for(const CSkinCache::CEntry &Entry : vEntries)
+			{
+				const CSkinCache::CEntry *pCached = Cache.Find(Entry.m_pPath, Entry.m_Size, Entry.m_Time);
+				int Size = CSkinCache::DataSize(Entry.m_Width, Entry.m_Height, Entry.m_Format);
+				if(!pCached || mem_comp(pCached->m_pData, Entry.m_pData, Size) != 0 || mem_comp(pCached->m_pColorData, Entry.m_pColorData, Size) != 0)
+				{
+					dbg_msg("skin_cache_bench", "cached skin differs: %s", Entry.m_pPath);
+					NumMismatches++;
+				}
+			}
+		}
+	}
+	if(NumWarmRuns > 0)
+		dbg_msg("skin_cache_bench", "warm: %d runs, %.2fms on average, %.2fms at best (%.1fx faster)", NumWarmRuns, TotalTime / NumWarmRuns, BestTime, DecodeTime / maximum(BestTime, 0.001));
+
+	for(CBenchSkin &Skin : Cold.m_vSkins)
+	{
+		free(Skin.m_Info.m_pData);
+		free(Skin.m_pColorData);
+	}
+	fs_remove(pCacheFile);
+	return NumMismatches ? -1 : 0;
+}